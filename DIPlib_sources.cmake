@@ -21,6 +21,7 @@ include/diplib/geometry.h
 include/diplib/histogram.h
 include/diplib/iterators.h
 include/diplib/kernel.h
+include/diplib/lazy.h
 include/diplib/library/clamp_cast.h
 include/diplib/library/copy_buffer.h
 include/diplib/library/datatype.h
@@ -46,6 +47,7 @@ include/diplib/multithreading.h
 include/diplib/neighborlist.h
 include/diplib/nonlinear.h
 include/diplib/overload.h
+include/diplib/packed_binary.h
 include/diplib/pixel_table.h
 include/diplib/private/monadic_operators.h
 include/diplib/random.h
@@ -66,6 +68,7 @@ src/binary/binary_support.cpp
 src/binary/binary_support.h
 src/binary/bucket.h
 src/binary/count_neighbors.cpp
+src/binary/packed_binary.cpp
 src/binary/skeleton.cpp
 src/binary/thick_thin_2D.cpp
 src/color/cmyk.h
@@ -81,6 +84,8 @@ src/display/image_display.cpp
 src/distance/edt.cpp
 src/distance/gdt.cpp
 src/distance/vdt.cpp
+src/file_io/blockwise.cpp
+src/file_io/file_io_support.h
 src/file_io/ics.cpp
 src/file_io/tiff_read.cpp
 src/file_io/tiff_write.cpp
@@ -95,6 +100,7 @@ src/histogram/histogram.cpp
 src/histogram/statistics.cpp
 src/histogram/threshold_algorithms.cpp
 src/library/boundary.cpp
+src/library/buffer_pool.cpp
 src/library/copy_buffer.cpp
 src/library/datatype.cpp
 src/library/framework.cpp
@@ -129,6 +135,7 @@ src/math/bitwise.cpp
 src/math/comparison.cpp
 src/math/dyadic_operators.cpp
 src/math/error.cpp
+src/math/lazy.cpp
 src/math/monadic_operators.cpp
 src/math/pixel.cpp
 src/math/projection.cpp
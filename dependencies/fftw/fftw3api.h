@@ -61,6 +61,9 @@ struct fftwapidef<T> \
    FFTW_TEMPLATED_API_FUNC( MANGLE, print_plan ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, malloc ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, free ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, alignment_of ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, export_wisdom_to_string ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, import_wisdom_from_string ); \
 }; // end fftwapidef<>
 // Excluded, because free() results in runtime error in debug mode: static std::string plan_to_string( plan p ) { char* pStr = MANGLE( sprint_plan )(p); std::string result( pStr ); ::free( pStr ); return result; };
 
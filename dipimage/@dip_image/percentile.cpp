@@ -51,7 +51,7 @@ void mexFunction( int /*nlhs*/, mxArray* plhs[], int nrhs, mxArray const* prhs[]
       }
 
       // Do the thing
-      dip::Percentile( in, mask, out, percentile, process );
+      dip::Percentile( in, mask, out, percentile, "exact", process );
 
       // Done
       if( nrhs > 2 ) {
@@ -89,6 +89,12 @@ class DIP_NO_EXPORT StatisticsAccumulator {
 
       /// Combine two accumulators
       StatisticsAccumulator& operator+=( StatisticsAccumulator const& b ) {
+         if( b.n_ == 0 ) {
+            return *this;
+         }
+         if( n_ == 0 ) {
+            return *this = b;
+         }
          dfloat an = static_cast< dfloat >( n_ );
          dfloat an2 = an * an;
          dfloat bn = static_cast< dfloat >( b.n_ );
@@ -209,6 +215,9 @@ class DIP_NO_EXPORT VarianceAccumulator {
 
       /// Combine two accumulators
       VarianceAccumulator& operator+=( VarianceAccumulator const& b ) {
+         if( b.n_ == 0 ) {
+            return *this;
+         }
          dfloat oldn = static_cast< dfloat >( n_ );
          n_ += b.n_;
          dfloat n = static_cast< dfloat >( n_ );
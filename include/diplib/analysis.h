@@ -200,6 +200,11 @@ inline Image CrossCorrelationFT(
 ///    sub-sampled by a factor four will be used (parameter = 0.2).
 ///    This method only supports 2-D images.
 ///
+///  - `"robust CPF"`: As `"CPF"`, but after the first fit, the frequencies whose phase deviates from the fitted
+///    plane by more than three times the (robust) standard deviation of the deviations are iteratively removed,
+///    and the plane is fitted again. This makes the method less sensitive to phase wrapping and to frequencies
+///    dominated by noise. This method only supports 2-D images.
+///
 ///  - `"MTS"`: The MTS method (see Luengo Hendriks (1998), where it is called GRS) uses a first order Taylor
 ///    approximation of the equation `in1(t) = in2(t-s)` at scale `parameter`. If `parameter` is <= 0, a scale
 ///    of 1 will be used. This means that the images will be smoothed with a Gaussian kernel of 1. This method is
@@ -234,6 +239,83 @@ DIP_EXPORT FloatArray FindShift(
       UnsignedArray maxShift = {}
 );
 
+/// \brief Estimates the (sub-pixel) global shift between a fixed reference image and many other images.
+///
+/// Computes the same shift as `dip::FindShift( reference, frame, method, parameter, maxShift )` for each
+/// `frame`, but the quantities that depend only on `reference` are computed once, when the object is constructed:
+/// the Fourier transform used for the cross-correlation (and its normalization, for `"NCC"`), and for `"MTS"` and
+/// `"ITER"`, the smoothed image, its gradient and the gradient products. This is useful, for example, to
+/// correct the drift in a long time series, where each frame is compared to the same reference.
+///
+/// For `"CPF"`, the Fourier transform of the reference is reused when the integer shift is zero. For `"PROJ"`,
+/// only the integer shift estimation uses cached data.
+///
+/// For the methods that crop the images to their common part, `"MTS"` and `"ITER"` take the derivatives of the
+/// reference near the edges of the common part from the full reference image, rather than computing them on
+/// the cropped image. The result can therefore differ slightly from that of `dip::FindShift`.
+///
+/// `window` can be `"none"`, `"Hann"` or `"Tukey"`. If it is not `"none"`, both images are multiplied by a
+/// separable window function before computing the cross-correlation, which reduces the effect of the periodic
+/// boundary imposed by the Fourier transform. This affects the integer shift estimation, as well as the
+/// `"CC"`, `"NCC"`, `"CPF"` and `"robust CPF"` methods. The Hann window tapers the whole image towards its edges,
+/// the Tukey window tapers only 1/8 of the image size at each edge.
+///
+/// `Estimate` can be called for one frame at the time (for example as frames arrive from a stream), and is
+/// safe to call from multiple threads simultaneously. Given an array of frames, or an image stack where the last
+/// dimension indexes the frames, the frames are processed in parallel.
+///
+/// ```cpp
+///     dip::ShiftEstimator estimator( reference, "ITER" );
+///     std::vector< dip::FloatArray > shifts = estimator.EstimateStack( timeSeries );
+/// ```
+///
+/// `reference` and the frames must be real-valued, scalar images of the same sizes. The object keeps a copy
+/// of the reference image.
+class DIP_NO_EXPORT ShiftEstimator {
+   public:
+      /// \brief Prepares to estimate shifts with respect to `reference`. See `dip::FindShift` for the
+      /// meaning of `method`, `parameter` and `maxShift`.
+      DIP_EXPORT explicit ShiftEstimator(
+            Image const& reference,
+            String const& method = "MTS",
+            dfloat parameter = 0,
+            UnsignedArray maxShift = {},
+            String const& window = "none"
+      );
+
+      /// \brief Estimates the shift of `frame` with respect to the reference image.
+      DIP_EXPORT FloatArray Estimate( Image const& frame ) const;
+
+      /// \brief Estimates the shift of each image in `frames` with respect to the reference image.
+      DIP_EXPORT std::vector< FloatArray > Estimate( ImageArray const& frames ) const;
+
+      /// \brief Estimates the shift of each frame in `stack` with respect to the reference image. `stack` has
+      /// one more dimension than the reference image, the last dimension indexes the frames.
+      DIP_EXPORT std::vector< FloatArray > EstimateStack( Image const& stack ) const;
+
+      /// \brief Returns the reference image.
+      Image const& Reference() const { return reference_; }
+
+   private:
+      enum class Method { INTEGER, CC, NCC, CPF, ROBUST_CPF, MTS, ITER, PROJ };
+      Method method_;
+      dfloat parameter_;
+      UnsignedArray maxShift_;
+      String window_;
+      dfloat sigma_;             // For MTS and ITER
+      dip::uint maxIter_;
+      dfloat accuracy_;
+      Image reference_;
+      Image referenceFT_;        // Half spectrum of the windowed reference, normalized for NCC
+      Image cpfReferenceFT_;     // Full spectrum of the windowed reference, for CPF
+      Image smoothed_;           // For MTS and ITER
+      Image gradient_;
+      Image gradientProducts_;
+      Image M_;
+
+      Image Windowed( Image const& img ) const;
+};
+
 
 /// \brief Computes the structure tensor.
 ///
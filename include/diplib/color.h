@@ -64,6 +64,23 @@ class DIP_EXPORT ColorSpaceConverter {
       /// spaces, as determined by the `InputColorSpace` and `OutputColorSpace` method.
       virtual void Convert( ConstLineIterator< dfloat >& input, LineIterator< dfloat >& output ) const = 0;
 
+      /// \brief Returns the affine transformation performed by the converter, if it is one.
+      ///
+      /// If the conversion can be written as `output = A * input + b`, this method returns the matrix `[A b]`,
+      /// which has as many rows as there are output channels and one more column than there are input
+      /// channels, with its elements stored in column-major order. `dip::ColorSpaceManager` uses this to
+      /// combine consecutive affine conversion steps into a single matrix multiplication. It is not necessary
+      /// to define this method, the default implementation returns an empty array, meaning that the conversion
+      /// is not affine.
+      virtual std::vector< dfloat > AffineMatrix() const { return {}; }
+
+      /// \brief Returns true if each output channel depends only on the corresponding input channel.
+      ///
+      /// `dip::ColorSpaceManager` uses this to replace the conversion by a look-up table when it is the first
+      /// step applied to an 8-bit or 16-bit unsigned integer image. It is not necessary to define this method,
+      /// the default implementation returns `false`.
+      virtual bool IsChannelwise() const { return false; }
+
       virtual ~ColorSpaceConverter() {}
 };
 
@@ -166,6 +183,7 @@ class DIP_NO_EXPORT ColorSpaceManager {
          auto& edges = colorSpaces_[ source ].edges;
          auto it = edges.find( destination );
          DIP_THROW_IF( it == edges.end(), "Converter function not registered" );
+         ClearPlanCache(); // The caller might modify the converter's parameters
          return it->second.get();
       }
 
@@ -212,6 +230,13 @@ class DIP_NO_EXPORT ColorSpaceManager {
       /// but the result is cast to 8-bit unsigned integers when written to the output image. Some color spaces,
       /// such as RGB and CMYK are defined to use the [0,255] range of 8-bit unsigned integers. Other color spaces
       /// such as Lab and XYZ are not. For those color spaces, casting to an integer will destroy the data.
+      ///
+      /// The sequence of conversion steps is compiled into a plan before it is applied: consecutive affine steps
+      /// (see `dip::ColorSpaceConverter::AffineMatrix`) are combined into a single matrix multiplication, and a
+      /// first step that works on each channel independently (see `dip::ColorSpaceConverter::IsChannelwise`)
+      /// is replaced by a look-up table if `in` is an 8-bit or 16-bit unsigned integer image. Plans are cached,
+      /// such that repeated conversions between the same color spaces do not need to be compiled again. The
+      /// cache is cleared by `SetWhitePoint` and `GetColorSpaceConverter`.
       DIP_EXPORT void Convert( Image const& in, Image& out, String const& colorSpaceName = "" ) const;
       Image Convert( Image const& in, String const& colorSpaceName = "" ) const {
          Image out;
@@ -272,6 +297,15 @@ class DIP_NO_EXPORT ColorSpaceManager {
       std::map< String, dip::uint > names_;
       std::vector< ColorSpace > colorSpaces_;
 
+      // Compiled conversion plans, see `Convert()`. Copies of the object share the cache, as they share the
+      // converter objects too. Plans are keyed by the converter objects along the path, not by color space
+      // indices, and hold a reference to those objects, so sharing the cache is safe even if a copy registers
+      // new converters.
+      class ConversionPlanCache;
+      std::shared_ptr< ConversionPlanCache > planCache_;
+
+      DIP_EXPORT void ClearPlanCache() const;
+
       dip::uint Index( String const& name ) const {
          auto it = names_.find( name );
          DIP_THROW_IF( it == names_.end(), "Color space name not defined" );
@@ -26,6 +26,7 @@
 #include <vector>
 #include <complex>
 #include <limits>
+#include <memory>
 #include "dip_export.h"
 
 /// \file
@@ -106,6 +107,16 @@ class DFT {
       int sz_ = 0; // Size of the buffer to be passed to DFT.
 };
 
+/// \brief Returns a `DFT` object for a transform of size `size`, taken from a thread-safe cache.
+///
+/// The first call for a given size and direction creates the object, later calls (from any thread) share
+/// it, so that repeated transforms of the same size don't need to recompute the tables. The cache holds
+/// a limited number of objects; when it is full, the objects that are not in use are removed.
+///
+/// The template can be instantiated for `T = float` or `T = double`. Linker errors will result for other types.
+template< typename T >
+DIP_EXPORT std::shared_ptr< DFT< T > const > GetCachedDFT( size_t size, bool inverse );
+
 /// \brief Returns a size equal or larger to `size0` that is efficient for our DFT implementation.
 ///
 /// Returns 0 if `size0` is too large for our DFT implementation.
@@ -21,6 +21,8 @@
 #ifndef DIP_FILE_IO_H
 #define DIP_FILE_IO_H
 
+#include <functional>
+
 #include "diplib.h"
 
 
@@ -68,6 +70,15 @@ struct FileInformation {
 /// interface set it might also be impossible to dictate what the stides will look like. In these cases,
 /// the flag is ignored.
 ///
+/// If `mode` is `"mmap"`, the pixel data is not read, but the file is mapped into memory, and `out` becomes
+/// a view of the requested `roi` and `channels` of the mapped data. Pages are read from disk only when they
+/// are first accessed, so opening even a very large file is fast and doesn't allocate memory for the pixels.
+/// The mapping is private (copy-on-write): `out` can be written to, but changes are not written to the file.
+/// The file stays mapped until the last image referencing the data is stripped or destroyed. This is only
+/// possible for uncompressed files stored in the machine's byte order, on systems that support `mmap`,
+/// and when `out` is not protected and has no external interface; in all other cases the data is read
+/// as usual. Note that `out` will generally have non-standard strides.
+///
 /// Information about the file and all metadata is returned in the `FileInformation` output argument.
 // TODO: read sensor information also into the history strings
 DIP_EXPORT FileInformation ImageReadICS(
@@ -178,21 +189,28 @@ DIP_EXPORT void ImageWriteICS(
 /// planes and thumbnails alternate. A range such as {0,-1,2} reads all image planes skipping the
 /// thumbnails.
 ///
+/// `roi` can be set to read in a subset of the pixels in each image plane. It has one or two elements,
+/// for the x and y dimensions; if only one element is given, it is used for both dimensions. An empty
+/// array indicates that all pixels should be read. Only the strips or tiles that intersect the ROI are
+/// read from the file, making it efficient to read a small region from a large, tiled image.
+///
+/// Strips and tiles are decompressed in parallel if the file is compressed and large enough
+/// (see `dip::SetNumberOfThreads`).
+///
 /// The pixels per inch value in the TIFF file will be used to set the pixel size of `out`.
 ///
 /// TIFF is a very flexible file format. We have to limit the types of images that can be read to the
 /// more common ones. These are the most obvious limitations:
-///  - Tiled images are not supported.
 ///  - Only 1, 4, 8, 16 and 32 bits per pixel integer grayvalues are read, as well as 32-bit and 64-bit
 ///    floating point.
 ///  - Only 4 and 8 bits per pixel colormapped images are read.
 ///  - Class Y images (YCbCr) and Log-compressed images (LogLuv or LogL) are not supported.
-// TODO: Support reading ROIs (especially from tiled images)
 // TODO: Option to read an indexed image without applying the color map, and reading in the color map separately.
 DIP_EXPORT FileInformation ImageReadTIFF(
       Image& out,
       String const& filename,
-      Range imageNumbers = Range{ 0 }
+      Range imageNumbers = Range{ 0 },
+      RangeArray roi = {}
 );
 inline Image ImageReadTIFF(
       String const& filename,
@@ -202,6 +220,15 @@ inline Image ImageReadTIFF(
    ImageReadTIFF( out, filename, imageNumbers );
    return out;
 }
+inline Image ImageReadTIFF(
+      String const& filename,
+      Range const& imageNumbers,
+      RangeArray const& roi
+) {
+   Image out;
+   ImageReadTIFF( out, filename, imageNumbers, roi );
+   return out;
+}
 
 /// \brief Reads a set of 2D TIFF images as a single 3D image.
 ///
@@ -229,7 +256,9 @@ DIP_EXPORT bool ImageIsTIFF( String const& filename );
 /// \brief Writes `image` as a TIFF file.
 ///
 /// The TIFF image file format is very flexible in how data can be written, but is limited to multiple pages
-/// of 2D images. A 3D image will be written as a multi-page TIFF file (not yet implemented).
+/// of 2D images. A 3D image will be written as a multi-page TIFF file, which `dip::ImageReadTIFF` can read
+/// back as a 3D image. Images with more than three dimensions are written as a multi-page TIFF file as well,
+/// with the dimensions beyond the 2nd flattened.
 /// A tensor image will be written as an image with multiple samples per pixel, but the tensor shape will be lost.
 /// Color space information and pixel size are not saved either, though the pixel size, if in units of length,
 /// will set the pixels per centimeter value in the TIFF file.
@@ -250,11 +279,65 @@ DIP_EXPORT bool ImageIsTIFF( String const& filename );
 ///    by compliant TIFF readers. Even small amounts of noise can cause this method to yield larger files than `"none"`.
 ///  - `"JPEG"`: uses **lossy** JPEG compression. `jpegLevel` determines the amount of compression applied. `jpegLevel`
 ///    is an integer between 1 and 100, with increasing numbers yielding larger files and fewer compression artifacts.
+///
+/// If `tileSize` is 0, the image is written in strips, which is most compatible. Otherwise it is written in
+/// square tiles of `tileSize` pixels to a side, which must be a multiple of 16. Tiled files allow efficient reading
+/// of a small region of a large image (see `dip::ImageReadTIFF`).
+///
+/// Strips or tiles are compressed in parallel (see `dip::SetNumberOfThreads`), except with JPEG compression.
 DIP_EXPORT void ImageWriteTIFF(
       Image const& image,
       String const& filename,
       String const& compression = "",
-      dip::uint jpegLevel = 80
+      dip::uint jpegLevel = 80,
+      dip::uint tileSize = 0
+);
+
+/// \brief A function that processes one block of an image, used by `dip::ImageProcessBlockwise`.
+///
+/// The function reads `in` and writes its result to `out`, which must have the same sizes as `in`.
+using BlockProcessingFunction = std::function< void( Image const& in, Image& out ) >;
+
+/// \brief Applies `function` to the image in file `inFilename`, block by block, writing the result to
+/// the ICS file `outFilename`. Use this to process images that do not fit in memory.
+///
+/// `inFilename` is a TIFF file if it has a ".tif" or ".tiff" extension, and an ICS file otherwise. A multi-page
+/// TIFF file is processed as a 3D image. The image is divided into blocks that are processed independently.
+/// Each block is read from file together with a border of `border` pixels on each side (fewer at the image
+/// edges), the border is cropped from the result of `function`, and the rest is written to the corresponding
+/// location in the output file. If `border` is at least the
+/// reach of the filter applied by `function`, the result is identical to applying `function` to the whole image:
+/// at the image edges the filter sees the actual image edge, and applies its own boundary condition. `border`
+/// can be obtained from the filter parameters, for example through `dip::Kernel::Boundary`,
+/// `dip::StructuringElement::Boundary` or `dip::GaussFIRBoundary`. If only one value is given,
+/// it is used for all dimensions. Filters that do not have a finite reach (Fourier-domain or IIR filters,
+/// labeling, reconstruction, etc.) yield a different result than when applied to the full image.
+///
+/// `function` must produce an output of the same sizes as its input, and the same data type and number of
+/// tensor elements for all blocks. Pixel size, color space and tensor shape are taken from the output of the
+/// first block written.
+///
+/// Blocks are processed in parallel, each thread reading, processing and writing one block at the time
+/// (see `dip::SetNumberOfThreads`). Filters called from within `function` then run single-threaded.
+/// The block size is chosen such that the blocks being processed simultaneously do not use more than
+/// `memoryBudget` bytes, assuming each block (including its border) needs memory for three copies of the
+/// input: the input itself, the output, and one intermediate image. An exception is thrown if `border`
+/// is too large for the budget. Uncompressed ICS files are read through memory mapping (see `dip::ImageReadICS`).
+///
+/// Reading from the input file is serialized: only one thread reads a block at the time, while the other
+/// threads process or write theirs. For TIFF files and compressed ICS files, which are decoded while reading,
+/// the reading can therefore dominate the processing time. Compressed ICS files are decompressed from the
+/// start of the file for each block; convert them to uncompressed ICS files before processing large images.
+///
+/// The output is an ICS version 2 file, whose header is written to `outFilename` (with the ".ics" extension
+/// added if it doesn't have it) and whose uncompressed pixel data is written to a file with the same name but the
+/// ".ids" extension. The header is written only after all blocks have been processed successfully.
+DIP_EXPORT void ImageProcessBlockwise(
+      String const& inFilename,
+      String const& outFilename,
+      BlockProcessingFunction const& function,
+      UnsignedArray border,
+      dip::uint memoryBudget = 1024ul * 1024ul * 1024ul
 );
 
 
@@ -121,6 +121,13 @@ DIP_EXPORT dip::uint OptimalProcessingDim( Image const& in );
 /// to a dimension where `kernelSizes` is large also.
 DIP_EXPORT dip::uint OptimalProcessingDim( Image const& in, UnsignedArray const& kernelSizes );
 
+/// \brief Computes the coordinates of the first pixel of image line number `line`, for an image of size `sizes`,
+/// where lines run along `processingDim`.
+///
+/// Lines are numbered in the order in which an iterator with `processingDim` as processing dimension
+/// visits them (see `dip::GenericImageIterator`). The frameworks use this to hand out image lines to threads.
+DIP_EXPORT UnsignedArray LineStartCoordinates( UnsignedArray const& sizes, dip::uint processingDim, dip::uint line );
+
 
 //
 // Scan Framework:
@@ -275,6 +282,10 @@ class DIP_EXPORT ScanLineFilter {
 /// first input image with matching number of tensor elements.
 /// The calling function is expected to "correct" these values if necessary.
 ///
+/// When processing along a dimension other than the one with the smallest stride, image lines are processed
+/// in blocks of adjacent lines, see `dip::Framework::SeparableLineFilter::FilterLines`. The input buffer
+/// is always a temporary buffer in this case.
+///
 /// The buffers are not guaranteed to be contiguous, please use the `stride`
 /// and `tensorStride` values to access samples. All buffers contain `bufferLength`
 /// pixels. `position` gives the coordinates for the first pixel in the buffers,
@@ -482,6 +493,10 @@ inline void ScanDyadic(
 /// These functions take an optional second input argument `cost`, which specifies the cost in cycles to execute
 /// a single call of `func`. This cost is used to determine if it's worthwhile to parallelize the operation, see
 /// \ref design_multithreading.
+///
+/// When all buffers are contiguous (unit stride for scalar images, or interleaved tensor elements), the line is
+/// processed with a simple indexed loop that the compiler can vectorize, provided that `func` can be inlined and
+/// does not branch on the sample values. This is the common case when input and output images are not views.
 template< dip::uint N, typename TPI, typename F >
 class DIP_NO_EXPORT VariadicScanLineFilter : public ScanLineFilter {
    // Note that N is a compile-time constant, and consequently the compiler should be able to optimize all the loops
@@ -500,18 +515,35 @@ class DIP_NO_EXPORT VariadicScanLineFilter : public ScanLineFilter {
          std::array< dip::sint, N > inTensorStride;
          dip::uint const bufferLength = params.bufferLength;
          dip::uint const tensorLength = params.outBuffer[ 0 ].tensorLength; // all buffers have same number of tensor elements
+         // `contiguous` is true if all buffers have their samples one after the other, with the tensor elements
+         // (if any) interleaved. We then treat the buffers as simple arrays of `bufferLength * tensorLength`
+         // samples, and index all of them with the same counter, which allows the compiler to vectorize the loop.
+         dip::sint const contiguousStride = static_cast< dip::sint >( tensorLength );
+         bool contiguous = ( params.outBuffer[ 0 ].stride == contiguousStride ) &&
+                           (( tensorLength == 1 ) || ( params.outBuffer[ 0 ].tensorStride == 1 ));
          for( dip::uint ii = 0; ii < N; ++ii ) {
             in[ ii ] = static_cast< TPI const* >( params.inBuffer[ ii ].buffer );
             inStride[ ii ] = params.inBuffer[ ii ].stride;
             if( tensorLength > 1 ) {
                inTensorStride[ ii ] = params.inBuffer[ ii ].tensorStride;
+               contiguous &= inTensorStride[ ii ] == 1;
             }
+            contiguous &= inStride[ ii ] == contiguousStride;
             DIP_ASSERT( params.inBuffer[ ii ].tensorLength == tensorLength );
          }
          TPI* out = static_cast< TPI* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
          dip::sint const outTensorStride = params.outBuffer[ 0 ].tensorStride;
-         if( tensorLength > 1 ) {
+         if( contiguous ) {
+            dip::uint const length = bufferLength * tensorLength;
+            for( dip::uint kk = 0; kk < length; ++kk ) {
+               std::array< TPI const*, N > inK;
+               for( dip::uint ii = 0; ii < N; ++ii ) {
+                  inK[ ii ] = in[ ii ] + kk;
+               }
+               out[ kk ] = func_( inK );
+            }
+         } else if( tensorLength > 1 ) {
             for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
                std::array< TPI const*, N > inT = in;
                TPI* outT = out;
@@ -640,6 +672,20 @@ struct DIP_NO_EXPORT SeparableLineFilterParameters {
    dip::uint thread;                  ///< Thread number
 };
 
+/// \brief Describes a batch of image lines passed to `dip::Framework::SeparableLineFilter::FilterLines`.
+///
+/// The `inBuffer` and `outBuffer` members of the `dip::Framework::SeparableLineFilterParameters` object
+/// describe the first line in the batch. Line `ii` starts `ii * inLineStride` samples after the first line in
+/// the input buffer, and `ii * outLineStride` samples after the first line in the output buffer. Its position
+/// is that of the first line, with `ii` added to `position[ lineDimension ]`.
+struct DIP_NO_EXPORT SeparableLineBatch {
+   dip::uint nLines;        ///< Number of image lines in the batch
+   dip::sint inLineStride;  ///< Stride to walk from one line to the next in the input buffer
+   dip::sint outLineStride; ///< Stride to walk from one line to the next in the output buffer
+   dip::uint lineDimension; ///< Dimension along which the lines in the batch are adjacent
+   DataType bufferType;     ///< Data type of the input and output buffers
+};
+
 /// \brief Prototype line filter for `dip::Framework::Separable`.
 ///
 /// An object of a class derived from `%SeparableLineFilter` must be passed to the separable framework. The derived
@@ -654,10 +700,19 @@ struct DIP_NO_EXPORT SeparableLineFilterParameters {
 /// The `GetNumberOfOperations` method is called to determine if it is worthwhile to start worker threads and
 /// perform the computation in parallel. This function should not perform any other tasks, as it is not
 /// guaranteed to be called. It is not important that the function be very precise, see \ref design_multithreading.
+///
+/// When processing along a dimension that does not have the smallest stride, the framework gathers a block of
+/// adjacent image lines into a temporary buffer at once, which is much more cache friendly than copying one image
+/// line at the time. The `FilterLines` method is then called to process all lines in the block. Its default
+/// implementation calls `Filter` for each of the lines; a derived class can override it to process the lines
+/// together.
 class DIP_EXPORT SeparableLineFilter {
    public:
       /// \brief The derived class must must define this method, this is the actual line filter.
       virtual void Filter( SeparableLineFilterParameters const& params ) = 0;
+      /// \brief The derived class can define this method to filter a batch of adjacent image lines in one call,
+      /// see `dip::Framework::SeparableLineBatch`. The default calls `Filter` for each line.
+      virtual void FilterLines( SeparableLineFilterParameters const& params, SeparableLineBatch const& batch );
       /// \brief The derived class can define this function for setting up the processing.
       virtual void SetNumberOfThreads( dip::uint threads ) { ( void )threads; }
       /// \brief The derived class can define this function for helping to determine whether to whether to compute
@@ -764,8 +819,19 @@ class DIP_EXPORT SeparableLineFilter {
 /// extra samples at each end. These extra samples are meant to help in the
 /// computation for some filters, and are not copied back to the output image.
 /// `position` gives the coordinates for the first pixel in the buffers,
-/// subsequent pixels occur along dimension `dimension`. `position[dimension]`
-/// is always zero.
+/// subsequent pixels occur along dimension `dimension`. The buffers do not always
+/// contain a full image line: `lineFilter` can be called for a segment of `bufferLength`
+/// pixels along the line, and `position[dimension]` is then not zero.
+///
+/// If the input image needs a boundary extension, but no data type conversion or tensor
+/// expansion, and the boundary conditions only depend on pixels close to the image edge
+/// (that is, they are not periodic), then the input image is not copied. The pixels whose
+/// neighborhood lies entirely within the image are processed reading directly from the input
+/// image. The other pixels are processed in small blocks, for each of which the framework
+/// copies and extends the neighborhood into a buffer that has the same strides as the input
+/// image. In all other cases, the input image is copied to a buffer with the boundary extended.
+/// The boundary extension at each end of each dimension is given by the extent of the pixel
+/// table, and thus can be different at the two ends for shifted or even-sized kernels.
 ///
 /// If `in` and `out` share their data segments, then the input image might be
 /// overwritten with the processing result. However, the input and output buffers
@@ -846,9 +912,9 @@ struct DIP_NO_EXPORT FullBuffer {
 struct DIP_NO_EXPORT FullLineFilterParameters {
    FullBuffer const& inBuffer;            ///< Input buffer (1D)
    FullBuffer& outBuffer;                 ///< Output buffer (1D)
-   dip::uint bufferLength;                ///< Number of pixels in each buffer
+   dip::uint bufferLength;                ///< Number of pixels in each buffer, can be smaller than the image line
    dip::uint dimension;                   ///< Dimension along which the line filter is applied
-   UnsignedArray const& position;         ///< Coordinates of first pixel in line
+   UnsignedArray const& position;         ///< Coordinates of first pixel in the buffers
    PixelTableOffsets const& pixelTable;   ///< The pixel table object describing the neighborhood
    dip::uint thread;                      ///< Thread number
 };
@@ -965,8 +1031,19 @@ class DIP_EXPORT FullLineFilter {
 /// `boundaryConditions` are ignored.
 ///
 /// `position` gives the coordinates for the first pixel in the buffers,
-/// subsequent pixels occur along dimension `dimension`. `position[dimension]`
-/// is always zero.
+/// subsequent pixels occur along dimension `dimension`. The buffers do not always
+/// contain a full image line: `lineFilter` can be called for a segment of `bufferLength`
+/// pixels along the line, and `position[dimension]` is then not zero.
+///
+/// If the input image needs a boundary extension, but no data type conversion or tensor
+/// expansion, and the boundary conditions only depend on pixels close to the image edge
+/// (that is, they are not periodic), then the input image is not copied. The pixels whose
+/// neighborhood lies entirely within the image are processed reading directly from the input
+/// image. The other pixels are processed in small blocks, for each of which the framework
+/// copies and extends the neighborhood into a buffer that has the same strides as the input
+/// image. In all other cases, the input image is copied to a buffer with the boundary extended.
+/// The boundary extension at each end of each dimension is given by the extent of the pixel
+/// table, and thus can be different at the two ends for shifted or even-sized kernels.
 ///
 /// The input and output buffers will never share memory. That is, the line
 /// filter can freely write in the output buffer without invalidating the input
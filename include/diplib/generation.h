@@ -591,11 +591,10 @@ inline Image CreateCoordinates( UnsignedArray const& sizes, StringSet const& mod
 /// for each pixel it does `in += uniformRandomGenerator( lowerBound, upperBound )`. The output image is of the
 /// same type as the input image.
 ///
-/// `random` is used to generate the random values needed by the first thread. If the algorithm runs in multiple
-/// threads, portions of the image processed by additional threads take their random values from `random.Split()`,
-/// which is essentially a copy of `random` set to a different random stream. Given a `dip::Random` object in an
-/// identical state before calling this function, the output image will be different depending on the number of
-/// threads used.
+/// `random` is used to generate a key for a counter-based random number generator, which computes the random
+/// values for each pixel from this key and the pixel's linear index. Given a `dip::Random` object in an identical
+/// state before calling this function, the output image will be identical, independently of the number of threads
+/// used. `random` is advanced, such that a second call with the same object yields different noise.
 ///
 /// \see dip::UniformRandomGenerator.
 DIP_EXPORT void UniformNoise( Image const& in, Image& out, Random& random, dfloat lowerBound = 0.0, dfloat upperBound = 1.0 );
@@ -611,11 +610,10 @@ inline Image UniformNoise( Image const& in, Random& random, dfloat lowerBound =
 /// for each pixel it does `in += gaussianRandomGenerator( 0, std::sqrt( variance ))`. The output image is of the
 /// same type as the input image.
 ///
-/// `random` is used to generate the random values needed by the first thread. If the algorithm runs in multiple
-/// threads, portions of the image processed by additional threads take their random values from `random.Split()`,
-/// which is essentially a copy of `random` set to a different random stream. Given a `dip::Random` object in an
-/// identical state before calling this function, the output image will be different depending on the number of
-/// threads used.
+/// `random` is used to generate a key for a counter-based random number generator, which computes the random
+/// values for each pixel from this key and the pixel's linear index. Given a `dip::Random` object in an identical
+/// state before calling this function, the output image will be identical, independently of the number of threads
+/// used. `random` is advanced, such that a second call with the same object yields different noise.
 ///
 /// \see dip::GaussianRandomGenerator.
 DIP_EXPORT void GaussianNoise( Image const& in, Image& out, Random& random, dfloat variance = 1.0 );
@@ -635,11 +633,10 @@ inline Image GaussianNoise( Image const& in, Random& random, dfloat variance = 1
 ///
 /// The output image is of the same type as the input image.
 ///
-/// `random` is used to generate the random values needed by the first thread. If the algorithm runs in multiple
-/// threads, portions of the image processed by additional threads take their random values from `random.Split()`,
-/// which is essentially a copy of `random` set to a different random stream. Given a `dip::Random` object in an
-/// identical state before calling this function, the output image will be different depending on the number of
-/// threads used.
+/// `random` is used to generate a key for a counter-based random number generator, which computes the random
+/// values for each pixel from this key and the pixel's linear index. Given a `dip::Random` object in an identical
+/// state before calling this function, the output image will be identical, independently of the number of threads
+/// used. `random` is advanced, such that a second call with the same object yields different noise.
 ///
 /// \see dip::PoissonRandomGenerator.
 DIP_EXPORT void PoissonNoise( Image const& in, Image& out, Random& random, dfloat conversion = 1.0 );
@@ -692,11 +689,10 @@ inline Image PoissonNoise( Image const& in, Random& random, dfloat conversion =
 ///     poissonPoint3 = poissonPoint3 >= threshold;
 /// ```
 ///
-/// `random` is used to generate the random values needed by the first thread. If the algorithm runs in multiple
-/// threads, portions of the image processed by additional threads take their random values from `random.Split()`,
-/// which is essentially a copy of `random` set to a different random stream. Given a `dip::Random` object in an
-/// identical state before calling this function, the output image will be different depending on the number of
-/// threads used.
+/// `random` is used to generate a key for a counter-based random number generator, which computes the random
+/// values for each pixel from this key and the pixel's linear index. Given a `dip::Random` object in an identical
+/// state before calling this function, the output image will be identical, independently of the number of threads
+/// used. `random` is advanced, such that a second call with the same object yields different noise.
 ///
 /// \see dip::BinaryRandomGenerator.
 DIP_EXPORT void BinaryNoise( Image const& in, Image& out, Random& random, dfloat p10 = 0.05, dfloat p01 = 0.05 );
@@ -364,6 +364,7 @@ class DIP_NO_EXPORT GenericImageIterator {
          }
          offset_ = image_->Offset( coords ); // tests for coords to be correct
          coords_ = coords;
+         atEnd_ = false;
       }
 
       /// \brief Return true if the iterator points at a pixel on the edge of the image. If there is a processing
@@ -636,6 +637,7 @@ class DIP_NO_EXPORT GenericJointImageIterator {
             offsets_[ ii ] = images_[ ii ]->Offset( coords );
          }
          coords_ = coords;
+         atEnd_ = false;
       }
 
       /// \brief Return true if the iterator points at a pixel on the edge of the image. If there is a processing
@@ -0,0 +1,161 @@
+/*
+ * DIPlib 3.0
+ * This file contains declarations for lazily evaluated image arithmetic.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_LAZY_H
+#define DIP_LAZY_H
+
+#include <memory>
+
+#include "diplib.h"
+
+
+/// \file
+/// \brief Declares `dip::ImageExpression`, for lazily evaluated, fused pixel-wise arithmetic.
+/// \see diplib/library/operators.h, math_arithmetic
+
+
+namespace dip {
+
+
+/// \addtogroup math_arithmetic
+/// \{
+
+
+/// \brief A pixel-wise arithmetic expression on images, evaluated in a single pass over the data.
+///
+/// The arithmetic operators on `dip::Image` (see `diplib/library/operators.h`) are evaluated immediately: each
+/// operator allocates a new image and passes over all of its pixels. An expression such as `a * b + c / 2`
+/// thus allocates three images and reads and writes each pixel several times. An `%ImageExpression` instead
+/// records the operations, and evaluates them all in a single pass when it is assigned to an image.
+/// Intermediate results are kept in small buffers that fit in the cache, so no temporary images are
+/// allocated.
+///
+/// Create an expression with `dip::Lazy`, and combine it with images, scalars and other expressions using
+/// the arithmetic operators:
+///
+/// ```cpp
+///     dip::Image a, b, c;
+///     // ...
+///     dip::Image out = dip::Lazy( a ) * b + dip::Lazy( c ) / 2;
+/// ```
+///
+/// Only operators with an `%ImageExpression` operand are recorded. Following the usual C++ rules, in
+/// `dip::Lazy( a ) * b + c / 2` the sub-expression `c / 2` only involves an image and a scalar, and is computed
+/// immediately into a temporary image. Each sub-expression that should be evaluated lazily must therefore
+/// contain a `dip::Lazy` operand.
+///
+/// The result is identical to that of the equivalent expression without `dip::Lazy`: each operation is computed
+/// in the data type that the eager operator would have used (`dip::DataType::SuggestArithmetic` for the dyadic
+/// operators), with saturated arithmetic, and the operands are converted to that type in the same way.
+/// Singleton expansion is applied to all images in the expression at once, which leads to the same output
+/// sizes as applying it for each operation.
+///
+/// The supported operations are addition, subtraction, multiplication, division and unary negation (see
+/// `dip::Add`, `dip::Subtract`, `dip::Multiply`, `dip::Divide` and `dip::Invert`). All operations are
+/// sample-wise. Images with a non-scalar tensor can be used, but all of them must have the same tensor shape.
+/// Scalar images are expanded to that shape. Multiplication requires one of its operands to be scalar, because
+/// `dip::Multiply` computes a matrix product for two tensor images.
+///
+/// The expression shares the data of the images it uses, as an image copy does. Modifying their pixel values
+/// before the expression is evaluated thus affects the result.
+class DIP_NO_EXPORT ImageExpression {
+   public:
+      /// \brief The operations that can be recorded in an expression.
+      enum class Operation { Leaf, Add, Subtract, Multiply, Divide, Invert };
+
+      /// \brief An expression that consists of just an image, see `dip::Lazy`.
+      DIP_EXPORT explicit ImageExpression( Image const& image );
+
+      /// \brief An expression that applies `operation` to `lhs` and `rhs`. For `Operation::Invert`, `rhs` is ignored.
+      DIP_EXPORT ImageExpression( Operation operation, ImageExpression const& lhs, ImageExpression const& rhs );
+
+      /// \brief Returns the data type of the result of the expression.
+      dip::DataType DataType() const { return node_->dataType; }
+
+      /// \brief Returns the tensor of the result of the expression.
+      dip::Tensor const& Tensor() const { return node_->tensor; }
+
+      /// \brief Evaluates the expression, writing the result into `out`.
+      ///
+      /// If `out` is protected, the result is converted to its data type. `out` can be one of the images used
+      /// in the expression.
+      DIP_EXPORT void Evaluate( Image& out ) const;
+
+      /// \brief Evaluates the expression, returning a new image.
+      operator Image() const {
+         Image out;
+         Evaluate( out );
+         return out;
+      }
+
+   private:
+      struct Node {
+         Operation operation;
+         dip::DataType dataType;
+         dip::Tensor tensor;
+         Image image;                       // Only for `Operation::Leaf`
+         std::shared_ptr< Node const > lhs; // Not for `Operation::Leaf`
+         std::shared_ptr< Node const > rhs; // Only for dyadic operations
+      };
+      std::shared_ptr< Node const > node_;
+};
+
+/// \brief Starts a lazily evaluated expression, see `dip::ImageExpression`.
+inline ImageExpression Lazy( Image const& image ) {
+   return ImageExpression( image );
+}
+
+//
+// Operators
+//
+
+#define DIP__DEFINE_LAZY_OPERATOR( op, operation ) \
+inline ImageExpression operator op( ImageExpression const& lhs, ImageExpression const& rhs ) { \
+   return ImageExpression( ImageExpression::Operation::operation, lhs, rhs ); } \
+inline ImageExpression operator op( Image const& lhs, ImageExpression const& rhs ) { \
+   return ImageExpression( ImageExpression::Operation::operation, ImageExpression( lhs ), rhs ); } \
+template< typename T > inline ImageExpression operator op( ImageExpression const& lhs, T const& rhs ) { \
+   return ImageExpression( ImageExpression::Operation::operation, lhs, ImageExpression( Image{ rhs } )); } \
+template< typename T > inline ImageExpression operator op( T const& lhs, ImageExpression const& rhs ) { \
+   return ImageExpression( ImageExpression::Operation::operation, ImageExpression( Image{ lhs } ), rhs ); }
+
+/// \brief Lazy arithmetic operator, records a call to `dip::Add`.
+DIP__DEFINE_LAZY_OPERATOR( +, Add )
+
+/// \brief Lazy arithmetic operator, records a call to `dip::Subtract`.
+DIP__DEFINE_LAZY_OPERATOR( -, Subtract )
+
+/// \brief Lazy arithmetic operator, records a call to `dip::Multiply`. One of the operands must be scalar.
+DIP__DEFINE_LAZY_OPERATOR( *, Multiply )
+
+/// \brief Lazy arithmetic operator, records a call to `dip::Divide`.
+DIP__DEFINE_LAZY_OPERATOR( /, Divide )
+
+#undef DIP__DEFINE_LAZY_OPERATOR
+
+/// \brief Lazy unary operator, records a call to `dip::Invert`.
+inline ImageExpression operator-( ImageExpression const& in ) {
+   return ImageExpression( ImageExpression::Operation::Invert, in, in );
+}
+
+/// \}
+
+} // namespace dip
+
+#endif // DIP_LAZY_H
@@ -54,7 +54,7 @@ namespace dip {
 ///
 /// When casting from complex to non-complex, the absolute value of the complex number is taken.
 /// When casting from a floating-point number to an integer, the decimals are truncated, as typically
-/// done in C++.
+/// done in C++. NaN is cast to the lowest value of the integer type.
 /// TODO: Do we want to round the float values instead?
 ///
 /// `%dip::clamp_cast` is defined as a series of overloaded template functions with specializations.
@@ -71,12 +71,13 @@ namespace dip {
 
 
 // Basis of dip::clamp_cast<>
+// The upper limit of T might round up when cast to S (e.g. `sint32` to `sfloat`), so we test for it instead of
+// casting the clamped value. NaN compares false, and so converts to the lower limit.
 template< typename T, typename S >
 constexpr inline const T clamp_both( S const& v ) {
-   return static_cast< T >( clamp(
-         v,
-         static_cast< S >( std::numeric_limits< T >::lowest() ),
-         static_cast< S >( std::numeric_limits< T >::max()    ) ));
+   return v >= static_cast< S >( std::numeric_limits< T >::max() )
+          ? std::numeric_limits< T >::max()
+          : static_cast< T >( std::max( static_cast< S >( std::numeric_limits< T >::lowest() ), v ));
 }
 template< typename T, typename S >
 constexpr inline const T clamp_lower( S const& v ) {   // T is an unsigned integer type with same or more bits than S
@@ -484,6 +485,11 @@ DOCTEST_TEST_CASE("[DIPlib] testing the dip::clamp_cast functions") {
    DOCTEST_CHECK( dip::clamp_cast< dip::uint16 >( dip::sfloat( 1e20 )) == dip::uint16( 65535 ));
    DOCTEST_CHECK( dip::clamp_cast< dip::sint16 >( dip::sfloat( -50 )) == dip::sint16( -50 ));
    DOCTEST_CHECK( dip::clamp_cast< dip::sint16 >( dip::sfloat( 1e20 )) == dip::sint16( 32767 ));
+   DOCTEST_CHECK( dip::clamp_cast< dip::sint32 >( dip::sfloat( 3e9 )) == dip::sint32( 2147483647 ));
+   DOCTEST_CHECK( dip::clamp_cast< dip::sint32 >( std::numeric_limits< dip::sfloat >::infinity() ) == dip::sint32( 2147483647 ));
+   DOCTEST_CHECK( dip::clamp_cast< dip::uint8 >( -std::numeric_limits< dip::dfloat >::infinity() ) == dip::uint8( 0 ));
+   DOCTEST_CHECK( dip::clamp_cast< dip::sint16 >( std::numeric_limits< dip::sfloat >::quiet_NaN() ) == dip::sint16( -32768 ));
+   DOCTEST_CHECK( dip::clamp_cast< dip::uint16 >( std::numeric_limits< dip::dfloat >::quiet_NaN() ) == dip::uint16( 0 ));
    DOCTEST_CHECK( dip::clamp_cast< dip::sfloat >( dip::dcomplex{ 4, 3 } ) == dip::sfloat( 5 ));
    DOCTEST_CHECK( dip::clamp_cast< dip::uint8 >( dip::scomplex{ 4, 3 } ) == dip::uint8( 5 ));
    // Signed/unsigned casts:
@@ -161,6 +161,98 @@ class DIP_EXPORT AlignedAllocInterface : public ExternalInterface {
       }
 };
 
+/// \brief ExternalInterface that recycles the memory of images that are no longer used.
+///
+/// The class is designed as a singleton: `dip::BufferPoolInterface::GetInstance()`
+/// returns a pointer to the unique instance. When an image allocated through this
+/// interface is destroyed, its data segment is not returned to the system, but kept
+/// in the pool, and used again for a later image of similar size. This avoids
+/// the cost of the system allocator and of the page faults on freshly allocated
+/// memory when the same sizes are allocated and freed over and over again, as happens
+/// in per-frame processing pipelines.
+///
+/// Requests are rounded up to one of a set of size classes, with four classes for
+/// each power of two (so that at most 25% of the block is unused). Each thread keeps
+/// a small cache of free blocks up to 1 MiB, which it can use without locking; other
+/// blocks are kept in a pool shared by all threads. All blocks are aligned to 64 bytes.
+///
+/// The total size of the free blocks kept is limited by `SetMemoryLimit` (256 MiB by
+/// default); a block that would exceed the limit is returned to the system instead.
+///
+/// Use `UseAsDefaultAllocator` to have `dip::Image::Forge` use the pool for all images
+/// that do not have an external interface set, including the temporary images created
+/// internally by all library functions:
+/// ```cpp
+///     dip::BufferPoolInterface::UseAsDefaultAllocator( true );
+/// ```
+///
+/// Alternatively, set it as the external interface for specific images:
+/// ```cpp
+///     dip::Image img;
+///     img.SetExternalInterface( dip::BufferPoolInterface::GetInstance() );
+/// ```
+class DIP_EXPORT BufferPoolInterface : public ExternalInterface {
+   private:
+      // Private constructor to enforce the singleton interface
+      BufferPoolInterface() = default;
+
+   public:
+      /// \brief Usage statistics for the pool, see `dip::BufferPoolInterface::GetStatistics`.
+      struct Statistics {
+         dip::uint hits = 0;           ///< Number of allocations served with a recycled block.
+         dip::uint misses = 0;         ///< Number of allocations that obtained a new block from the system.
+         dip::uint bytesInUse = 0;     ///< Total size of the blocks currently in use.
+         dip::uint peakBytesInUse = 0; ///< Largest value of `bytesInUse` since the last reset.
+         dip::uint bytesCached = 0;    ///< Total size of the free blocks kept for recycling.
+      };
+
+      /// Allocates the data for an image, with normal strides.
+      virtual DataSegment AllocateData(
+            void*& origin,
+            dip::DataType dataType,
+            UnsignedArray const& sizes,
+            IntegerArray& strides,
+            dip::Tensor const& tensor,
+            dip::sint& tensorStride
+      ) override;
+
+      /// Allocates a block of at least `bytes` bytes. The block is recycled when the last
+      /// `dip::DataSegment` referencing it is destroyed.
+      DataSegment Allocate( dip::uint bytes );
+
+      /// Sets the maximum total size, in bytes, of the free blocks kept for recycling.
+      /// Free blocks beyond the new limit are returned to the system.
+      void SetMemoryLimit( dip::uint bytes );
+
+      /// Returns the maximum total size, in bytes, of the free blocks kept for recycling.
+      dip::uint MemoryLimit() const;
+
+      /// Enables or disables the use of transparent huge pages for newly allocated blocks
+      /// of 2 MiB or larger. This reduces the number of page faults and TLB misses for large
+      /// images. It is disabled by default, and is ignored on systems other than Linux.
+      void SetHugePages( bool enable );
+
+      /// Returns the free blocks in the shared pool and in the calling thread's cache to the system.
+      void Release();
+
+      /// Returns the usage statistics.
+      Statistics GetStatistics() const;
+
+      /// Resets the hit and miss counts, and sets the peak usage to the current usage.
+      void ResetStatistics();
+
+      /// Singleton interface.
+      static BufferPoolInterface* GetInstance();
+
+      /// Sets whether `dip::Image::Forge` uses the pool for images that do not have an
+      /// external interface set. It is disabled by default.
+      static void UseAsDefaultAllocator( bool enable );
+
+      /// Returns true if `dip::Image::Forge` uses the pool for images that do not have an
+      /// external interface set.
+      static bool IsDefaultAllocator();
+};
+
 
 //
 // Functor that converts indices or offsets to coordinates.
@@ -35,6 +35,7 @@
 #include <string>
 #include <set>
 #include <cctype>
+#include <limits>
 
 #include "diplib/library/dimension_array.h"
 
@@ -98,6 +98,11 @@ DIP_EXPORT OneDimensionalFilterArray SeparateFilter( Image const& filter );
 ///
 /// `boundaryCondition` indicates how the boundary should be expanded in each dimension. See `dip::BoundaryCondition`.
 ///
+/// When the filters are large enough that the convolution is cheaper through the Fourier domain,
+/// `dip::OverlapSaveConvolution` is called with the equivalent non-separated filter. This is not done for the
+/// `"add max"` and `"add min"` boundary conditions, which would yield a different result when the image is
+/// extended only once instead of before each 1D filter.
+///
 /// \see dip::SeparateFilter, dip::GeneralConvolution, dip::ConvolveFT, dip::Framework::Separable
 DIP_EXPORT void SeparableConvolution(
       Image const& in,                    ///< Input image
@@ -129,7 +134,9 @@ inline Image SeparableConvolution(
 /// to `"frequency"`. Similarly, if `outRepresentation` is `"frequency"`, the output will not be
 /// inverse-transformed, so will be in the frequency domain.
 ///
-/// \see dip::GeneralConvolution, dip::SeparableConvolution
+/// For large images, `dip::OverlapSaveConvolution` uses less memory.
+///
+/// \see dip::GeneralConvolution, dip::SeparableConvolution, dip::OverlapSaveConvolution
 DIP_EXPORT void ConvolveFT(
       Image const& in,
       Image const& filter,
@@ -150,6 +157,47 @@ inline Image ConvolveFT(
    return out;
 }
 
+/// \brief Applies a convolution with a filter kernel (PSF) by multiplication in the Fourier domain, block by block.
+///
+/// The image is divided into blocks, and each block, together with the neighboring pixels needed to compute
+/// the convolution, is convolved with `filter` through the Fourier domain (the overlap-save method). The
+/// filter is transformed only once, and the blocks are processed in parallel. Compared to `dip::ConvolveFT`,
+/// this needs much less memory for large images, uses transform sizes that are efficient for the FFT, and
+/// is faster when `filter` is much smaller than `in`.
+///
+/// `filter` must be a scalar image, and must be equal in size or smaller than `in`. As elsewhere, the origin
+/// of `filter` is in the middle of the image, on the pixel to the right of the center in case of an even-sized
+/// image. If both `in` and `filter` are real, `out` will be real too, otherwise it will have a complex type.
+///
+/// `boundaryCondition` indicates how the boundary should be expanded in each dimension. See `dip::BoundaryCondition`.
+/// The input image is extended once, which requires a copy of the image that is larger by the filter size.
+///
+/// `blockSizes` are the sizes of the blocks that are transformed, including the `filter.Size( ii ) - 1` pixels
+/// of overlap with neighboring blocks. They are increased to a size that the FFT can transform efficiently.
+/// If an element is 0, or the array is empty, the block size is chosen automatically.
+///
+/// `dip::GeneralConvolution` and `dip::SeparableConvolution` use this method when the filter is large enough
+/// for it to be faster than the direct computation.
+///
+/// \see dip::ConvolveFT, dip::GeneralConvolution, dip::SeparableConvolution
+DIP_EXPORT void OverlapSaveConvolution(
+      Image const& in,
+      Image const& filter,
+      Image& out,
+      StringArray const& boundaryCondition = {},
+      UnsignedArray const& blockSizes = {}
+);
+inline Image OverlapSaveConvolution(
+      Image const& in,
+      Image const& filter,
+      StringArray const& boundaryCondition = {},
+      UnsignedArray const& blockSizes = {}
+) {
+   Image out;
+   OverlapSaveConvolution( in, filter, out, boundaryCondition, blockSizes );
+   return out;
+}
+
 /// \brief Applies a convolution with a filter kernel (PSF) by direct implementation of the convolution sum.
 ///
 /// `filter` is an image, and must be equal in size or smaller than `in`. `filter` must be real-valued.
@@ -160,7 +208,9 @@ inline Image ConvolveFT(
 /// Note that this is a really expensive way to compute the convolution for any `filter` that has more than a
 /// small amount of non-zero values. It is always advantageous to try to separate your filter into a set of 1D
 /// filters (see `dip::SeparateFilter` and `dip::SeparableConvolution`). If this is not possible, use
-/// `dip::ConvolveFT` with larger filters to compute the convolution in the Fourier domain.
+/// `dip::ConvolveFT` with larger filters to compute the convolution in the Fourier domain. When the filter is
+/// large enough, this function calls `dip::OverlapSaveConvolution`, except for the `"add max"` and `"add min"`
+/// boundary conditions.
 ///
 /// Also, if all non-zero filter weights have the same value, `dip::Uniform` implements a more efficient
 /// algorithm. If `filter` is a binary image, `dip::Uniform` is called.
@@ -250,6 +300,19 @@ inline Image GaussFIR(
    return out;
 }
 
+/// \brief Returns the size of the boundary extension along each dimension that `dip::GaussFIR` needs to compute
+/// the edge pixels of an image of dimensionality `nDims`.
+///
+/// The parameters `sigmas`, `derivativeOrder` and `truncation` are as for `dip::GaussFIR`. This is the number of
+/// pixels beyond each side of a region that influence the filter result within that region, which is useful,
+/// for example, to determine the border needed by `dip::ImageProcessBlockwise`.
+DIP_EXPORT UnsignedArray GaussFIRBoundary(
+      FloatArray sigmas,
+      UnsignedArray derivativeOrder,
+      dip::uint nDims,
+      dfloat truncation = 3
+);
+
 /// \brief Fourier implementation of the Gaussian filter and its derivatives
 ///
 /// Convolves the image with a Gaussian kernel by multiplication in the Fourier domain.
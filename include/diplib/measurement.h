@@ -22,6 +22,7 @@
 #define DIP_MEASUREMENT_H
 
 #include <map>
+#include <memory>
 
 #include "diplib.h"
 #include "diplib/accumulators.h"
@@ -93,6 +94,49 @@ using ValueInformationArray = std::vector< ValueInformation >;
 /// \brief Maps object IDs to object indices
 using ObjectIdToIndexMap = std::map< dip::uint, dip::uint >;
 
+/// \brief Looks up object indices given object IDs, for use in measurement features that process
+/// each pixel of an image.
+///
+/// If the object IDs are compact (at least one fourth of the IDs between 0 and the largest ID are in the map),
+/// this class builds a table indexed by object ID, and lookups take constant time. Otherwise, lookups search
+/// the `dip::ObjectIdToIndexMap` it was constructed from, which must outlive this object.
+class DIP_NO_EXPORT ObjectIdToIndexLookup {
+   public:
+      explicit ObjectIdToIndexLookup( ObjectIdToIndexMap const& map ) : map_( map ) {
+         if( !map.empty() ) {
+            dip::uint maxID = map.rbegin()->first;
+            if( maxID / 4 <= map.size() ) {
+               table_.resize( maxID + 1, NotFound() );
+               for( auto const& element : map ) {
+                  table_[ element.first ] = element.second;
+               }
+            }
+         }
+      }
+
+      /// \brief Finds the index for `objectID`, returns false if the object ID is not in the map.
+      bool Find( dip::uint objectID, dip::uint& index ) const {
+         if( !table_.empty() ) {
+            if( objectID >= table_.size() ) {
+               return false;
+            }
+            index = table_[ objectID ];
+            return index != NotFound();
+         }
+         auto it = map_.find( objectID );
+         if( it == map_.end() ) {
+            return false;
+         }
+         index = it->second;
+         return true;
+      }
+
+   private:
+      static constexpr dip::uint NotFound() { return std::numeric_limits< dip::uint >::max(); }
+      ObjectIdToIndexMap const& map_;
+      std::vector< dip::uint > table_;
+};
+
 /// \brief Contains measurement results, as obtained through `dip::MeasurementTool::Measure`.
 ///
 /// \ingroup measurement
@@ -400,8 +444,7 @@ class DIP_NO_EXPORT Measurement {
       void AddObjectIDs( UnsignedArray const& objectIDs ) {
          DIP_THROW_IF( IsForged(), E::MEASUREMENT_NOT_RAW );
          for( auto const& objectID : objectIDs ) {
-            DIP_THROW_IF( ObjectExists( objectID ), "Object already present: " + std::to_string( objectID ));
-            AddObjectID_( objectID );
+            DIP_THROW_IF( !AddObjectID_( objectID ), "Object already present: " + std::to_string( objectID ));
          }
       }
 
@@ -578,10 +621,16 @@ class DIP_NO_EXPORT Measurement {
          features_.emplace_back( name, startIndex, n );
          featureIndices_.emplace( name, index );
       }
-      void AddObjectID_( dip::uint objectID ) {
+      // Returns false if the object ID was already present
+      bool AddObjectID_( dip::uint objectID ) {
          dip::uint index = objects_.size();
+         dip::uint size = objectIndices_.size();
+         objectIndices_.emplace_hint( objectIndices_.end(), objectID, index ); // constant time if IDs are added in increasing order
+         if( objectIndices_.size() == size ) {
+            return false;
+         }
          objects_.push_back( objectID );
-         objectIndices_.emplace( objectID, index );
+         return true;
       }
       UnsignedArray objects_;                         // the rows of the table (maps row indices to objectIDs)
       ObjectIdToIndexMap objectIndices_;              // maps object IDs to row indices
@@ -662,7 +711,8 @@ class DIP_EXPORT LineBased : public Base {
       LineBased( Information const& information ) : Base( information, Type::LINE_BASED ) {};
 
       /// \brief Called once for each image line, to accumulate information about each object.
-      /// This function is not called in parallel, and hence does not need to be thread-safe.
+      /// This function is not called in parallel on the same feature instance (each thread works on its own
+      /// `Clone()`), and hence does not need to be thread-safe.
       ///
       /// The two line iterators can always be incremented exactly the same number of times.
       /// `coordinates[ dimension ]` should be incremented at the same time, if coordinate
@@ -673,16 +723,37 @@ class DIP_EXPORT LineBased : public Base {
       /// elements, where measurements are accumulated. The `dip::Feature::LineBased::Finish`
       /// function is called after the whole image has been scanned, and should provide the
       /// final measurement result for one object given its index (not object ID).
+      ///
+      /// \note In earlier versions, `objectIndices` was a `dip::ObjectIdToIndexMap const&`. To update a
+      /// user-defined feature, change the type of this parameter, and replace lookups of the form
+      /// `auto it = objectIndices.find( objectID ); if( it != objectIndices.end() ) { index = it->second; ... }`
+      /// with `if( objectIndices.Find( objectID, index )) { ... }`.
       virtual void ScanLine(
             LineIterator< uint32 > label, ///< Pointer to the line in the labeled image (always scalar)
             LineIterator< dfloat > grey, ///< Pointer to the line in the grey-value image (if given, invalid otherwise)
             UnsignedArray coordinates, ///< Coordinates of the first pixel on the line (by copy, so it can be modified)
             dip::uint dimension, ///< Along which dimension the line runs
-            ObjectIdToIndexMap const& objectIndices ///< A map from objectID (label) to index
+            ObjectIdToIndexLookup const& objectIndices ///< Looks up the index given the objectID (label)
       ) = 0;
 
       /// \brief Called once for each object, to finalize the measurement
       virtual void Finish( dip::uint objectIndex, Measurement::ValueIterator output ) = 0;
+
+      /// \brief Creates a copy of the feature, with its own accumulators, so that the image can be scanned
+      /// in parallel.
+      ///
+      /// The `dip::MeasurementTool` calls this function after `Initialize`, once for each additional thread. Each
+      /// thread calls `ScanLine` on its own copy, for a subset of the image lines. `Reduce` is then called on
+      /// the original feature with each of the copies, after which `Finish` is called on the original feature.
+      ///
+      /// The default implementation returns a null pointer, meaning that the feature cannot be used in parallel.
+      /// If any of the line-based features requested does not support parallel use, the image is scanned in
+      /// a single thread.
+      virtual std::unique_ptr< LineBased > Clone() const { return nullptr; }
+
+      /// \brief Merges the measurements accumulated in `other`, a copy of this feature obtained through `Clone`,
+      /// into the accumulators of this feature.
+      virtual void Reduce( LineBased& /*other*/ ) {}
 };
 
 /// \brief The pure virtual base class for all image-based measurement features.
@@ -887,6 +958,10 @@ class DIP_NO_EXPORT MeasurementTool {
       /// the `label` image into account. Those of `grey` are ignored. Some measurements require
       /// isotropic pixel sizes, if `label` is not isotropic, the pixel size is ignored and these
       /// measures will return values in pixels instead.
+      ///
+      /// The line-based features are computed in parallel, each thread accumulating values for a portion of the
+      /// image lines, which are merged at the end. Because the order in which values are summed can differ between
+      /// runs, the last digits of some floating-point measurements can differ too.
       DIP_EXPORT Measurement Measure(
             Image const& label,
             Image const& grey,
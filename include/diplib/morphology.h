@@ -249,6 +249,30 @@ class DIP_NO_EXPORT StructuringElement {
       /// \brief Returns the structuring element parameters, not adjusted to image dimensionality.
       FloatArray const& Params() const { return params_; }
 
+      /// \brief Returns the size of the boundary extension along each dimension that is necessary to accommodate
+      /// the structuring element on the edge pixels of an image of dimensionality `nDims`.
+      ///
+      /// Parabolic structuring elements have an unbounded support, and cause an exception to be thrown.
+      UnsignedArray Boundary( dip::uint nDims ) const {
+         DIP_THROW_IF( shape_ == ShapeCode::PARABOLIC, "Parabolic structuring elements have an unbounded support" );
+         FloatArray params;
+         if( IsCustom() ) {
+            DIP_THROW_IF( image_.Dimensionality() > nDims, E::DIMENSIONALITIES_DONT_MATCH );
+            params = FloatArray{ image_.Sizes() };
+            params.resize( nDims, 1 );
+         } else {
+            params = params_;
+            DIP_START_STACK_TRACE
+               ArrayUseParameter( params, nDims, 1.0 );
+            DIP_END_STACK_TRACE
+         }
+         UnsignedArray boundary( nDims );
+         for( dip::uint ii = 0; ii < nDims; ++ii ) {
+            boundary[ ii ] = static_cast< dip::uint >( std::ceil( std::abs( params[ ii ] ) / 2.0 ));
+         }
+         return boundary;
+      }
+
       /// \brief Returns the structuring element shape
       ShapeCode Shape() const { return shape_; }
 
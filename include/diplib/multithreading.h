@@ -22,6 +22,9 @@
 #ifndef DIP_MULTITHREADING_H
 #define DIP_MULTITHREADING_H
 
+#include <functional>
+#include <mutex>
+
 #include "diplib/library/types.h"
 
 #ifdef _OPENMP
@@ -30,6 +33,7 @@
 // We don't have OpenMP, these are OpenMP function stubs to avoid conditional compilation elsewhere.
 inline int omp_get_thread_num() { return 0; }
 inline int omp_get_max_threads() { return 1; }
+inline void omp_set_num_threads( int ) {}
 #endif
 
 
@@ -50,13 +54,17 @@ namespace dip {
 /// number of CPU cores otherwise.
 ///
 /// Note that parallelized algorithms only spawn multiple threads for the computation if the amount of work
-/// to be done is large enough to compensate for the overhead of spawning threads.
+/// to be done is large enough to compensate for the overhead of spawning threads. See `dip::OptimalNumberOfThreads`.
 ///
 /// If `nThreads` is 1, disables multithreading within DIPlib. Usually it is more beneficial to manage multithreading
 /// at a higher level, for example by processing multiple images at the same time. If yo do so, set `nThreads` to 1.
 ///
 /// If `nThreads` is 0, resets the maximum number of threads to the default value.
 ///
+/// The frameworks and other parallel algorithms run on a persistent pool of worker threads owned by the library
+/// (see `dip::ParallelExecute`). Worker threads are created when first needed, and live until the program ends
+/// or until this function is called with a smaller number of threads than there are workers in the pool.
+///
 /// If DIPlib was compiled without OpenMP support, this function does nothing.
 DIP_EXPORT void SetNumberOfThreads( dip::uint nThreads );
 
@@ -70,11 +78,129 @@ DIP_EXPORT void SetNumberOfThreads( dip::uint nThreads );
 DIP_EXPORT dip::uint GetNumberOfThreads();
 
 
-// Undocumented constant: how many operations (clock cycles) it takes to make it worth going into multiple threads.
-// (experimentally determined on Cris' computer, might be different elsewhere).
-// I also noticed that going to 2 threads or 4 threads does not make a huge difference in overhead, so this is a
-// threshold for single vs multithreaded computation, not a threshold per thread created.
-constexpr dip::uint threadingThreshold = 70000;
+/// \brief Describes the cost of parallel computation on the host machine, used to decide how many threads
+/// to use for a computation.
+///
+/// Algorithms estimate the number of operations (roughly, clock cycles) a computation will take. Using `N`
+/// threads, the computation takes an estimated `operations * operationTime / N + ( N - 1 ) * threadStartTime`
+/// seconds. `dip::OptimalNumberOfThreads` minimizes this expression over `N`.
+///
+/// The default values correspond to a threshold of about 70,000 operations for using two threads, which was
+/// experimentally determined on one particular machine. Use `dip::CalibrateThreadingCostModel` to measure
+/// these values on the host machine, or `dip::SetThreadingCostModel` to set them explicitly.
+///
+/// \see dip::GetThreadingCostModel, dip::SetThreadingCostModel, dip::CalibrateThreadingCostModel
+struct ThreadingCostModel {
+   dfloat operationTime = 0.3e-9;              ///< Time, in seconds, taken by one operation.
+   dfloat threadStartTime = 35000 * 0.3e-9;    ///< Time, in seconds, added for each additional thread in a parallel section.
+
+   /// \brief The overhead of using `nThreads` threads instead of one, expressed as a number of operations.
+   dip::uint Overhead( dip::uint nThreads ) const {
+      if(( nThreads <= 1 ) || ( operationTime <= 0 )) {
+         return 0;
+      }
+      return static_cast< dip::uint >( static_cast< dfloat >( nThreads - 1 ) * threadStartTime / operationTime + 0.5 );
+   }
+};
+
+/// \brief Returns the cost model currently used to decide how many threads to use.
+///
+/// If the environment variable `DIP_THREADING_COST_MODEL` is set when this function is first called (directly
+/// or through any parallelized algorithm), it is taken as the name of a file to read the model from (see
+/// `dip::LoadThreadingCostModel`). If that file does not exist, the model is calibrated
+/// (see `dip::CalibrateThreadingCostModel`) and written to that file, so that the calibration happens only once
+/// on each machine. Otherwise, the default values are used.
+DIP_EXPORT ThreadingCostModel GetThreadingCostModel();
+
+/// \brief Overrides the cost model used to decide how many threads to use.
+DIP_EXPORT void SetThreadingCostModel( ThreadingCostModel const& model );
+
+/// \brief Measures the thread start-up cost and per-operation cost on the host machine, and sets the result as
+/// the cost model used to decide how many threads to use.
+///
+/// The measurement takes a fraction of a second. If `filename` is not empty, the model is written to that file,
+/// see `dip::SaveThreadingCostModel`. Returns the new model.
+DIP_EXPORT ThreadingCostModel CalibrateThreadingCostModel( String const& filename = "" );
+
+/// \brief Writes the current cost model to a text file, to be read with `dip::LoadThreadingCostModel`.
+DIP_EXPORT void SaveThreadingCostModel( String const& filename );
+
+/// \brief Reads a cost model from a text file written by `dip::SaveThreadingCostModel`, and sets it as the
+/// cost model used to decide how many threads to use. Returns `false` if the file could not be read, in which
+/// case the cost model is not changed.
+DIP_EXPORT bool LoadThreadingCostModel( String const& filename );
+
+/// \brief Determines how many threads to use for a computation that takes `operations` operations, using
+/// at most `maxThreads` threads.
+///
+/// The number of threads is chosen such that the estimated computation time, according to the current
+/// `dip::ThreadingCostModel`, is minimal. The result is 1 for small computations, and increases as the
+/// square root of `operations` up to `maxThreads`.
+DIP_EXPORT dip::uint OptimalNumberOfThreads( dip::uint operations, dip::uint maxThreads );
+
+
+/// \brief Calls `function` from up to `nThreads` threads simultaneously, using *DIPlib*'s persistent thread pool.
+///
+/// `function` is called with the thread index as argument, in the range 0 to `nThreads - 1`. Thread 0 is
+/// always the calling thread, the other indices are executed by worker threads from the pool. This function
+/// returns when all calls to `function` have returned. Threads are not started and stopped on each call,
+/// they wait for work in between calls, so the overhead of a parallel section is small.
+///
+/// If the pool is already in use (for example when this function is called from within `function`, or
+/// from two user threads at the same time), `function` is called only for thread 0, in the calling thread.
+/// For this reason, the work should be distributed using a `dip::WorkDistributor` object, which
+/// allows any thread to take over the work not yet done by the others. Memory allocated for each thread
+/// can still be indexed by the thread index.
+///
+/// If `function` throws an exception in any of the threads, the first one is re-thrown in the calling thread
+/// after all threads have finished.
+DIP_EXPORT void ParallelExecute( dip::uint nThreads, std::function< void( dip::uint ) > const& function );
+
+
+/// \brief Distributes a range of work items among threads, with dynamic load balancing through work stealing.
+///
+/// The range `[0, nItems)` is initially split into `nThreads` equal contiguous parts, one per thread. Each thread
+/// repeatedly calls `Next` to obtain a chunk of work from its own part. Chunks shrink as a thread's part empties,
+/// so that the load can be balanced at the end. When a thread's own part is empty, it steals half of the remaining
+/// items from another thread's part. `Next` returns `false` only when all work has been handed out.
+///
+/// Work items are meant to be image lines or other small units of work, adjacent items are handed out together
+/// such that threads process contiguous blocks of memory.
+///
+/// ```cpp
+///     dip::WorkDistributor work( nLines, nThreads );
+///     dip::ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+///        dip::uint begin, end;
+///        while( work.Next( thread, begin, end )) {
+///           for( dip::uint ii = begin; ii < end; ++ii ) {
+///              // process line `ii`
+///           }
+///        }
+///     } );
+/// ```
+class DIP_EXPORT WorkDistributor {
+   public:
+      /// \brief Prepares the distribution of `nItems` work items among `nThreads` threads. Each chunk handed out will
+      /// have at least `minChunkSize` items, except the last one in each part.
+      WorkDistributor( dip::uint nItems, dip::uint nThreads, dip::uint minChunkSize = 1 );
+
+      /// \brief Gets the next chunk of work for thread `thread`, in the form of a half-open range `[begin, end)`.
+      /// Returns `false` if there is no more work left.
+      bool Next( dip::uint thread, dip::uint& begin, dip::uint& end );
+
+   private:
+      struct Part {
+         std::mutex mutex;
+         dip::uint begin = 0;
+         dip::uint end = 0;
+         char padding[ 64 ]; // avoid false sharing between threads
+      };
+      std::vector< Part > parts_;
+      dip::uint minChunkSize_;
+
+      // Takes a chunk from the front of `part`, assumes `part.mutex` is locked
+      bool TakeChunk( Part& part, dip::uint& begin, dip::uint& end );
+};
 
 /// \}
 
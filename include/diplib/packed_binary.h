@@ -0,0 +1,231 @@
+/*
+ * DIPlib 3.0
+ * This file contains declarations for bit-packed binary images and the filters that operate on them.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_PACKED_BINARY_H
+#define DIP_PACKED_BINARY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "diplib.h"
+
+
+/// \file
+/// \brief Declares `dip::PackedBinaryImage`, a binary image that stores 64 pixels in each machine word,
+/// and the binary filters that operate on it.
+/// \see binary
+
+
+namespace dip {
+
+
+/// \addtogroup binary
+/// \{
+
+
+/// \brief A binary image that stores one bit per pixel.
+///
+/// A `dip::Image` of type `dip::DT_BIN` uses one byte per pixel. A `%PackedBinaryImage` stores the image
+/// lines along the first dimension (the rows) as sequences of 64-bit words, each word holding 64 consecutive
+/// pixels. Bit `ii` of word `jj` in a row is the pixel with coordinate `jj * 64 + ii` along the first dimension.
+/// Each row starts at a new word, the unused bits at the end of each row are always zero. The rows are stored
+/// in linear order, with the second dimension varying fastest.
+///
+/// The binary filters that take a `%PackedBinaryImage` as input (`dip::BinaryDilation`, `dip::BinaryErosion`,
+/// `dip::BinaryPropagation`, `dip::CountNeighbors` and `dip::Label`) process 64 pixels with each machine
+/// instruction, and use 8 times less memory bandwidth than the corresponding functions on a `dip::DT_BIN`
+/// image. Their results are identical. When applying a sequence of binary operations, convert the image once
+/// and convert the result back with `Unpack`.
+///
+/// ```cpp
+///     dip::Image binary = ...;
+///     dip::PackedBinaryImage packed( binary );
+///     packed = dip::BinaryErosion( dip::BinaryDilation( packed, 2, 5 ), 2, 5 );
+///     dip::Image result = packed.Unpack();
+/// ```
+///
+/// The image must have at least one dimension. It has no tensor, color space or pixel size.
+class DIP_NO_EXPORT PackedBinaryImage {
+   public:
+      /// \brief The type of a word holding 64 pixels.
+      using Word = std::uint64_t;
+
+      /// \brief The number of pixels stored in each word.
+      static constexpr dip::uint bitsPerWord = 64;
+
+      /// \brief An empty image.
+      PackedBinaryImage() = default;
+
+      /// \brief A new image of the given sizes, with all pixels set to 0.
+      DIP_EXPORT explicit PackedBinaryImage( UnsignedArray const& sizes );
+
+      /// \brief Packs the scalar, binary image `binary`.
+      DIP_EXPORT explicit PackedBinaryImage( Image const& binary );
+
+      /// \brief Returns true if the image has been allocated.
+      bool IsForged() const { return !sizes_.empty(); }
+
+      /// \brief Returns the sizes of the image.
+      UnsignedArray const& Sizes() const { return sizes_; }
+
+      /// \brief Returns the number of dimensions.
+      dip::uint Dimensionality() const { return sizes_.size(); }
+
+      /// \brief Returns the number of pixels.
+      dip::uint NumberOfPixels() const { return sizes_.product(); }
+
+      /// \brief Returns the number of rows, the product of all sizes except the first one.
+      dip::uint NumberOfRows() const { return wordsPerRow_ == 0 ? 0 : data_.size() / wordsPerRow_; }
+
+      /// \brief Returns the number of words used to store each row.
+      dip::uint WordsPerRow() const { return wordsPerRow_; }
+
+      /// \brief Returns a pointer to the first word of row `row`.
+      Word* Row( dip::uint row ) { return data_.data() + row * wordsPerRow_; }
+
+      /// \brief Returns a pointer to the first word of row `row`.
+      Word const* Row( dip::uint row ) const { return data_.data() + row * wordsPerRow_; }
+
+      /// \brief Returns the value of the pixel at the given coordinates.
+      bool At( UnsignedArray const& coords ) const {
+         DIP_ASSERT( coords.size() == sizes_.size() );
+         dip::uint row = 0;
+         for( dip::uint ii = sizes_.size() - 1; ii > 0; --ii ) {
+            row = row * sizes_[ ii ] + coords[ ii ];
+         }
+         return (( Row( row )[ coords[ 0 ] / bitsPerWord ] >> ( coords[ 0 ] % bitsPerWord )) & 1u ) != 0;
+      }
+
+      /// \brief Returns the number of set pixels.
+      DIP_EXPORT dip::uint Count() const;
+
+      /// \brief Unpacks the image into the scalar, binary image `out`.
+      DIP_EXPORT void Unpack( Image& out ) const;
+      Image Unpack() const {
+         Image out;
+         Unpack( out );
+         return out;
+      }
+
+      /// \brief Compares two images, returns true if they have the same sizes and pixel values.
+      bool operator==( PackedBinaryImage const& other ) const {
+         return ( sizes_ == other.sizes_ ) && ( data_ == other.data_ );
+      }
+
+      /// \brief Compares two images, returns true if they differ in sizes or pixel values.
+      bool operator!=( PackedBinaryImage const& other ) const {
+         return !( *this == other );
+      }
+
+   private:
+      UnsignedArray sizes_;
+      dip::uint wordsPerRow_ = 0;
+      std::vector< Word > data_;
+};
+
+/// \brief Binary morphological dilation operation on a bit-packed image.
+///
+/// Computes the same result as `dip::BinaryDilation` does for the unpacked image. All connectivities are
+/// supported; alternating connectivity is only implemented for 2D and 3D images.
+DIP_EXPORT PackedBinaryImage BinaryDilation(
+      PackedBinaryImage const& in,
+      dip::sint connectivity = -1,
+      dip::uint iterations = 3,
+      String const& edgeCondition = S::BACKGROUND
+);
+
+/// \brief Binary morphological erosion operation on a bit-packed image.
+///
+/// Computes the same result as `dip::BinaryErosion` does for the unpacked image. All connectivities are
+/// supported; alternating connectivity is only implemented for 2D and 3D images.
+DIP_EXPORT PackedBinaryImage BinaryErosion(
+      PackedBinaryImage const& in,
+      dip::sint connectivity = -1,
+      dip::uint iterations = 3,
+      String const& edgeCondition = S::OBJECT
+);
+
+/// \brief Binary morphological propagation (reconstruction by dilation) on bit-packed images.
+///
+/// Computes the same result as `dip::BinaryPropagation` does for the unpacked images. `inSeed` can be
+/// a default-initialized (not forged) image, meaning that there are no seeds. Otherwise it must have the
+/// same sizes as `inMask`.
+///
+/// When `iterations` is 0 and the connectivity is not alternating, the propagation is computed with
+/// alternating forward and backward raster scans, which propagate each seed across a whole object in one
+/// or a few scans.
+DIP_EXPORT PackedBinaryImage BinaryPropagation(
+      PackedBinaryImage const& inSeed,
+      PackedBinaryImage const& inMask,
+      dip::sint connectivity = 1,
+      dip::uint iterations = 0,
+      String const& edgeCondition = S::BACKGROUND
+);
+
+/// \brief Counts the number of set neighbors for each pixel in the bit-packed image `in`.
+///
+/// Computes the same `dip::DT_UINT8` image as `dip::CountNeighbors` does for the unpacked image. The
+/// counts for 64 pixels are accumulated at once, in bit-sliced counters.
+DIP_EXPORT void CountNeighbors(
+      PackedBinaryImage const& in,
+      Image& out,
+      dip::uint connectivity = 0,
+      dip::String const& mode = S::FOREGROUND,
+      dip::String const& edgeCondition = S::BACKGROUND
+);
+inline Image CountNeighbors(
+      PackedBinaryImage const& in,
+      dip::uint connectivity = 0,
+      dip::String const& mode = S::FOREGROUND,
+      dip::String const& edgeCondition = S::BACKGROUND
+) {
+   Image out;
+   CountNeighbors( in, out, connectivity, mode, edgeCondition );
+   return out;
+}
+
+/// \brief Labels the connected components in the bit-packed image `binary`.
+///
+/// Computes the same labeled image as `dip::Label` does for the unpacked image (with default boundary
+/// conditions; periodic boundaries are not supported). The runs of set pixels along each row are extracted
+/// a word at a time, and connected to the overlapping runs in neighboring rows, so that the work done depends
+/// on the number of runs rather than the number of pixels.
+DIP_EXPORT dip::uint Label(
+      PackedBinaryImage const& binary,
+      Image& out,
+      dip::uint connectivity = 0,
+      dip::uint minSize = 0,
+      dip::uint maxSize = 0
+);
+inline Image Label(
+      PackedBinaryImage const& binary,
+      dip::uint connectivity = 0,
+      dip::uint minSize = 0,
+      dip::uint maxSize = 0
+) {
+   Image out;
+   Label( binary, out, connectivity, minSize, maxSize );
+   return out;
+}
+
+/// \}
+
+} // namespace dip
+
+#endif // DIP_PACKED_BINARY_H
@@ -21,6 +21,8 @@
 #ifndef DIP_PIXEL_TABLE_H
 #define DIP_PIXEL_TABLE_H
 
+#include <algorithm>
+
 #include "diplib.h"
 
 
@@ -288,7 +290,7 @@ class DIP_NO_EXPORT PixelTable {
          ShiftOrigin( offset );
       }
 
-      /// \brief Mirrors the neighborhood.
+      /// \brief Mirrors the neighborhood. The weights, if any, are mirrored together with the pixel locations.
       void Mirror() {
          dip::uint nDims = sizes_.size();
          IntegerArray origin( nDims, std::numeric_limits< dip::sint >::max() );
@@ -300,6 +302,14 @@ class DIP_NO_EXPORT PixelTable {
             }
          }
          origin_ = origin;
+         if( HasWeights() ) {
+            // The weights of each run are now in reverse order
+            auto it = weights_.begin();
+            for( auto const& run : runs_ ) {
+               std::reverse( it, it + static_cast< dip::sint >( run.length ));
+               it += static_cast< dip::sint >( run.length );
+            }
+         }
       }
 
       /// Returns the number of pixels in the neighborhood
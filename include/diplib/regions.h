@@ -54,6 +54,10 @@ namespace dip {
 ///
 /// The boundary conditions are generally ignored (labeling stops at the boundary). The exception
 /// is `"periodic"`, which is the only one that makes sense for this algorithm.
+///
+/// For large images, the first pass of the algorithm is computed in parallel on slabs of the image, whose
+/// labels are then merged. The output is identical to that of the single-threaded algorithm: labels are
+/// consecutive and assigned in the order in which objects are first encountered in the image.
 DIP_EXPORT dip::uint Label(
       Image const& binary,
       Image& out,
@@ -425,10 +425,17 @@ inline Image MinimumAbs( Image const& in, Image const& mask = {}, BooleanArray c
 /// For tensor images, the result is computed for each element independently. Input must be not complex.
 ///
 /// If `mask` is forged, only those pixels selected by the mask image are used.
-DIP_EXPORT void Percentile( Image const& in, Image const& mask, Image& out, dfloat percentile, BooleanArray const& process = {} );
-inline Image Percentile( Image const& in, Image const& mask, dfloat percentile, BooleanArray const& process = {} ) {
+///
+/// `mode` can be `"exact"` or `"approximate"`. For 8-bit and 16-bit integer and binary images, the exact result is
+/// always computed, using a small histogram of the pixel values, which is cheap. For other data types,
+/// `"exact"` copies the pixel values to a buffer and partially sorts them, whereas `"approximate"` summarizes them
+/// in a single pass using a t-digest, and interpolates the result from it. The rank of the approximate result
+/// differs from the requested rank by no more than about 1% of the number of pixels, and much less for percentiles
+/// close to 0 or 100. If there are fewer than 1500 pixels to process, the approximate result is exact.
+DIP_EXPORT void Percentile( Image const& in, Image const& mask, Image& out, dfloat percentile, String const& mode = "exact", BooleanArray const& process = {} );
+inline Image Percentile( Image const& in, Image const& mask, dfloat percentile, String const& mode = "exact", BooleanArray const& process = {} ) {
    Image out;
-   Percentile( in, mask, out, percentile, process );
+   Percentile( in, mask, out, percentile, mode, process );
    return out;
 }
 
@@ -445,12 +452,14 @@ inline Image Percentile( Image const& in, Image const& mask, dfloat percentile,
 /// For tensor images, the result is computed for each element independently. Input must be not complex.
 ///
 /// If `mask` is forged, only those pixels selected by the mask image are used.
-inline void Median( Image const& in, Image const& mask, Image& out, BooleanArray const& process = {} ) {
-   Percentile( in, mask, out, 50.0, process );
+///
+/// For the meaning of `mode`, see `dip::Percentile`.
+inline void Median( Image const& in, Image const& mask, Image& out, String const& mode = "exact", BooleanArray const& process = {} ) {
+   Percentile( in, mask, out, 50.0, mode, process );
 }
-inline Image Median( Image const& in, Image const& mask = {}, BooleanArray const& process = {} ) {
+inline Image Median( Image const& in, Image const& mask = {}, String const& mode = "exact", BooleanArray const& process = {} ) {
    Image out;
-   Median( in, mask, out, process );
+   Median( in, mask, out, mode, process );
    return out;
 }
 
@@ -23,9 +23,11 @@
 
 #include <chrono>
 #include <ctime>
+#include <functional>
 #include <iomanip>
 
 #include "diplib.h"
+#include "diplib/multithreading.h"
 #include "diplib/statistics.h"
 #include "diplib/iterators.h"
 
@@ -284,6 +286,46 @@ class DIP_NO_EXPORT Timer {
       std::clock_t endCpu_;
 };
 
+/// \brief Calls `function( 0 )` with multithreading disabled, then `function( 1 )` with multithreading
+/// forced on, using `nThreads` threads.
+///
+/// Use this to test that an algorithm produces the same result independently of the number of threads used.
+/// The second call uses `nThreads` threads even on a machine with fewer cores: the limit set by OpenMP is raised,
+/// and the threading cost model is set such that starting a thread has no cost (see `dip::ThreadingCostModel`),
+/// so that parallel algorithms use all available threads even for small images. All settings are restored
+/// before returning.
+///
+/// Returns `false` if DIPlib was compiled without OpenMP support, in which case `function( 1 )` is not called.
+inline bool SingleAndMultiThreaded( std::function< void( dip::uint ) > const& function, dip::uint nThreads = 4 ) {
+   dip::uint oldThreads = GetNumberOfThreads();
+   int oldOmpThreads = omp_get_max_threads();
+   ThreadingCostModel oldModel = GetThreadingCostModel();
+   auto restore = [ & ]() {
+      SetThreadingCostModel( oldModel );
+      omp_set_num_threads( oldOmpThreads );
+      SetNumberOfThreads( oldThreads );
+   };
+   bool multiThreaded = false;
+   try {
+      SetNumberOfThreads( 1 );
+      function( 0 );
+      omp_set_num_threads( static_cast< int >( nThreads ));
+      SetNumberOfThreads( nThreads );
+      multiThreaded = GetNumberOfThreads() > 1;
+      if( multiThreaded ) {
+         ThreadingCostModel model = oldModel;
+         model.threadStartTime = 0.0;
+         SetThreadingCostModel( model );
+         function( 1 );
+      }
+   } catch( ... ) {
+      restore();
+      throw;
+   }
+   restore();
+   return multiThreaded;
+}
+
 /// \brief Reports elapsed time to a stream.
 inline std::ostream& operator<<(
       std::ostream& os,
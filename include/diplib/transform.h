@@ -76,6 +76,20 @@ namespace dip {
 ///     are normalized by the same amount. Each transform is multiplied by `1/sqrt(size)` for each
 ///     dimension. This makes the transform identical to how it was in versions of *DIPlib* prior to
 ///     version 3.0.
+///   - "half": the frequency-domain image stores only half of the spectrum: along the first dimension
+///     processed, only the non-negative frequencies are stored, frequency 0 at the first pixel (also
+///     when "corner" is not given). The other half follows from the conjugate symmetry of the transform
+///     of a real-valued image. The forward transform requires a real-valued input, and produces
+///     `N/2+1` pixels along that dimension. The inverse transform produces a real-valued output;
+///     if the input has `M` pixels along that dimension, the output has `2*M-2` pixels, unless `out`
+///     is forged with `2*M-1` pixels along that dimension (and the other sizes matching the input),
+///     in which case that odd size is produced. Cannot be combined with "fast".
+///
+/// The forward transform of a real-valued image, and the inverse transform with "real" or "half", use
+/// real-to-complex and complex-to-real transforms along the first dimension processed, computing
+/// only half of the spectrum. This takes about half the time and memory of a complex transform. With
+/// "half", the result stays at this size, which saves time when the frequency-domain image is
+/// multiplied and transformed back, as in `dip::ConvolveFT` and `dip::GaussFT`.
 ///
 /// For tensor images, each plane is transformed independently.
 ///
@@ -83,6 +97,10 @@ namespace dip {
 /// represented by a `dip::uint`, which on a 64-bit system can hold values up to 2^64-1. But this function
 /// uses `int` internally to represent sizes, and therefore has a more strict limit to image sizes. Note
 /// that this limit refers to the size of one image dimension, not to the total number of pixels in the image.
+///
+/// The transform plans (the twiddle factor tables of the built-in DFT, or the FFTW plans when *DIPlib* is
+/// linked against FFTW) are cached, so that repeated transforms of the same sizes do not need to repeat
+/// the planning. See `dip::ExportFourierTransformWisdom` for keeping them across program runs.
 DIP_EXPORT void FourierTransform(
       Image const& in,
       Image& out,
@@ -103,6 +121,26 @@ inline Image FourierTransform(
 /// (smaller than 2^31-1, the largest possible value of an `int` on most platforms).
 DIP_EXPORT dip::uint OptimalFourierTransformSize( dip::uint size );
 
+/// \brief Writes the knowledge accumulated by `dip::FourierTransform` about the transforms computed so far
+/// to the file `filename`.
+///
+/// When *DIPlib* is linked against FFTW, this is the FFTW wisdom, which allows planning to be instantaneous
+/// for these transforms in a later program run. For the built-in DFT, the list of transform sizes is written,
+/// for which `dip::ImportFourierTransformWisdom` will compute the tables up front.
+///
+/// The file is only meaningful for the same *DIPlib* build on the same machine.
+DIP_EXPORT void ExportFourierTransformWisdom( String const& filename );
+
+/// \brief Reads a file written by `dip::ExportFourierTransformWisdom`.
+///
+/// Throws if the file cannot be read, or was written by a *DIPlib* using a different FFT implementation.
+DIP_EXPORT void ImportFourierTransformWisdom( String const& filename );
+
+/// \brief Empties the cache of transform plans used by `dip::FourierTransform`, freeing the memory used.
+///
+/// Do not call this function while other threads are computing a Fourier transform.
+DIP_EXPORT void ClearFourierTransformPlanCache();
+
 
 // TODO: port dip_HartleyTransform (dip_transform.h)
 // TODO: add wavelet transforms
@@ -116,6 +116,9 @@ class UnionFind {
          }
       }
 
+      /// \brief Returns the number of elements created.
+      dip::uint Size() const { return list.size() - 1; }
+
       /// \brief Returns a reference to the value associated to the tree that contains `index`.
       ValueType& Value( IndexType index ) { return list[ FindRoot( index ) ].value; }
 
@@ -117,10 +117,11 @@ void init_assorted( py::module& m ) {
           "image"_a, "filename"_a, "history"_a = dip::StringArray{}, "significantBits"_a = 0, "options"_a = dip::StringSet {} );
 
    m.def( "ImageReadTIFF", py::overload_cast< dip::String const&, dip::Range const& >( &dip::ImageReadTIFF ), "filename"_a, "imageNumbers"_a = dip::Range{ 0 } );
+   m.def( "ImageReadTIFF", py::overload_cast< dip::String const&, dip::Range const&, dip::RangeArray const& >( &dip::ImageReadTIFF ), "filename"_a, "imageNumbers"_a, "roi"_a );
    m.def( "ImageReadTIFFSeries", py::overload_cast< dip::StringArray const& >( &dip::ImageReadTIFFSeries ), "filenames"_a );
    m.def( "ImageIsTIFF", &dip::ImageIsTIFF, "filename"_a );
-   m.def( "ImageWriteTIFF", py::overload_cast< dip::Image const&, dip::String const&, dip::String const&, dip::uint >( &dip::ImageWriteTIFF ),
-          "image"_a, "filename"_a, "compression"_a = "", "jpegLevel"_a = 80 );
+   m.def( "ImageWriteTIFF", py::overload_cast< dip::Image const&, dip::String const&, dip::String const&, dip::uint, dip::uint >( &dip::ImageWriteTIFF ),
+          "image"_a, "filename"_a, "compression"_a = "", "jpegLevel"_a = 80, "tileSize"_a = 0 );
 
    // diplib/generation.h
    m.def( "FillDelta", &dip::FillDelta, "out"_a, "origin"_a = "" );
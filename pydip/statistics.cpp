@@ -69,10 +69,10 @@ void init_statistics( py::module& m ) {
           "in"_a, "mask"_a = dip::Image{}, "process"_a = dip::BooleanArray{} );
    m.def( "MinimumAbs", py::overload_cast< dip::Image const&, dip::Image const&, dip::BooleanArray const& >( &dip::MinimumAbs ),
           "in"_a, "mask"_a = dip::Image{}, "process"_a = dip::BooleanArray{} );
-   m.def( "Percentile", py::overload_cast< dip::Image const&, dip::Image const&, dip::dfloat, dip::BooleanArray const& >( &dip::Percentile ),
-          "in"_a, "mask"_a = dip::Image{}, "percentile"_a = 50.0, "process"_a = dip::BooleanArray{} );
-   m.def( "Median", py::overload_cast< dip::Image const&, dip::Image const&, dip::BooleanArray const& >( &dip::Median ),
-          "in"_a, "mask"_a = dip::Image{}, "process"_a = dip::BooleanArray{} );
+   m.def( "Percentile", py::overload_cast< dip::Image const&, dip::Image const&, dip::dfloat, dip::String const&, dip::BooleanArray const& >( &dip::Percentile ),
+          "in"_a, "mask"_a = dip::Image{}, "percentile"_a = 50.0, "mode"_a = "exact", "process"_a = dip::BooleanArray{} );
+   m.def( "Median", py::overload_cast< dip::Image const&, dip::Image const&, dip::String const&, dip::BooleanArray const& >( &dip::Median ),
+          "in"_a, "mask"_a = dip::Image{}, "mode"_a = "exact", "process"_a = dip::BooleanArray{} );
    m.def( "All", py::overload_cast< dip::Image const&, dip::Image const&, dip::BooleanArray const& >( &dip::All ),
           "in"_a, "mask"_a = dip::Image{}, "process"_a = dip::BooleanArray{} );
    m.def( "Any", py::overload_cast< dip::Image const&, dip::Image const&, dip::BooleanArray const& >( &dip::Any ),
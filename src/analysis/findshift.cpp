@@ -25,6 +25,7 @@
 #include "diplib/statistics.h"
 #include "diplib/linear.h"
 #include "diplib/geometry.h"
+#include "diplib/multithreading.h"
 
 namespace dip {
 
@@ -40,54 +41,136 @@ void CrossCorrelationFT(
    DIP_THROW_IF( !in1.IsForged() || !in2.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !in1.IsScalar() || !in2.IsScalar(), E::IMAGE_NOT_SCALAR );
    DIP_THROW_IF( in1.Sizes() != in2.Sizes(), E::SIZES_DONT_MATCH );
+   bool in1Spatial = BooleanFromString( in1Representation, "spatial", "frequency" );
+   bool in2Spatial = BooleanFromString( in2Representation, "spatial", "frequency" );
+   bool outSpatial = BooleanFromString( outRepresentation, "spatial", "frequency" );
+   // If both inputs are real-valued, and we return to the spatial domain, we only need to compute half the spectrum
+   bool half = in1Spatial && in2Spatial && outSpatial && !in1.DataType().IsComplex() && !in2.DataType().IsComplex();
+   StringSet forwardOptions;
+   if( half ) {
+      forwardOptions.insert( "half" );
+   }
+   UnsignedArray sizes = in1.Sizes();
    Image in1FT;
-   if( BooleanFromString( in1Representation, "spatial", "frequency" )) {
-      DIP_STACK_TRACE_THIS( FourierTransform( in1, in1FT ));
+   if( in1Spatial ) {
+      DIP_STACK_TRACE_THIS( FourierTransform( in1, in1FT, forwardOptions ));
    } else {
       in1FT = in1.QuickCopy();
    }
    Image in2FT;
-   if( BooleanFromString( in2Representation, "spatial", "frequency" )) {
-      DIP_STACK_TRACE_THIS( FourierTransform( in2, in2FT ));
+   if( in2Spatial ) {
+      DIP_STACK_TRACE_THIS( FourierTransform( in2, in2FT, forwardOptions ));
    } else {
       in2FT = in2.QuickCopy();
    }
+   Image halfFT;
+   Image& outFT = half ? halfFT : out;
    DataType dt = in1FT.DataType();
-   DIP_STACK_TRACE_THIS( MultiplyConjugate( in1FT, in2FT, out, dt ));
+   DIP_STACK_TRACE_THIS( MultiplyConjugate( in1FT, in2FT, outFT, dt ));
    if( BooleanFromString( normalize, "normalize", "don't normalize" )) {
       if( in2FT.IsShared() ) {
          in2FT.Strip(); // make sure we don't write in any input data segments. Otherwise, we re-use the data segment.
       }
       SquareModulus( in1FT, in2FT );
-      SafeDivide( out, in2FT, out, out.DataType() ); // Normalize by the square modulus of in1.
+      SafeDivide( outFT, in2FT, outFT, outFT.DataType() ); // Normalize by the square modulus of in1.
    }
-   if( BooleanFromString( outRepresentation, "spatial", "frequency" )) {
+   if( half ) {
+      // Forging `out` with the sizes of the input tells `FourierTransform` the size of the half dimension
+      DIP_START_STACK_TRACE
+         out.ReForge( sizes, 1, DataType::SuggestFloat( dt ), Option::AcceptDataTypeChange::DO_ALLOW );
+         FourierTransform( halfFT, out, { "inverse", "half" } );
+      DIP_END_STACK_TRACE
+   } else if( outSpatial ) {
       DIP_STACK_TRACE_THIS( FourierTransform( out, out, { "inverse", "real" } ));
    }
 }
 
 namespace {
 
-FloatArray FindShift_CPF( Image const& in1, Image const& in2, dfloat maxFrequency ) {
-   DIP_THROW_IF( in1.Dimensionality() != 2, E::DIMENSIONALITY_NOT_SUPPORTED );
-   if( maxFrequency <= 0.0 ) {
-      maxFrequency = 0.2;
-   }
-   // Do cross-correlation for sub-pixel shift, forcing dcomplex output
-   Image cross{ in1.Sizes(), 1, DT_DCOMPLEX };
+// Computes the normalized cross-correlation in the frequency domain as used by the CPF method, forcing dcomplex output
+Image CPFCrossSpectrum( Image const& in1, String const& in1Representation, Image const& in2 ) {
+   Image cross{ in2.Sizes(), 1, DT_DCOMPLEX };
    cross.Protect();
-   CrossCorrelationFT( in1, in2, cross, "spatial", "spatial", "frequency", "normalize" );
+   CrossCorrelationFT( in1, in2, cross, in1Representation, "spatial", "frequency", "normalize" );
    DIP_ASSERT( cross.DataType() == DT_DCOMPLEX );
    DIP_ASSERT( cross.Stride( 0 ) == 1 );
-   // Do the least squares fit
-   dip::sint center_x = static_cast< dip::sint >( cross.Size( 0 ) / 2 );
-   dip::sint center_y = static_cast< dip::sint >( cross.Size( 1 ) / 2 );
-   dip::uint amount = 0;
+   return cross;
+}
+
+// A frequency used in the CPF fit, with the phase of the cross-correlation at that frequency
+struct CPFPoint {
+   dfloat u;
+   dfloat v;
+   dfloat angle;
+};
+
+// Least squares fit of the plane `angle = shift[0] * u + shift[1] * v`
+FloatArray CPFFit( std::vector< CPFPoint > const& points ) {
+   DIP_THROW_IF( points.size() < 3, "Too few valid data points to do calculation" );
    dfloat sumuv = 0;
    dfloat sumuu = 0;
    dfloat sumvv = 0;
    dfloat sumAv = 0;
    dfloat sumAu = 0;
+   for( auto const& point : points ) {
+      sumuv += point.u * point.v;
+      sumuu += point.u * point.u;
+      sumvv += point.v * point.v;
+      sumAv += point.angle * point.v;
+      sumAu += point.angle * point.u;
+   }
+   dfloat value = sumuv * sumuv - sumvv * sumuu;
+   DIP_THROW_IF ( value == 0, "Parameter 'value' is zero" );
+   return FloatArray{
+         ( sumAv * sumuv - sumAu * sumvv ) / value,
+         ( sumAu * sumuv - sumAv * sumuu ) / value
+   };
+}
+
+// Iteratively removes the points whose phase deviates from the fitted plane by more than three (robust) standard
+// deviations, and fits the plane again. Phase wrapping at the higher frequencies is the main source of outliers.
+FloatArray CPFRemoveOutliers( std::vector< CPFPoint >& points, FloatArray shift ) {
+   constexpr dip::uint maxIterations = 10;
+   std::vector< dfloat > residuals;
+   for( dip::uint iter = 0; iter < maxIterations; ++iter ) {
+      residuals.resize( points.size() );
+      for( dip::uint ii = 0; ii < points.size(); ++ii ) {
+         dfloat residual = points[ ii ].angle - shift[ 0 ] * points[ ii ].u - shift[ 1 ] * points[ ii ].v;
+         residuals[ ii ] = std::abs( residual - 2.0 * pi * std::round( residual / ( 2.0 * pi )));
+      }
+      std::vector< dfloat > sorted = residuals;
+      auto median = sorted.begin() + static_cast< dip::sint >( sorted.size() / 2 );
+      std::nth_element( sorted.begin(), median, sorted.end() );
+      dfloat threshold = 3.0 * 1.4826 * *median; // 1.4826 * MAD estimates the standard deviation
+      if( threshold <= 0.0 ) {
+         break;
+      }
+      dip::uint kk = 0;
+      for( dip::uint ii = 0; ii < points.size(); ++ii ) {
+         if( residuals[ ii ] <= threshold ) {
+            points[ kk ] = points[ ii ];
+            ++kk;
+         }
+      }
+      if( kk == points.size() ) {
+         break;
+      }
+      points.resize( kk );
+      shift = CPFFit( points );
+   }
+   return shift;
+}
+
+// `cross` is the output of `CPFCrossSpectrum`
+FloatArray FindShift_CPF( Image const& cross, dfloat maxFrequency, bool removeOutliers ) {
+   DIP_THROW_IF( cross.Dimensionality() != 2, E::DIMENSIONALITY_NOT_SUPPORTED );
+   if( maxFrequency <= 0.0 ) {
+      maxFrequency = 0.2;
+   }
+   // Collect the points for the least squares fit
+   dip::sint center_x = static_cast< dip::sint >( cross.Size( 0 ) / 2 );
+   dip::sint center_y = static_cast< dip::sint >( cross.Size( 1 ) / 2 );
+   std::vector< CPFPoint > points;
    dfloat radius = maxFrequency * maxFrequency;
    dfloat du = 2.0 * pi / static_cast< dfloat >( cross.Size( 0 ));
    dfloat dv = 2.0 * pi / static_cast< dfloat >( cross.Size( 1 ));
@@ -95,7 +178,7 @@ FloatArray FindShift_CPF( Image const& in1, Image const& in2, dfloat maxFrequenc
    dfloat v = static_cast< dfloat >( 0 - center_y ) * dv;
    // For the sake of simplicity, we forgo the Framework
    for( dip::sint jj = 0; jj < static_cast< dip::sint >( cross.Size( 1 )); ++jj ) {
-      dcomplex* ptr = static_cast< dcomplex* >( cross.Origin() ) + cross.Stride( 1 ) * jj; // just in case stride != width, which should not happen.
+      dcomplex const* ptr = static_cast< dcomplex const* >( cross.Origin() ) + cross.Stride( 1 ) * jj; // just in case stride != width, which should not happen.
       dfloat vv = v * v;
       if( vv < radius ) {
          dfloat u = uStart;
@@ -105,13 +188,7 @@ FloatArray FindShift_CPF( Image const& in1, Image const& in2, dfloat maxFrequenc
                dfloat amplitude = std::abs( *ptr );
                if( std::abs( amplitude - 1 ) < 0.1 ) {
                   // Use this point
-                  dfloat angle = std::arg( *ptr );
-                  sumuv += u * v;
-                  sumuu += uu;
-                  sumvv += vv;
-                  sumAv += angle * v;
-                  sumAu += angle * u;
-                  ++amount;
+                  points.push_back( { u, v, std::arg( *ptr ) } );
                }
             }
             ++ptr;
@@ -120,19 +197,39 @@ FloatArray FindShift_CPF( Image const& in1, Image const& in2, dfloat maxFrequenc
       }
       v += dv;
    }
-   DIP_THROW_IF( amount < 3, "Too few valid data points to do calculation" );
-   dfloat value = sumuv * sumuv - sumvv * sumuu;
-   DIP_THROW_IF ( value == 0, "Parameter 'value' is zero" );
-   return FloatArray{
-         ( sumAv * sumuv - sumAu * sumvv ) / value,
-         ( sumAu * sumuv - sumAv * sumuu ) / value
-   };
-   // TODO: Add removal of outliers as an option to CPF.
+   FloatArray shift = CPFFit( points );
+   if( removeOutliers ) {
+      shift = CPFRemoveOutliers( points, shift );
+   }
+   return shift;
    // TODO: CPF can probably be computed independently for each dimension by averaging fits along each line.
 }
 
-FloatArray FindShift_MTS( Image const& in1, Image const& in2, dip::uint iterations, dfloat accuracy, dfloat sigma ) {
-   dip::uint nDims = in1.Dimensionality();
+// The quantities computed from `in1` by the MTS method
+struct MTSReference {
+   Image original;
+   Image smoothed;
+   Image gradient;
+   Image M;          // Sum( gradient * gradient' ), as a full DT_DFLOAT matrix
+};
+
+void MTSSumGradientProducts( Image const& products, Image& M ) {
+   M = Sum( products );
+   M.Convert( DT_DFLOAT );
+   M.ExpandTensor(); // Multiply yields a symmetric tensor, here we force the storage to be normal
+}
+
+MTSReference MTSPrepareReference( Image const& in1, dfloat sigma ) {
+   MTSReference ref;
+   ref.original = in1.QuickCopy();
+   ref.smoothed = Gauss( in1, { sigma } );
+   ref.gradient = Gradient( in1, { sigma } );
+   MTSSumGradientProducts( Multiply( ref.gradient, Transpose( ref.gradient )), ref.M );
+   return ref;
+}
+
+FloatArray FindShift_MTS( MTSReference const& ref, Image const& in2, dip::uint iterations, dfloat accuracy, dfloat sigma ) {
+   dip::uint nDims = in2.Dimensionality();
    FloatArray out( nDims, 0.0 );
    FloatArray shift( nDims, 0.0 );
    FloatArray previousShift( nDims, 0.0 );
@@ -140,12 +237,8 @@ FloatArray FindShift_MTS( Image const& in1, Image const& in2, dip::uint iteratio
 
    // Solve: sum( gradient * gradient' ) * shift = sum(( in1 - in2 ) * gradient )
    // Solve: M * shift = V
-   Image in1g = Gauss( in1, { sigma } );
+   Image const* in1g = &ref.smoothed;
    Image in2g = Gauss( in2, { sigma } );
-   Image gradient = Gradient( in1, { sigma } );
-   Image M = Sum( Multiply( gradient, Transpose( gradient )));
-   M.Convert( DT_DFLOAT );
-   M.ExpandTensor(); // Multiply yields a symmetric tensor, here we force the storage to be normal
 
    // iterative Taylor with early break if accuracy is achieved
    dip::uint ii;
@@ -164,14 +257,14 @@ FloatArray FindShift_MTS( Image const& in1, Image const& in2, dip::uint iteratio
       } else {
          // Use non-smoothed image for iterations after the 3rd one.
          tmp = Shift( in2, invShift, "3-cubic" );
-         in1g = in1.QuickCopy();
+         in1g = &ref.original;
       }
-      Subtract( in1g, tmp, tmp, tmp.DataType() );
-      Image V = Sum( tmp * gradient );
+      Subtract( *in1g, tmp, tmp, tmp.DataType() );
+      Image V = Sum( tmp * ref.gradient );
       V.Convert( DT_DFLOAT );
       previousPreviousShift = previousShift;
       previousShift = shift;
-      Solve( nDims, nDims, { static_cast< dfloat* >( M.Origin() ), M.TensorStride() },
+      Solve( nDims, nDims, { static_cast< dfloat* >( ref.M.Origin() ), ref.M.TensorStride() },
                            { static_cast< dfloat* >( V.Origin() ), V.TensorStride() }, shift.begin() );
       out += shift;
       //std::cout << "[FindShift_MTS] iter = " << ii << ", shift = " << shift << ", out = " << out << std::endl;
@@ -217,6 +310,10 @@ FloatArray FindShift_MTS( Image const& in1, Image const& in2, dip::uint iteratio
    return out;
 }
 
+FloatArray FindShift_MTS( Image const& in1, Image const& in2, dip::uint iterations, dfloat accuracy, dfloat sigma ) {
+   return FindShift_MTS( MTSPrepareReference( in1, sigma ), in2, iterations, accuracy, sigma );
+}
+
 FloatArray FindShift_PROJ( Image const& in1, Image const& in2, dip::uint iterations, dfloat accuracy, dfloat sigma ) {
    dip::uint nDims = in1.Dimensionality();
    FloatArray shift( nDims, 0.0 );
@@ -236,17 +333,14 @@ FloatArray FindShift_PROJ( Image const& in1, Image const& in2, dip::uint iterati
    return shift;
 }
 
-FloatArray FindShift_CC(
-      Image const& in1,
-      Image const& in2,
+// Finds the peak in the spatial-domain cross-correlation `cross`, which is cropped if `maxShift` requires it
+FloatArray CrossCorrelationPeak(
+      Image& cross,
       UnsignedArray const& maxShift,
-      String const& normalize = "don't normalize",
-      bool subpixelPrecision = false
+      bool subpixelPrecision
 ) {
-   dip::uint nDims = in1.Dimensionality();
-   Image cross;
-   DIP_STACK_TRACE_THIS( CrossCorrelationFT( in1, in2, cross, "spatial", "spatial", "spatial", normalize ));
    DIP_ASSERT( cross.DataType().IsReal() );
+   dip::uint nDims = cross.Dimensionality();
    UnsignedArray sizes = cross.Sizes();
    bool crop = false;
    for( dip::uint ii = 0; ii < nDims; ++ii ) {
@@ -283,34 +377,87 @@ FloatArray FindShift_CC(
    return shift;
 }
 
+FloatArray FindShift_CC(
+      Image const& in1,
+      Image const& in2,
+      UnsignedArray const& maxShift,
+      String const& normalize = "don't normalize",
+      bool subpixelPrecision = false
+) {
+   Image cross;
+   DIP_STACK_TRACE_THIS( CrossCorrelationFT( in1, in2, cross, "spatial", "spatial", "spatial", normalize ));
+   return CrossCorrelationPeak( cross, maxShift, subpixelPrecision );
+}
+
+// Returns the ranges that select, in `in1` (if `first`) or in `in2`, the part that the two images have in common,
+// given the integer shift between them
+RangeArray CommonPart( UnsignedArray const& sizes, FloatArray const& shift, bool first ) {
+   dip::uint nDims = sizes.size();
+   RangeArray ranges( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::sint start = static_cast< dip::sint >( std::abs( shift[ ii ] ));
+      if( first == ( shift[ ii ] > 0 )) {
+         start = 0;
+      }
+      dip::sint length = static_cast< dip::sint >( sizes[ ii ] ) - static_cast< dip::sint >( std::abs( shift[ ii ] ));
+      ranges[ ii ] = Range{ start, start + length - 1 };
+   }
+   return ranges;
+}
+
 FloatArray CorrectIntegerShift(
       Image& in1,
       Image& in2,
       UnsignedArray const& maxShift
 ) {
-   dip::uint nDims = in1.Dimensionality();
    FloatArray shift;
    DIP_STACK_TRACE_THIS( shift = FindShift_CC( in1, in2, maxShift ));
    if( shift.any() ) {
       // Shift is non-zero along at least one dimension
       // Correct for this integer shift by cropping both images
       UnsignedArray sizes = in1.Sizes();
-      UnsignedArray origin( nDims, 0 );
-      for( dip::uint ii = 0; ii < nDims; ++ii ) {
-         origin[ ii ] = shift[ ii ] > 0 ? static_cast< dip::uint >( shift[ ii ] ) : 0;
-         sizes[ ii ] -= static_cast< dip::uint >( std::abs( shift[ ii ] ));
-      }
-      in2.dip__SetSizes( sizes );
-      in2.dip__SetOrigin( in2.Pointer( origin ));
-      for( dip::uint ii = 0; ii < nDims; ++ii ) {
-         origin[ ii ] = shift[ ii ] < 0 ? static_cast< dip::uint >( -shift[ ii ] ) : 0;
-      }
-      in1.dip__SetSizes( sizes );
-      in1.dip__SetOrigin( in1.Pointer( origin ));
+      in1 = in1.At( CommonPart( sizes, shift, true ));
+      in2 = in2.At( CommonPart( sizes, shift, false ));
    }
    return shift;
 }
 
+// Translates the parameter of the ITER and PROJ methods to the number of iterations and the accuracy
+void IterationParameters( dfloat parameter, dip::uint& maxIter, dfloat& accuracy ) {
+   maxIter = 5;      // default number of iteration => accuracy ~ 1e-4
+   accuracy = 0.0;   // signals early break if bias correction is possible
+   if( parameter < 0.0 ) {
+      maxIter = std::max( dip::uint{ 1 }, static_cast< dip::uint >( round_cast( -parameter )));
+      accuracy = 1e-10; // so small that maxIter would play its role
+   } else if(( parameter > 0.0 ) && ( parameter <= 0.1 )) {
+      maxIter = 20;     // NOTE: more iteration solution may end up very far from truth
+      accuracy = parameter;
+   }
+}
+
+// Multiplies `in` with a separable window function, returns a floating-point image
+Image ApplyWindow( Image const& in, String const& window ) {
+   Image out = Convert( in, DataType::SuggestFlex( in.DataType() ));
+   dip::uint nDims = in.Dimensionality();
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::uint size = in.Size( ii );
+      UnsignedArray sizes( nDims, 1 );
+      sizes[ ii ] = size;
+      Image line( sizes, 1, DT_SFLOAT );
+      sfloat* ptr = static_cast< sfloat* >( line.Origin() );
+      dip::sint stride = line.Stride( ii );
+      // The Tukey window tapers 1/8 of the image at each end, the Hann window is the limit case of tapering 1/2
+      dfloat taper = static_cast< dfloat >( size ) * ( window == "Hann" ? 0.5 : 0.125 );
+      for( dip::uint jj = 0; jj < size; ++jj, ptr += stride ) {
+         dfloat x = std::min( static_cast< dfloat >( jj ), static_cast< dfloat >( size - 1 - jj )) + 0.5;
+         dfloat value = x < taper ? std::sin( pi / 2.0 * x / taper ) : 1.0;
+         *ptr = static_cast< sfloat >( value * value );
+      }
+      Multiply( out, line, out, out.DataType() );
+   }
+   return out;
+}
+
 } // namespace
 
 FloatArray FindShift(
@@ -337,23 +484,20 @@ FloatArray FindShift(
       Image in1 = c_in1.QuickCopy();
       Image in2 = c_in2.QuickCopy();
       DIP_STACK_TRACE_THIS( shift = CorrectIntegerShift( in1, in2, maxShift )); // modifies in1 and in2
-      if( method == "CPF" ) {
-         DIP_STACK_TRACE_THIS( shift += FindShift_CPF( in1, in2, parameter ));
+      if(( method == "CPF" ) || ( method == "robust CPF" )) {
+         DIP_START_STACK_TRACE
+            Image cross = CPFCrossSpectrum( in1, "spatial", in2 );
+            shift += FindShift_CPF( cross, parameter, method == "robust CPF" );
+         DIP_END_STACK_TRACE
       } else if( method == "MTS" ) {
          if( parameter <= 0.0 ) {
             parameter = 1.0;
          }
          DIP_STACK_TRACE_THIS( shift += FindShift_MTS( in1, in2, 1, 0.0, parameter ));
       } else {
-         dip::uint maxIter = 5;  // default number of iteration => accuracy ~ 1e-4
-         dfloat accuracy = 0.0;  // signals early break if bias correction is possible
-         if( parameter < 0.0 ) {
-            maxIter = std::max( dip::uint{ 1 }, static_cast< dip::uint >( round_cast( -parameter )));
-            accuracy = 1e-10;    // so small that maxIter would play its role
-         } else if(( parameter > 0.0 ) && ( parameter <= 0.1 )) {
-            maxIter = 20;        // NOTE: more iteration solution may end up very far from truth
-            accuracy = parameter;
-         }
+         dip::uint maxIter;
+         dfloat accuracy;
+         IterationParameters( parameter, maxIter, accuracy );
          if( method == "ITER" ) {
             DIP_STACK_TRACE_THIS( shift += FindShift_MTS( in1, in2, maxIter, accuracy, 1.0 ));
          } else if( method == "PROJ" ) {
@@ -366,6 +510,187 @@ FloatArray FindShift(
    return shift;
 }
 
+ShiftEstimator::ShiftEstimator(
+      Image const& reference,
+      String const& method,
+      dfloat parameter,
+      UnsignedArray maxShift,
+      String const& window
+) {
+   DIP_THROW_IF( !reference.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !reference.IsScalar(), E::IMAGE_NOT_SCALAR );
+   DIP_THROW_IF( !reference.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
+   dip::uint nDims = reference.Dimensionality();
+   DIP_STACK_TRACE_THIS( ArrayUseParameter( maxShift, nDims, std::numeric_limits< dip::uint >::max() ));
+   maxShift_ = std::move( maxShift );
+   if( method == "integer only" ) {
+      method_ = Method::INTEGER;
+   } else if( method == "CC" ) {
+      method_ = Method::CC;
+   } else if( method == "NCC" ) {
+      method_ = Method::NCC;
+   } else if( method == "CPF" ) {
+      method_ = Method::CPF;
+   } else if( method == "robust CPF" ) {
+      method_ = Method::ROBUST_CPF;
+   } else if( method == "MTS" ) {
+      method_ = Method::MTS;
+   } else if( method == "ITER" ) {
+      method_ = Method::ITER;
+   } else if( method == "PROJ" ) {
+      method_ = Method::PROJ;
+   } else {
+      DIP_THROW( E::INVALID_FLAG );
+   }
+   DIP_THROW_IF((( method_ == Method::CPF ) || ( method_ == Method::ROBUST_CPF )) && ( nDims != 2 ), E::DIMENSIONALITY_NOT_SUPPORTED );
+   DIP_THROW_IF(( window != "none" ) && ( window != "Hann" ) && ( window != "Tukey" ), E::INVALID_FLAG );
+   window_ = window;
+   parameter_ = parameter;
+   sigma_ = 1.0;
+   if( method_ == Method::MTS ) {
+      maxIter_ = 1;
+      accuracy_ = 0.0;
+      if( parameter_ > 0.0 ) {
+         sigma_ = parameter_;
+      }
+   } else {
+      IterationParameters( parameter_, maxIter_, accuracy_ );
+   }
+   reference_.Copy( reference );
+   DIP_START_STACK_TRACE
+      // The spectrum used to find the integer shift, or the full cross-correlation for the CC methods
+      Image windowed = Windowed( reference_ );
+      FourierTransform( windowed, referenceFT_, { "half" } );
+      if( method_ == Method::NCC ) {
+         Image squareModulus = SquareModulus( referenceFT_ );
+         SafeDivide( referenceFT_, squareModulus, referenceFT_, referenceFT_.DataType() );
+      }
+      switch( method_ ) {
+         case Method::CPF:
+         case Method::ROBUST_CPF:
+            // Used when there is no integer shift
+            cpfReferenceFT_ = Image{ windowed.Sizes(), 1, DT_DCOMPLEX };
+            cpfReferenceFT_.Protect();
+            FourierTransform( windowed, cpfReferenceFT_ );
+            cpfReferenceFT_.Protect( false );
+            break;
+         case Method::MTS:
+         case Method::ITER:
+            smoothed_ = Gauss( reference_, { sigma_ } );
+            gradient_ = Gradient( reference_, { sigma_ } );
+            gradientProducts_ = Multiply( gradient_, Transpose( gradient_ ));
+            MTSSumGradientProducts( gradientProducts_, M_ );
+            break;
+         default:
+            break;
+      }
+   DIP_END_STACK_TRACE
+}
+
+Image ShiftEstimator::Windowed( Image const& img ) const {
+   if( window_ == "none" ) {
+      return img.QuickCopy();
+   }
+   return ApplyWindow( img, window_ );
+}
+
+FloatArray ShiftEstimator::Estimate( Image const& frame ) const {
+   DIP_THROW_IF( !frame.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !frame.IsScalar(), E::IMAGE_NOT_SCALAR );
+   DIP_THROW_IF( !frame.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
+   DIP_THROW_IF( frame.Sizes() != reference_.Sizes(), E::SIZES_DONT_MATCH );
+   FloatArray shift;
+   DIP_START_STACK_TRACE
+      // Cross-correlation with the cached reference spectrum, as `dip::CrossCorrelationFT` computes it
+      Image frameFT = FourierTransform( Windowed( frame ), { "half" } );
+      MultiplyConjugate( referenceFT_, frameFT, frameFT, referenceFT_.DataType() );
+      // Forging `cross` with the sizes of the frame tells `FourierTransform` the size of the half dimension
+      Image cross( frame.Sizes(), 1, DataType::SuggestFloat( referenceFT_.DataType() ));
+      FourierTransform( frameFT, cross, { "inverse", "half" } );
+      bool subpixelPrecision = ( method_ == Method::CC ) || ( method_ == Method::NCC );
+      shift = CrossCorrelationPeak( cross, maxShift_, subpixelPrecision );
+   DIP_END_STACK_TRACE
+   if(( method_ == Method::INTEGER ) || ( method_ == Method::CC ) || ( method_ == Method::NCC )) {
+      return shift;
+   }
+   // Crop both images to the common part
+   bool cropped = shift.any();
+   RangeArray ranges;
+   Image in1 = reference_.QuickCopy();
+   Image in2 = frame.QuickCopy();
+   if( cropped ) {
+      ranges = CommonPart( reference_.Sizes(), shift, true );
+      in1 = reference_.At( ranges );
+      in2 = frame.At( CommonPart( reference_.Sizes(), shift, false ));
+   }
+   DIP_START_STACK_TRACE
+      switch( method_ ) {
+         case Method::CPF:
+         case Method::ROBUST_CPF: {
+            Image cross = cropped
+                          ? CPFCrossSpectrum( Windowed( in1 ), "spatial", Windowed( in2 ))
+                          : CPFCrossSpectrum( cpfReferenceFT_, "frequency", Windowed( in2 ));
+            shift += FindShift_CPF( cross, parameter_, method_ == Method::ROBUST_CPF );
+            break;
+         }
+         case Method::MTS:
+         case Method::ITER: {
+            MTSReference ref;
+            if( cropped ) {
+               // The derivatives near the edges of the common part are computed from the reference image data
+               // outside of it, rather than extrapolated as `dip::FindShift` does
+               ref.original = in1;
+               ref.smoothed = smoothed_.At( ranges );
+               ref.gradient = gradient_.At( ranges );
+               MTSSumGradientProducts( gradientProducts_.At( ranges ), ref.M );
+            } else {
+               ref.original = in1;
+               ref.smoothed = smoothed_;
+               ref.gradient = gradient_;
+               ref.M = M_;
+            }
+            shift += FindShift_MTS( ref, in2, maxIter_, accuracy_, sigma_ );
+            break;
+         }
+         case Method::PROJ:
+            shift += FindShift_PROJ( in1, in2, maxIter_, accuracy_, 1.0 );
+            break;
+         default:
+            DIP_THROW( E::NOT_IMPLEMENTED ); // We should never get here
+      }
+   DIP_END_STACK_TRACE
+   return shift;
+}
+
+std::vector< FloatArray > ShiftEstimator::Estimate( ImageArray const& frames ) const {
+   std::vector< FloatArray > shifts( frames.size() );
+   dip::uint nThreads = std::min( GetNumberOfThreads(), frames.size() );
+   WorkDistributor work( frames.size(), nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         for( dip::uint ii = begin; ii < end; ++ii ) {
+            shifts[ ii ] = Estimate( frames[ ii ] );
+         }
+      }
+   } );
+   return shifts;
+}
+
+std::vector< FloatArray > ShiftEstimator::EstimateStack( Image const& stack ) const {
+   DIP_THROW_IF( !stack.IsForged(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = reference_.Dimensionality();
+   DIP_THROW_IF( stack.Dimensionality() != nDims + 1, E::DIMENSIONALITIES_DONT_MATCH );
+   ImageArray frames( stack.Size( nDims ));
+   RangeArray ranges( nDims + 1 );
+   for( dip::uint ii = 0; ii < frames.size(); ++ii ) {
+      ranges[ nDims ] = Range{ static_cast< dip::sint >( ii ) };
+      frames[ ii ] = stack.At( ranges );
+      frames[ ii ].Squeeze( nDims );
+   }
+   return Estimate( frames );
+}
+
 } // namespace dip
 
 #ifdef DIP__ENABLE_DOCTEST
@@ -412,6 +737,12 @@ DOCTEST_TEST_CASE("[DIPlib] testing the FindShift fuction") {
    DOCTEST_CHECK( std::abs( result[ 0 ] - shift[ 0 ] ) < 0.05 );
    DOCTEST_CHECK( std::abs( result[ 1 ] - shift[ 1 ] ) < 0.05 );
 
+   // Method: "robust CPF"
+   result = FindShift( in1, in2, "robust CPF" );
+   DOCTEST_REQUIRE( result.size() == 2 );
+   DOCTEST_CHECK( std::abs( result[ 0 ] - shift[ 0 ] ) < 0.02 );
+   DOCTEST_CHECK( std::abs( result[ 1 ] - shift[ 1 ] ) < 0.02 );
+
    // Method: "MTS"
    result = FindShift( in1, in2, "MTS" );
    DOCTEST_REQUIRE( result.size() == 2 );
@@ -437,4 +768,53 @@ DOCTEST_TEST_CASE("[DIPlib] testing the FindShift fuction") {
    DOCTEST_CHECK( std::abs( result[ 1 ] - shift[ 1 ] ) < 0.03 );
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the ShiftEstimator class") {
+   dip::Image in1( { 250, 261 }, 1, dip::DT_SFLOAT );
+   dip::FillRadiusCoordinate( in1 );
+   in1 -= 100;
+   dip::Erf( in1, in1 );
+   dip::Image stack( { 250, 261, 3 }, 1, dip::DT_SFLOAT );
+   dip::FloatArray shifts{ 0.0, -0.4, 2.7, 1.3, -5.2, 0.9 };
+   for( dip::uint ii = 0; ii < 3; ++ii ) {
+      dip::Image frame = stack.At( dip::Range{}, dip::Range{}, dip::Range{ static_cast< dip::sint >( ii ) } );
+      frame.Squeeze( 2 );
+      frame.Copy( dip::Shift( in1, { shifts[ 2 * ii ], shifts[ 2 * ii + 1 ] }, "3-cubic" ));
+   }
+
+   // The first frame has no integer shift, the other two do, and are cropped to the common part before
+   // the sub-pixel estimation. Except for MTS, which computes the derivatives near the edges of the common
+   // part from the reference image rather than by extrapolation, the results are identical to `FindShift`
+   for( auto const& method : { "CC", "NCC", "CPF", "MTS" } ) {
+      dip::ShiftEstimator estimator( in1, method );
+      std::vector< dip::FloatArray > result = estimator.EstimateStack( stack );
+      DOCTEST_REQUIRE( result.size() == 3 );
+      dip::dfloat tolerance = std::string( method ) == "MTS" ? 1e-3 : 1e-6;
+      for( dip::uint ii = 0; ii < 3; ++ii ) {
+         dip::Image frame = stack.At( dip::Range{}, dip::Range{}, dip::Range{ static_cast< dip::sint >( ii ) } );
+         frame.Squeeze( 2 );
+         dip::FloatArray expected = FindShift( in1, frame, method );
+         DOCTEST_CHECK( std::abs( result[ ii ][ 0 ] - expected[ 0 ] ) < tolerance );
+         DOCTEST_CHECK( std::abs( result[ ii ][ 1 ] - expected[ 1 ] ) < tolerance );
+      }
+   }
+
+   // The ITER method uses the cached reference derivatives
+   dip::ShiftEstimator estimator( in1, "ITER" );
+   std::vector< dip::FloatArray > result = estimator.EstimateStack( stack );
+   DOCTEST_REQUIRE( result.size() == 3 );
+   for( dip::uint ii = 0; ii < 3; ++ii ) {
+      DOCTEST_CHECK( std::abs( result[ ii ][ 0 ] - shifts[ 2 * ii ] ) < 0.002 );
+      DOCTEST_CHECK( std::abs( result[ ii ][ 1 ] - shifts[ 2 * ii + 1 ] ) < 0.002 );
+   }
+
+   // With a window
+   estimator = dip::ShiftEstimator( in1, "robust CPF", 0, {}, "Tukey" );
+   result = estimator.EstimateStack( stack );
+   DOCTEST_REQUIRE( result.size() == 3 );
+   for( dip::uint ii = 0; ii < 3; ++ii ) {
+      DOCTEST_CHECK( std::abs( result[ ii ][ 0 ] - shifts[ 2 * ii ] ) < 0.05 );
+      DOCTEST_CHECK( std::abs( result[ ii ][ 1 ] - shifts[ 2 * ii + 1 ] ) < 0.05 );
+   }
+}
+
 #endif // DIP__ENABLE_DOCTEST
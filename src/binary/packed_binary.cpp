@@ -0,0 +1,875 @@
+/*
+ * DIPlib 3.0
+ * This file contains the bit-packed binary image and the binary filters that work on it.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "diplib.h"
+#include "diplib/packed_binary.h"
+#include "diplib/union_find.h"
+#include "binary_support.h"
+
+namespace dip {
+
+using Word = PackedBinaryImage::Word;
+constexpr dip::uint bitsPerWord = PackedBinaryImage::bitsPerWord;
+
+namespace {
+
+inline dip::uint CountBits( Word word ) {
+#if defined(__GNUC__) || defined(__clang__)
+   return static_cast< dip::uint >( __builtin_popcountll( word ));
+#else
+   dip::uint count = 0;
+   while( word ) {
+      word &= word - 1;
+      ++count;
+   }
+   return count;
+#endif
+}
+
+// `word` must not be zero
+inline dip::uint CountTrailingZeros( Word word ) {
+#if defined(__GNUC__) || defined(__clang__)
+   return static_cast< dip::uint >( __builtin_ctzll( word ));
+#else
+   dip::uint count = 0;
+   while( !( word & 1u )) {
+      word >>= 1;
+      ++count;
+   }
+   return count;
+#endif
+}
+
+// The bits of the last word in each row that represent pixels
+inline Word LastWordMask( dip::uint size0 ) {
+   dip::uint rem = size0 % bitsPerWord;
+   return rem == 0 ? ~Word( 0 ) : ( Word( 1 ) << rem ) - 1;
+}
+
+// Calls `function( row, offset )` for each image line along dimension 0, in the order in which the packed image
+// stores them. `offset` is the offset in samples to the first pixel of the line.
+template< typename F >
+void ForEachImageRow( Image const& img, F const& function ) {
+   dip::uint nDims = img.Dimensionality();
+   UnsignedArray const& sizes = img.Sizes();
+   IntegerArray const& strides = img.Strides();
+   dip::uint nRows = img.NumberOfPixels() / sizes[ 0 ];
+   UnsignedArray pos( nDims, 0 );
+   dip::sint offset = 0;
+   for( dip::uint row = 0; row < nRows; ++row ) {
+      function( row, offset );
+      for( dip::uint ii = 1; ii < nDims; ++ii ) {
+         ++pos[ ii ];
+         offset += strides[ ii ];
+         if( pos[ ii ] < sizes[ ii ] ) {
+            break;
+         }
+         offset -= strides[ ii ] * static_cast< dip::sint >( sizes[ ii ] );
+         pos[ ii ] = 0;
+      }
+   }
+}
+
+// A neighboring row: a displacement along dimensions 1 and up, and the displacements along dimension 0
+// that are neighbors for the given connectivity.
+struct NeighborRow {
+   IntegerArray displacement; // for dimensions 1 and up
+   bool sides;                // if true, displacements of -1 and 1 along dimension 0 are neighbors too
+   dip::sint direction;       // -1 if the row precedes the current one in storage order, 1 if it follows, 0 if it's the same row
+};
+
+// Lists the neighboring rows for connectivity `connectivity`, including the current row.
+std::vector< NeighborRow > ListNeighborRows( dip::uint nDims, dip::uint connectivity ) {
+   std::vector< NeighborRow > list;
+   IntegerArray displacement( nDims - 1, -1 );
+   for( ;; ) {
+      dip::uint nNonZero = 0;
+      dip::sint direction = 0;
+      for( auto d : displacement ) {
+         if( d != 0 ) {
+            ++nNonZero;
+            direction = d; // the last non-zero displacement determines the direction
+         }
+      }
+      if( nNonZero <= connectivity ) {
+         list.push_back( { displacement, nNonZero + 1 <= connectivity, direction } );
+      }
+      dip::uint ii = 0;
+      for( ; ii < displacement.size(); ++ii ) {
+         ++displacement[ ii ];
+         if( displacement[ ii ] <= 1 ) {
+            break;
+         }
+         displacement[ ii ] = -1;
+      }
+      if( ii == displacement.size() ) {
+         break;
+      }
+   }
+   return list;
+}
+
+// Iterates over the rows of a packed image, keeping track of the row coordinates, so that neighboring rows
+// can be found.
+class RowWalker {
+   public:
+      explicit RowWalker( UnsignedArray const& sizes ) : sizes_( sizes ), pos_( sizes.size(), 0 ), rowStrides_( sizes.size(), 0 ) {
+         dip::uint stride = 1;
+         for( dip::uint ii = 1; ii < sizes.size(); ++ii ) {
+            rowStrides_[ ii ] = stride;
+            stride *= sizes[ ii ];
+         }
+         nRows_ = stride;
+      }
+      dip::uint NumberOfRows() const { return nRows_; }
+      dip::uint Row() const { return row_; }
+      // Moves to the given row
+      void Set( dip::uint row ) {
+         row_ = row;
+         for( dip::uint ii = 1; ii < sizes_.size(); ++ii ) {
+            pos_[ ii ] = row % sizes_[ ii ];
+            row /= sizes_[ ii ];
+         }
+      }
+      void Next() {
+         ++row_;
+         for( dip::uint ii = 1; ii < sizes_.size(); ++ii ) {
+            if( ++pos_[ ii ] < sizes_[ ii ] ) {
+               break;
+            }
+            pos_[ ii ] = 0;
+         }
+      }
+      void Previous() {
+         --row_;
+         for( dip::uint ii = 1; ii < sizes_.size(); ++ii ) {
+            if( pos_[ ii ] > 0 ) {
+               --pos_[ ii ];
+               break;
+            }
+            pos_[ ii ] = sizes_[ ii ] - 1;
+         }
+      }
+      // Finds the neighboring row at the given displacement. Returns false if it's outside the image.
+      bool Neighbor( IntegerArray const& displacement, dip::uint& neighbor ) const {
+         neighbor = row_;
+         for( dip::uint ii = 1; ii < sizes_.size(); ++ii ) {
+            dip::sint d = displacement[ ii - 1 ];
+            if( d < 0 ) {
+               if( pos_[ ii ] == 0 ) {
+                  return false;
+               }
+               neighbor -= rowStrides_[ ii ];
+            } else if( d > 0 ) {
+               if( pos_[ ii ] + 1 >= sizes_[ ii ] ) {
+                  return false;
+               }
+               neighbor += rowStrides_[ ii ];
+            }
+         }
+         return true;
+      }
+   private:
+      UnsignedArray const& sizes_;
+      UnsignedArray pos_;
+      UnsignedArray rowStrides_;
+      dip::uint nRows_;
+      dip::uint row_ = 0;
+};
+
+// Combines into `out` the row `src`, shifted such that pixel `x` in `out` is combined with pixel `x + shift` in
+// `src`. Pixels outside the row have the value `edge`. If `src` is a null pointer, the row is outside the image,
+// and all its pixels have the value `edge`. The unused bits at the end of `out` are not meaningful.
+template< typename Operator >
+inline void CombineShiftedRow(
+      Word* out,
+      Word const* src,
+      dip::sint shift,
+      bool edge,
+      dip::uint nWords,
+      dip::uint size0,
+      Operator const& op
+) {
+   if( !src ) {
+      Word value = edge ? ~Word( 0 ) : Word( 0 );
+      for( dip::uint ii = 0; ii < nWords; ++ii ) {
+         out[ ii ] = op( out[ ii ], value );
+      }
+   } else if( shift == 0 ) {
+      for( dip::uint ii = 0; ii < nWords; ++ii ) {
+         out[ ii ] = op( out[ ii ], src[ ii ] );
+      }
+   } else if( shift > 0 ) {
+      for( dip::uint ii = 0; ii < nWords - 1; ++ii ) {
+         out[ ii ] = op( out[ ii ], ( src[ ii ] >> 1 ) | ( src[ ii + 1 ] << ( bitsPerWord - 1 )));
+      }
+      // The unused bits of `src` are zero, so only the last pixel needs to be fixed for an object edge
+      Word last = src[ nWords - 1 ] >> 1;
+      if( edge ) {
+         last |= Word( 1 ) << (( size0 - 1 ) % bitsPerWord );
+      }
+      out[ nWords - 1 ] = op( out[ nWords - 1 ], last );
+   } else {
+      out[ 0 ] = op( out[ 0 ], ( src[ 0 ] << 1 ) | ( edge ? Word( 1 ) : Word( 0 )));
+      for( dip::uint ii = 1; ii < nWords; ++ii ) {
+         out[ ii ] = op( out[ ii ], ( src[ ii ] << 1 ) | ( src[ ii - 1 ] >> ( bitsPerWord - 1 )));
+      }
+   }
+}
+
+struct OrOperator {
+   Word operator()( Word a, Word b ) const { return a | b; }
+};
+struct AndOperator {
+   Word operator()( Word a, Word b ) const { return a & b; }
+};
+struct AssignOperator {
+   Word operator()( Word, Word b ) const { return b; }
+};
+
+// Sets the unused bits at the end of each row to zero
+void ClearUnusedBits( PackedBinaryImage& img ) {
+   Word mask = LastWordMask( img.Sizes()[ 0 ] );
+   if( mask == ~Word( 0 )) {
+      return;
+   }
+   dip::uint nWords = img.WordsPerRow();
+   for( dip::uint row = 0; row < img.NumberOfRows(); ++row ) {
+      img.Row( row )[ nWords - 1 ] &= mask;
+   }
+}
+
+// One iteration of a dilation (with `OrOperator`) or an erosion (with `AndOperator`)
+template< typename Operator >
+PackedBinaryImage DilationErosionStep(
+      PackedBinaryImage const& in,
+      dip::uint connectivity,
+      bool edge,
+      Operator const& op
+) {
+   UnsignedArray const& sizes = in.Sizes();
+   dip::uint nDims = sizes.size();
+   dip::uint nWords = in.WordsPerRow();
+   PackedBinaryImage out = in;
+   RowWalker walker( sizes );
+   if(( connectivity == nDims ) && ( nDims > 1 )) {
+      // The rectangular structuring element is separable
+      for( dip::uint row = 0; row < walker.NumberOfRows(); ++row ) {
+         CombineShiftedRow( out.Row( row ), in.Row( row ), -1, edge, nWords, sizes[ 0 ], op );
+         CombineShiftedRow( out.Row( row ), in.Row( row ), 1, edge, nWords, sizes[ 0 ], op );
+      }
+      PackedBinaryImage tmp;
+      for( dip::uint dim = 1; dim < nDims; ++dim ) {
+         tmp = out;
+         IntegerArray displacement( nDims - 1, 0 );
+         walker.Set( 0 );
+         for( dip::uint row = 0; row < walker.NumberOfRows(); ++row, walker.Next() ) {
+            for( dip::sint d : { -1, 1 } ) {
+               displacement[ dim - 1 ] = d;
+               dip::uint neighbor;
+               Word const* src = walker.Neighbor( displacement, neighbor ) ? tmp.Row( neighbor ) : nullptr;
+               CombineShiftedRow( out.Row( row ), src, 0, edge, nWords, sizes[ 0 ], op );
+            }
+         }
+      }
+   } else {
+      std::vector< NeighborRow > neighbors = ListNeighborRows( nDims, connectivity );
+      for( dip::uint row = 0; row < walker.NumberOfRows(); ++row, walker.Next() ) {
+         Word* dest = out.Row( row );
+         for( auto const& nr : neighbors ) {
+            dip::uint neighbor;
+            Word const* src = walker.Neighbor( nr.displacement, neighbor ) ? in.Row( neighbor ) : nullptr;
+            if( nr.direction != 0 ) {
+               CombineShiftedRow( dest, src, 0, edge, nWords, sizes[ 0 ], op );
+            }
+            if( nr.sides ) {
+               CombineShiftedRow( dest, src, -1, edge, nWords, sizes[ 0 ], op );
+               CombineShiftedRow( dest, src, 1, edge, nWords, sizes[ 0 ], op );
+            }
+         }
+      }
+   }
+   ClearUnusedBits( out );
+   return out;
+}
+
+dip::uint AbsoluteConnectivity( dip::uint nDims, dip::sint connectivity, dip::uint iteration ) {
+   dip::uint conn = GetAbsBinaryConnectivity( nDims, connectivity, iteration );
+   DIP_THROW_IF( conn > nDims, E::ILLEGAL_CONNECTIVITY );
+   return conn == 0 ? nDims : conn;
+}
+
+template< typename Operator >
+PackedBinaryImage DilationErosion(
+      PackedBinaryImage const& in,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& s_edgeCondition,
+      Operator const& op
+) {
+   DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( connectivity > static_cast< dip::sint >( nDims ), E::PARAMETER_OUT_OF_RANGE );
+   bool edge;
+   DIP_STACK_TRACE_THIS( edge = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND ));
+   PackedBinaryImage out = in;
+   for( dip::uint ii = 0; ii < iterations; ++ii ) {
+      out = DilationErosionStep( out, AbsoluteConnectivity( nDims, connectivity, ii ), edge, op );
+   }
+   return out;
+}
+
+// Propagates the set pixels of `seed` within the row to all pixels connected through `mask`.
+// `seed` must be a subset of `mask`.
+void FillRow( Word* seed, Word const* mask, dip::uint nWords ) {
+   // Towards higher bits
+   Word carry = 0;
+   for( dip::uint ii = 0; ii < nWords; ++ii ) {
+      Word g = seed[ ii ] | ( carry & mask[ ii ] );
+      Word p = mask[ ii ];
+      g |= p & ( g << 1 );
+      p &= p << 1;
+      g |= p & ( g << 2 );
+      p &= p << 2;
+      g |= p & ( g << 4 );
+      p &= p << 4;
+      g |= p & ( g << 8 );
+      p &= p << 8;
+      g |= p & ( g << 16 );
+      p &= p << 16;
+      g |= p & ( g << 32 );
+      seed[ ii ] = g;
+      carry = g >> ( bitsPerWord - 1 );
+   }
+   // Towards lower bits
+   carry = 0;
+   for( dip::uint ii = nWords; ii > 0; ) {
+      --ii;
+      Word g = seed[ ii ] | ( carry & mask[ ii ] );
+      Word p = mask[ ii ];
+      g |= p & ( g >> 1 );
+      p &= p >> 1;
+      g |= p & ( g >> 2 );
+      p &= p >> 2;
+      g |= p & ( g >> 4 );
+      p &= p >> 4;
+      g |= p & ( g >> 8 );
+      p &= p >> 8;
+      g |= p & ( g >> 16 );
+      p &= p >> 16;
+      g |= p & ( g >> 32 );
+      seed[ ii ] = g;
+      carry = g << ( bitsPerWord - 1 );
+   }
+}
+
+// One raster scan of the propagation, either forward (`direction` == -1, propagating from preceding rows)
+// or backward (`direction` == 1, propagating from following rows). Returns true if any pixel was changed.
+bool PropagationScan(
+      PackedBinaryImage& seed,
+      PackedBinaryImage const& mask,
+      std::vector< NeighborRow > const& neighbors,
+      dip::sint direction,
+      std::vector< Word >& buffer
+) {
+   dip::uint nWords = seed.WordsPerRow();
+   dip::uint size0 = seed.Sizes()[ 0 ];
+   RowWalker walker( seed.Sizes() );
+   dip::uint nRows = walker.NumberOfRows();
+   walker.Set( direction < 0 ? 0 : nRows - 1 );
+   bool changed = false;
+   for( dip::uint ii = 0; ii < nRows; ++ii ) {
+      dip::uint row = walker.Row();
+      Word* s = seed.Row( row );
+      Word const* m = mask.Row( row );
+      std::fill( buffer.begin(), buffer.end(), Word( 0 ));
+      for( auto const& nr : neighbors ) {
+         dip::uint neighbor;
+         if(( nr.direction == direction ) && walker.Neighbor( nr.displacement, neighbor )) {
+            Word const* src = seed.Row( neighbor );
+            CombineShiftedRow( buffer.data(), src, 0, false, nWords, size0, OrOperator{} );
+            if( nr.sides ) {
+               CombineShiftedRow( buffer.data(), src, -1, false, nWords, size0, OrOperator{} );
+               CombineShiftedRow( buffer.data(), src, 1, false, nWords, size0, OrOperator{} );
+            }
+         }
+      }
+      bool grow = false;
+      for( dip::uint jj = 0; jj < nWords; ++jj ) {
+         Word add = buffer[ jj ] & m[ jj ] & ~s[ jj ];
+         grow |= add != 0;
+         buffer[ jj ] = s[ jj ] | add;
+      }
+      if( grow ) {
+         FillRow( buffer.data(), m, nWords );
+         std::copy( buffer.begin(), buffer.end(), s );
+         changed = true;
+      }
+      if( direction < 0 ) {
+         walker.Next();
+      } else if( ii + 1 < nRows ) {
+         walker.Previous();
+      }
+   }
+   return changed;
+}
+
+// Unpacks the bit-sliced counters in `planes` for one row and writes them to `out`
+void WriteCounts( std::vector< Word > const& planes, dip::uint nPlanes, dip::uint nWords, dip::uint size0, uint8* out, dip::sint stride ) {
+   for( dip::uint x = 0; x < size0; ++x, out += stride ) {
+      dip::uint word = x / bitsPerWord;
+      dip::uint bit = x % bitsPerWord;
+      uint8 count = 0;
+      for( dip::uint p = 0; p < nPlanes; ++p ) {
+         count = static_cast< uint8 >( count | ((( planes[ p * nWords + word ] >> bit ) & 1u ) << p ));
+      }
+      *out = count;
+   }
+}
+
+// Adds one to the bit-sliced counters in `planes` for each set bit in `value`
+void AddToCounters( std::vector< Word >& planes, dip::uint nPlanes, dip::uint nWords, Word const* value ) {
+   for( dip::uint ii = 0; ii < nWords; ++ii ) {
+      Word carry = value[ ii ];
+      for( dip::uint p = 0; ( p < nPlanes ) && carry; ++p ) {
+         Word& plane = planes[ p * nWords + ii ];
+         Word next = plane & carry;
+         plane ^= carry;
+         carry = next;
+      }
+   }
+}
+
+// A run of set pixels along a row
+struct Run {
+   dip::uint start;
+   dip::uint end; // inclusive
+};
+
+void ExtractRuns( Word const* row, dip::uint nWords, dip::uint size0, std::vector< Run >& runs ) {
+   bool inRun = false;
+   dip::uint start = 0;
+   for( dip::uint ii = 0; ii < nWords; ++ii ) {
+      Word word = row[ ii ];
+      dip::uint bit = 0;
+      while( bit < bitsPerWord ) {
+         Word rest = ( inRun ? ~word : word ) >> bit;
+         if( rest == 0 ) {
+            break; // the current state continues into the next word
+         }
+         bit += CountTrailingZeros( rest );
+         if( inRun ) {
+            runs.push_back( { start, ii * bitsPerWord + bit - 1 } );
+         } else {
+            start = ii * bitsPerWord + bit;
+         }
+         inRun = !inRun;
+      }
+   }
+   if( inRun ) {
+      runs.push_back( { start, size0 - 1 } );
+   }
+}
+
+using RunRegionList = UnionFind< LabelType, dip::uint, std::plus< dip::uint >>;
+
+// Merges the regions of overlapping runs in two rows. `extend` is 1 if runs that touch diagonally are connected.
+void ConnectRuns(
+      RunRegionList& regions,
+      std::vector< Run > const& runs,
+      dip::uint first1, dip::uint last1,
+      dip::uint first2, dip::uint last2,
+      dip::uint extend
+) {
+   dip::uint ii = first1;
+   dip::uint jj = first2;
+   while(( ii < last1 ) && ( jj < last2 )) {
+      Run const& a = runs[ ii ];
+      Run const& b = runs[ jj ];
+      if( b.end + extend < a.start ) {
+         ++jj;
+      } else if( a.end + extend < b.start ) {
+         ++ii;
+      } else {
+         regions.Union( static_cast< LabelType >( ii + 1 ), static_cast< LabelType >( jj + 1 ));
+         if( a.end < b.end ) {
+            ++ii;
+         } else {
+            ++jj;
+         }
+      }
+   }
+}
+
+} // namespace
+
+PackedBinaryImage::PackedBinaryImage( UnsignedArray const& sizes ) {
+   DIP_THROW_IF( sizes.empty(), E::DIMENSIONALITY_NOT_SUPPORTED );
+   DIP_THROW_IF( sizes.product() == 0, E::INVALID_PARAMETER );
+   sizes_ = sizes;
+   wordsPerRow_ = div_ceil( sizes[ 0 ], bitsPerWord );
+   data_.resize( wordsPerRow_ * ( sizes.product() / sizes[ 0 ] ), Word( 0 ));
+}
+
+PackedBinaryImage::PackedBinaryImage( Image const& binary ) {
+   DIP_THROW_IF( !binary.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !binary.DataType().IsBinary(), E::IMAGE_NOT_BINARY );
+   DIP_THROW_IF( !binary.IsScalar(), E::IMAGE_NOT_SCALAR );
+   DIP_STACK_TRACE_THIS( *this = PackedBinaryImage( binary.Sizes() ));
+   dip::uint size0 = sizes_[ 0 ];
+   dip::sint stride = binary.Stride( 0 );
+   bin const* origin = static_cast< bin const* >( binary.Origin() );
+   ForEachImageRow( binary, [ & ]( dip::uint row, dip::sint offset ) {
+      bin const* in = origin + offset;
+      Word* out = Row( row );
+      for( dip::uint ii = 0; ii < size0; ii += bitsPerWord, ++out ) {
+         dip::uint n = std::min( bitsPerWord, size0 - ii );
+         Word word = 0;
+         for( dip::uint jj = 0; jj < n; ++jj, in += stride ) {
+            word |= static_cast< Word >( static_cast< bool >( *in )) << jj;
+         }
+         *out = word;
+      }
+   } );
+}
+
+dip::uint PackedBinaryImage::Count() const {
+   dip::uint count = 0;
+   for( auto word : data_ ) {
+      count += CountBits( word );
+   }
+   return count;
+}
+
+void PackedBinaryImage::Unpack( Image& out ) const {
+   DIP_THROW_IF( !IsForged(), E::IMAGE_NOT_FORGED );
+   out.ReForge( sizes_, 1, DT_BIN );
+   dip::uint size0 = sizes_[ 0 ];
+   dip::sint stride = out.Stride( 0 );
+   bin* origin = static_cast< bin* >( out.Origin() );
+   ForEachImageRow( out, [ & ]( dip::uint row, dip::sint offset ) {
+      bin* dest = origin + offset;
+      Word const* in = Row( row );
+      for( dip::uint ii = 0; ii < size0; ii += bitsPerWord, ++in ) {
+         dip::uint n = std::min( bitsPerWord, size0 - ii );
+         Word word = *in;
+         for( dip::uint jj = 0; jj < n; ++jj, dest += stride ) {
+            *dest = static_cast< bool >(( word >> jj ) & 1u );
+         }
+      }
+   } );
+}
+
+PackedBinaryImage BinaryDilation(
+      PackedBinaryImage const& in,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& edgeCondition
+) {
+   return DilationErosion( in, connectivity, iterations, edgeCondition, OrOperator{} );
+}
+
+PackedBinaryImage BinaryErosion(
+      PackedBinaryImage const& in,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& edgeCondition
+) {
+   return DilationErosion( in, connectivity, iterations, edgeCondition, AndOperator{} );
+}
+
+PackedBinaryImage BinaryPropagation(
+      PackedBinaryImage const& inSeed,
+      PackedBinaryImage const& inMask,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& s_edgeCondition
+) {
+   DIP_THROW_IF( !inMask.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( inSeed.IsForged() && ( inSeed.Sizes() != inMask.Sizes() ), E::SIZES_DONT_MATCH );
+   dip::uint nDims = inMask.Dimensionality();
+   DIP_THROW_IF( connectivity > static_cast< dip::sint >( nDims ), E::PARAMETER_OUT_OF_RANGE );
+   bool edge;
+   DIP_STACK_TRACE_THIS( edge = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND ));
+   PackedBinaryImage seed = inSeed.IsForged() ? inSeed : PackedBinaryImage( inMask.Sizes() );
+   dip::uint nWords = inMask.WordsPerRow();
+   dip::uint nRows = inMask.NumberOfRows();
+
+   // The first iteration propagates from the seeds (which can be outside the mask) and from the image edge
+   dip::uint conn0 = AbsoluteConnectivity( nDims, connectivity, 0 );
+   PackedBinaryImage out = DilationErosionStep( seed, conn0, edge, OrOperator{} );
+   for( dip::uint row = 0; row < nRows; ++row ) {
+      Word* dest = out.Row( row );
+      Word const* mask = inMask.Row( row );
+      for( dip::uint ii = 0; ii < nWords; ++ii ) {
+         dest[ ii ] &= mask[ ii ];
+      }
+   }
+   if( iterations == 1 ) {
+      return out;
+   }
+
+   if(( iterations == 0 ) && ( GetAbsBinaryConnectivity( nDims, connectivity, 1 ) == GetAbsBinaryConnectivity( nDims, connectivity, 0 ))) {
+      // Propagate until idempotence, using alternating raster scans
+      std::vector< NeighborRow > neighbors = ListNeighborRows( nDims, conn0 );
+      std::vector< Word > buffer( nWords );
+      for( dip::uint row = 0; row < nRows; ++row ) {
+         FillRow( out.Row( row ), inMask.Row( row ), nWords );
+      }
+      if( nRows > 1 ) {
+         bool changed = true;
+         while( changed ) {
+            changed = PropagationScan( out, inMask, neighbors, -1, buffer );
+            changed |= PropagationScan( out, inMask, neighbors, 1, buffer );
+         }
+      }
+      return out;
+   }
+
+   // A limited number of iterations (or an alternating connectivity): propagate from the pixels that were
+   // added in the previous iteration only, as `dip::BinaryPropagation` does
+   PackedBinaryImage front = out;
+   for( dip::uint row = 0; row < nRows; ++row ) {
+      Word* dest = front.Row( row );
+      Word const* s = seed.Row( row );
+      for( dip::uint ii = 0; ii < nWords; ++ii ) {
+         dest[ ii ] &= ~s[ ii ];
+      }
+   }
+   for( dip::uint iter = 1; ( iterations == 0 ) || ( iter < iterations ); ++iter ) {
+      PackedBinaryImage grown = DilationErosionStep( front, AbsoluteConnectivity( nDims, connectivity, iter ), false, OrOperator{} );
+      bool any = false;
+      for( dip::uint row = 0; row < nRows; ++row ) {
+         Word* f = front.Row( row );
+         Word* o = out.Row( row );
+         Word const* g = grown.Row( row );
+         Word const* m = inMask.Row( row );
+         for( dip::uint ii = 0; ii < nWords; ++ii ) {
+            f[ ii ] = g[ ii ] & m[ ii ] & ~o[ ii ];
+            o[ ii ] |= f[ ii ];
+            any |= f[ ii ] != 0;
+         }
+      }
+      if( !any ) {
+         break;
+      }
+   }
+   return out;
+}
+
+void CountNeighbors(
+      PackedBinaryImage const& in,
+      Image& out,
+      dip::uint connectivity,
+      dip::String const& s_mode,
+      dip::String const& s_edgeCondition
+) {
+   DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( connectivity > nDims, E::ILLEGAL_CONNECTIVITY );
+   if( connectivity == 0 ) {
+      connectivity = nDims;
+   }
+   bool all;
+   DIP_STACK_TRACE_THIS( all = BooleanFromString( s_mode, S::ALL, S::FOREGROUND ));
+   bool edge;
+   DIP_STACK_TRACE_THIS( edge = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND ));
+   out.ReForge( in.Sizes(), 1, DT_UINT8 );
+
+   std::vector< NeighborRow > neighbors = ListNeighborRows( nDims, connectivity );
+   dip::uint nNeighbors = 0;
+   for( auto const& nr : neighbors ) {
+      nNeighbors += ( nr.direction != 0 ? 1u : 0u ) + ( nr.sides ? 2u : 0u );
+   }
+   dip::uint nPlanes = 1;
+   while(( nPlanes < 8 ) && (( dip::uint( 1 ) << nPlanes ) <= nNeighbors + 1 )) {
+      ++nPlanes;
+   }
+   dip::uint nWords = in.WordsPerRow();
+   dip::uint size0 = in.Sizes()[ 0 ];
+   std::vector< Word > planes( nPlanes * nWords );
+   std::vector< Word > buffer( nWords );
+
+   RowWalker walker( in.Sizes() );
+   dip::sint stride = out.Stride( 0 );
+   uint8* origin = static_cast< uint8* >( out.Origin() );
+   ForEachImageRow( out, [ & ]( dip::uint row, dip::sint offset ) {
+      std::fill( planes.begin(), planes.end(), Word( 0 ));
+      Word const* center = in.Row( row );
+      AddToCounters( planes, nPlanes, nWords, center );
+      for( auto const& nr : neighbors ) {
+         dip::uint neighbor;
+         Word const* src = walker.Neighbor( nr.displacement, neighbor ) ? in.Row( neighbor ) : nullptr;
+         if( nr.direction != 0 ) {
+            CombineShiftedRow( buffer.data(), src, 0, edge, nWords, size0, AssignOperator{} );
+            AddToCounters( planes, nPlanes, nWords, buffer.data() );
+         }
+         if( nr.sides ) {
+            CombineShiftedRow( buffer.data(), src, -1, edge, nWords, size0, AssignOperator{} );
+            AddToCounters( planes, nPlanes, nWords, buffer.data() );
+            CombineShiftedRow( buffer.data(), src, 1, edge, nWords, size0, AssignOperator{} );
+            AddToCounters( planes, nPlanes, nWords, buffer.data() );
+         }
+      }
+      if( !all ) {
+         for( dip::uint p = 0; p < nPlanes; ++p ) {
+            for( dip::uint ii = 0; ii < nWords; ++ii ) {
+               planes[ p * nWords + ii ] &= center[ ii ];
+            }
+         }
+      }
+      WriteCounts( planes, nPlanes, nWords, size0, origin + offset, stride );
+      walker.Next();
+   } );
+}
+
+dip::uint Label(
+      PackedBinaryImage const& binary,
+      Image& out,
+      dip::uint connectivity,
+      dip::uint minSize,
+      dip::uint maxSize
+) {
+   DIP_THROW_IF( !binary.IsForged(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = binary.Dimensionality();
+   DIP_THROW_IF( connectivity > nDims, E::PARAMETER_OUT_OF_RANGE );
+   if( connectivity == 0 ) {
+      connectivity = nDims;
+   }
+   dip::uint nWords = binary.WordsPerRow();
+   dip::uint nRows = binary.NumberOfRows();
+   dip::uint size0 = binary.Sizes()[ 0 ];
+
+   // Extract the runs; runs in row `row` are `runs[ firstRun[ row ] ]` until `runs[ firstRun[ row + 1 ] ]`
+   std::vector< Run > runs;
+   std::vector< dip::uint > firstRun( nRows + 1 );
+   for( dip::uint row = 0; row < nRows; ++row ) {
+      firstRun[ row ] = runs.size();
+      ExtractRuns( binary.Row( row ), nWords, size0, runs );
+   }
+   firstRun[ nRows ] = runs.size();
+   DIP_THROW_IF( runs.size() >= std::numeric_limits< LabelType >::max(), "Cannot create more regions!" );
+
+   // Each run is a region, connected runs are merged
+   RunRegionList regions{ std::plus< dip::uint >{} };
+   for( auto const& run : runs ) {
+      regions.Create( run.end - run.start + 1 );
+   }
+   std::vector< NeighborRow > neighbors = ListNeighborRows( nDims, connectivity );
+   RowWalker walker( binary.Sizes() );
+   for( dip::uint row = 0; row < nRows; ++row, walker.Next() ) {
+      if( firstRun[ row ] == firstRun[ row + 1 ] ) {
+         continue;
+      }
+      for( auto const& nr : neighbors ) {
+         dip::uint neighbor;
+         if(( nr.direction < 0 ) && walker.Neighbor( nr.displacement, neighbor )) {
+            ConnectRuns( regions, runs, firstRun[ row ], firstRun[ row + 1 ], firstRun[ neighbor ], firstRun[ neighbor + 1 ], nr.sides ? 1 : 0 );
+         }
+      }
+   }
+
+   // Relabel
+   dip::uint nLabel;
+   if(( minSize > 0 ) && ( maxSize > 0 )) {
+      nLabel = regions.Relabel(
+            [ & ]( dip::uint size ){ return ( size >= minSize ) && ( size <= maxSize ); }
+      );
+   } else if( minSize > 0 ) {
+      nLabel = regions.Relabel(
+            [ & ]( dip::uint size ){ return size >= minSize; }
+      );
+   } else if( maxSize > 0 ) {
+      nLabel = regions.Relabel(
+            [ & ]( dip::uint size ){ return size <= maxSize; }
+      );
+   } else {
+      nLabel = regions.Relabel();
+   }
+
+   // Paint the runs
+   out.ReForge( binary.Sizes(), 1, DT_LABEL );
+   out.Fill( 0 );
+   dip::sint stride = out.Stride( 0 );
+   LabelType* origin = static_cast< LabelType* >( out.Origin() );
+   ForEachImageRow( out, [ & ]( dip::uint row, dip::sint offset ) {
+      for( dip::uint ii = firstRun[ row ]; ii < firstRun[ row + 1 ]; ++ii ) {
+         LabelType label = regions.Label( static_cast< LabelType >( ii + 1 ));
+         if( label > 0 ) {
+            LabelType* dest = origin + offset + static_cast< dip::sint >( runs[ ii ].start ) * stride;
+            for( dip::uint x = runs[ ii ].start; x <= runs[ ii ].end; ++x, dest += stride ) {
+               *dest = label;
+            }
+         }
+      }
+   } );
+   return nLabel;
+}
+
+} // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/binary.h"
+#include "diplib/regions.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the bit-packed binary image filters") {
+   dip::Random random( 0 );
+   for( dip::UnsignedArray sizes : { dip::UnsignedArray{ 200, 37 }, dip::UnsignedArray{ 64, 10 }, dip::UnsignedArray{ 70, 9, 6 }, dip::UnsignedArray{ 130 } } ) {
+      dip::uint nDims = sizes.size();
+      dip::Image noise( sizes, 1, dip::DT_SFLOAT );
+      noise.Fill( 0 );
+      dip::UniformNoise( noise, noise, random );
+      dip::Image in = noise > 0.6;
+      dip::Image mask = noise > 0.35;
+      dip::PackedBinaryImage packed( in );
+      DOCTEST_CHECK( dip::testing::CompareImages( packed.Unpack(), in ));
+      DOCTEST_CHECK( packed.Count() == dip::Count( in ));
+      dip::sint minConnectivity = nDims > 1 ? -static_cast< dip::sint >( nDims ) : 0; // alternating connectivity is only for 2D and 3D
+      for( dip::sint connectivity = minConnectivity; connectivity <= static_cast< dip::sint >( nDims ); ++connectivity ) {
+         for( dip::String edge : { dip::S::BACKGROUND, dip::S::OBJECT } ) {
+            DOCTEST_CHECK( dip::testing::CompareImages( dip::BinaryDilation( packed, connectivity, 3, edge ).Unpack(),
+                                                        dip::BinaryDilation( in, connectivity, 3, edge )));
+            DOCTEST_CHECK( dip::testing::CompareImages( dip::BinaryErosion( packed, connectivity, 2, edge ).Unpack(),
+                                                        dip::BinaryErosion( in, connectivity, 2, edge )));
+            for( dip::uint iterations : { 0u, 4u } ) {
+               DOCTEST_CHECK( dip::testing::CompareImages( dip::BinaryPropagation( packed, dip::PackedBinaryImage( mask ), connectivity, iterations, edge ).Unpack(),
+                                                           dip::BinaryPropagation( in, mask, connectivity, iterations, edge )));
+            }
+         }
+         if( connectivity >= 0 ) {
+            dip::uint conn = static_cast< dip::uint >( connectivity );
+            DOCTEST_CHECK( dip::testing::CompareImages( dip::CountNeighbors( packed, conn, dip::S::ALL, dip::S::OBJECT ),
+                                                        dip::CountNeighbors( in, conn, dip::S::ALL, dip::S::OBJECT )));
+            DOCTEST_CHECK( dip::testing::CompareImages( dip::CountNeighbors( packed, conn ), dip::CountNeighbors( in, conn )));
+            dip::Image lab1, lab2;
+            dip::uint n1 = dip::Label( packed, lab1, conn, 2, 40 );
+            dip::uint n2 = dip::Label( in, lab2, conn, 2, 40 );
+            DOCTEST_CHECK( n1 == n2 );
+            DOCTEST_CHECK( dip::testing::CompareImages( lab1, lab2 ));
+         }
+      }
+   }
+}
+
+#endif // DIP__ENABLE_DOCTEST
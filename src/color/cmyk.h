@@ -33,6 +33,9 @@ class rgb2cmy : public ColorSpaceConverter {
             output[ 2 ] = 255.0 - input[ 2 ];
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { -1.0, 0.0, 0.0,   0.0, -1.0, 0.0,   0.0, 0.0, -1.0,   255.0, 255.0, 255.0 };
+      }
 };
 
 class cmy2rgb : public ColorSpaceConverter {
@@ -46,6 +49,9 @@ class cmy2rgb : public ColorSpaceConverter {
             output[ 2 ] = ( 255.0 - input[ 2 ] );
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { -1.0, 0.0, 0.0,   0.0, -1.0, 0.0,   0.0, 0.0, -1.0,   255.0, 255.0, 255.0 };
+      }
 };
 
 class cmy2cmyk : public ColorSpaceConverter {
@@ -20,6 +20,7 @@
  */
 
 #include <queue>
+#include <mutex>
 
 #include "diplib.h"
 #include "diplib/color.h"
@@ -48,7 +49,7 @@ constexpr ColorSpaceManager::XYZ ColorSpaceManager::IlluminantD55;
 constexpr ColorSpaceManager::XYZ ColorSpaceManager::IlluminantD65;
 constexpr ColorSpaceManager::XYZ ColorSpaceManager::IlluminantE;
 
-ColorSpaceManager::ColorSpaceManager() {
+ColorSpaceManager::ColorSpaceManager() : planCache_( std::make_shared< ConversionPlanCache >() ) {
    // grey (or gray)
    Define( "grey", 1 );
    DefineAlias( "gray", "grey" );
@@ -138,88 +139,246 @@ ColorSpaceManager::ColorSpaceManager() {
 
 namespace {
 
-struct ConversionStep {
-   ColorSpaceConverter const* converterFunction;
-   dip::uint nOutputChannels;
-   bool last = false;
+// A compiled sequence of conversion steps, see `ColorSpaceManager::Convert()`.
+class ConversionPlan {
+   public:
+      struct Step {
+         std::shared_ptr< ColorSpaceConverter > converter; // If null, this step is an affine transformation
+         std::vector< dfloat > matrix;                      // nOutputChannels x ( nInputChannels + 1 ), column-major
+         dip::uint nInputChannels;
+         dip::uint nOutputChannels;
+      };
+
+      std::vector< std::shared_ptr< ColorSpaceConverter >> path; // The converters this plan was compiled from
+      DataType dataType;                                          // The input image type this plan was compiled for
+      DataType inputType;                                         // The buffer type expected for the input image
+      std::vector< dfloat > lut;                                  // The first step as a look-up table, nLutChannels x nLutValues
+      dip::uint nLutChannels = 0;
+      dip::uint nLutValues = 0;
+      std::vector< Step > steps;
+      dip::uint maxChannels = 0;
+      dip::uint cost = 0;
+
+      ConversionPlan( std::vector< std::shared_ptr< ColorSpaceConverter >> converters, std::vector< dip::uint > const& nChannels, DataType imageType )
+            : path( std::move( converters )), dataType( imageType ), inputType( DT_DFLOAT ) {
+         DIP_ASSERT( nChannels.size() == path.size() + 1 );
+         maxChannels = *std::max_element( nChannels.begin(), nChannels.end() );
+         dip::uint first = 0;
+         if((( imageType == DT_UINT8 ) || ( imageType == DT_UINT16 )) && path[ 0 ]->IsChannelwise() && ( nChannels[ 0 ] == nChannels[ 1 ] )) {
+            // Tabulate the first step for all possible input values
+            inputType = imageType;
+            nLutChannels = nChannels[ 0 ];
+            nLutValues = imageType == DT_UINT8 ? 256 : 65536;
+            std::vector< dfloat > values( nLutChannels * nLutValues );
+            for( dip::uint jj = 0; jj < nLutChannels; ++jj ) {
+               for( dip::uint ii = 0; ii < nLutValues; ++ii ) {
+                  values[ jj * nLutValues + ii ] = static_cast< dfloat >( ii );
+               }
+            }
+            lut.resize( nLutChannels * nLutValues );
+            ConstLineIterator< dfloat > input( values.data(), nLutValues, 1, nLutChannels, static_cast< dip::sint >( nLutValues ));
+            LineIterator< dfloat > output( lut.data(), nLutValues, 1, nLutChannels, static_cast< dip::sint >( nLutValues ));
+            path[ 0 ]->Convert( input, output );
+            cost = 10;
+            first = 1;
+         }
+         for( dip::uint ii = first; ii < path.size(); ++ii ) {
+            Step step{ nullptr, path[ ii ]->AffineMatrix(), nChannels[ ii ], nChannels[ ii + 1 ] };
+            if( step.matrix.empty() ) {
+               step.converter = path[ ii ];
+               steps.push_back( std::move( step ));
+               continue;
+            }
+            DIP_ASSERT( step.matrix.size() == step.nOutputChannels * ( step.nInputChannels + 1 ));
+            if( !steps.empty() && !steps.back().converter ) {
+               // Combine with the previous affine step: [A2 b2] * [A1 b1; 0 1] = [A2*A1, A2*b1+b2]
+               Step& previous = steps.back();
+               dip::uint nIn = previous.nInputChannels;
+               dip::uint nMid = step.nInputChannels;
+               dip::uint nOut = step.nOutputChannels;
+               std::vector< dfloat > matrix( nOut * ( nIn + 1 ), 0.0 );
+               for( dip::uint kk = 0; kk <= nIn; ++kk ) {
+                  for( dip::uint jj = 0; jj < nMid; ++jj ) {
+                     for( dip::uint rr = 0; rr < nOut; ++rr ) {
+                        matrix[ kk * nOut + rr ] += step.matrix[ jj * nOut + rr ] * previous.matrix[ kk * nMid + jj ];
+                     }
+                  }
+               }
+               for( dip::uint rr = 0; rr < nOut; ++rr ) {
+                  matrix[ nIn * nOut + rr ] += step.matrix[ nMid * nOut + rr ];
+               }
+               previous.matrix = std::move( matrix );
+               previous.nOutputChannels = nOut;
+            } else {
+               steps.push_back( std::move( step ));
+            }
+         }
+         for( auto const& step : steps ) {
+            dip::uint c = step.converter ? step.converter->Cost() : 1;
+            if( c >= 100 ) {
+               c -= 99; // This is usually the case for conversion to gray, to indicate data loss
+            }
+            cost += 50 * c; // This is very rough, most methods indicate a cost of 1 through 3, which we map here to 50-150.
+         }
+      }
 };
 
-using ConversionStepArray = std::vector< ConversionStep >;
+} // namespace
 
-class ConverterLineFilter : public Framework::ScanLineFilter {
+// Holds compiled plans. `Find()` and `Insert()` can be called from multiple threads concurrently.
+class ColorSpaceManager::ConversionPlanCache {
    public:
-      ConverterLineFilter( ConversionStepArray const& steps ) : steps_( steps ) {
-         maxIntermediateChannels_ = steps[ 0 ].nOutputChannels;
-         for( dip::uint ii = 1; ii < steps.size() - 1; ++ii ) {
-            maxIntermediateChannels_ = std::max( maxIntermediateChannels_, steps[ 1 ].nOutputChannels );
+      using PlanPointer = std::shared_ptr< ConversionPlan const >;
+
+      PlanPointer Find( std::vector< ColorSpaceConverterPointer > const& path, DataType dataType ) {
+         std::lock_guard< std::mutex > guard( mutex_ );
+         for( auto const& plan : plans_ ) {
+            if(( plan->dataType == dataType ) && ( plan->path == path )) {
+               return plan;
+            }
+         }
+         return nullptr;
+      }
+
+      void Insert( PlanPointer plan ) {
+         std::lock_guard< std::mutex > guard( mutex_ );
+         if( plans_.size() >= maxPlans ) {
+            plans_.erase( plans_.begin() );
          }
-         nBuffers_ = std::min< dip::uint >( 2, steps.size() - 1 );
+         plans_.push_back( std::move( plan ));
       }
+
+      void Clear() {
+         std::lock_guard< std::mutex > guard( mutex_ );
+         plans_.clear();
+      }
+
+   private:
+      static constexpr dip::uint maxPlans = 32;
+      std::vector< PlanPointer > plans_;
+      std::mutex mutex_;
+};
+
+void ColorSpaceManager::ClearPlanCache() const {
+   planCache_->Clear();
+}
+
+namespace {
+
+class ConverterLineFilter : public Framework::ScanLineFilter {
+   public:
+      ConverterLineFilter( ConversionPlan const& plan ) : plan_( plan ) {}
       virtual void SetNumberOfThreads( dip::uint threads ) override {
-         buffer1_.resize( threads );
-         buffer2_.resize( threads );
+         buffers_.resize( threads );
       }
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
-         dip::uint cost = 0;
-         for( auto const& step : steps_ ) {
-            dip::uint c = step.converterFunction->Cost();
-            if( c >= 100 ) {
-               c -= 99; // This is usually the case for conversion to gray, to indicate data loss
-            }
-            cost += 50 * c; // This is very rough, most methods indicate a cost of 1 through 3, which we map here to 50-150.
-         }
-         return cost;
+         return plan_.cost;
       }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
-         dip::uint thread = params.thread;
+         // We process the line in blocks, stored with the channels as separate rows of `blockSize` samples, so
+         // that the affine steps and the converters' inner loops access memory contiguously. We alternate
+         // between two such buffers, so the conversion functions don't need to worry about input and output
+         // being the same buffer.
+         auto& buffer = buffers_[ params.thread ];
+         buffer.resize( 2 * plan_.maxChannels * blockSize );
+         dfloat* bufferA = buffer.data();
+         dfloat* bufferB = bufferA + plan_.maxChannels * blockSize;
          dip::uint nPixels = params.bufferLength;
-         if( nBuffers_ > 0 ) {
-            if( buffer1_[ thread ].size() != nPixels * maxIntermediateChannels_ ) {
-               buffer1_[ thread ].resize( nPixels * maxIntermediateChannels_ );
-               if( nBuffers_ > 1 ) {
-                  buffer2_[ thread ].resize( nPixels * maxIntermediateChannels_ );
+         dip::sint inStride = params.inBuffer[ 0 ].stride;
+         dip::sint inTStride = params.inBuffer[ 0 ].tensorStride;
+         dip::uint inChans = params.inBuffer[ 0 ].tensorLength;
+         dfloat* out = static_cast< dfloat* >( params.outBuffer[ 0 ].buffer );
+         dip::sint outStride = params.outBuffer[ 0 ].stride;
+         dip::sint outTStride = params.outBuffer[ 0 ].tensorStride;
+         for( dip::uint start = 0; start < nPixels; start += blockSize ) {
+            dip::uint n = std::min( blockSize, nPixels - start );
+            dfloat* src = bufferA;
+            dfloat* dest = bufferB;
+            dip::uint nChans = inChans;
+            switch( plan_.inputType ) {
+               case DT_UINT8:
+                  Load( static_cast< uint8 const* >( params.inBuffer[ 0 ].buffer ) + static_cast< dip::sint >( start ) * inStride,
+                        inStride, inTStride, inChans, n, src );
+                  break;
+               case DT_UINT16:
+                  Load( static_cast< uint16 const* >( params.inBuffer[ 0 ].buffer ) + static_cast< dip::sint >( start ) * inStride,
+                        inStride, inTStride, inChans, n, src );
+                  break;
+               default:
+                  Load( static_cast< dfloat const* >( params.inBuffer[ 0 ].buffer ) + static_cast< dip::sint >( start ) * inStride,
+                        inStride, inTStride, inChans, n, src );
+                  break;
+            }
+            for( auto const& step : plan_.steps ) {
+               if( step.converter ) {
+                  ConstLineIterator< dfloat > input( src, n, 1, nChans, blockSize );
+                  LineIterator< dfloat > output( dest, n, 1, step.nOutputChannels, blockSize );
+                  step.converter->Convert( input, output );
+               } else {
+                  Affine( step, src, dest, n );
+               }
+               std::swap( src, dest );
+               nChans = step.nOutputChannels;
+            }
+            dfloat* outPtr = out + static_cast< dip::sint >( start ) * outStride;
+            for( dip::uint jj = 0; jj < nChans; ++jj ) {
+               dfloat const* channel = src + jj * blockSize;
+               dfloat* outLine = outPtr + static_cast< dip::sint >( jj ) * outTStride;
+               for( dip::uint ii = 0; ii < n; ++ii, outLine += outStride ) {
+                  *outLine = channel[ ii ];
                }
             }
          }
-         dfloat* buffer1 = buffer1_[ thread ].data(); // Might not be used...
-         dfloat* buffer2 = buffer2_[ thread ].data(); // Might not be used...
-         // We initialize 'out' parameters to the input.
-         dfloat* out = static_cast< dfloat* >( params.inBuffer[ 0 ].buffer );
-         dip::sint outStride = params.inBuffer[ 0 ].stride;
-         dip::sint outTStride = params.inBuffer[ 0 ].tensorStride;
-         dip::uint outChans = params.inBuffer[ 0 ].tensorLength;
-         for( auto const& step : steps_ ) {
-            // At each iteration, we read from the previous `out`
-            ConstLineIterator< dfloat > input( out, nPixels, outStride, outChans, outTStride );
-            // At each iteration, we write to either the output image, or an intermediate buffer
-            outChans = step.nOutputChannels;
-            if( step.last ) {
-               out = static_cast< dfloat* >( params.outBuffer[ 0 ].buffer );
-               outStride = params.outBuffer[ 0 ].stride;
-               outTStride = params.outBuffer[ 0 ].tensorStride;
+      }
+   private:
+      static constexpr dip::uint blockSize = 256;
+      ConversionPlan const& plan_;
+      std::vector< std::vector< dfloat >> buffers_; // one for each thread
+
+      // Copies a block of pixels into the buffer, applying the look-up table if there is one
+      template< typename TPI >
+      void Load( TPI const* in, dip::sint stride, dip::sint tStride, dip::uint nChans, dip::uint n, dfloat* dest ) const {
+         for( dip::uint jj = 0; jj < nChans; ++jj ) {
+            TPI const* inLine = in + static_cast< dip::sint >( jj ) * tStride;
+            dfloat* channel = dest + jj * blockSize;
+            if( plan_.nLutChannels > 0 ) {
+               dfloat const* lut = plan_.lut.data() + jj * plan_.nLutValues;
+               for( dip::uint ii = 0; ii < n; ++ii, inLine += stride ) {
+                  channel[ ii ] = lut[ static_cast< dip::uint >( *inLine ) ];
+               }
             } else {
-               out = out == buffer1 ? buffer2 : buffer1;
-               outStride = static_cast< dip::sint >( outChans );
-               outTStride = 1;
+               for( dip::uint ii = 0; ii < n; ++ii, inLine += stride ) {
+                  channel[ ii ] = static_cast< dfloat >( *inLine );
+               }
+            }
+         }
+      }
+
+      static void Affine( ConversionPlan::Step const& step, dfloat const* src, dfloat* dest, dip::uint n ) {
+         dip::uint nIn = step.nInputChannels;
+         dip::uint nOut = step.nOutputChannels;
+         for( dip::uint rr = 0; rr < nOut; ++rr ) {
+            dfloat* channel = dest + rr * blockSize;
+            dfloat offset = step.matrix[ nIn * nOut + rr ];
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               channel[ ii ] = offset;
+            }
+            for( dip::uint jj = 0; jj < nIn; ++jj ) {
+               dfloat weight = step.matrix[ jj * nOut + rr ];
+               if( weight == 0.0 ) {
+                  continue;
+               }
+               dfloat const* input = src + jj * blockSize;
+               for( dip::uint ii = 0; ii < n; ++ii ) {
+                  channel[ ii ] += weight * input[ ii ];
+               }
             }
-            LineIterator< dfloat > output( out, nPixels, outStride, outChans, outTStride );
-            step.converterFunction->Convert( input, output );
          }
       }
-   private:
-      ConversionStepArray const& steps_;
-      dip::uint maxIntermediateChannels_;
-      dip::uint nBuffers_;
-      std::vector< std::vector< dfloat >> buffer1_; // one for each thread
-      std::vector< std::vector< dfloat >> buffer2_; // one for each thread
-      // We use up to 2 buffers. If there's 1 step, we don't need a buffer, we can read from in and write to out.
-      // If we have 2 steps, we need one buffer (in->buffer->out). If we have more steps, then we need 2 buffers,
-      // which are alternated at each step. The last steps always writes to out, and the first step always reads
-      // from in.
-      // This means that the conversion functions don't need to worry about input and output being the same buffer.
-      // It also means we don't need to worry about how many channels an intermediate representation needs.
 };
 
+constexpr dip::uint ConverterLineFilter::blockSize;
+
 } // namespace
 
 void ColorSpaceManager::Convert(
@@ -248,30 +407,35 @@ void ColorSpaceManager::Convert(
                                   ( startColorSpace.empty() ? "grey" : startColorSpace ) + " and " +
                                   ( endColorSpace.empty() ? "grey" : endColorSpace ) );
       DIP_ASSERT( path.size() > 1 ); // It should have at least start and stop on it!
-      // Collect information about the converter functions along the path
+      // Collect the converter functions along the path
       dip::uint nSteps = path.size() - 1;
-      ConversionStepArray steps( nSteps );
-      //std::cout << "Found path: ";
+      std::vector< ColorSpaceConverterPointer > converters( nSteps );
+      std::vector< dip::uint > nChannels( nSteps + 1 );
+      nChannels[ 0 ] = colorSpaces_[ path[ 0 ]].nChannels;
       for( dip::uint ii = 0; ii < nSteps; ++ii ) {
-         //std::cout << colorSpaces_[ path[ ii ] ].name << " -> ";
-         steps[ ii ].nOutputChannels = colorSpaces_[ path[ ii + 1 ] ].nChannels;
+         nChannels[ ii + 1 ] = colorSpaces_[ path[ ii + 1 ] ].nChannels;
          auto it = colorSpaces_[ path[ ii ] ].edges.find( path[ ii + 1 ] );
          DIP_ASSERT( it != colorSpaces_[ path[ ii ] ].edges.end() );
-         steps[ ii ].converterFunction = it->second.get();
+         converters[ ii ] = it->second;
+      }
+      // Find or compile the plan
+      DataType dataType = in.DataType();
+      if(( dataType != DT_UINT8 ) && ( dataType != DT_UINT16 )) {
+         dataType = DT_DFLOAT;
+      }
+      auto plan = planCache_->Find( converters, dataType );
+      if( !plan ) {
+         DIP_START_STACK_TRACE
+            plan = std::make_shared< ConversionPlan const >( std::move( converters ), nChannels, dataType );
+         DIP_END_STACK_TRACE
+         planCache_->Insert( plan );
       }
-      steps.back().last = true;
-      //std::cout << colorSpaces_[ path.back() ].name << std::endl;
       // Call scan framework
       DIP_START_STACK_TRACE
-         ConverterLineFilter lineFilter( steps );
-         Framework::ScanMonadic(
-               in,
-               out,
-               DT_DFLOAT,
-               DataType::SuggestFloat( in.DataType() ),
-               steps.back().nOutputChannels,
-               lineFilter
-         );
+         ConverterLineFilter lineFilter( *plan );
+         ImageRefArray outar{ out };
+         Framework::Scan( { in }, outar, { plan->inputType }, { DT_DFLOAT }, { DataType::SuggestFloat( in.DataType() ) },
+                          { nChannels.back() }, lineFilter );
       DIP_END_STACK_TRACE
       out.ReshapeTensorAsVector();
    }
@@ -385,6 +549,8 @@ void ColorSpaceManager::SetWhitePoint( XYZ whitePoint ) {
 #ifdef DIP__ENABLE_DOCTEST
 #include "doctest.h"
 #include "diplib/math.h"
+#include "diplib/statistics.h"
+#include "diplib/generation.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the ColorSpaceManager class") {
    dip::ColorSpaceManager csm;
@@ -428,4 +594,39 @@ DOCTEST_TEST_CASE("[DIPlib] testing the ColorSpaceManager class") {
    DOCTEST_CHECK_FALSE( xyz.At( 0 ) == out.At( 0 ));
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the compiled color space conversion plans") {
+   auto maxDifference = []( dip::Image const& a, dip::Image const& b ) {
+      dip::Image diff = a - b;
+      diff.TensorToSpatial();
+      return dip::MaximumAbs( diff ).As< dip::dfloat >();
+   };
+   dip::ColorSpaceManager csm;
+   dip::Random random( 0 );
+   dip::Image img( { 70, 40 }, 3, dip::DT_DFLOAT );
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 255.0 );
+   img.SetColorSpace( "sRGB" );
+   // 8-bit input uses a look-up table for the sRGB -> RGB step
+   dip::Image img8 = dip::Convert( img, dip::DT_UINT8 );
+   dip::Image lab8 = csm.Convert( img8, "Lab" );
+   dip::Image lab = csm.Convert( dip::Convert( img8, dip::DT_DFLOAT ), "Lab" );
+   DOCTEST_CHECK( lab8.ColorSpace() == "Lab" );
+   DOCTEST_CHECK( lab8.DataType() == dip::DT_SFLOAT );
+   DOCTEST_CHECK( maxDifference( lab8, lab ) < 1e-4 );
+   // Same for 16-bit input
+   dip::Image img16 = dip::Convert( img, dip::DT_UINT16 );
+   DOCTEST_CHECK( maxDifference( csm.Convert( img16, "RGB" ), csm.Convert( dip::Convert( img16, dip::DT_DFLOAT ), "RGB" )) < 1e-4 );
+   // The fused result must match the result of applying each step independently
+   dip::Image ref = csm.Convert( csm.Convert( csm.Convert( img, "RGB" ), "XYZ" ), "Lab" );
+   DOCTEST_CHECK( maxDifference( csm.Convert( img, "Lab" ), ref ) < 1e-10 );
+   // CMY -> RGB -> XYZ -> grey are all affine steps, combined into a single one
+   img.SetColorSpace( "CMY" );
+   ref = csm.Convert( csm.Convert( img, "RGB" ), "XYZ" );
+   DOCTEST_CHECK( maxDifference( csm.Convert( img, "XYZ" ), ref ) < 1e-10 );
+   ref = csm.Convert( csm.Convert( img, "RGB" ), "grey" );
+   DOCTEST_CHECK( maxDifference( csm.Convert( img, "grey" ), ref ) < 1e-10 );
+   // Repeated conversions use the cached plan, and give the same result
+   DOCTEST_CHECK( maxDifference( csm.Convert( img8, "Lab" ), lab8 ) == 0 );
+}
+
 #endif // DIP__ENABLE_DOCTEST
@@ -26,6 +26,23 @@ constexpr dfloat epsilon = 0.008856;
 constexpr dfloat epsilon1_3 = 0.206893; // ==  std::cbrt( epsilon );
 constexpr dfloat kappa = 903.3;
 
+// Cube root for positive, normal `x`, about twice as fast as `std::cbrt`, and accurate to a few ULP.
+// It has no branches and doesn't call into the math library.
+inline dfloat FastCbrt( dfloat x ) {
+   // Initial estimate, about 3% error: divide the exponent by 3 by manipulating the bit pattern
+   std::uint64_t bits;
+   std::memcpy( &bits, &x, sizeof( bits ));
+   bits = bits / 3 + 0x2a9f7893782da1ceull;
+   dfloat t;
+   std::memcpy( &t, &bits, sizeof( t ));
+   // Two Halley iterations (cubic convergence) and one Newton iteration (quadratic convergence)
+   dfloat t3 = t * t * t;
+   t = t * ( t3 + 2 * x ) / ( 2 * t3 + x );
+   t3 = t * t * t;
+   t = t * ( t3 + 2 * x ) / ( 2 * t3 + x );
+   return t - ( t * t * t - x ) / ( 3 * t * t );
+}
+
 class lab2grey : public ColorSpaceConverter {
    public:
       virtual String InputColorSpace() const override { return "Lab"; }
@@ -55,7 +72,7 @@ class grey2lab : public ColorSpaceConverter {
          do {
             dfloat y = input[ 0 ] / 255;  // Yn == 1.000 by definition
             output[ 0 ] = y > epsilon
-                          ? 116.0 * std::cbrt( y ) - 16.0
+                          ? 116.0 * FastCbrt( y ) - 16.0
                           : kappa * y;
             output[ 1 ] = 0;
             output[ 2 ] = 0;
@@ -105,13 +122,13 @@ class xyz2lab : public ColorSpaceConverter {
             dfloat y = input[ 1 ] / whitePoint_[ 1 ];
             dfloat z = input[ 2 ] / whitePoint_[ 2 ];
             dfloat fx = x > epsilon
-                        ? std::cbrt( x )
+                        ? FastCbrt( x )
                         : ( kappa * x + 16.0 ) / 116.0;
             dfloat fy = y > epsilon
-                        ? std::cbrt( y )
+                        ? FastCbrt( y )
                         : ( kappa * y + 16.0 ) / 116.0;
             dfloat fz = z > epsilon
-                        ? std::cbrt( z )
+                        ? FastCbrt( z )
                         : ( kappa * z + 16.0 ) / 116.0;
             output[ 0 ] = 116.0 * fy - 16.0;
             output[ 1 ] = 500.0 * ( fx - fy );
@@ -185,7 +202,7 @@ class xyz2luv : public ColorSpaceConverter {
             dfloat v = 9 * input[ 1 ] / sum;
             dfloat y = input[ 1 ];
             dfloat L = y > epsilon
-                          ? 116.0 * std::cbrt( y ) - 16.0
+                          ? 116.0 * FastCbrt( y ) - 16.0
                           : kappa * y;
             output[ 0 ] = L;
             output[ 1 ] = 13.0 * L * ( u - un );
@@ -34,6 +34,9 @@ class rgb2grey : public ColorSpaceConverter {
                           input[ 2 ] * Y_[ 2 ];
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { Y_[ 0 ], Y_[ 1 ], Y_[ 2 ], 0.0 };
+      }
       void SetWhitePoint( XYZMatrix const& matrix ) {
          Y_[ 0 ] = matrix[ 1 ];
          Y_[ 1 ] = matrix[ 4 ];
@@ -54,6 +57,9 @@ class grey2rgb : public ColorSpaceConverter {
             output[ 2 ] = input[ 0 ];
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { 1.0, 1.0, 1.0,   0.0, 0.0, 0.0 };
+      }
 };
 
 // sRGB transformations
@@ -93,6 +99,7 @@ class rgb2srgb : public ColorSpaceConverter {
             output[ 2 ] = LinearToS( input[ 2 ] / 255.0 ) * 255.0;
          } while( ++input, ++output );
       }
+      virtual bool IsChannelwise() const override { return true; }
 };
 
 class srgb2rgb : public ColorSpaceConverter {
@@ -107,6 +114,7 @@ class srgb2rgb : public ColorSpaceConverter {
             output[ 2 ] = SToLinear( input[ 2 ] / 255.0 ) * 255.0;
          } while( ++input, ++output );
       }
+      virtual bool IsChannelwise() const override { return true; }
 };
 
 } // namespace
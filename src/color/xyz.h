@@ -32,6 +32,9 @@ class xyz2grey : public ColorSpaceConverter {
             output[ 0 ] = input[ 1 ] * 255;
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { 0.0, 255.0, 0.0, 0.0 };
+      }
 };
 
 class yxy2grey : public xyz2grey {
@@ -50,6 +53,9 @@ class grey2xyz : public ColorSpaceConverter {
             output[ 2 ] = input[ 0 ] * whitePoint_[ 2 ] / 255;
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         return { whitePoint_[ 0 ] / 255, whitePoint_[ 1 ] / 255, whitePoint_[ 2 ] / 255,   0.0, 0.0, 0.0 };
+      }
       void SetWhitePoint( ColorSpaceManager::XYZ const& whitePoint ) {
          whitePoint_ = whitePoint;
       }
@@ -68,6 +74,13 @@ class rgb2xyz : public ColorSpaceConverter {
             output[ 2 ] = ( input[ 0 ] * matrix_[ 2 ] + input[ 1 ] * matrix_[ 5 ] + input[ 2 ] * matrix_[ 8 ] ) / 255;
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         std::vector< dfloat > out( 12, 0.0 );
+         for( dip::uint ii = 0; ii < 9; ++ii ) {
+            out[ ii ] = matrix_[ ii ] / 255;
+         }
+         return out;
+      }
       void SetWhitePoint( XYZMatrix const& matrix ) {
          matrix_ = matrix;
          /*
@@ -98,6 +111,13 @@ class xyz2rgb : public ColorSpaceConverter {
             output[ 2 ] = ( input[ 0 ] * invMatrix_[ 2 ] + input[ 1 ] * invMatrix_[ 5 ] + input[ 2 ] * invMatrix_[ 8 ] ) * 255;
          } while( ++input, ++output );
       }
+      virtual std::vector< dfloat > AffineMatrix() const override {
+         std::vector< dfloat > out( 12, 0.0 );
+         for( dip::uint ii = 0; ii < 9; ++ii ) {
+            out[ ii ] = invMatrix_[ ii ] * 255;
+         }
+         return out;
+      }
       void SetWhitePoint( XYZMatrix const& matrix ) {
          Inverse( 3, matrix.data(), invMatrix_.data() );
          /*
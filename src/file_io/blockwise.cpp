@@ -0,0 +1,358 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definition for the out-of-core block-wise processing of image files.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <mutex>
+
+#include "diplib.h"
+#include "diplib/file_io.h"
+#include "diplib/multithreading.h"
+#include "file_io_support.h"
+
+namespace dip {
+
+namespace {
+
+// Each block in flight needs memory for its input, its output and one intermediate image
+constexpr dip::uint blockMemoryFactor = 3;
+
+// The input file: either a (possibly multi-page) TIFF file, recognized by its extension, or an ICS file
+class BlockReader {
+   public:
+      explicit BlockReader( String const& filename ) : filename_( filename ) {
+         if( FileCompareExtension( filename, "tif" ) || FileCompareExtension( filename, "tiff" )) {
+            isICS_ = false;
+            FileInformation info = ImageReadTIFFInfo( filename );
+            sizes_ = info.sizes;
+            if( info.numberOfImages > 1 ) {
+               sizes_.push_back( info.numberOfImages );
+            }
+            bytesPerPixel_ = info.dataType.SizeOf() * info.tensorElements;
+         } else {
+            isICS_ = true;
+            FileInformation info = ImageReadICSInfo( filename );
+            sizes_ = info.sizes;
+            bytesPerPixel_ = info.dataType.SizeOf() * info.tensorElements;
+         }
+      }
+
+      UnsignedArray const& Sizes() const { return sizes_; }
+      dip::uint BytesPerPixel() const { return bytesPerPixel_; }
+
+      // Thread safe. libics is not reentrant, so files are opened one at the time. With memory mapping, only the
+      // part of the file that contains the block is mapped, and its pixel data is read from disk when accessed.
+      Image Read( RangeArray const& roi ) {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         Image out;
+         if( isICS_ ) {
+            ImageReadICS( out, filename_, roi, {}, "mmap" );
+         } else if( roi.size() > 2 ) {
+            RangeArray roi2D{ roi[ 0 ], roi[ 1 ] };
+            ImageReadTIFF( out, filename_, roi[ 2 ], roi2D );
+            if( roi[ 2 ].Size() == 1 ) {
+               out.AddSingleton( 2 ); // A single page is read as a 2D image
+            }
+         } else {
+            ImageReadTIFF( out, filename_, Range{ 0 }, roi );
+         }
+         return out;
+      }
+
+   private:
+      String filename_;
+      bool isICS_;
+      UnsignedArray sizes_;
+      dip::uint bytesPerPixel_;
+      std::mutex mutex_;
+};
+
+// The output file: uncompressed pixel data, the first dimension varies fastest, the tensor dimension slowest.
+// The properties of the output image are established by the first block written.
+class BlockWriter {
+   public:
+      BlockWriter( String const& filename, UnsignedArray const& sizes ) : filename_( filename ), sizes_( sizes ) {
+         file_.open( filename, std::ios::out | std::ios::binary | std::ios::trunc );
+         DIP_THROW_IF( !file_.is_open(), "Could not open file for writing: " + filename );
+      }
+
+      // Writes the image `block`, whose origin is at `origin` in the output image. Thread safe.
+      void Write( Image const& block, UnsignedArray const& origin ) {
+         // Copy the block to a contiguous buffer, with the tensor dimension last
+         Image buffer = block.QuickCopy();
+         if( buffer.TensorElements() > 1 ) {
+            buffer.TensorToSpatial();
+         }
+         if( !buffer.HasNormalStrides() ) {
+            Image tmp = buffer;
+            buffer = Image( tmp.Sizes(), 1, tmp.DataType() );
+            buffer.Copy( tmp );
+         }
+         UnsignedArray const& bufSizes = buffer.Sizes();
+         dip::uint nDims = bufSizes.size();
+         std::lock_guard< std::mutex > lock( mutex_ );
+         if( !initialized_ ) {
+            // First block: set the output properties
+            initialized_ = true;
+            prototype_.SetSizes( sizes_ );
+            prototype_.SetDataType( block.DataType() );
+            prototype_.SetTensorSizes( block.TensorElements() );
+            prototype_.ReshapeTensor( block.Tensor() );
+            prototype_.SetColorSpace( block.ColorSpace() );
+            prototype_.SetPixelSize( block.PixelSize() );
+            fileSizes_ = sizes_;
+            if( block.TensorElements() > 1 ) {
+               fileSizes_.push_back( block.TensorElements() );
+            }
+            fileStrides_.resize( fileSizes_.size() );
+            fileStrides_[ 0 ] = 1;
+            for( dip::uint ii = 1; ii < fileSizes_.size(); ++ii ) {
+               fileStrides_[ ii ] = fileStrides_[ ii - 1 ] * fileSizes_[ ii - 1 ];
+            }
+         } else {
+            DIP_THROW_IF(( block.DataType() != prototype_.DataType() ) ||
+                         ( block.TensorElements() != prototype_.TensorElements() ),
+                         "The block processing function produced inconsistent outputs" );
+         }
+         DIP_ASSERT( nDims == fileSizes_.size() );
+         // Find the length of the contiguous runs: the block spans the full output along the first few dimensions
+         dip::uint runDims = 1;
+         dip::uint runLength = bufSizes[ 0 ];
+         while(( runDims < nDims ) && ( bufSizes[ runDims - 1 ] == fileSizes_[ runDims - 1 ] )) {
+            runLength *= bufSizes[ runDims ];
+            ++runDims;
+         }
+         dip::uint sizeOf = buffer.DataType().SizeOf();
+         dip::uint nRuns = buffer.NumberOfPixels() / runLength;
+         UnsignedArray position( nDims, 0 );
+         uint8 const* src = static_cast< uint8 const* >( buffer.Origin() );
+         for( dip::uint run = 0; run < nRuns; ++run ) {
+            dip::uint offset = 0;
+            for( dip::uint ii = 0; ii < nDims; ++ii ) {
+               offset += (( ii < origin.size() ? origin[ ii ] : 0 ) + position[ ii ] ) * fileStrides_[ ii ];
+            }
+            file_.seekp( static_cast< std::streamoff >( offset * sizeOf ));
+            file_.write( reinterpret_cast< char const* >( src ), static_cast< std::streamsize >( runLength * sizeOf ));
+            DIP_THROW_IF( !file_, "Could not write to file: " + filename_ );
+            src += runLength * sizeOf;
+            for( dip::uint ii = runDims; ii < nDims; ++ii ) {
+               if( ++position[ ii ] < bufSizes[ ii ] ) {
+                  break;
+               }
+               position[ ii ] = 0;
+            }
+         }
+      }
+
+      // Closes the data file, returns a raw image with the properties of the output
+      Image const& Close() {
+         file_.close();
+         DIP_THROW_IF( !file_, "Could not write to file: " + filename_ );
+         return prototype_;
+      }
+
+   private:
+      String filename_;
+      UnsignedArray sizes_;
+      std::ofstream file_;
+      std::mutex mutex_;
+      bool initialized_ = false;
+      Image prototype_;
+      UnsignedArray fileSizes_;
+      UnsignedArray fileStrides_;
+};
+
+// Determines the size of the blocks such that one block, including its border, fits in `budget` bytes.
+// Halves the largest dimension until it fits; for equal sizes, the last dimension is split first, as
+// blocks that span the full image along the first dimensions are read and written more efficiently.
+UnsignedArray ComputeBlockSizes(
+      UnsignedArray const& sizes,
+      UnsignedArray const& border,
+      dip::uint bytesPerPixel,
+      dip::uint budget
+) {
+   UnsignedArray blockSizes = sizes;
+   while( true ) {
+      dip::uint bytes = bytesPerPixel * blockMemoryFactor;
+      for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+         bytes *= std::min( blockSizes[ ii ] + 2 * border[ ii ], sizes[ ii ] );
+      }
+      if( bytes <= budget ) {
+         break;
+      }
+      dip::uint dim = 0;
+      for( dip::uint ii = 1; ii < sizes.size(); ++ii ) {
+         if( blockSizes[ ii ] >= blockSizes[ dim ] ) {
+            dim = ii;
+         }
+      }
+      DIP_THROW_IF( blockSizes[ dim ] == 1, "The memory budget is too small for the requested border" );
+      blockSizes[ dim ] = div_ceil( blockSizes[ dim ], dip::uint( 2 ));
+   }
+   return blockSizes;
+}
+
+} // namespace
+
+void ImageProcessBlockwise(
+      String const& inFilename,
+      String const& outFilename,
+      BlockProcessingFunction const& function,
+      UnsignedArray border,
+      dip::uint memoryBudget
+) {
+   DIP_THROW_IF( !function, E::INVALID_PARAMETER );
+   BlockReader reader( inFilename );
+   UnsignedArray const& sizes = reader.Sizes();
+   dip::uint nDims = sizes.size();
+   DIP_STACK_TRACE_THIS( ArrayUseParameter( border, nDims, dip::uint( 0 )));
+
+   // Divide the image into blocks
+   dip::uint nThreads = std::max< dip::uint >( GetNumberOfThreads(), 1 );
+   UnsignedArray blockSizes;
+   DIP_STACK_TRACE_THIS( blockSizes = ComputeBlockSizes( sizes, border, reader.BytesPerPixel(), memoryBudget / nThreads ));
+   UnsignedArray nBlocksPerDim( nDims );
+   dip::uint nBlocks = 1;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      nBlocksPerDim[ ii ] = div_ceil( sizes[ ii ], blockSizes[ ii ] );
+      nBlocks *= nBlocksPerDim[ ii ];
+   }
+   nThreads = std::min( nThreads, nBlocks );
+
+   // Create the output file
+   String headerFilename = FileCompareExtension( outFilename, "ics" ) ? outFilename : outFilename + ".ics";
+   String dataFilename = FileAddExtension( headerFilename, "ids" );
+   BlockWriter writer( dataFilename, sizes );
+
+   // Process the blocks
+   WorkDistributor work( nBlocks, nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint first, last;
+      while( work.Next( thread, first, last )) {
+         for( dip::uint block = first; block < last; ++block ) {
+            // Find the block and the region to read
+            RangeArray roi( nDims );
+            RangeArray core( nDims );
+            UnsignedArray origin( nDims );
+            dip::uint index = block;
+            for( dip::uint ii = 0; ii < nDims; ++ii ) {
+               dip::uint start = ( index % nBlocksPerDim[ ii ] ) * blockSizes[ ii ];
+               index /= nBlocksPerDim[ ii ];
+               dip::uint stop = std::min( start + blockSizes[ ii ], sizes[ ii ] ) - 1;
+               dip::uint readStart = start - std::min( start, border[ ii ] );
+               dip::uint readStop = std::min( stop + border[ ii ], sizes[ ii ] - 1 );
+               roi[ ii ] = Range{ static_cast< dip::sint >( readStart ), static_cast< dip::sint >( readStop ) };
+               core[ ii ] = Range{ static_cast< dip::sint >( start - readStart ), static_cast< dip::sint >( stop - readStart ) };
+               origin[ ii ] = start;
+            }
+            // Read, process, crop and write
+            Image in = reader.Read( roi );
+            Image out;
+            function( in, out );
+            DIP_THROW_IF( !out.IsForged(), E::IMAGE_NOT_FORGED );
+            DIP_THROW_IF( out.Sizes() != in.Sizes(), "The block processing function must not change the image sizes" );
+            writer.Write( out.At( core ), origin );
+         }
+      }
+   } );
+
+   // Write the header, now that we know all went well
+   Image const& prototype = writer.Close();
+   DIP_STACK_TRACE_THIS( detail::ImageWriteICSHeader( prototype, headerFilename, dataFilename ));
+}
+
+} // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/linear.h"
+#include "diplib/morphology.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+#ifdef DIP__HAS_ICS
+
+DOCTEST_TEST_CASE("[DIPlib] testing block-wise processing of image files") {
+   dip::Image image( { 60, 45, 20 }, 1, dip::DT_UINT16 );
+   image.Fill( 1000 );
+   dip::Random random( 0 );
+   dip::GaussianNoise( image, image, random, 200 );
+   image.SetPixelSize( dip::PhysicalQuantityArray{ 2 * dip::Units::Micrometer() } );
+   dip::ImageWriteICS( image, "test_block_in.ics", {}, 0, { "uncompressed" } );
+
+   // Separable linear filter
+   dip::UnsignedArray border = dip::GaussFIRBoundary( { 2.0 }, { 0 }, 3 );
+   dip::ImageProcessBlockwise( "test_block_in", "test_block_out", []( dip::Image const& in, dip::Image& out ) {
+      dip::GaussFIR( in, out, { 2.0 } );
+   }, border, 200000 );
+   dip::Image result = dip::ImageReadICS( "test_block_out" );
+   DOCTEST_CHECK( dip::testing::CompareImages( result, dip::GaussFIR( image, { 2.0 } ), 1e-3 ));
+   DOCTEST_CHECK( result.PixelSize() == image.PixelSize() );
+
+   // Morphological filter on a compressed file, with a tensor output
+   dip::ImageWriteICS( image, "test_block_in.ics" );
+   dip::StructuringElement se( { 7, 5, 3 }, "rectangular" );
+   border = se.Boundary( 3 );
+   border += dip::GaussFIRBoundary( { 1.0 }, { 1 }, 3 );
+   dip::ImageProcessBlockwise( "test_block_in", "test_block_out", [ & ]( dip::Image const& in, dip::Image& out ) {
+      out = dip::Gradient( dip::Dilation( in, se ), { 1.0 }, "gaussFIR" );
+   }, border, 300000 );
+   result = dip::ImageReadICS( "test_block_out" );
+   DOCTEST_CHECK( result.TensorElements() == 3 );
+   DOCTEST_CHECK( dip::testing::CompareImages( result, dip::Gradient( dip::Dilation( image, se ), { 1.0 }, "gaussFIR" ), 1e-3 ));
+
+   // The border doesn't fit in the budget
+   DOCTEST_CHECK_THROWS( dip::ImageProcessBlockwise( "test_block_in", "test_block_out", []( dip::Image const& in, dip::Image& out ) {
+      out = in;
+   }, { 40 }, 1000 ));
+}
+
+namespace {
+
+// Processes the 4x4x4 `DT_UINT16` image in `filename` in blocks that are one slice thick: the budget fits
+// a 2x2x1 block, but not a 2x2x2 one
+void BlockwiseSingleSlices( dip::Image const& image, dip::String const& filename ) {
+   dip::uint budget = 3 * 2 * ( 2 * 2 * 1 ) * dip::GetNumberOfThreads();
+   dip::ImageProcessBlockwise( filename, "test_block_out", []( dip::Image const& in, dip::Image& out ) {
+      DIP_THROW_IF( in.Dimensionality() != 3, "Expected a 3D block" );
+      DIP_THROW_IF( in.Size( 2 ) != 1, "Expected a block one slice thick" );
+      out = in + 1;
+   }, { 0 }, budget );
+   dip::Image result = dip::ImageReadICS( "test_block_out" );
+   DOCTEST_CHECK( dip::testing::CompareImages( result, image + 1 ));
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing block-wise processing with blocks one slice thick") {
+   dip::Image image( { 4, 4, 4 }, 1, dip::DT_UINT16 );
+   dip::FillRamp( image, 2, { "corner" } );
+   image += dip::CreateRamp( image.Sizes(), 0, { "corner" } );
+   dip::ImageWriteICS( image, "test_block_in.ics", {}, 0, { "uncompressed" } );
+   BlockwiseSingleSlices( image, "test_block_in" );
+#ifdef DIP__HAS_TIFF
+   dip::ImageWriteTIFF( image, "test_block_in.tif", "none" );
+   BlockwiseSingleSlices( image, "test_block_in.tif" );
+#endif // DIP__HAS_TIFF
+}
+
+#endif // DIP__HAS_ICS
+
+#endif // DIP__ENABLE_DOCTEST
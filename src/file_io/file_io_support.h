@@ -0,0 +1,41 @@
+/*
+ * DIPlib 3.0
+ * This file declares support functionality shared by the image file readers and writers.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_FILE_IO_SUPPORT_H
+#define DIP_FILE_IO_SUPPORT_H
+
+#include "diplib.h"
+
+namespace dip {
+namespace detail {
+
+// Writes the header of an ICS version 2 file that describes an uncompressed image with the properties of `image`
+// (which doesn't need to be forged). The pixel data is expected in the file `dataFilename`, starting at the first
+// byte, with the first image dimension varying fastest and the tensor dimension (if any) slowest.
+DIP_NO_EXPORT void ImageWriteICSHeader(
+      Image const& image,
+      String const& filename,
+      String const& dataFilename,
+      StringArray const& history = {}
+);
+
+} // namespace detail
+} // namespace dip
+
+#endif // DIP_FILE_IO_SUPPORT_H
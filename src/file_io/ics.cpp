@@ -21,13 +21,24 @@
 #ifdef DIP__HAS_ICS
 
 #include <cstdlib> // std::strtoul
+#include <cstring>
 
 #include "diplib.h"
 #include "diplib/file_io.h"
 #include "diplib/generic_iterators.h"
 #include "diplib/library/copy_buffer.h"
+#include "file_io_support.h"
 
 #include "libics.h"
+#include "libics_ll.h"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DIP__CAN_MMAP
+#endif
 
 // Fix strcasecmp for MSVC compilation
 #ifdef _MSC_VER
@@ -398,6 +409,124 @@ GetICSInfoData GetICSInfo( IcsFile& icsFile ) {
    return data;
 }
 
+// Returns true if the samples in the file are stored in the byte order of this machine, so they can be used directly.
+bool IcsHasNativeByteOrder( ICS* ics ) {
+   int bytes = static_cast< int >( IcsGetDataTypeSize( ics->imel.dataType ));
+   uint16 one = 1;
+   bool littleEndian = *reinterpret_cast< uint8* >( &one ) == 1;
+   for( int ii = 0; ii < bytes; ++ii ) {
+      if( ics->byteOrder[ ii ] == 0 ) {
+         return true; // Byte order not given, libics doesn't reorder either
+      }
+      int native = littleEndian ? ii + 1 : bytes - ii;
+      if( ics->byteOrder[ ii ] != native ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Memory-maps the part of the pixel data of the ICS file that contains the ROI given by `roi` and `channels`
+// (fixed, with `start <= stop`), and returns an image of that ROI. The mapping is private (copy-on-write):
+// pages are read from disk when first touched, and writing to the image never modifies the file. Pages are
+// not reserved in swap space, as only written pages need it. Returns a raw image if the data cannot be mapped;
+// the caller then reads it normally.
+Image MapIcsData(
+      ICS* ics,
+      dip::DataType dataType,
+      IntegerArray const& strides,
+      dip::uint tensorElements,
+      RangeArray const& roi,
+      Range const& channels
+) {
+#ifdef DIP__CAN_MMAP
+   if(( ics->compression != IcsCompr_uncompressed ) || !IcsHasNativeByteOrder( ics )) {
+      return {};
+   }
+   // Find the file and the offset of the pixel data within it
+   char filename[ ICS_MAXPATHLEN ];
+   dip::uint offset = 0;
+   if( ics->version == 1 ) {
+      IcsGetIdsName( filename, ics->filename );
+   } else {
+      if( ics->srcFile[ 0 ] == '\0' ) {
+         return {};
+      }
+      std::strncpy( filename, ics->srcFile, ICS_MAXPATHLEN - 1 );
+      filename[ ICS_MAXPATHLEN - 1 ] = '\0';
+      offset = ics->srcOffset;
+   }
+   // The first sample must be properly aligned for the data type
+   dip::uint alignment = dataType.IsComplex() ? dataType.SizeOf() / 2 : dataType.SizeOf();
+   if( offset % alignment != 0 ) {
+      return {};
+   }
+   // The bounding box of the ROI, and the range of samples it spans in the file
+   dip::uint nDims = roi.size();
+   UnsignedArray boxSizes( nDims );
+   IntegerArray boxStrides( nDims );
+   RangeArray boxRoi( nDims );
+   dip::uint first = 0;
+   dip::uint last = 0;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::uint lo = roi[ ii ].Offset();
+      dip::uint extent = ( roi[ ii ].Size() - 1 ) * roi[ ii ].step;
+      boxSizes[ ii ] = extent + 1;
+      boxStrides[ ii ] = strides[ ii ];
+      boxRoi[ ii ] = Range{ 0, static_cast< dip::sint >( extent ), roi[ ii ].step };
+      first += lo * static_cast< dip::uint >( strides[ ii ] );
+      last += ( lo + extent ) * static_cast< dip::uint >( strides[ ii ] );
+   }
+   dip::uint boxTensor = 1;
+   dip::sint tensorStride = 1;
+   Range boxChannels{ 0 };
+   if( tensorElements > 1 ) {
+      dip::uint extent = ( channels.Size() - 1 ) * channels.step;
+      boxTensor = extent + 1;
+      tensorStride = strides.back();
+      boxChannels = Range{ 0, static_cast< dip::sint >( extent ), channels.step };
+      first += channels.Offset() * static_cast< dip::uint >( tensorStride );
+      last += ( channels.Offset() + extent ) * static_cast< dip::uint >( tensorStride );
+   }
+   offset += first * dataType.SizeOf();
+   dip::uint length = ( last - first + 1 ) * dataType.SizeOf();
+   int fd = open( filename, O_RDONLY );
+   if( fd < 0 ) {
+      return {};
+   }
+   struct stat st;
+   if(( fstat( fd, &st ) != 0 ) || ( static_cast< dip::uint >( st.st_size ) < offset + length ) || ( length == 0 )) {
+      close( fd );
+      return {};
+   }
+   // `mmap` needs the offset to be a multiple of the page size
+   dip::uint pageSize = static_cast< dip::uint >( sysconf( _SC_PAGESIZE ));
+   dip::uint mapOffset = offset - offset % pageSize;
+   dip::uint mapLength = length + ( offset - mapOffset );
+#ifdef MAP_NORESERVE
+   int flags = MAP_PRIVATE | MAP_NORESERVE;
+#else
+   int flags = MAP_PRIVATE;
+#endif
+   void* base = mmap( nullptr, mapLength, PROT_READ | PROT_WRITE, flags, fd, static_cast< off_t >( mapOffset ));
+   close( fd ); // The mapping keeps its own reference to the file
+   if( base == MAP_FAILED ) {
+      return {};
+   }
+   DataSegment segment{ base, [ mapLength ]( void* ptr ) { munmap( ptr, mapLength ); }};
+   void* origin = static_cast< uint8* >( base ) + ( offset - mapOffset );
+   Image box( segment, origin, dataType, boxSizes, boxStrides, Tensor( boxTensor ), tensorStride );
+   Image view = box.At( boxRoi );
+   if( channels.Size() != tensorElements ) {
+      view = view[ boxChannels ];
+   }
+   return view;
+#else
+   ( void )ics; ( void )dataType; ( void )strides; ( void )tensorElements; ( void )roi; ( void )channels;
+   return {};
+#endif
+}
+
 } // namespace
 
 FileInformation ImageReadICS(
@@ -407,7 +536,15 @@ FileInformation ImageReadICS(
       Range channels,
       String const& mode
 ) {
-   bool fast = BooleanFromString( mode, "fast", "" );
+   bool fast = false;
+   bool mapped = false;
+   if( mode == "fast" ) {
+      fast = true;
+   } else if( mode == "mmap" ) {
+      mapped = true;
+   } else if( !mode.empty() ) {
+      DIP_THROW_INVALID_FLAG( mode );
+   }
 
    // open the ICS file
    IcsFile icsFile( filename, "r" );
@@ -470,6 +607,19 @@ FileInformation ImageReadICS(
    // if there's a tensor dimension, it's sorted last in `strides`.
    //std::cout << "[ImageReadICS] strides = " << strides << std::endl;
 
+   // if "mmap", try to map the file and use the requested portion of it directly
+   if( mapped ) {
+      mapped = false;
+      if( !out.IsProtected() && !out.HasExternalInterface() ) {
+         Image view = MapIcsData( icsFile, data.fileInformation.dataType, strides,
+                                  data.fileInformation.tensorElements, roi, channels );
+         if( view.IsForged() ) {
+            out = std::move( view );
+            mapped = true;
+         }
+      }
+   }
+
    // if "fast", try to match strides with those in the file
    if( fast ) {
       IntegerArray reqStrides( nDims );
@@ -538,11 +688,13 @@ FileInformation ImageReadICS(
    }
    //std::cout << "[ImageReadICS] outRef = " << outRef << std::endl;
 
-   if( strides == out.Strides() ) {
+   if( mapped ) {
+      // The data is already there
+   } else if( strides == out.Strides() ) {
       // Fast reading!
       //std::cout << "[ImageReadICS] fast reading!\n";
 
-      CALL_ICS( IcsGetData( icsFile, outRef.Origin(), outRef.NumberOfPixels() ), "Couldn't read pixel data from ICS file" );
+      CALL_ICS( IcsGetData( icsFile, outRef.Origin(), outRef.NumberOfPixels() * outRef.DataType().SizeOf() ), "Couldn't read pixel data from ICS file" );
 
    } else {
       // Reading using strides
@@ -696,46 +848,13 @@ inline bool StridesArePositive( IntegerArray strides ) {
    return true;
 }
 
-} // namespace
-
-void ImageWriteICS(
-      Image const& c_image,
-      String const& filename,
-      StringArray const& history,
-      dip::uint significantBits,
-      StringSet const& options
-) {
-   // parse options
-   bool oldStyle = false; // true if v1
-   bool compress = true;
-   bool fast = false;
-   for( auto& option : options ) {
-      if( option == "v1" ) {
-         oldStyle = true;
-      } else if( option == "v2" ) {
-         oldStyle = false;
-      } else if( option == "uncompressed" ) {
-         compress = false;
-      } else if( option == "gzip" ) {
-         compress = true;
-      } else if( option == "fast" ) {
-         fast = true;
-      } else {
-         DIP_THROW_INVALID_FLAG( option );
-      }
-   }
-
-   // should we reorder dimensions?
-   if( fast ) {
-      if( !c_image.HasContiguousData() || !StridesArePositive( c_image.Strides() )) {
-         fast = false;
-      }
-   }
-
+// Sets the data layout and the image properties in the header of the ICS file. `image` doesn't need to be forged.
+// If `image` is a tensor image, the tensor dimension is stored as the last dimension in the file.
+void WriteICSLayout( IcsFile& icsFile, Image const& image, dip::uint significantBits ) {
    // find info on image
    Ics_DataType dt;
    dip::uint maxSignificantBits;
-   switch( c_image.DataType()) {
+   switch( image.DataType()) {
       case DT_BIN:      dt = Ics_uint8;     maxSignificantBits = 1;  break;
       case DT_UINT8:    dt = Ics_uint8;     maxSignificantBits = 8;  break;
       case DT_UINT16:   dt = Ics_uint16;    maxSignificantBits = 16; break;
@@ -756,34 +875,31 @@ void ImageWriteICS(
       significantBits = std::min( significantBits, maxSignificantBits );
    }
 
-   // Quick copy of the image, with tensor dimension moved to the end
-   Image image = c_image.QuickCopy();
+   // sizes, with the tensor dimension at the end
+   UnsignedArray sizes = image.Sizes();
    bool isTensor = false;
    if( image.TensorElements() > 1 ) {
       isTensor = true;
-      image.TensorToSpatial(); // last dimension
+      sizes.push_back( image.TensorElements() );
    }
 
-   // open the ICS file
-   IcsFile icsFile( filename, oldStyle ? "w1" : "w2" );
-
    // set info on image
-   int nDims = static_cast< int >( image.Dimensionality() );
-   CALL_ICS( IcsSetLayout( icsFile, dt, nDims, image.Sizes().data() ), "Couldn't write to ICS file" );
+   int nDims = static_cast< int >( sizes.size() );
+   CALL_ICS( IcsSetLayout( icsFile, dt, nDims, sizes.data() ), "Couldn't write to ICS file" );
    if( nDims >= 5 ) {
       // By default, 5th dimension is called "probe", but this is turned into a tensor dimension...
       CALL_ICS( IcsSetOrder( icsFile, 4, "dim_4", 0 ), "Couldn't write to ICS file" );
    }
    CALL_ICS( IcsSetSignificantBits( icsFile, significantBits ), "Couldn't write to ICS file" );
-   if( c_image.IsColor() ) {
-      CALL_ICS( IcsSetOrder( icsFile, nDims - 1, c_image.ColorSpace().c_str(), 0 ), "Couldn't write to ICS file" );
+   if( image.IsColor() ) {
+      CALL_ICS( IcsSetOrder( icsFile, nDims - 1, image.ColorSpace().c_str(), 0 ), "Couldn't write to ICS file" );
    } else if( isTensor ) {
       CALL_ICS( IcsSetOrder( icsFile, nDims - 1, "tensor", 0 ), "Couldn't write to ICS file" );
    }
-   if( c_image.HasPixelSize() ) {
+   if( image.HasPixelSize() ) {
       if( isTensor ) { nDims--; }
       for( int ii = 0; ii < nDims; ii++ ) {
-         auto pixelSize = c_image.PixelSize( static_cast< dip::uint >( ii ));
+         auto pixelSize = image.PixelSize( static_cast< dip::uint >( ii ));
          CALL_ICS( IcsSetPosition( icsFile, ii, 0.0, pixelSize.magnitude, pixelSize.units.String().c_str() ), "Couldn't write to ICS file" );
       }
       if( isTensor ) {
@@ -791,11 +907,73 @@ void ImageWriteICS(
       }
    }
    if( isTensor ) {
-      String tensorShape = c_image.Tensor().TensorShapeAsString() + "\t" +
-                           std::to_string( c_image.Tensor().Rows() ) + "\t" +
-                           std::to_string( c_image.Tensor().Columns() );
+      String tensorShape = image.Tensor().TensorShapeAsString() + "\t" +
+                           std::to_string( image.Tensor().Rows() ) + "\t" +
+                           std::to_string( image.Tensor().Columns() );
       CALL_ICS( IcsAddHistory( icsFile, "tensor", tensorShape.c_str() ), "Couldn't write metadata to ICS file" );
    }
+}
+
+// Tags the data and writes the history lines to the ICS file.
+void WriteICSHistory( IcsFile& icsFile, StringArray const& history ) {
+   CALL_ICS( IcsAddHistory( icsFile, "software", "DIPlib " DIP_VERSION_STRING ), "Couldn't write metadata to ICS file" );
+   for( auto const& line : history ) {
+      auto error = IcsAddHistory( icsFile, 0, line.c_str() );
+      if(( error == IcsErr_LineOverflow ) || // history line is too long
+         ( error == IcsErr_IllParameter )) { // history line contains illegal characters
+         // Ignore these errors, the history line will not be written.
+      }
+      CALL_ICS( error, "Couldn't write metadata to ICS file" );
+   }
+}
+
+} // namespace
+
+void ImageWriteICS(
+      Image const& c_image,
+      String const& filename,
+      StringArray const& history,
+      dip::uint significantBits,
+      StringSet const& options
+) {
+   // parse options
+   bool oldStyle = false; // true if v1
+   bool compress = true;
+   bool fast = false;
+   for( auto& option : options ) {
+      if( option == "v1" ) {
+         oldStyle = true;
+      } else if( option == "v2" ) {
+         oldStyle = false;
+      } else if( option == "uncompressed" ) {
+         compress = false;
+      } else if( option == "gzip" ) {
+         compress = true;
+      } else if( option == "fast" ) {
+         fast = true;
+      } else {
+         DIP_THROW_INVALID_FLAG( option );
+      }
+   }
+
+   // should we reorder dimensions?
+   if( fast ) {
+      if( !c_image.HasContiguousData() || !StridesArePositive( c_image.Strides() )) {
+         fast = false;
+      }
+   }
+
+   // Quick copy of the image, with tensor dimension moved to the end
+   Image image = c_image.QuickCopy();
+   if( image.TensorElements() > 1 ) {
+      image.TensorToSpatial(); // last dimension
+   }
+
+   // open the ICS file
+   IcsFile icsFile( filename, oldStyle ? "w1" : "w2" );
+
+   // set info on image
+   DIP_STACK_TRACE_THIS( WriteICSLayout( icsFile, c_image, significantBits ));
 
    // set type of compression
    CALL_ICS( IcsSetCompression( icsFile, compress ? IcsCompr_gzip : IcsCompr_uncompressed, 9 ),
@@ -822,28 +1000,37 @@ void ImageWriteICS(
                 "Couldn't write data to ICS file" );
    }
 
-   // tag the data
-   CALL_ICS( IcsAddHistory( icsFile, "software", "DIPlib " DIP_VERSION_STRING ), "Couldn't write metadata to ICS file" );
-
-   // write history lines
-   for( auto const& line : history ) {
-      auto error = IcsAddHistory( icsFile, 0, line.c_str() );
-      if(( error == IcsErr_LineOverflow ) || // history line is too long
-         ( error == IcsErr_IllParameter )) { // history line contains illegal characters
-         // Ignore these errors, the history line will not be written.
-      }
-      CALL_ICS( error, "Couldn't write metadata to ICS file" );
-   }
+   // tag the data and write history lines
+   DIP_STACK_TRACE_THIS( WriteICSHistory( icsFile, history ));
 
    // write everything to file by closing it
    icsFile.Close();
 }
 
+namespace detail {
+
+void ImageWriteICSHeader(
+      Image const& image,
+      String const& filename,
+      String const& dataFilename,
+      StringArray const& history
+) {
+   IcsFile icsFile( filename, "w2" );
+   DIP_STACK_TRACE_THIS( WriteICSLayout( icsFile, image, 0 ));
+   CALL_ICS( IcsSetCompression( icsFile, IcsCompr_uncompressed, 0 ), "Couldn't write to ICS file" );
+   CALL_ICS( IcsSetSource( icsFile, dataFilename.c_str(), 0 ), "Couldn't write to ICS file" );
+   DIP_STACK_TRACE_THIS( WriteICSHistory( icsFile, history ));
+   icsFile.Close();
+}
+
+} // namespace detail
+
 } // namespace dip
 
 #ifdef DIP__ENABLE_DOCTEST
 #include "doctest.h"
 #include "diplib/testing.h"
+#include "diplib/iterators.h"
 
 DOCTEST_TEST_CASE( "[DIPlib] testing ICS file reading and writing" ) {
    dip::Image image = dip::ImageReadICS( DIP__EXAMPLES_DIR "/chromo3d.ics" );
@@ -881,12 +1068,75 @@ DOCTEST_TEST_CASE( "[DIPlib] testing ICS file reading and writing" ) {
    DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
 }
 
+DOCTEST_TEST_CASE( "[DIPlib] testing memory-mapped ICS file reading" ) {
+   dip::Image image( { 35, 24, 6 }, 3, dip::DT_SFLOAT );
+   image.SetColorSpace( "RGB" );
+   dip::ImageIterator< dip::sfloat > it( image );
+   dip::sfloat value = 0;
+   do {
+      for( auto& v : it ) {
+         v = value;
+         value += 1;
+      }
+   } while( ++it );
+
+   for( auto version : { "v1", "v2" } ) {
+      dip::ImageWriteICS( image, "test3.ics", {}, 7, { version, "uncompressed" } );
+      dip::Image result = dip::ImageReadICS( "test3", dip::RangeArray{}, {}, "mmap" );
+      DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
+      DOCTEST_CHECK( result.ColorSpace() == "RGB" );
+#ifdef DIP__CAN_MMAP
+      // The file was mapped, not read. In a v2 file the pixel data follows the header, and is not necessarily
+      // aligned, in which case the file is read normally.
+      bool aligned = std::strcmp( version, "v1" ) == 0;
+      if( aligned ) {
+         DOCTEST_CHECK( result.IsExternalData() );
+      }
+#endif
+
+      dip::RangeArray roi{ dip::Range{ 30, 2 }, dip::Range{ 5, 20, 3 }, dip::Range{ 1 } };
+      result = dip::ImageReadICS( "test3", roi, dip::Range{ 1, 2 }, "mmap" );
+      dip::Image expected = image.At( roi )[ dip::Range{ 1, 2 } ];
+      DOCTEST_CHECK( dip::testing::CompareImages( expected, result ));
+#ifdef DIP__CAN_MMAP
+      if( aligned ) {
+         DOCTEST_CHECK( result.IsExternalData() );
+         // Only the part of the file that contains the ROI is mapped: the ROI starts in the second channel, but the
+         // mapping starts less than a page before its first sample
+         dip::uint distance = static_cast< dip::uint >( static_cast< dip::uint8* >( result.Origin() ) - static_cast< dip::uint8* >( result.Data() ));
+         DOCTEST_CHECK( distance < static_cast< dip::uint >( sysconf( _SC_PAGESIZE )) + 28 * sizeof( dip::sfloat ));
+      }
+#endif
+
+      // Writing to the mapped image does not change the file
+      result.Fill( 0 );
+      result = dip::ImageReadICS( "test3", roi, dip::Range{ 1, 2 }, "mmap" );
+      DOCTEST_CHECK( dip::testing::CompareImages( expected, result ));
+   }
+
+   // 8-bit data is always aligned, also in a v2 file
+   dip::Image bytes = image.Copy();
+   bytes.Convert( dip::DT_UINT8 );
+   dip::ImageWriteICS( bytes, "test3.ics", {}, 7, { "v2", "uncompressed" } );
+   dip::Image result = dip::ImageReadICS( "test3", dip::RangeArray{}, {}, "mmap" );
+   DOCTEST_CHECK( dip::testing::CompareImages( bytes, result ));
+#ifdef DIP__CAN_MMAP
+   DOCTEST_CHECK( result.IsExternalData() );
+#endif
+
+   // Compressed files are read normally
+   dip::ImageWriteICS( image, "test3.ics", {}, 7, { "v2", "gzip" } );
+   result = dip::ImageReadICS( "test3", dip::RangeArray{}, {}, "mmap" );
+   DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
+}
+
 #endif // DIP__ENABLE_DOCTEST
 
 #else // DIP__HAS_ICS
 
 #include "diplib.h"
 #include "diplib/file_io.h"
+#include "file_io_support.h"
 
 namespace dip {
 
@@ -912,6 +1162,14 @@ void ImageWriteICS( Image const&, String const&, StringArray const&, dip::uint,
    DIP_THROW( NOT_AVAILABLE );
 }
 
+namespace detail {
+
+void ImageWriteICSHeader( Image const&, String const&, String const&, StringArray const& ) {
+   DIP_THROW( NOT_AVAILABLE );
+}
+
+} // namespace detail
+
 }
 
 #endif // DIP__HAS_ICS
@@ -23,6 +23,10 @@
 #include "diplib.h"
 #include "diplib/file_io.h"
 #include "diplib/generic_iterators.h"
+#include "diplib/multithreading.h"
+
+#include <cstring>
+#include <memory>
 
 #include <tiffio.h>
 
@@ -31,7 +35,6 @@ namespace dip {
 namespace {
 
 constexpr char const* TIFF_NO_TAG = "Invalid TIFF: Required tag not found";
-constexpr char const* TIFF_TILES_NOT_SUPPORTED = "Tiled TIFF format not yet supported";
 constexpr char const* TIFF_DIRECTORY_NOT_FOUND = "Could not find the requested image in the file";
 
 #define READ_REQUIRED_TIFF_TAG( tiff, tag, ... ) do { if( !TIFFGetField( tiff, tag, __VA_ARGS__ )) { DIP_THROW_RUNTIME( TIFF_NO_TAG ); }} while(false)
@@ -243,341 +246,308 @@ GetTIFFInfoData GetTIFFInfo( TiffFile& tiff ) {
 }
 
 //
-// Color Map
+// Strips and tiles
 //
 
-inline void ExpandColourMap4(
-      uint16* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      dip::sint tensorStride,
-      IntegerArray const& strides,
-      uint16 const* ColourMapRed,
-      uint16 const* ColourMapGreen,
-      uint16 const* ColourMapBlue
+// Describes how the pixel data of the current directory is divided into strips or tiles. We call both "chunks".
+// A strip is a chunk that spans the full width of the image.
+struct TiffLayout {
+   bool tiled = false;
+   dip::uint chunkWidth = 0;    // for strips, the image width
+   dip::uint chunkLength = 0;   // for strips, the number of rows per strip
+   dip::uint chunksAcross = 1;  // for strips, 1
+   dip::uint chunksDown = 1;
+   dip::uint nPlanes = 1;       // the number of samples per pixel if PLANARCONFIG_SEPARATE, 1 otherwise
+   dip::uint rowSize = 0;       // the number of bytes in one row of a decoded chunk
+   dip::uint chunkSize = 0;     // the number of bytes in a decoded chunk
+   bool compressed = false;
+};
+
+TiffLayout GetTIFFLayout( TiffFile& tiff, UnsignedArray const& sizes, dip::uint tensorElements ) {
+   TiffLayout layout;
+   uint16 planarConfiguration = PLANARCONFIG_CONTIG;
+   if( tensorElements > 1 ) {
+      if( !TIFFGetField( tiff, TIFFTAG_PLANARCONFIG, &planarConfiguration )) {
+         planarConfiguration = PLANARCONFIG_CONTIG; // Default
+      }
+   }
+   switch( planarConfiguration ) {
+      case PLANARCONFIG_CONTIG:
+         // 1234123412341234....
+         break;
+      case PLANARCONFIG_SEPARATE:
+         // 1111...2222...3333...4444...
+         layout.nPlanes = tensorElements;
+         break;
+      default:
+         DIP_THROW_RUNTIME( "Unsupported TIFF: unknown PlanarConfiguration value" );
+   }
+   uint16 compression;
+   if( TIFFGetField( tiff, TIFFTAG_COMPRESSION, &compression )) {
+      layout.compressed = compression != COMPRESSION_NONE;
+   }
+   if( TIFFIsTiled( tiff )) {
+      layout.tiled = true;
+      uint32 tileWidth, tileLength;
+      READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_TILEWIDTH, &tileWidth );
+      READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_TILELENGTH, &tileLength );
+      layout.chunkWidth = tileWidth;
+      layout.chunkLength = tileLength;
+      layout.rowSize = static_cast< dip::uint >( TIFFTileRowSize( tiff ));
+      layout.chunkSize = static_cast< dip::uint >( TIFFTileSize( tiff ));
+   } else {
+      uint32 rowsPerStrip;
+      TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip );
+      layout.chunkWidth = sizes[ 0 ];
+      layout.chunkLength = std::min< dip::uint >( rowsPerStrip, sizes[ 1 ] );
+      layout.rowSize = static_cast< dip::uint >( TIFFScanlineSize( tiff ));
+      layout.chunkSize = static_cast< dip::uint >( TIFFStripSize( tiff ));
+   }
+   DIP_THROW_IF(( layout.chunkWidth == 0 ) || ( layout.chunkLength == 0 ), "Invalid TIFF: Strip or tile size is 0" );
+   layout.chunksAcross = div_ceil( sizes[ 0 ], layout.chunkWidth );
+   layout.chunksDown = div_ceil( sizes[ 1 ], layout.chunkLength );
+   DIP_THROW_IF( layout.chunkSize < layout.rowSize * layout.chunkLength, "Invalid TIFF: Strip or tile size inconsistent" );
+   return layout;
+}
+
+// The part of the ROI covered by one chunk. `first` and `last` are indices into the ROI (i.e. output image
+// coordinates), `last` is one past the end.
+struct TiffChunkRegion {
+   dip::uint index;        // the strip or tile number
+   dip::uint plane;        // the sample plane, always 0 for PLANARCONFIG_CONTIG
+   dip::uint chunkX;       // the file image coordinates of the chunk's first pixel
+   dip::uint chunkY;
+   dip::uint firstX;
+   dip::uint lastX;
+   dip::uint firstY;
+   dip::uint lastY;
+};
+
+// Finds which of the ROI indices fall within the chunk extent [ chunkStart, chunkStart + chunkSize ).
+// `roi` must have `start <= stop`.
+bool RoiChunkIntersection( Range const& roi, dip::uint chunkStart, dip::uint chunkSize, dip::uint& first, dip::uint& last ) {
+   dip::uint start = roi.Offset();
+   dip::uint chunkEnd = chunkStart + chunkSize;
+   if( chunkEnd <= start ) {
+      return false;
+   }
+   first = chunkStart <= start ? 0 : div_ceil( chunkStart - start, roi.step );
+   last = std::min( roi.Size(), div_ceil( chunkEnd - start, roi.step ));
+   return first < last;
+}
+
+// Returns the pointer into the image where a chunk can be decoded directly, or `nullptr` if it must be decoded
+// into a buffer and copied over.
+using TiffChunkDestination = std::function< uint8*( TiffChunkRegion const& ) >;
+// Copies the relevant part of a decoded chunk into the image.
+using TiffChunkCopier = std::function< void( uint8 const*, TiffChunkRegion const& ) >;
+
+// Decodes all strips or tiles that intersect `roi` (two ranges, with `start <= stop`), and hands them to `copy`.
+// Decoding is CPU-bound for compressed files, so we decode chunks in parallel. libtiff handles are not thread
+// safe, each additional thread opens the file anew.
+void ReadTIFFChunks(
+      TiffFile& tiff,
+      TiffLayout const& layout,
+      RangeArray const& roi,
+      TiffChunkCopier const& copy,
+      TiffChunkDestination const& destination = {}
 ) {
-   dip::sint green = tensorStride;
-   dip::sint blue = 2 * tensorStride;
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint16* dest_pixel = dest;
-      for( dip::uint jj = 0; jj < width; ) {
-         dip::uint index = ( static_cast< dip::uint >( *src ) >> 4 ) & 0x0Fu;
-         *dest_pixel = ColourMapRed[ index ];
-         *( dest_pixel + green ) = ColourMapGreen[ index ];
-         *( dest_pixel + blue ) = ColourMapBlue[ index ];
-         dest_pixel += strides[ 0 ];
-         ++jj;
-         if( jj >= width ) {
-            ++src;
-            break;
+   // Find the chunks that intersect the ROI. Chunks are numbered plane by plane, in row-major order.
+   std::vector< TiffChunkRegion > chunks;
+   for( dip::uint plane = 0; plane < layout.nPlanes; ++plane ) {
+      for( dip::uint yy = 0; yy < layout.chunksDown; ++yy ) {
+         TiffChunkRegion region;
+         region.plane = plane;
+         region.chunkY = yy * layout.chunkLength;
+         if( !RoiChunkIntersection( roi[ 1 ], region.chunkY, layout.chunkLength, region.firstY, region.lastY )) {
+            continue;
+         }
+         for( dip::uint xx = 0; xx < layout.chunksAcross; ++xx ) {
+            region.chunkX = xx * layout.chunkWidth;
+            if( !RoiChunkIntersection( roi[ 0 ], region.chunkX, layout.chunkWidth, region.firstX, region.lastX )) {
+               continue;
+            }
+            region.index = ( plane * layout.chunksDown + yy ) * layout.chunksAcross + xx;
+            chunks.push_back( region );
          }
-         index = ( *src ) & 0x0Fu;
-         *dest_pixel = ColourMapRed[ index ];
-         *( dest_pixel + green ) = ColourMapGreen[ index ];
-         *( dest_pixel + blue ) = ColourMapBlue[ index ];
-         dest_pixel += strides[ 0 ];
-         ++jj;
-         ++src;
       }
-      dest += strides[ 1 ];
    }
+   if( chunks.empty() ) {
+      return;
+   }
+
+   // Determine the number of threads we'll be using
+   dip::uint nThreads = std::min( GetNumberOfThreads(), chunks.size() );
+   if( nThreads > 1 ) {
+      // Rough estimate: decompressing costs about 20 cycles per output byte, a plain read about 1.
+      dip::uint operations = chunks.size() * layout.chunkSize * ( layout.compressed ? 20 : 1 );
+      nThreads = OptimalNumberOfThreads( operations, nThreads );
+   }
+
+   String const& filename = tiff.FileName();
+   auto directory = TIFFCurrentDirectory( tiff );
+   std::mutex openMutex; // `TiffFile` sets library-wide error handlers
+   WorkDistributor work( chunks.size(), nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      std::unique_ptr< TiffFile > ownFile;
+      TIFF* handle = thread == 0 ? static_cast< TIFF* >( tiff ) : nullptr;
+      std::vector< uint8 > buffer;
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         if( !handle ) {
+            std::lock_guard< std::mutex > lock( openMutex );
+            ownFile = std::make_unique< TiffFile >( filename );
+            handle = *ownFile;
+            if( TIFFSetDirectory( handle, directory ) == 0 ) {
+               DIP_THROW_RUNTIME( TIFF_DIRECTORY_NOT_FOUND );
+            }
+         }
+         for( dip::uint ii = begin; ii < end; ++ii ) {
+            TiffChunkRegion const& region = chunks[ ii ];
+            uint8* dest = destination ? destination( region ) : nullptr;
+            bool inPlace = dest != nullptr;
+            tmsize_t size;
+            if( inPlace ) {
+               // Only strips of a fully read image are decoded in place, we don't write past the image's last row.
+               size = static_cast< tmsize_t >(( region.lastY - region.firstY ) * layout.rowSize );
+            } else {
+               if( buffer.empty() ) {
+                  buffer.resize( layout.chunkSize );
+               }
+               dest = buffer.data();
+               size = static_cast< tmsize_t >( layout.chunkSize );
+            }
+            tmsize_t result = layout.tiled
+                              ? TIFFReadEncodedTile( handle, static_cast< uint32 >( region.index ), dest, size )
+                              : TIFFReadEncodedStrip( handle, static_cast< uint32 >( region.index ), dest, size );
+            if( result < 0 ) {
+               DIP_THROW_RUNTIME( "Error reading data" );
+            }
+            if( !inPlace ) {
+               copy( dest, region );
+            }
+         }
+      }
+   } );
 }
 
-inline void ExpandColourMap8(
-      uint16* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      dip::sint tensorStride,
-      IntegerArray const& strides,
-      uint16 const* ColourMapRed,
-      uint16 const* ColourMapGreen,
-      uint16 const* ColourMapBlue
-) {
-   dip::sint green = tensorStride;
-   dip::sint blue = 2 * tensorStride;
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint16* dest_pixel = dest;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         *dest_pixel = ColourMapRed[ *src ];
-         *( dest_pixel + green ) = ColourMapGreen[ *src ];
-         *( dest_pixel + blue ) = ColourMapBlue[ *src ];
-         dest_pixel += strides[ 0 ];
-         ++src;
+// Fixes the ROI for a 2D image plane of the given sizes, mirrored ranges are flipped and flagged in `mirror`.
+void FixTIFFRoi( RangeArray& roi, UnsignedArray const& sizes, BooleanArray& mirror ) {
+   ArrayUseParameter( roi, 2, Range{} );
+   mirror.resize( 2, false );
+   for( dip::uint ii = 0; ii < 2; ++ii ) {
+      roi[ ii ].Fix( sizes[ ii ] );
+      // The last index actually read, `stop` might not be reached
+      dip::sint last = roi[ ii ].start + roi[ ii ].Step() * static_cast< dip::sint >( roi[ ii ].Size() - 1 );
+      if( roi[ ii ].start > roi[ ii ].stop ) {
+         // Read the same pixels in forward order
+         roi[ ii ].stop = roi[ ii ].start;
+         roi[ ii ].start = last;
+         mirror[ ii ] = true;
+      } else {
+         roi[ ii ].stop = last;
       }
-      dest += strides[ 1 ];
    }
 }
 
+bool RoiIsFullImage( RangeArray const& roi, UnsignedArray const& sizes ) {
+   return ( roi[ 0 ].step == 1 ) && ( roi[ 0 ].Size() == sizes[ 0 ] ) && ( roi[ 1 ].step == 1 ) && ( roi[ 1 ].Size() == sizes[ 1 ] );
+}
+
+//
+// Color Map
+//
+
 void ReadTIFFColorMap(
       Image& image,
       TiffFile& tiff,
-      GetTIFFInfoData& data
+      GetTIFFInfoData& data,
+      RangeArray const& roi
 ) {
-   // Test for tiled TIFF files. These we can't handle (yet).
-   uint32 tileWidth;
-   if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth )) {
-      DIP_THROW_RUNTIME( TIFF_TILES_NOT_SUPPORTED );
-   }
-
    // Read the tags
    uint16 bitsPerSample;
    READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample );
    if(( bitsPerSample != 4 ) && ( bitsPerSample != 8 )) {
       DIP_THROW_RUNTIME( "Unsupported TIFF: Unknown bit depth" );
    }
-   //std::vector< uint16 > CMRed( 1u << bitsPerSample );
-   //std::vector< uint16 > CMGreen( 1u << bitsPerSample );
-   //std::vector< uint16 > CMBlue( 1u << bitsPerSample );
    uint16* CMRed;
    uint16* CMGreen;
    uint16* CMBlue;
    READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_COLORMAP, &CMRed, &CMGreen, &CMBlue );
 
    // Forge the image
-   image.ReForge( data.fileInformation.sizes, 3, DT_UINT16 );
+   image.ReForge( { roi[ 0 ].Size(), roi[ 1 ].Size() }, 3, DT_UINT16 );
    uint16* imagedata = static_cast< uint16* >( image.Origin() );
+   dip::sint green = image.TensorStride();
+   dip::sint blue = 2 * green;
+   dip::sint strideX = image.Stride( 0 );
+   dip::sint strideY = image.Stride( 1 );
 
-   // Read the image data stripwise
-   uint32 imageWidth = static_cast< uint32 >( image.Size( 0 ));
-   uint32 imageLength = static_cast< uint32 >( image.Size( 1 ));
-   dip::uint scanline = static_cast< dip::uint >( TIFFScanlineSize( tiff ));
-   if( bitsPerSample == 4 ) {
-      DIP_ASSERT( scanline == div_ceil< dip::uint >( image.Size( 0 ), 2 ));
-   } else {
-      DIP_ASSERT( scanline == image.Size( 0 ));
-   }
-   std::vector< uint8 > buf( static_cast< dip::uint >( TIFFStripSize( tiff )));
-   uint32 rowsPerStrip;
-   TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip );
-   uint32 nStrips = TIFFNumberOfStrips( tiff );
-   uint32 row = 0;
-   for( uint32 strip = 0; strip < nStrips; ++strip ) {
-      dip::uint nrow = row + rowsPerStrip > imageLength ? imageLength - row : rowsPerStrip;
-      if( TIFFReadEncodedStrip( tiff, strip, buf.data(), static_cast< tmsize_t >( nrow * scanline )) < 0 ) {
-         DIP_THROW_RUNTIME( "Error reading data" );
-      }
-      if( bitsPerSample == 4 ) {
-         ExpandColourMap4( imagedata, buf.data(), imageWidth, nrow, image.TensorStride(), image.Strides(), CMRed, CMGreen, CMBlue );
-      } else {
-         ExpandColourMap8( imagedata, buf.data(), imageWidth, nrow, image.TensorStride(), image.Strides(), CMRed, CMGreen, CMBlue );
+   // Read the image data
+   TiffLayout layout;
+   DIP_STACK_TRACE_THIS( layout = GetTIFFLayout( tiff, data.fileInformation.sizes, 1 ));
+   DIP_STACK_TRACE_THIS( ReadTIFFChunks( tiff, layout, roi, [ & ]( uint8 const* buffer, TiffChunkRegion const& region ) {
+      for( dip::uint jj = region.firstY; jj < region.lastY; ++jj ) {
+         uint8 const* src = buffer + ( roi[ 1 ].Offset() + jj * roi[ 1 ].step - region.chunkY ) * layout.rowSize;
+         uint16* dest = imagedata + static_cast< dip::sint >( jj ) * strideY + static_cast< dip::sint >( region.firstX ) * strideX;
+         for( dip::uint ii = region.firstX; ii < region.lastX; ++ii ) {
+            dip::uint x = roi[ 0 ].Offset() + ii * roi[ 0 ].step - region.chunkX;
+            dip::uint index = bitsPerSample == 4
+                              ? ( static_cast< dip::uint >( src[ x / 2 ] ) >> ( x % 2 ? 0 : 4 )) & 0x0Fu
+                              : src[ x ];
+            dest[ 0 ] = CMRed[ index ];
+            dest[ green ] = CMGreen[ index ];
+            dest[ blue ] = CMBlue[ index ];
+            dest += strideX;
+         }
       }
-      imagedata += static_cast< dip::sint >( nrow ) * image.Stride( 1 );
-      row += rowsPerStrip;
-   }
+   } ));
 }
 
 //
 // Binary
 //
 
-inline void CopyBuffer1(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& strides
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      dip::sint kk = 7;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         *dest_pixel = (( *src ) & ( 1 << kk )) ? 1 : 0;
-         dest_pixel += strides[ 0 ];
-         --kk;
-         if( kk < 0 ) {
-            kk = 7;
-            ++src;
-         }
-      }
-      if( kk != 7 ) {
-         //kk = 7;
-         ++src;
-      }
-      dest += strides[ 1 ];
-   }
-}
-
-inline void CopyBufferInv1(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& strides
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      dip::sint kk = 7;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         *dest_pixel = (( *src ) & ( 1 << kk )) ? 0 : 1;
-         dest_pixel += strides[ 0 ];
-         --kk;
-         if( kk < 0 ) {
-            kk = 7;
-            ++src;
-         }
-      }
-      if( kk != 7 ) {
-         //kk = 7;
-         ++src;
-      }
-      dest += strides[ 1 ];
-   }
-}
-
 void ReadTIFFBinary(
       Image& image,
       TiffFile& tiff,
-      GetTIFFInfoData& data
+      GetTIFFInfoData& data,
+      RangeArray const& roi
 ) {
-   // Test for tiled TIFF files. These we can't handle (yet).
-   uint32 tileWidth;
-   if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth )) {
-      DIP_THROW_RUNTIME( TIFF_TILES_NOT_SUPPORTED );
-   }
-
    // Forge the image
-   image.ReForge( data.fileInformation.sizes, data.fileInformation.tensorElements, DT_BIN );
+   image.ReForge( { roi[ 0 ].Size(), roi[ 1 ].Size() }, data.fileInformation.tensorElements, DT_BIN );
    uint8* imagedata = static_cast< uint8* >( image.Origin() );
+   dip::sint tensorStride = image.TensorStride();
+   dip::sint strideX = image.Stride( 0 );
+   dip::sint strideY = image.Stride( 1 );
+   uint8 zero = data.photometricInterpretation == PHOTOMETRIC_MINISWHITE ? 1 : 0;
 
-   // Read the image data stripwise
-   uint32 imageWidth = static_cast< uint32 >( image.Size( 0 ));
-   uint32 imageLength = static_cast< uint32 >( image.Size( 1 ));
-   dip::uint scanline = static_cast< dip::uint >( TIFFScanlineSize( tiff ));
-   DIP_ASSERT( scanline == div_ceil< dip::uint >( image.Size( 0 ), 8 ));
-   std::vector< uint8 > buf( static_cast< dip::uint >( TIFFStripSize( tiff )));
-   uint32 rowsPerStrip;
-   TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip );
-   uint32 nStrips = TIFFNumberOfStrips( tiff );
-   uint32 row = 0;
-   for( uint32 strip = 0; strip < nStrips; ++strip ) {
-      uint32 nrow = ( row + rowsPerStrip > imageLength ? imageLength - row : rowsPerStrip );
-      if( TIFFReadEncodedStrip( tiff, strip, buf.data(), static_cast< tmsize_t >( nrow * scanline )) < 0 ) {
-         DIP_THROW_RUNTIME( "Error reading data" );
-      }
-      if( data.photometricInterpretation == PHOTOMETRIC_MINISWHITE ) {
-         CopyBufferInv1( imagedata, buf.data(), imageWidth, nrow, image.Strides() );
-      } else {
-         CopyBuffer1( imagedata, buf.data(), imageWidth, nrow, image.Strides() );
+   // Read the image data
+   TiffLayout layout;
+   DIP_STACK_TRACE_THIS( layout = GetTIFFLayout( tiff, data.fileInformation.sizes, image.TensorElements() ));
+   dip::uint samplesPerPixel = layout.nPlanes == 1 ? image.TensorElements() : 1;
+   DIP_STACK_TRACE_THIS( ReadTIFFChunks( tiff, layout, roi, [ & ]( uint8 const* buffer, TiffChunkRegion const& region ) {
+      for( dip::uint jj = region.firstY; jj < region.lastY; ++jj ) {
+         uint8 const* src = buffer + ( roi[ 1 ].Offset() + jj * roi[ 1 ].step - region.chunkY ) * layout.rowSize;
+         uint8* dest = imagedata + static_cast< dip::sint >( jj ) * strideY + static_cast< dip::sint >( region.firstX ) * strideX
+                       + static_cast< dip::sint >( region.plane ) * tensorStride;
+         for( dip::uint ii = region.firstX; ii < region.lastX; ++ii ) {
+            dip::uint bit = ( roi[ 0 ].Offset() + ii * roi[ 0 ].step - region.chunkX ) * samplesPerPixel;
+            uint8* dest_sample = dest;
+            for( dip::uint kk = 0; kk < samplesPerPixel; ++kk, ++bit ) {
+               *dest_sample = ( src[ bit / 8 ] & ( 0x80u >> ( bit % 8 ))) ? uint8( 1 - zero ) : zero;
+               dest_sample += tensorStride;
+            }
+            dest += strideX;
+         }
       }
-      imagedata += static_cast< dip::sint >( nrow ) * image.Stride( 1 );
-      row += rowsPerStrip;
-   }
+   } ));
 }
 
 //
 // Grey-value (including multi-channel, color, etc)
 //
 
-inline void CopyBuffer8(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& destStrides,
-      dip::sint srcStride // src has x-stride = 1, y-stride = srcStride.
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      uint8 const* src_sample = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         *dest_pixel = *src_sample;
-         dest_pixel += destStrides[ 0 ];
-         ++src_sample;
-      }
-      dest += destStrides[ 1 ];
-      src += srcStride;
-   }
-}
-
-inline void CopyBufferN(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& destStrides,
-      dip::sint srcStride, // src has x-stride = 1, y-stride = srcStride.
-      dip::uint sizeOf
-) {
-   dip::sint stride_row = destStrides[ 1 ] * static_cast< dip::sint >( sizeOf );
-   dip::sint stride_pixel = destStrides[ 0 ] * static_cast< dip::sint >( sizeOf );
-   dip::sint stride_src = srcStride * static_cast< dip::sint >( sizeOf );
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      uint8 const* src_sample = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         memcpy( dest_pixel, src_sample, sizeOf );
-         dest_pixel += stride_pixel;
-         src_sample += sizeOf;
-      }
-      dest += stride_row;
-      src += stride_src;
-   }
-}
-
-inline void CopyBufferMultiChannel8(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint tensorElements,
-      dip::uint width,
-      dip::uint height,
-      dip::sint tensorStride, // for dest
-      IntegerArray const& destStrides,
-      dip::sint srcStride // src has tensor-stride = 1, x-stride = tensorElements, y-stride = srcStride.
-) {
-   //std::cout << "[CopyBufferMultiChannel8] tensorElements = " << tensorElements << ", width = " << width << ", height = " << height << std::endl;
-   //std::cout << "[CopyBufferMultiChannel8] tensorStride = " << tensorStride << ", destStrides[0] = " << destStrides[0] << ", destStrides[1] = " << destStrides[1] << std::endl;
-   //std::cout << "[CopyBufferMultiChannel8] srcStride = " << srcStride << std::endl;
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      uint8 const* src_sample = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         uint8* dest_sample = dest_pixel;
-         for( dip::uint kk = 0; kk < tensorElements; ++kk ) {
-            *dest_sample = *src_sample;
-            dest_sample += tensorStride;
-            ++src_sample;
-         }
-         dest_pixel += destStrides[ 0 ];
-      }
-      dest += destStrides[ 1 ];
-      src += srcStride;
-   }
-}
-
-inline void CopyBufferMultiChannelN(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint tensorElements,
-      dip::uint width,
-      dip::uint height,
-      dip::sint tensorStride, // for dest
-      IntegerArray const& destStrides,
-      dip::sint srcStride, // src has tensor-stride = 1, x-stride = tensorElements, y-stride = srcStride.
-      dip::uint sizeOf
-) {
-   dip::sint stride_row = destStrides[ 1 ] * static_cast< dip::sint >( sizeOf );
-   dip::sint stride_pixel = destStrides[ 0 ] * static_cast< dip::sint >( sizeOf );
-   dip::sint stride_sample = tensorStride * static_cast< dip::sint >( sizeOf );
-   dip::sint stride_src = srcStride * static_cast< dip::sint >( sizeOf );
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8* dest_pixel = dest;
-      uint8 const* src_sample = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         uint8* dest_sample = dest_pixel;
-         for( dip::uint kk = 0; kk < tensorElements; ++kk ) {
-            memcpy( dest_sample, src_sample, sizeOf );
-            dest_sample += stride_sample;
-            src_sample += sizeOf;
-         }
-         dest_pixel += stride_pixel;
-      }
-      dest += stride_row;
-      src += stride_src;
-   }
-}
-
 inline bool StridesAreNormal(
       dip::uint tensorElements,
       dip::sint tensorStride,
@@ -588,7 +558,7 @@ inline bool StridesAreNormal(
       return false;
    }
    dip::sint total = static_cast< dip::sint >( tensorElements );
-   for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+   for( dip::uint ii = 0; ii < 2; ++ii ) {
       if( strides[ ii ] != total ) {
          return false;
       }
@@ -597,6 +567,8 @@ inline bool StridesAreNormal(
    return true;
 }
 
+// Reads the current directory into the 2D image plane starting at `imagedata`. `sizes` are the sizes of the
+// image in the file.
 void ReadTIFFData(
       uint8* imagedata,
       UnsignedArray const& sizes,
@@ -604,188 +576,72 @@ void ReadTIFFData(
       dip::uint tensorElements,
       dip::sint tensorStride,
       DataType dataType,
-      TiffFile& tiff
+      TiffFile& tiff,
+      RangeArray const& roi
 ) {
-   dip::uint sizeOf = dataType.SizeOf();
-
-   // Planar configuration?
-   uint16 planarConfiguration = PLANARCONFIG_SEPARATE;
-   if( tensorElements > 1 ) {
-      if( !TIFFGetField( tiff, TIFFTAG_PLANARCONFIG, &planarConfiguration )) {
-         planarConfiguration = PLANARCONFIG_CONTIG; // Default
-      }
-   }
-
-   // Strips or tiles?
-   uint32 tileWidth;
-   if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth )) {
-      // --- Tiled TIFF file ---
-      uint32 tileLength;
-      READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_TILELENGTH, &tileLength );
-      auto tileSize = TIFFTileSize( tiff );
-      //std::cout << "[ReadTIFFData] tileSize = " << tileSize << std::endl;
-      //std::cout << "[ReadTIFFData] tileWidth = " << tileWidth << ", tileLength = " << tileLength << std::endl;
-      //std::cout << "[ReadTIFFData] tensorElements = " << tensorElements << ", sizeOf = " << sizeOf << std::endl;
-      std::vector< uint8 > buf( static_cast< dip::uint >( tileSize ));
-      //uint32 nTiles = TIFFNumberOfTiles( tiff );
-      if( planarConfiguration == PLANARCONFIG_CONTIG ) {
-         // 1234123412341234....
-         // We know that tensorElements > 1, otherwise we force to PLANARCONFIG_SEPARATE
-         DIP_ASSERT( static_cast< dip::uint >( tileSize ) == tileWidth * tileLength * tensorElements * sizeOf );
-         dip::sint tileStride = static_cast< dip::sint >( tensorElements * tileWidth );
-         uint32 tile = 0;
-         for( dip::uint y = 0; y < sizes[ 1 ]; y += tileLength ) {
-            uint8* imagedataRow = imagedata;
-            dip::uint copyHeight = std::min< dip::uint >( sizes[ 1 ] - y, tileLength );
-            for( dip::uint x = 0; x < sizes[ 0 ]; x += tileWidth ) {
-               dip::uint copyWidth = std::min< dip::uint >( sizes[ 0 ] - x, tileWidth );
-               TIFFReadEncodedTile( tiff, tile, buf.data(), tileSize );
-               if( sizeOf == 1 ) {
-                  CopyBufferMultiChannel8( imagedataRow, buf.data(), tensorElements, copyWidth, copyHeight,
-                                           tensorStride, strides, tileStride );
-                  imagedataRow += static_cast< dip::sint >( tileWidth ) * strides[ 0 ];
-               } else {
-                  CopyBufferMultiChannelN( imagedataRow, buf.data(), tensorElements, copyWidth, copyHeight,
-                                           tensorStride, strides, tileStride, sizeOf );
-                  imagedataRow += static_cast< dip::sint >( tileWidth * sizeOf ) * strides[ 0 ];
-               }
-               ++tile;
-            }
-            imagedata += static_cast< dip::sint >( tileLength * sizeOf ) * strides[ 1 ];
-         }
-      } else if( planarConfiguration == PLANARCONFIG_SEPARATE ) {
-         // 1111...2222...3333...4444...
-         DIP_ASSERT( static_cast< dip::uint >( tileSize ) == tileWidth * tileLength * sizeOf );
-         dip::sint tileStride = tileWidth;
-         uint8* imagebase = imagedata;
-         uint32 tile = 0;
-         for( uint16 plane = 0; plane < tensorElements; ++plane ) {
-            imagedata = imagebase + static_cast< dip::sint >( plane * sizeOf ) * tensorStride;
-            for( dip::uint y = 0; y < sizes[ 1 ]; y += tileLength ) {
-               uint8* imagedataRow = imagedata;
-               dip::uint copyHeight = std::min< dip::uint >( sizes[ 1 ] - y, tileLength );
-               for( dip::uint x = 0; x < sizes[ 0 ]; x += tileWidth ) {
-                  dip::uint copyWidth = std::min< dip::uint >( sizes[ 0 ] - x, tileWidth );
-                  TIFFReadEncodedTile( tiff, tile, buf.data(), tileSize );
-                  if( sizeOf == 1 ) {
-                     CopyBuffer8( imagedataRow, buf.data(), copyWidth, copyHeight, strides, tileStride );
-                     imagedataRow += static_cast< dip::sint >( tileWidth ) * strides[ 0 ];
-                  } else {
-                     CopyBufferN( imagedataRow, buf.data(), copyWidth, copyHeight, strides, tileStride, sizeOf );
-                     imagedataRow += static_cast< dip::sint >( tileWidth * sizeOf ) * strides[ 0 ];
-                  }
-                  ++tile;
-               }
-               imagedata += static_cast< dip::sint >( tileLength * sizeOf ) * strides[ 1 ];
-            }
+   dip::sint sizeOf = static_cast< dip::sint >( dataType.SizeOf() );
+   TiffLayout layout;
+   DIP_STACK_TRACE_THIS( layout = GetTIFFLayout( tiff, sizes, tensorElements ));
+   dip::uint samplesPerPixel = layout.nPlanes == 1 ? tensorElements : 1;
+   dip::uint pixelSize = samplesPerPixel * static_cast< dip::uint >( sizeOf );
+   DIP_ASSERT( layout.rowSize == layout.chunkWidth * pixelSize );
+
+   // Strips can be decoded directly into the image if we read all pixels and the strides match
+   TiffChunkDestination destination;
+   if( !layout.tiled && RoiIsFullImage( roi, sizes ) &&
+       ( layout.nPlanes == 1 ? StridesAreNormal( tensorElements, tensorStride, sizes, strides )
+                             : StridesAreNormal( 1, 1, sizes, strides ))) {
+      destination = [ & ]( TiffChunkRegion const& region ) {
+         return imagedata + ( static_cast< dip::sint >( region.chunkY ) * strides[ 1 ]
+                              + static_cast< dip::sint >( region.plane ) * tensorStride ) * sizeOf;
+      };
+   }
+
+   // Otherwise we copy from a buffer. If the pixels are contiguous in the image as they are in the buffer,
+   // we can copy whole rows at once.
+   bool copyRows = ( roi[ 0 ].step == 1 ) && ( strides[ 0 ] == static_cast< dip::sint >( samplesPerPixel )) &&
+                   (( samplesPerPixel == 1 ) || ( tensorStride == 1 ));
+   DIP_STACK_TRACE_THIS( ReadTIFFChunks( tiff, layout, roi, [ & ]( uint8 const* buffer, TiffChunkRegion const& region ) {
+      for( dip::uint jj = region.firstY; jj < region.lastY; ++jj ) {
+         uint8 const* src = buffer + ( roi[ 1 ].Offset() + jj * roi[ 1 ].step - region.chunkY ) * layout.rowSize
+                            + ( roi[ 0 ].Offset() + region.firstX * roi[ 0 ].step - region.chunkX ) * pixelSize;
+         uint8* dest = imagedata + ( static_cast< dip::sint >( jj ) * strides[ 1 ] + static_cast< dip::sint >( region.firstX ) * strides[ 0 ]
+                                     + static_cast< dip::sint >( region.plane ) * tensorStride ) * sizeOf;
+         dip::uint width = region.lastX - region.firstX;
+         if( copyRows ) {
+            std::memcpy( dest, src, width * pixelSize );
+            continue;
          }
-      } else {
-         DIP_THROW_RUNTIME( "Unsupported TIFF: unknown PlanarConfiguration value" );
-      }
-   } else {
-      // --- Striped TIFF file ---
-      uint32 rowsPerStrip;
-      TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip );
-      tsize_t stripSize = TIFFStripSize( tiff );
-      uint32 nStrips = TIFFNumberOfStrips( tiff );
-      if( planarConfiguration == PLANARCONFIG_CONTIG ) {
-         // 1234123412341234....
-         // We know that tensorElements > 1, otherwise we force to PLANARCONFIG_SEPARATE
-         DIP_ASSERT( static_cast< dip::uint >( TIFFScanlineSize( tiff )) == sizes[ 0 ] * tensorElements * sizeOf );
-         if( StridesAreNormal( tensorElements, tensorStride, sizes, strides )) {
-            uint32 row = 0;
-            for( uint32 strip = 0; strip < nStrips; ++strip ) {
-               dip::uint nrow = ( row + rowsPerStrip > sizes[ 1 ] ? sizes[ 1 ] - row : rowsPerStrip );
-               if( TIFFReadEncodedStrip( tiff, strip, imagedata, stripSize ) < 0 ) {
-                  DIP_THROW_RUNTIME( "Error reading data (planar config cont)" );
-               }
-               imagedata += static_cast< dip::sint >( nrow * sizeOf ) * strides[ 1 ];
-               row += rowsPerStrip;
-            }
-         } else {
-            std::vector< uint8 > buf( static_cast< dip::uint >( stripSize ));
-            dip::sint bufferStride = static_cast< dip::sint >( tensorElements * sizes[ 0 ] );
-            uint32 row = 0;
-            for( uint32 strip = 0; strip < nStrips; ++strip ) {
-               dip::uint nrow = ( row + rowsPerStrip > sizes[ 1 ] ? sizes[ 1 ] - row : rowsPerStrip );
-               if( TIFFReadEncodedStrip( tiff, strip, buf.data(), stripSize ) < 0 ) {
-                  DIP_THROW_RUNTIME( "Error reading data (planar config cont)" );
-               }
-               if( sizeOf == 1 ) {
-                  CopyBufferMultiChannel8( imagedata, buf.data(), tensorElements, sizes[ 0 ], nrow,
-                                          tensorStride, strides, bufferStride );
-                  imagedata += static_cast< dip::sint >( nrow ) * strides[ 1 ];
-               } else {
-                  CopyBufferMultiChannelN( imagedata, buf.data(), tensorElements, sizes[ 0 ], nrow,
-                                          tensorStride, strides, bufferStride, sizeOf );
-                  imagedata += static_cast< dip::sint >( nrow * sizeOf ) * strides[ 1 ];
-               }
-               row += rowsPerStrip;
-            }
-         }
-      } else if( planarConfiguration == PLANARCONFIG_SEPARATE ) {
-         // 1111...2222...3333...4444...
-         DIP_ASSERT( static_cast< dip::uint >( TIFFScanlineSize( tiff )) == sizes[ 0 ] * sizeOf );
-         DIP_ASSERT( nStrips % tensorElements == 0 );
-         nStrips /= static_cast< uint32 >( tensorElements );
-         uint8* imagebase = imagedata;
-         uint32 stripOffset = 0;
-         if( StridesAreNormal( 1, 1, sizes, strides )) {
-            for( uint16 plane = 0; plane < tensorElements; ++plane ) {
-               imagedata = imagebase + static_cast< dip::sint >( plane * sizeOf ) * tensorStride;
-               uint32 row = 0;
-               for( uint32 strip = 0; strip < nStrips; ++strip ) {
-                  dip::uint nrow = ( row + rowsPerStrip > sizes[ 1 ] ? sizes[ 1 ] - row : rowsPerStrip );
-                  if( TIFFReadEncodedStrip( tiff, stripOffset + strip, imagedata, stripSize ) < 0 ) {
-                     DIP_THROW_RUNTIME( "Error reading data (planar config separate)" );
-                  }
-                  imagedata += static_cast< dip::sint >( nrow * sizeOf ) * strides[ 1 ];
-                  row += rowsPerStrip;
-               }
-               stripOffset += nStrips;
-            }
-         } else {
-            std::vector< uint8 > buf( static_cast< dip::uint >( stripSize ));
-            dip::sint bufferStride = static_cast< dip::sint >( sizes[ 0 ] );
-            for( uint16 plane = 0; plane < tensorElements; ++plane ) {
-               imagedata = imagebase + static_cast< dip::sint >( plane * sizeOf ) * tensorStride;
-               uint32 row = 0;
-               for( uint32 strip = 0; strip < nStrips; ++strip ) {
-                  dip::uint nrow = ( row + rowsPerStrip > sizes[ 1 ] ? sizes[ 1 ] - row : rowsPerStrip );
-                  if( TIFFReadEncodedStrip( tiff, stripOffset + strip, buf.data(), stripSize ) < 0 ) {
-                     DIP_THROW_RUNTIME( "Error reading data (planar config separate)" );
-                  }
-                  if( sizeOf == 1 ) {
-                     CopyBuffer8( imagedata, buf.data(), sizes[ 0 ], nrow, strides, bufferStride );
-                     imagedata += static_cast< dip::sint >( nrow ) * strides[ 1 ];
-                  } else {
-                     CopyBufferN( imagedata, buf.data(), sizes[ 0 ], nrow, strides, bufferStride, sizeOf );
-                     imagedata += static_cast< dip::sint >( nrow * sizeOf ) * strides[ 1 ];
-                  }
-                  row += rowsPerStrip;
-               }
-               stripOffset += nStrips;
+         dip::uint srcStep = roi[ 0 ].step * pixelSize;
+         for( dip::uint ii = 0; ii < width; ++ii ) {
+            uint8* dest_sample = dest;
+            uint8 const* src_sample = src;
+            for( dip::uint kk = 0; kk < samplesPerPixel; ++kk ) {
+               std::memcpy( dest_sample, src_sample, static_cast< dip::uint >( sizeOf ));
+               dest_sample += tensorStride * sizeOf;
+               src_sample += sizeOf;
             }
+            dest += strides[ 0 ] * sizeOf;
+            src += srcStep;
          }
-      } else {
-         DIP_THROW_RUNTIME( "Unsupported TIFF: unknown PlanarConfiguration value" );
       }
-   }
+   }, destination ));
 }
 
 void ReadTIFFGreyValue(
       Image& image,
       TiffFile& tiff,
-      GetTIFFInfoData& data
+      GetTIFFInfoData& data,
+      RangeArray const& roi
 ) {
    // Forge the image
-   image.ReForge( data.fileInformation.sizes, data.fileInformation.tensorElements, data.fileInformation.dataType );
+   image.ReForge( { roi[ 0 ].Size(), roi[ 1 ].Size() }, data.fileInformation.tensorElements, data.fileInformation.dataType );
    uint8* imagedata = static_cast< uint8* >( image.Origin() );
 
    // Read the image data
    DIP_STACK_TRACE_THIS( ReadTIFFData(
-         imagedata, image.Sizes(), image.Strides(), image.TensorElements(), image.TensorStride(),
-         image.DataType(), tiff ));
+         imagedata, data.fileInformation.sizes, image.Strides(), image.TensorElements(), image.TensorStride(),
+         image.DataType(), tiff, roi ));
 
    if( data.photometricInterpretation == PHOTOMETRIC_MINISWHITE ) {
       Invert( image, image );
@@ -796,18 +652,18 @@ void ImageReadTIFFStack(
       Image& image,
       TiffFile& tiff,
       GetTIFFInfoData& data,
-      Range const& imageNumbers
+      Range const& imageNumbers,
+      RangeArray const& roi
 ) {
    // Forge the image
-   data.fileInformation.sizes.push_back( imageNumbers.Size() );
-   image.ReForge( data.fileInformation.sizes, data.fileInformation.tensorElements, data.fileInformation.dataType );
+   image.ReForge( { roi[ 0 ].Size(), roi[ 1 ].Size(), imageNumbers.Size() }, data.fileInformation.tensorElements, data.fileInformation.dataType );
    uint8* imagedata = static_cast< uint8* >( image.Origin() );
    dip::sint z_stride = image.Stride( 2 ) * static_cast< dip::sint >( data.fileInformation.dataType.SizeOf() );
 
    // Read the image data for first plane
    DIP_STACK_TRACE_THIS( ReadTIFFData(
-         imagedata, image.Sizes(), image.Strides(), image.TensorElements(), image.TensorStride(),
-         image.DataType(), tiff ));
+         imagedata, data.fileInformation.sizes, image.Strides(), image.TensorElements(), image.TensorStride(),
+         image.DataType(), tiff, roi ));
 
    // Read the image data for other planes
    dip::uint directory = imageNumbers.Offset();
@@ -825,11 +681,11 @@ void ImageReadTIFFStack(
       // Test image plane to make sure it matches expectations
       uint32 temp32;
       READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_IMAGEWIDTH, &temp32 );
-      if( temp32 != image.Size( 0 )) {
+      if( temp32 != data.fileInformation.sizes[ 0 ] ) {
          DIP_THROW_RUNTIME( "Reading multi-slice TIFF: width of images not consistent" );
       }
       READ_REQUIRED_TIFF_TAG( tiff, TIFFTAG_IMAGELENGTH, &temp32 );
-      if( temp32 != image.Size( 1 )) {
+      if( temp32 != data.fileInformation.sizes[ 1 ] ) {
          DIP_THROW_RUNTIME( "Reading multi-slice TIFF: length of images not consistent" );
       }
       uint16 photometricInterpretation;
@@ -856,8 +712,8 @@ void ImageReadTIFFStack(
 
       // Read the image data for this plane
       DIP_STACK_TRACE_THIS( ReadTIFFData(
-            imagedata, image.Sizes(), image.Strides(), image.TensorElements(), image.TensorStride(),
-            image.DataType(), tiff ));
+            imagedata, data.fileInformation.sizes, image.Strides(), image.TensorElements(), image.TensorStride(),
+            image.DataType(), tiff, roi ));
    }
 }
 
@@ -866,7 +722,8 @@ void ImageReadTIFFStack(
 FileInformation ImageReadTIFF(
       Image& out,
       String const& filename,
-      Range imageNumbers
+      Range imageNumbers,
+      RangeArray roi
 ) {
    // Open TIFF file
    TiffFile tiff( filename );
@@ -883,9 +740,15 @@ FileInformation ImageReadTIFF(
    GetTIFFInfoData data;
    DIP_STACK_TRACE_THIS( data = GetTIFFInfo( tiff ));
 
+   // Check & fix ROI information
+   BooleanArray mirror;
+   DIP_STACK_TRACE_THIS( FixTIFFRoi( roi, data.fileInformation.sizes, mirror ));
+
    if( imageNumbers.start != imageNumbers.stop ) {
       // Read in multiple pages as a 3D image
-      DIP_STACK_TRACE_THIS( ImageReadTIFFStack( out, tiff, data, imageNumbers ));
+      DIP_STACK_TRACE_THIS( ImageReadTIFFStack( out, tiff, data, imageNumbers, roi ));
+      data.fileInformation.sizes.push_back( imageNumbers.Size() );
+      mirror.push_back( false );
    } else {
       // Hack by Bernd Rieger to recognize Leica 12 bit TIFFs
       // These are written as color-mapped images, but they are not
@@ -901,16 +764,17 @@ FileInformation ImageReadTIFF(
          }
       }
       if( data.photometricInterpretation == PHOTOMETRIC_PALETTE ) {
-         DIP_STACK_TRACE_THIS( ReadTIFFColorMap( out, tiff, data ));
+         DIP_STACK_TRACE_THIS( ReadTIFFColorMap( out, tiff, data, roi ));
       } else {
          if( data.fileInformation.dataType.IsBinary() ) {
-            DIP_STACK_TRACE_THIS( ReadTIFFBinary( out, tiff, data ));
+            DIP_STACK_TRACE_THIS( ReadTIFFBinary( out, tiff, data, roi ));
          } else {
-            DIP_STACK_TRACE_THIS( ReadTIFFGreyValue( out, tiff, data ));
+            DIP_STACK_TRACE_THIS( ReadTIFFGreyValue( out, tiff, data, roi ));
          }
       }
    }
 
+   out.Mirror( mirror );
    out.SetColorSpace( data.fileInformation.colorSpace );
    out.SetPixelSize( data.fileInformation.pixelSize );
 
@@ -988,6 +852,122 @@ bool ImageIsTIFF(
 
 } // namespace dip
 
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/testing.h"
+#include "diplib/generation.h"
+
+namespace {
+
+// `dip::ImageWriteTIFF` doesn't write color-mapped images, we write them directly. `indices` is a 2D `uint8` image.
+void WritePaletteTIFF( dip::Image const& indices, std::vector< dip::uint16 >& colorMap, char const* filename, dip::uint tileSize ) {
+   TIFF* tiff = TIFFOpen( filename, "w" );
+   DIP_THROW_IF( tiff == nullptr, "Could not open the specified file" );
+   dip::uint width = indices.Size( 0 );
+   dip::uint height = indices.Size( 1 );
+   TIFFSetField( tiff, TIFFTAG_IMAGEWIDTH, static_cast< dip::uint32 >( width ));
+   TIFFSetField( tiff, TIFFTAG_IMAGELENGTH, static_cast< dip::uint32 >( height ));
+   TIFFSetField( tiff, TIFFTAG_BITSPERSAMPLE, dip::uint16( 8 ));
+   TIFFSetField( tiff, TIFFTAG_SAMPLESPERPIXEL, dip::uint16( 1 ));
+   TIFFSetField( tiff, TIFFTAG_PHOTOMETRIC, dip::uint16( PHOTOMETRIC_PALETTE ));
+   TIFFSetField( tiff, TIFFTAG_COLORMAP, colorMap.data(), colorMap.data() + 256, colorMap.data() + 512 );
+   TIFFSetField( tiff, TIFFTAG_COMPRESSION, dip::uint16( COMPRESSION_DEFLATE ));
+   dip::uint chunkWidth = width;
+   dip::uint chunkLength = 16;
+   if( tileSize > 0 ) {
+      TIFFSetField( tiff, TIFFTAG_TILEWIDTH, static_cast< dip::uint32 >( tileSize ));
+      TIFFSetField( tiff, TIFFTAG_TILELENGTH, static_cast< dip::uint32 >( tileSize ));
+      chunkWidth = tileSize;
+      chunkLength = tileSize;
+   } else {
+      TIFFSetField( tiff, TIFFTAG_ROWSPERSTRIP, static_cast< dip::uint32 >( chunkLength ));
+   }
+   std::vector< dip::uint8 > buffer( chunkWidth * chunkLength );
+   dip::uint index = 0;
+   for( dip::uint y = 0; y < height; y += chunkLength ) {
+      for( dip::uint x = 0; x < width; x += chunkWidth, ++index ) {
+         std::fill( buffer.begin(), buffer.end(), dip::uint8( 0 ));
+         dip::uint chunkHeight = std::min( chunkLength, height - y );
+         for( dip::uint jj = 0; jj < chunkHeight; ++jj ) {
+            for( dip::uint ii = 0; ii < std::min( chunkWidth, width - x ); ++ii ) {
+               buffer[ jj * chunkWidth + ii ] = static_cast< dip::uint8 >( indices.At( x + ii, y + jj ).As< dip::uint >() );
+            }
+         }
+         tmsize_t result = tileSize > 0
+                           ? TIFFWriteEncodedTile( tiff, static_cast< dip::uint32 >( index ), buffer.data(), static_cast< tmsize_t >( buffer.size() ))
+                           : TIFFWriteEncodedStrip( tiff, static_cast< dip::uint32 >( index ), buffer.data(), static_cast< tmsize_t >( chunkHeight * chunkWidth ));
+         DIP_THROW_IF( result < 0, "Error writing data" );
+      }
+   }
+   TIFFClose( tiff );
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE( "[DIPlib] testing TIFF reading of strips and tiles" ) {
+   dip::Random random( 0 );
+   dip::Image grey( { 400, 300 }, 1, dip::DT_UINT16 );
+   grey.Fill( 0 );
+   dip::DrawBandlimitedBall( grey, 250, { 200, 150 }, { 30000 } );
+   dip::UniformNoise( grey, grey, random, 0.0, 1000.0 );
+   dip::Image color( { 400, 300 }, 3, dip::DT_UINT8 );
+   color.Fill( 0 );
+   dip::DrawBandlimitedBall( color, 250, { 200, 150 }, { 100, 150, 200 } );
+   dip::UniformNoise( color, color, random, 0.0, 40.0 );
+   color.SetColorSpace( "RGB" );
+   dip::Image binary( { 1000, 300 }, 1, dip::DT_BIN );
+   binary.Fill( 0 );
+   dip::BinaryNoise( binary, binary, random, 0.0, 0.5 );
+   dip::Image indices( { 400, 300 }, 1, dip::DT_UINT8 );
+   indices.Fill( 0 );
+   dip::UniformNoise( indices, indices, random, 0.0, 255.0 );
+   std::vector< dip::uint16 > colorMap( 3 * 256 );
+   for( dip::uint ii = 0; ii < 256; ++ii ) {
+      colorMap[ ii ] = static_cast< dip::uint16 >( ii * 256 );
+      colorMap[ 256 + ii ] = static_cast< dip::uint16 >( 65535 - ii * 17 );
+      colorMap[ 512 + ii ] = static_cast< dip::uint16 >(( ii * 97 ) % 256 * 256 );
+   }
+   dip::Image palette( indices.Sizes(), 3, dip::DT_UINT16 );
+   for( dip::uint y = 0; y < palette.Size( 1 ); ++y ) {
+      for( dip::uint x = 0; x < palette.Size( 0 ); ++x ) {
+         dip::uint index = indices.At( x, y ).As< dip::uint >();
+         palette.At( x, y ) = { colorMap[ index ], colorMap[ 256 + index ], colorMap[ 512 + index ] };
+      }
+   }
+   palette.SetColorSpace( "RGB" );
+
+   dip::RangeArray roi{ dip::Range{ 10, 390, 3 }, dip::Range{ 250, 5, 2 }}; // subsampled and mirrored
+   dip::RangeArray roi2{ dip::Range{ 37, 300 }, dip::Range{ 3, 131 }};
+   for( dip::uint tileSize : { dip::uint( 0 ), dip::uint( 32 ) } ) {
+      dip::ImageWriteTIFF( grey, "test6g.tif", "deflate", 80, tileSize );
+      dip::ImageWriteTIFF( color, "test6c.tif", "LZW", 80, tileSize );
+      dip::ImageWriteTIFF( binary, "test6b.tif", "PackBits", 80, tileSize );
+      WritePaletteTIFF( indices, colorMap, "test6p.tif", tileSize );
+      std::pair< dip::Image const*, char const* > files[] = {
+            { &grey, "test6g.tif" }, { &color, "test6c.tif" }, { &binary, "test6b.tif" }, { &palette, "test6p.tif" }
+      };
+      for( auto const& file : files ) {
+         dip::Image const& image = *file.first;
+         dip::Image result[ 2 ];
+         dip::Image resultRoi[ 2 ];
+         dip::Image resultRoi2[ 2 ];
+         bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+            result[ ii ] = dip::ImageReadTIFF( file.second );
+            resultRoi[ ii ] = dip::ImageReadTIFF( file.second, dip::Range{ 0 }, roi );
+            resultRoi2[ ii ] = dip::ImageReadTIFF( file.second, dip::Range{ 0 }, roi2 );
+         } );
+         for( dip::uint ii = 0; ii < ( multiThreaded ? 2u : 1u ); ++ii ) {
+            DOCTEST_CHECK( dip::testing::CompareImages( image, result[ ii ] ));
+            DOCTEST_CHECK( dip::testing::CompareImages( image.At( roi ), resultRoi[ ii ] ));
+            DOCTEST_CHECK( dip::testing::CompareImages( image.At( roi2 ), resultRoi2[ ii ] ));
+            DOCTEST_CHECK( result[ ii ].ColorSpace() == image.ColorSpace() );
+         }
+      }
+   }
+}
+
+#endif // DIP__ENABLE_DOCTEST
+
 #else // DIP__HAS_TIFF
 
 #include "diplib.h"
@@ -997,7 +977,7 @@ namespace dip {
 
 static const char* NOT_AVAILABLE = "DIPlib was compiled without TIFF support.";
 
-FileInformation ImageReadTIFF( Image&, String const&, Range ) {
+FileInformation ImageReadTIFF( Image&, String const&, Range, RangeArray ) {
    DIP_THROW( NOT_AVAILABLE );
 }
 
@@ -22,6 +22,11 @@
 
 #include "diplib.h"
 #include "diplib/file_io.h"
+#include "diplib/multithreading.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
 
 #include <tiffio.h>
 
@@ -81,191 +86,313 @@ static uint16 CompressionTranslate( String const& compression ) {
    }
 }
 
-void FillBuffer1(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& strides
-) {
-   dip::sint kk = 7;
-   uint8 byte = 0;
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8 const* src_pixel = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         if( kk < 0 ) {
-            kk = 7;
-            *dest = byte;
-            ++dest;
-            byte = 0;
-         }
-         if( *src_pixel ) {
-            byte = static_cast< uint8 >( byte | ( 1u << kk )); // GCC likes to warn about `a |= b`, when both `a` and `b` are uint8.
-         }
-         src_pixel += strides[ 0 ];
-         --kk;
-      }
-      if( kk != 7 ) {
-         kk = 7;
-         *dest = byte;
-         ++dest;
-         byte = 0;
-      }
-      src += strides[ 1 ];
-   }
-}
+// The TIFF tags that determine how pixel data is encoded. These need to be the same in the file and in the
+// in-memory TIFF handles used to compress data in parallel.
+struct TiffWriteParameters {
+   uint32 imageWidth = 0;
+   uint32 imageLength = 0;
+   uint16 photometric = PHOTOMETRIC_MINISBLACK;
+   uint16 bitsPerSample = 1;
+   uint16 sampleFormat = SAMPLEFORMAT_UINT;
+   uint16 samplesPerPixel = 1;
+   uint16 compression = COMPRESSION_NONE;
+   uint16 predictor = PREDICTOR_NONE;
+   uint16 fillOrder = FILLORDER_MSB2LSB;
+   int jpegLevel = 80;
+   uint32 tileSize = 0; // 0 for strips
+   uint32 rowsPerStrip = 0;
+};
 
-void FillBuffer8(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& strides
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8 const* src_pixel = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         *dest = *src_pixel;
-         ++dest;
-         src_pixel += strides[ 0 ];
+void WriteTIFFLayoutTags( TIFF* tiff, TiffWriteParameters const& params ) {
+   WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, params.photometric );
+   WRITE_TIFF_TAG( tiff, TIFFTAG_IMAGEWIDTH, params.imageWidth );
+   WRITE_TIFF_TAG( tiff, TIFFTAG_IMAGELENGTH, params.imageLength );
+   if( params.bitsPerSample > 1 ) {
+      WRITE_TIFF_TAG( tiff, TIFFTAG_BITSPERSAMPLE, params.bitsPerSample );
+      WRITE_TIFF_TAG( tiff, TIFFTAG_SAMPLEFORMAT, params.sampleFormat );
+      WRITE_TIFF_TAG( tiff, TIFFTAG_SAMPLESPERPIXEL, params.samplesPerPixel );
+      if( params.samplesPerPixel > 1 ) {
+         WRITE_TIFF_TAG( tiff, TIFFTAG_PLANARCONFIG, uint16( PLANARCONFIG_CONTIG ));
+         // This is the standard way of writing channels (planes), PLANARCONFIG_SEPARATE is not required to be
+         // supported by all readers.
       }
-      src += strides[ 1 ];
    }
-}
-
-void FillBufferN(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint width,
-      dip::uint height,
-      IntegerArray const& strides,
-      dip::uint sizeOf
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8 const* src_pixel = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         memcpy( dest, src_pixel, sizeOf );
-         dest += sizeOf;
-         src_pixel += static_cast< dip::sint >( sizeOf ) * strides[ 0 ];
-      }
-      src += static_cast< dip::sint >( sizeOf ) * strides[ 1 ];
+   WRITE_TIFF_TAG( tiff, TIFFTAG_FILLORDER, params.fillOrder );
+   WRITE_TIFF_TAG( tiff, TIFFTAG_COMPRESSION, params.compression );
+   if( params.predictor != PREDICTOR_NONE ) {
+      WRITE_TIFF_TAG( tiff, TIFFTAG_PREDICTOR, params.predictor );
+   }
+   if( params.compression == COMPRESSION_JPEG ) {
+      WRITE_TIFF_TAG( tiff, TIFFTAG_JPEGQUALITY, params.jpegLevel );
+      WRITE_TIFF_TAG( tiff, TIFFTAG_JPEGCOLORMODE, int( JPEGCOLORMODE_RGB ));
+   }
+   if( params.tileSize > 0 ) {
+      WRITE_TIFF_TAG( tiff, TIFFTAG_TILEWIDTH, params.tileSize );
+      WRITE_TIFF_TAG( tiff, TIFFTAG_TILELENGTH, params.tileSize );
+   } else if( params.rowsPerStrip > 0 ) {
+      WRITE_TIFF_TAG( tiff, TIFFTAG_ROWSPERSTRIP, params.rowsPerStrip );
    }
 }
 
-void FillBufferMultiChannel8(
-      uint8* dest,
-      uint8 const* src,
-      dip::uint tensorElements,
-      dip::uint width,
-      dip::uint height,
-      dip::sint tensorStride,
-      IntegerArray const& strides
-) {
-   for( dip::uint ii = 0; ii < height; ++ii ) {
-      uint8 const* src_pixel = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         uint8 const* src_sample = src_pixel;
-         for( dip::uint kk = 0; kk < tensorElements; ++kk ) {
-            *dest = *src_pixel;
-            ++dest;
-            src_sample += tensorStride;
+// An in-memory file, used to let libtiff compress strips or tiles without touching the output file.
+class MemoryTiff {
+   public:
+      explicit MemoryTiff( TiffWriteParameters const& params ) {
+         tiff_ = TIFFClientOpen( "memory", "wm", static_cast< thandle_t >( this ),
+                                 &Read, &Write, &Seek, &Close, &Size, &Map, &Unmap );
+         if( tiff_ == nullptr ) {
+            DIP_THROW_RUNTIME( "Could not create in-memory TIFF" );
          }
-         src_pixel += strides[ 0 ];
+         WriteTIFFLayoutTags( tiff_, params );
       }
-      src += strides[ 1 ];
-   }
-}
+      MemoryTiff( MemoryTiff const& ) = delete;
+      MemoryTiff( MemoryTiff&& ) = delete;
+      MemoryTiff& operator=( MemoryTiff const& ) = delete;
+      MemoryTiff& operator=( MemoryTiff&& ) = delete;
+      ~MemoryTiff() {
+         if( tiff_ ) {
+            TIFFClose( tiff_ );
+            tiff_ = nullptr;
+         }
+      }
+      // Compresses `size` bytes in `buffer` as strip or tile number `index`, and returns the encoded bytes.
+      std::vector< uint8 > Encode( bool tiled, uint32 index, uint8* buffer, tmsize_t size ) {
+         tmsize_t result = tiled ? TIFFWriteEncodedTile( tiff_, index, buffer, size )
+                                 : TIFFWriteEncodedStrip( tiff_, index, buffer, size );
+         if( result < 0 ) {
+            DIP_THROW_RUNTIME( "Error compressing data" );
+         }
+         toff_t* offsets;
+         toff_t* byteCounts;
+         if( !TIFFGetField( tiff_, tiled ? TIFFTAG_TILEOFFSETS : TIFFTAG_STRIPOFFSETS, &offsets ) ||
+             !TIFFGetField( tiff_, tiled ? TIFFTAG_TILEBYTECOUNTS : TIFFTAG_STRIPBYTECOUNTS, &byteCounts )) {
+            DIP_THROW_RUNTIME( "Error compressing data" );
+         }
+         dip::uint begin = static_cast< dip::uint >( offsets[ index ] );
+         dip::uint end = begin + static_cast< dip::uint >( byteCounts[ index ] );
+         DIP_ASSERT( end <= data_.size() );
+         return std::vector< uint8 >( data_.begin() + static_cast< dip::sint >( begin ), data_.begin() + static_cast< dip::sint >( end ));
+      }
+   private:
+      TIFF* tiff_ = nullptr;
+      std::vector< uint8 > data_;
+      dip::uint position_ = 0;
+
+      static tmsize_t Read( thandle_t handle, void* buffer, tmsize_t size ) {
+         MemoryTiff* self = static_cast< MemoryTiff* >( handle );
+         dip::uint n = std::min( static_cast< dip::uint >( size ), self->data_.size() - std::min( self->position_, self->data_.size() ));
+         std::memcpy( buffer, self->data_.data() + self->position_, n );
+         self->position_ += n;
+         return static_cast< tmsize_t >( n );
+      }
+      static tmsize_t Write( thandle_t handle, void* buffer, tmsize_t size ) {
+         MemoryTiff* self = static_cast< MemoryTiff* >( handle );
+         dip::uint n = static_cast< dip::uint >( size );
+         if( self->position_ + n > self->data_.size() ) {
+            self->data_.resize( self->position_ + n );
+         }
+         std::memcpy( self->data_.data() + self->position_, buffer, n );
+         self->position_ += n;
+         return size;
+      }
+      static toff_t Seek( thandle_t handle, toff_t offset, int whence ) {
+         MemoryTiff* self = static_cast< MemoryTiff* >( handle );
+         switch( whence ) {
+            case SEEK_SET:
+               self->position_ = static_cast< dip::uint >( offset );
+               break;
+            case SEEK_CUR:
+               self->position_ += static_cast< dip::uint >( offset );
+               break;
+            case SEEK_END:
+               self->position_ = self->data_.size() + static_cast< dip::uint >( offset );
+               break;
+            default:
+               break;
+         }
+         return self->position_;
+      }
+      static int Close( thandle_t ) { return 0; }
+      static toff_t Size( thandle_t handle ) { return static_cast< MemoryTiff* >( handle )->data_.size(); }
+      static int Map( thandle_t, void**, toff_t* ) { return 0; }
+      static void Unmap( thandle_t, void*, toff_t ) {}
+};
 
-void FillBufferMultiChannelN(
+// Copies the pixels of a `width` x `height` region of the image into `dest`, which has rows of
+// `rowSize` bytes. Binary images are packed 8 pixels to a byte.
+void FillBuffer(
       uint8* dest,
+      dip::uint rowSize,
       uint8 const* src,
-      dip::uint tensorElements,
       dip::uint width,
       dip::uint height,
+      dip::uint tensorElements,
       dip::sint tensorStride,
       IntegerArray const& strides,
-      dip::uint sizeOf
+      dip::uint sizeOf,
+      bool binary
 ) {
    dip::sint stride_row = strides[ 1 ] * static_cast< dip::sint >( sizeOf );
    dip::sint stride_pixel = strides[ 0 ] * static_cast< dip::sint >( sizeOf );
    dip::sint stride_sample = tensorStride * static_cast< dip::sint >( sizeOf );
    for( dip::uint ii = 0; ii < height; ++ii ) {
+      uint8* dest_row = dest;
       uint8 const* src_pixel = src;
-      for( dip::uint jj = 0; jj < width; ++jj ) {
-         uint8 const* src_sample = src_pixel;
-         for( dip::uint kk = 0; kk < tensorElements; ++kk ) {
-            memcpy( dest, src_sample, sizeOf );
-            dest += sizeOf;
-            src_sample += stride_sample;
+      if( binary ) {
+         std::fill( dest_row, dest_row + div_ceil< dip::uint >( width, 8 ), uint8( 0 ));
+         for( dip::uint jj = 0; jj < width; ++jj ) {
+            if( *src_pixel ) {
+               dest_row[ jj / 8 ] = static_cast< uint8 >( dest_row[ jj / 8 ] | ( 0x80u >> ( jj % 8 )));
+            }
+            src_pixel += stride_pixel;
+         }
+      } else if(( stride_pixel == static_cast< dip::sint >( tensorElements * sizeOf )) && (( tensorElements == 1 ) || ( tensorStride == 1 ))) {
+         std::memcpy( dest_row, src_pixel, width * tensorElements * sizeOf );
+      } else {
+         for( dip::uint jj = 0; jj < width; ++jj ) {
+            uint8 const* src_sample = src_pixel;
+            for( dip::uint kk = 0; kk < tensorElements; ++kk ) {
+               std::memcpy( dest_row, src_sample, sizeOf );
+               dest_row += sizeOf;
+               src_sample += stride_sample;
+            }
+            src_pixel += stride_pixel;
          }
-         src_pixel += stride_pixel;
       }
+      dest += rowSize;
       src += stride_row;
    }
 }
 
-void WriteTIFFStrips(
+// A strip or tile to write
+struct TiffChunk {
+   uint32 index;
+   dip::uint x;         // image coordinates of the first pixel
+   dip::uint y;
+   dip::uint width;     // the part of the chunk that falls within the image
+   dip::uint height;
+};
+
+// Writes the 2D image `image` as strips or tiles into the current directory of `tiff`.
+// When compressing, this is CPU-bound, so chunks are compressed in parallel using an in-memory TIFF handle per
+// thread, and the encoded data is then written to the file sequentially with `TIFFWriteRawStrip` or
+// `TIFFWriteRawTile`.
+void WriteTIFFData(
       Image const& image,
-      TiffFile& tiff
+      TiffFile& tiff,
+      TiffWriteParameters const& params
 ) {
    dip::uint tensorElements = image.TensorElements();
-   dip::uint imageWidth = image.Size( 0 );
-   uint32 imageLength = static_cast< uint32 >( image.Size( 1 ));
    dip::sint tensorStride = image.TensorStride();
    IntegerArray const& strides = image.Strides();
    dip::uint sizeOf = image.DataType().SizeOf();
    bool binary = image.DataType().IsBinary();
-
-   uint32 rowsPerStrip = TIFFDefaultStripSize( tiff, 0 );
-   WRITE_TIFF_TAG( tiff, TIFFTAG_ROWSPERSTRIP, rowsPerStrip );
-
-   // Write it to the file
-   tmsize_t scanline = TIFFScanlineSize( tiff );
+   uint8 const* origin = static_cast< uint8 const* >( image.Origin() );
+   bool tiled = params.tileSize > 0;
+
+   // Divide the image into chunks
+   dip::uint chunkWidth = tiled ? params.tileSize : image.Size( 0 );
+   dip::uint chunkLength = tiled ? params.tileSize : params.rowsPerStrip;
+   dip::uint rowSize = static_cast< dip::uint >( tiled ? TIFFTileRowSize( tiff ) : TIFFScanlineSize( tiff ));
+   dip::uint chunkSize = static_cast< dip::uint >( tiled ? TIFFTileSize( tiff ) : TIFFStripSize( tiff ));
    if( binary ) {
-      DIP_ASSERT( static_cast< dip::uint >( scanline ) == div_ceil< dip::uint >( image.Size( 0 ), 8 ));
       DIP_ASSERT( tensorElements == 1 );
+      DIP_ASSERT( rowSize == div_ceil( chunkWidth, dip::uint( 8 )));
    } else {
-      DIP_ASSERT( static_cast< dip::uint >( scanline ) == image.Size( 0 ) * tensorElements * sizeOf );
+      DIP_ASSERT( rowSize == chunkWidth * tensorElements * sizeOf );
+   }
+   std::vector< TiffChunk > chunks;
+   for( dip::uint y = 0; y < image.Size( 1 ); y += chunkLength ) {
+      for( dip::uint x = 0; x < image.Size( 0 ); x += chunkWidth ) {
+         chunks.push_back( { static_cast< uint32 >( chunks.size() ), x, y,
+                             std::min( chunkWidth, image.Size( 0 ) - x ), std::min( chunkLength, image.Size( 1 ) - y ) } );
+      }
+   }
+   auto ChunkOrigin = [ & ]( TiffChunk const& chunk ) {
+      return origin + ( static_cast< dip::sint >( chunk.x ) * strides[ 0 ] + static_cast< dip::sint >( chunk.y ) * strides[ 1 ] )
+                      * static_cast< dip::sint >( sizeOf );
+   };
+   // Edge tiles are padded with zeros
+   auto FillChunk = [ & ]( uint8* buffer, TiffChunk const& chunk ) {
+      if(( chunk.width < chunkWidth ) || ( chunk.height < chunkLength )) {
+         std::fill( buffer, buffer + chunkSize, uint8( 0 ));
+      }
+      FillBuffer( buffer, rowSize, ChunkOrigin( chunk ), chunk.width, chunk.height,
+                  tensorElements, tensorStride, strides, sizeOf, binary );
+   };
+   // Tiles are always written whole, strips only up to the last image line
+   auto EncodedSize = [ & ]( TiffChunk const& chunk ) {
+      return static_cast< tmsize_t >( tiled ? chunkSize : chunk.height * rowSize );
+   };
+
+   // Determine the number of threads we'll be using. JPEG-compressed files share quantization tables between
+   // chunks, which are written by the file's handle, so we cannot compress those independently.
+   dip::uint nThreads = 1;
+   if(( params.compression != COMPRESSION_NONE ) && ( params.compression != COMPRESSION_JPEG )) {
+      nThreads = std::min( GetNumberOfThreads(), chunks.size() );
+      if( nThreads > 1 ) {
+         // Rough estimate: compressing costs about 50 cycles per input byte
+         dip::uint operations = chunks.size() * chunkSize * 50;
+         nThreads = OptimalNumberOfThreads( operations, nThreads );
+      }
    }
-   if( image.HasNormalStrides() && !binary ) {
-      // Simple writing
-      tstrip_t strip = 0;
-      uint8* data = static_cast< uint8* >( image.Origin() );
-      for( uint32 row = 0; row < imageLength; row += rowsPerStrip ) {
-         uint32 nrow = row + rowsPerStrip > imageLength ? imageLength - row : rowsPerStrip;
-         if( TIFFWriteEncodedStrip( tiff, strip, data, nrow * scanline ) < 0 ) {
+
+   if( nThreads == 1 ) {
+      bool simple = !tiled && !binary && (( tensorElements == 1 ) || ( tensorStride == 1 )) &&
+                    ( strides[ 0 ] == static_cast< dip::sint >( tensorElements )) &&
+                    ( strides[ 1 ] == static_cast< dip::sint >( tensorElements * image.Size( 0 )));
+      std::vector< uint8 > buf;
+      if( !simple ) {
+         buf.resize( chunkSize, 0 );
+      }
+      for( auto const& chunk : chunks ) {
+         uint8* data;
+         if( simple ) {
+            data = const_cast< uint8* >( ChunkOrigin( chunk )); // libtiff doesn't modify the data
+         } else {
+            FillChunk( buf.data(), chunk );
+            data = buf.data();
+         }
+         tmsize_t result = tiled ? TIFFWriteEncodedTile( tiff, chunk.index, data, EncodedSize( chunk ))
+                                 : TIFFWriteEncodedStrip( tiff, chunk.index, data, EncodedSize( chunk ));
+         if( result < 0 ) {
             DIP_THROW_RUNTIME( "Error writing data" );
          }
-         data += static_cast< dip::sint >( nrow * sizeOf ) * image.Stride( 1 );
-         ++strip;
       }
-   } else {
-      // Writing requires an intermediate buffer, filled using strides
-      std::vector< uint8 > buf( static_cast< dip::uint >( TIFFStripSize( tiff )));
-      tstrip_t strip = 0;
-      uint8* data = static_cast< uint8* >( image.Origin() );
-      for( uint32 row = 0; row < imageLength; row += rowsPerStrip ) {
-         uint32 nrow = row + rowsPerStrip > imageLength ? imageLength - row : rowsPerStrip;
-         if( tensorElements == 1 ) {
-            if( binary) {
-               FillBuffer1( buf.data(), data, imageWidth, nrow, strides );
-            } else if( sizeOf == 1 ) {
-               FillBuffer8( buf.data(), data, imageWidth, nrow, strides );
-            } else {
-               FillBufferN( buf.data(), data, imageWidth, nrow, strides, sizeOf );
+      return;
+   }
+
+   // Compress chunks in batches, to limit the amount of memory used for the compressed data
+   dip::uint batchSize = nThreads * 8;
+   std::vector< std::vector< uint8 >> encoded( std::min( batchSize, chunks.size() ));
+   std::mutex tiffMutex; // `TIFFClientOpen` and the error handlers are library-wide
+   for( dip::uint batch = 0; batch < chunks.size(); batch += batchSize ) {
+      dip::uint batchEnd = std::min( batch + batchSize, chunks.size() );
+      WorkDistributor work( batchEnd - batch, nThreads );
+      ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+         std::unique_ptr< MemoryTiff > memory;
+         std::vector< uint8 > buf( chunkSize, 0 );
+         dip::uint begin, end;
+         while( work.Next( thread, begin, end )) {
+            if( !memory ) {
+               std::lock_guard< std::mutex > lock( tiffMutex );
+               memory = std::make_unique< MemoryTiff >( params );
             }
-         } else {
-            if( sizeOf == 1 ) {
-               FillBufferMultiChannel8( buf.data(), data, tensorElements, imageWidth, nrow, tensorStride, strides );
-            } else {
-               FillBufferMultiChannelN( buf.data(), data, tensorElements, imageWidth, nrow, tensorStride, strides, sizeOf );
+            for( dip::uint ii = begin; ii < end; ++ii ) {
+               TiffChunk const& chunk = chunks[ batch + ii ];
+               FillChunk( buf.data(), chunk );
+               encoded[ ii ] = memory->Encode( tiled, chunk.index, buf.data(), EncodedSize( chunk ));
             }
          }
-         if( TIFFWriteEncodedStrip( tiff, strip, buf.data(), nrow * scanline ) < 0 ) {
+      } );
+      for( dip::uint ii = batch; ii < batchEnd; ++ii ) {
+         std::vector< uint8 >& data = encoded[ ii - batch ];
+         tmsize_t result = tiled ? TIFFWriteRawTile( tiff, chunks[ ii ].index, data.data(), static_cast< tmsize_t >( data.size() ))
+                                 : TIFFWriteRawStrip( tiff, chunks[ ii ].index, data.data(), static_cast< tmsize_t >( data.size() ));
+         if( result < 0 ) {
             DIP_THROW_RUNTIME( "Error writing data" );
          }
-         data += static_cast< dip::sint >( nrow * sizeOf ) * image.Stride( 1 );
-         ++strip;
+         std::vector< uint8 >().swap( data );
       }
    }
 }
@@ -276,97 +403,120 @@ void ImageWriteTIFF(
       Image const& image,
       String const& filename,
       String const& compression,
-      dip::uint jpegLevel
+      dip::uint jpegLevel,
+      dip::uint tileSize
 ) {
    DIP_THROW_IF( !image.IsForged(), E::IMAGE_NOT_FORGED );
-   DIP_THROW_IF( image.Dimensionality() != 2, E::DIMENSIONALITY_NOT_SUPPORTED );
-   // TODO: Implement writing of 3D images as a stack of 2D images
+   DIP_THROW_IF( image.Dimensionality() < 2, E::DIMENSIONALITY_NOT_SUPPORTED );
+   DIP_THROW_IF( tileSize % 16 != 0, "The tile size must be a multiple of 16" );
 
    // Get image info and quit if we can't write
    DIP_THROW_IF(( image.Size( 0 ) > std::numeric_limits< uint32 >::max() ) ||
                 ( image.Size( 1 ) > std::numeric_limits< uint32 >::max() ), "Image size too large for TIFF file" );
-   uint32 imageWidth = static_cast< uint32 >( image.Size( 0 ));
-   uint32 imageLength = static_cast< uint32 >( image.Size( 1 ));
+   dip::uint nPages = image.NumberOfPixels() / ( image.Size( 0 ) * image.Size( 1 ));
+   DIP_THROW_IF( nPages > std::numeric_limits< uint16 >::max(), "Image has too many planes for a TIFF file" );
+   TiffWriteParameters params;
+   params.imageWidth = static_cast< uint32 >( image.Size( 0 ));
+   params.imageLength = static_cast< uint32 >( image.Size( 1 ));
+   params.tileSize = static_cast< uint32 >( tileSize );
    dip::uint sizeOf = image.DataType().SizeOf();
-   uint16 bitsPerSample = 0;
-   uint16 sampleFormat = 0;
    if( image.DataType().IsBinary() ) {
       DIP_THROW_IF( !image.IsScalar(), E::IMAGE_NOT_SCALAR ); // Binary images should not have multiple samples per pixel
    } else {
-      bitsPerSample = static_cast< uint16 >( sizeOf * 8 );
+      params.bitsPerSample = static_cast< uint16 >( sizeOf * 8 );
       switch( image.DataType() ) {
          case DT_UINT8:
          case DT_UINT16:
          case DT_UINT32:
-            sampleFormat = SAMPLEFORMAT_UINT;
+            params.sampleFormat = SAMPLEFORMAT_UINT;
             break;
          case DT_SINT8:
          case DT_SINT16:
          case DT_SINT32:
-            sampleFormat = SAMPLEFORMAT_INT;
+            params.sampleFormat = SAMPLEFORMAT_INT;
             break;
          case DT_SFLOAT:
          case DT_DFLOAT:
-            sampleFormat = SAMPLEFORMAT_IEEEFP;
+            params.sampleFormat = SAMPLEFORMAT_IEEEFP;
             break;
          default:
             DIP_THROW( "Data type of image is not compatible with TIFF" );
             break;
       }
+      params.samplesPerPixel = static_cast< uint16 >( image.TensorElements() );
    }
-   uint16 compmode = CompressionTranslate( compression );
-
-   // Create the TIFF file and set the tags
-   TiffFile tiff( filename );
+   params.compression = CompressionTranslate( compression );
+   if((( params.compression == COMPRESSION_DEFLATE ) || ( params.compression == COMPRESSION_LZW )) &&
+      ( params.sampleFormat != SAMPLEFORMAT_IEEEFP ) && ( params.bitsPerSample > 1 )) {
+      // Horizontal differencing improves compression of natural images
+      params.predictor = PREDICTOR_HORIZONTAL;
+   }
+   params.jpegLevel = static_cast< int >( clamp< dip::uint >( jpegLevel, 1, 100 ));
 
    if( image.DataType().IsBinary() ) {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, uint16( PHOTOMETRIC_MINISBLACK ));
+      params.photometric = PHOTOMETRIC_MINISBLACK;
    } else if( image.ColorSpace() == "RGB" ) {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, uint16( PHOTOMETRIC_RGB ));
+      params.photometric = PHOTOMETRIC_RGB;
    } else if( image.ColorSpace() == "Lab" ) {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, uint16( PHOTOMETRIC_CIELAB ));
+      params.photometric = PHOTOMETRIC_CIELAB;
    } else if(( image.ColorSpace() == "CMY" ) || ( image.ColorSpace() == "CMYK" )) {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, uint16( PHOTOMETRIC_SEPARATED ));
+      params.photometric = PHOTOMETRIC_SEPARATED;
    } else {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_PHOTOMETRIC, uint16( PHOTOMETRIC_MINISBLACK ));
+      params.photometric = PHOTOMETRIC_MINISBLACK;
    }
 
-   WRITE_TIFF_TAG( tiff, TIFFTAG_IMAGEWIDTH, imageWidth );
-   WRITE_TIFF_TAG( tiff, TIFFTAG_IMAGELENGTH, imageLength );
-
-   if( !image.DataType().IsBinary() ) {
-      WRITE_TIFF_TAG( tiff, TIFFTAG_BITSPERSAMPLE, bitsPerSample );
-      WRITE_TIFF_TAG( tiff, TIFFTAG_SAMPLEFORMAT, sampleFormat );
-      WRITE_TIFF_TAG( tiff, TIFFTAG_SAMPLESPERPIXEL, static_cast< uint16 >( image.TensorElements()));
-      if( image.TensorElements() > 1 ) {
-         WRITE_TIFF_TAG( tiff, TIFFTAG_PLANARCONFIG, uint16( PLANARCONFIG_CONTIG ));
-         // This is the standard way of writing channels (planes), PLANARCONFIG_SEPARATE is not required to be
-         // supported by all readers.
-      }
-   }
-
-   WRITE_TIFF_TAG( tiff, TIFFTAG_COMPRESSION, compmode );
-   if( compmode == COMPRESSION_JPEG ) {
-      jpegLevel = clamp< dip::uint >( jpegLevel, 1, 100 );
-      WRITE_TIFF_TAG( tiff, TIFFTAG_JPEGQUALITY, static_cast< int >( jpegLevel ));
-      WRITE_TIFF_TAG( tiff, TIFFTAG_JPEGCOLORMODE, int( JPEGCOLORMODE_RGB ));
-   }
-
-   DIP_STACK_TRACE_THIS( WriteTIFFStrips( image, tiff ));
-
-   TIFFSetField( tiff, TIFFTAG_SOFTWARE, "DIPlib " DIP_VERSION_STRING );
-
+   // Resolution tags
+   float xResolution = 0;
+   float yResolution = 0;
    auto ps = image.PixelSize( 0 );
    if( ps.units.HasSameDimensions( Units::Meter() )) {
       ps.RemovePrefix();
-      TIFFSetField( tiff, TIFFTAG_XRESOLUTION, static_cast< float >( 0.01 / ps.magnitude ));
+      xResolution = static_cast< float >( 0.01 / ps.magnitude );
    }
    ps = image.PixelSize( 1 );
    if( ps.units.HasSameDimensions( Units::Meter() )) {
       ps.RemovePrefix();
-      TIFFSetField( tiff, TIFFTAG_YRESOLUTION, static_cast< float >( 0.01 / ps.magnitude ));
+      yResolution = static_cast< float >( 0.01 / ps.magnitude );
+   }
+
+   // Create the TIFF file
+   TiffFile tiff( filename );
+
+   // Write each 2D plane as a page. Dimensions beyond the 3rd are flattened.
+   for( dip::uint page = 0; page < nPages; ++page ) {
+      // The plane is a view with singleton dimensions beyond the 2nd, these are ignored when writing
+      RangeArray ranges( image.Dimensionality() );
+      dip::uint index = page;
+      for( dip::uint ii = 2; ii < image.Dimensionality(); ++ii ) {
+         ranges[ ii ] = Range( static_cast< dip::sint >( index % image.Size( ii )));
+         index /= image.Size( ii );
+      }
+      Image plane = image.At( ranges );
+
+      DIP_STACK_TRACE_THIS( WriteTIFFLayoutTags( tiff, params ));
+      if( params.tileSize == 0 ) {
+         params.rowsPerStrip = TIFFDefaultStripSize( tiff, 0 );
+         WRITE_TIFF_TAG( tiff, TIFFTAG_ROWSPERSTRIP, params.rowsPerStrip );
+      }
+      if( nPages > 1 ) {
+         WRITE_TIFF_TAG( tiff, TIFFTAG_SUBFILETYPE, uint32( FILETYPE_PAGE ));
+         TIFFSetField( tiff, TIFFTAG_PAGENUMBER, uint16( page ), uint16( nPages ));
+      }
+      TIFFSetField( tiff, TIFFTAG_SOFTWARE, "DIPlib " DIP_VERSION_STRING );
+      if( xResolution > 0 ) {
+         TIFFSetField( tiff, TIFFTAG_XRESOLUTION, xResolution );
+      }
+      if( yResolution > 0 ) {
+         TIFFSetField( tiff, TIFFTAG_YRESOLUTION, yResolution );
+      }
+      TIFFSetField( tiff, TIFFTAG_RESOLUTIONUNIT, uint16( RESUNIT_CENTIMETER ));
+
+      DIP_STACK_TRACE_THIS( WriteTIFFData( plane, tiff, params ));
+
+      if( !TIFFWriteDirectory( tiff )) {
+         DIP_THROW_RUNTIME( "Error writing data" );
+      }
    }
-   TIFFSetField( tiff, TIFFTAG_RESOLUTIONUNIT, uint16( RESUNIT_CENTIMETER ));
 }
 
 } // namespace dip
@@ -374,6 +524,9 @@ void ImageWriteTIFF(
 #ifdef DIP__ENABLE_DOCTEST
 #include "doctest.h"
 #include "diplib/testing.h"
+#include "diplib/generation.h"
+#include <fstream>
+#include <iterator>
 
 DOCTEST_TEST_CASE( "[DIPlib] testing TIFF file reading and writing" ) {
    dip::Image image = dip::ImageReadTIFF( DIP__EXAMPLES_DIR "/fractal1.tiff" );
@@ -393,11 +546,71 @@ DOCTEST_TEST_CASE( "[DIPlib] testing TIFF file reading and writing" ) {
    dip::ImageReadTIFF( result, "test1" );
    DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
 
+   // Read a region of interest, with subsampling and mirroring
+   dip::RangeArray roi{ dip::Range{ 10, 50, 3 }, dip::Range{ 60, 20, 2 }};
+   result = dip::ImageReadTIFF( "test1", dip::Range{ 0 }, roi );
+   DOCTEST_CHECK( dip::testing::CompareImages( image.At( roi ), result ));
+
    // Turn it on its side so the image to write has non-standard strides
    image.SwapDimensions( 0, 1 );
    dip::ImageWriteTIFF( image, "test2.tif" );
    result = dip::ImageReadTIFF( "test2" );
    DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
+
+   // Tiled file, with tiles at the image edge only partially filled
+   dip::ImageWriteTIFF( image, "test3.tif", "deflate", 80, 32 );
+   result = dip::ImageReadTIFF( "test3" );
+   DOCTEST_CHECK( dip::testing::CompareImages( image, result ));
+   dip::RangeArray roi2{ dip::Range{ 30, 100 }, dip::Range{ 5, 40 }};
+   result = dip::ImageReadTIFF( "test3", dip::Range{ 0 }, roi2 );
+   DOCTEST_CHECK( dip::testing::CompareImages( image.At( roi2 ), result ));
+
+   // 3D image as a multi-page file
+   dip::Image stack( { 50, 40, 5 }, 3, dip::DT_UINT16 );
+   stack.Fill( 0 );
+   dip::DrawBandlimitedBall( stack, 30, { 25, 20, 2 }, { 1000, 2000, 3000 } );
+   stack.SetColorSpace( "RGB" );
+   dip::ImageWriteTIFF( stack, "test4.tif", "LZW", 80, 16 );
+   result = dip::ImageReadTIFF( "test4", dip::Range{ 0, -1 } );
+   DOCTEST_CHECK( dip::testing::CompareImages( stack, result ));
+}
+
+DOCTEST_TEST_CASE( "[DIPlib] testing parallel TIFF writing" ) {
+   // A 2D grey-value image and a 3D multi-channel image, with enough detail that compression is not trivial
+   dip::Random random( 0 );
+   dip::Image grey( { 300, 200 }, 1, dip::DT_UINT8 );
+   grey.Fill( 0 );
+   dip::DrawBandlimitedBall( grey, 150, { 150, 100 }, { 200 } );
+   dip::UniformNoise( grey, grey, random, 0.0, 40.0 );
+   dip::Image stack( { 300, 200, 3 }, 3, dip::DT_UINT8 );
+   stack.Fill( 0 );
+   dip::DrawBandlimitedBall( stack, 150, { 150, 100, 1 }, { 100, 150, 200 } );
+   dip::UniformNoise( stack, stack, random, 0.0, 40.0 );
+   stack.SetColorSpace( "RGB" );
+
+   auto fileContents = []( char const* filename ) {
+      std::ifstream file( filename, std::ios::binary );
+      return std::vector< char >( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+   };
+   char const* filenames[ 2 ] = { "test5s.tif", "test5m.tif" };
+   for( dip::Image const* image : { &grey, &stack } ) {
+      for( auto compression : { "deflate", "LZW", "PackBits" } ) {
+         for( dip::uint tileSize : { dip::uint( 0 ), dip::uint( 64 ) } ) {
+            bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+               dip::ImageWriteTIFF( *image, filenames[ ii ], compression, 80, tileSize );
+            } );
+            dip::Image result = dip::ImageReadTIFF( filenames[ 0 ], dip::Range{ 0, -1 } );
+            DOCTEST_CHECK( dip::testing::CompareImages( *image, result ));
+            if( multiThreaded ) {
+               result = dip::ImageReadTIFF( filenames[ 1 ], dip::Range{ 0, -1 } );
+               DOCTEST_CHECK( dip::testing::CompareImages( *image, result ));
+               // The chunks compressed in parallel must be encoded exactly as the ones compressed by the file's
+               // handle, using the same predictor and fill order, and with the same byte counts
+               DOCTEST_CHECK( fileContents( filenames[ 0 ] ) == fileContents( filenames[ 1 ] ));
+            }
+         }
+      }
+   }
 }
 
 #endif // DIP__ENABLE_DOCTEST
@@ -411,7 +624,7 @@ namespace dip {
 
 static const char* NOT_AVAILABLE = "DIPlib was compiled without TIFF support.";
 
-void ImageWriteTIFF( Image const&, String const&, String const&, dip::uint ) {
+void ImageWriteTIFF( Image const&, String const&, String const&, dip::uint, dip::uint ) {
    DIP_THROW( NOT_AVAILABLE );
 }
 
@@ -18,6 +18,9 @@
  * limitations under the License.
  */
 
+#include <array>
+#include <cstdint>
+
 #include "diplib.h"
 #include "diplib/random.h"
 #include "diplib/generation.h"
@@ -27,201 +30,286 @@
 
 namespace dip {
 
-// TODO: Is there false sharing in these line filters?
-
 namespace {
-class UniformScanLineFilter : public Framework::ScanLineFilter {
+
+// Philox4x32-10, a counter-based pseudo-random number generator (J.K. Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", SC'11, 2011). It maps a 128-bit counter to 128 random bits, given a 64-bit key. There is
+// no state to advance: the random values for a pixel are computed directly from its index.
+class Philox {
    public:
+      using Block = std::array< uint32, 4 >;
+
+      explicit Philox( std::uint64_t key ) : key0_( static_cast< uint32 >( key )), key1_( static_cast< uint32 >( key >> 32 )) {}
+
+      // Returns the random bits for counter { index, sample, 0 }.
+      Block operator()( std::uint64_t index, uint32 sample = 0 ) const {
+         uint32 c0 = static_cast< uint32 >( index );
+         uint32 c1 = static_cast< uint32 >( index >> 32 );
+         uint32 c2 = sample;
+         uint32 c3 = 0;
+         uint32 k0 = key0_;
+         uint32 k1 = key1_;
+         for( dip::uint round = 0; round < 10; ++round ) {
+            std::uint64_t p0 = static_cast< std::uint64_t >( 0xD2511F53u ) * c0;
+            std::uint64_t p1 = static_cast< std::uint64_t >( 0xCD9E8D57u ) * c2;
+            c0 = static_cast< uint32 >( p1 >> 32 ) ^ c1 ^ k0;
+            c1 = static_cast< uint32 >( p1 );
+            c2 = static_cast< uint32 >( p0 >> 32 ) ^ c3 ^ k1;
+            c3 = static_cast< uint32 >( p0 );
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+         }
+         return {{ c0, c1, c2, c3 }};
+      }
+
+   private:
+      uint32 key0_;
+      uint32 key1_;
+};
+
+// Converts 64 random bits to a value in [0,1), with 53 bits of precision.
+inline dfloat UniformFromBits( uint32 a, uint32 b ) {
+   return ( static_cast< dfloat >( a >> 5 ) * 67108864.0 + static_cast< dfloat >( b >> 6 )) * ( 1.0 / 9007199254740992.0 );
+}
+
+// The sequence of random values for a single pixel, for distributions that need an unknown number of them.
+// Satisfies the requirements of a uniform random bit generator.
+class PixelRandomStream {
+   public:
+      using result_type = uint32;
+      static constexpr result_type min() { return 0; }
+      static constexpr result_type max() { return std::numeric_limits< uint32 >::max(); }
+      // `first` is `philox( index )`, the first block of random bits for this pixel
+      PixelRandomStream( Philox const& philox, dip::uint index, Philox::Block const& first ) :
+            philox_( philox ), index_( index ), block_( first ) {}
+      result_type operator()() {
+         if( pos_ == 4 ) {
+            block_ = philox_( index_, sample_++ );
+            pos_ = 0;
+         }
+         return block_[ pos_++ ];
+      }
+   private:
+      Philox const& philox_;
+      dip::uint index_;
+      uint32 sample_ = 1;
+      Philox::Block block_;
+      dip::uint pos_ = 0;
+};
+
+// Base class for the noise line filters. The random values for each pixel are obtained from its linear index
+// in the image, so that the output doesn't depend on how the image is split up among threads. Values are
+// generated for blocks of pixels at a time, in a loop the compiler can vectorize.
+class NoiseScanLineFilter : public Framework::ScanLineFilter {
+   public:
+      NoiseScanLineFilter( Random& random, Image const& in ) : philox_( DrawKey( random )) {
+         // With `Scan_TensorAsSpatialDim`, the tensor dimension becomes the last spatial dimension
+         UnsignedArray sizes = in.Sizes();
+         if( !in.IsScalar() ) {
+            sizes.push_back( in.TensorElements() );
+         }
+         indexStrides_.resize( sizes.size() );
+         dip::uint stride = 1;
+         for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+            indexStrides_[ ii ] = stride;
+            stride *= sizes[ ii ];
+         }
+      }
+
+   protected:
+      static constexpr dip::uint blockSize = 64;
+      struct Block {
+         uint32 w0[ blockSize ];
+         uint32 w1[ blockSize ];
+         uint32 w2[ blockSize ];
+         uint32 w3[ blockSize ];
+      };
+
+      // Calls `function( block, n )` for consecutive blocks of `n` pixels in the buffer, `block` contains the
+      // random bits for these pixels.
+      template< typename F >
+      void ForEachBlock( Framework::ScanLineFilterParameters const& params, F const& function ) const {
+         DIP_ASSERT( params.position.size() == indexStrides_.size() );
+         dip::uint index = 0;
+         for( dip::uint ii = 0; ii < indexStrides_.size(); ++ii ) {
+            index += params.position[ ii ] * indexStrides_[ ii ];
+         }
+         dip::uint step = indexStrides_.empty() ? 1 : indexStrides_[ params.dimension ];
+         Block block;
+         for( dip::uint kk = 0; kk < params.bufferLength; kk += blockSize ) {
+            dip::uint n = std::min( blockSize, params.bufferLength - kk );
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               Philox::Block r = philox_( index + ii * step );
+               block.w0[ ii ] = r[ 0 ];
+               block.w1[ ii ] = r[ 1 ];
+               block.w2[ ii ] = r[ 2 ];
+               block.w3[ ii ] = r[ 3 ];
+            }
+            function( block, n, index, step );
+            index += n * step;
+         }
+      }
+
+      Philox philox_;
+
+   private:
+      static std::uint64_t DrawKey( Random& random ) {
+         std::uint64_t key = random();
+         if( sizeof( Random::result_type ) < sizeof( std::uint64_t )) {
+            key = ( key << 32 ) | random();
+         }
+         return key;
+      }
+
+      UnsignedArray indexStrides_;
+};
+
+class UniformScanLineFilter : public NoiseScanLineFilter {
+   public:
+      UniformScanLineFilter( Random& random, Image const& in, dfloat lowerBound, dfloat upperBound ) :
+            NoiseScanLineFilter( random, in ), lowerBound_( lowerBound ), range_( upperBound - lowerBound ) {}
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 40; }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          dfloat const* in = static_cast< dfloat const* >( params.inBuffer[ 0 ].buffer );
          dip::sint inStride = params.inBuffer[ 0 ].stride;
-         dip::uint const bufferLength = params.bufferLength;
          dfloat* out = static_cast< dfloat* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
-         UniformRandomGenerator& generator = *generatorArray_[ params.thread ];
-         for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
-            *out = *in + generator( lowerBound_, upperBound_ );
-            in += inStride;
-            out += outStride;
-         }
-      }
-      virtual void SetNumberOfThreads( dip::uint threads ) override  {
-         generatorArray_.resize( threads );
-         generatorArray_[ 0 ] = std::make_unique< UniformRandomGenerator >( random_ );
-         if( threads > 1 ) {
-            randomArray_.resize( threads - 1, Random( 0 ));
-            for( dip::uint ii = 1; ii < threads; ++ii ) {
-               randomArray_[ ii - 1 ] = random_.Split();
-               generatorArray_[ ii ] = std::make_unique< UniformRandomGenerator >( randomArray_[ ii - 1 ] );
+         ForEachBlock( params, [ & ]( Block const& block, dip::uint n, dip::uint, dip::uint ) {
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               *out = *in + lowerBound_ + range_ * UniformFromBits( block.w0[ ii ], block.w1[ ii ] );
+               in += inStride;
+               out += outStride;
             }
-         }
+         } );
       }
-      UniformScanLineFilter( Random& random, dfloat lowerBound, dfloat upperBound ) :
-            random_( random ), lowerBound_( lowerBound ), upperBound_( upperBound ) {}
-      // Make the class non copyable (generatorArray_ cannot be copied)
-      UniformScanLineFilter(const UniformScanLineFilter&) = delete;
-      UniformScanLineFilter& operator =(const UniformScanLineFilter&) = delete;
    private:
-      Random& random_;
-      std::vector< Random > randomArray_;
-      std::vector< std::unique_ptr< UniformRandomGenerator >> generatorArray_;
       dfloat lowerBound_;
-      dfloat upperBound_;
+      dfloat range_;
 };
+
 } // namespace
 
 void UniformNoise( Image const& in, Image& out, Random& random, dfloat lowerBound, dfloat upperBound ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !in.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
-   UniformScanLineFilter filter( random, lowerBound, upperBound );
+   UniformScanLineFilter filter( random, in, lowerBound, upperBound );
    DataType dt = in.DataType();
-   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim );
+   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim + Framework::Scan_NeedCoordinates );
 }
 
 namespace {
-class GaussianScanLineFilter : public Framework::ScanLineFilter {
+
+// Uses the Box-Muller transform, which needs exactly 128 random bits for each pixel.
+class GaussianScanLineFilter : public NoiseScanLineFilter {
    public:
+      GaussianScanLineFilter( Random& random, Image const& in, dfloat std ) : NoiseScanLineFilter( random, in ), std_( std ) {}
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 150; }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          dfloat const* in = static_cast< dfloat const* >( params.inBuffer[ 0 ].buffer );
          dip::sint inStride = params.inBuffer[ 0 ].stride;
-         dip::uint const bufferLength = params.bufferLength;
          dfloat* out = static_cast< dfloat* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
-         GaussianRandomGenerator& generator = *( generatorArray_[ params.thread ] );
-         for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
-            *out = generator( *in, std_ );
-            in += inStride;
-            out += outStride;
-         }
-      }
-      virtual void SetNumberOfThreads( dip::uint threads ) override {
-         generatorArray_.resize( threads );
-         generatorArray_[ 0 ] = std::make_unique< GaussianRandomGenerator >( random_ );
-         if( threads > 1 ) {
-            randomArray_.resize( threads - 1, Random( 0 ));
-            for( dip::uint ii = 1; ii < threads; ++ii ) {
-               randomArray_[ ii - 1 ] = random_.Split();
-               generatorArray_[ ii ] = std::make_unique< GaussianRandomGenerator >( randomArray_[ ii - 1 ] );
+         ForEachBlock( params, [ & ]( Block const& block, dip::uint n, dip::uint, dip::uint ) {
+            dfloat noise[ blockSize ];
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               dfloat u1 = 1.0 - UniformFromBits( block.w0[ ii ], block.w1[ ii ] ); // in (0,1]
+               dfloat u2 = UniformFromBits( block.w2[ ii ], block.w3[ ii ] );
+               noise[ ii ] = std::sqrt( -2.0 * std::log( u1 )) * std::cos( 2.0 * pi * u2 );
             }
-         }
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               *out = *in + std_ * noise[ ii ];
+               in += inStride;
+               out += outStride;
+            }
+         } );
       }
-      GaussianScanLineFilter( Random& random, dfloat std ) : random_( random ), std_( std ) {}
-      // Make the class non copyable (generatorArray_ cannot be copied)
-      GaussianScanLineFilter(const GaussianScanLineFilter&) = delete;
-      GaussianScanLineFilter& operator =(const GaussianScanLineFilter&) = delete;
    private:
-      Random& random_;
-      std::vector< Random > randomArray_;
-      std::vector< std::unique_ptr< GaussianRandomGenerator >> generatorArray_;
       dfloat std_;
 };
-}
+
+} // namespace
 
 void GaussianNoise( Image const& in, Image& out, Random& random, dfloat variance ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !in.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
-   GaussianScanLineFilter filter( random, std::sqrt( variance ));
+   GaussianScanLineFilter filter( random, in, std::sqrt( variance ));
    DataType dt = in.DataType();
-   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim );
+   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim + Framework::Scan_NeedCoordinates );
 }
 
 namespace {
-class PoissonScanLineFilter : public Framework::ScanLineFilter {
+
+// The Poisson distribution needs a variable number of random values, each pixel gets its own stream.
+class PoissonScanLineFilter : public NoiseScanLineFilter {
    public:
+      PoissonScanLineFilter( Random& random, Image const& in, dfloat conversion ) : NoiseScanLineFilter( random, in ), conversion_( conversion ) {}
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 800; }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          dfloat const* in = static_cast< dfloat const* >( params.inBuffer[ 0 ].buffer );
          dip::sint inStride = params.inBuffer[ 0 ].stride;
-         dip::uint const bufferLength = params.bufferLength;
          dfloat* out = static_cast< dfloat* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
-         PoissonRandomGenerator& generator = *generatorArray_[ params.thread ];
-         for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
-            *out = static_cast< dfloat >( generator( *in * conversion_ )) / conversion_;
-            in += inStride;
-            out += outStride;
-         }
-      }
-      virtual void SetNumberOfThreads( dip::uint threads ) override {
-         generatorArray_.resize( threads );
-         generatorArray_[ 0 ] = std::make_unique< PoissonRandomGenerator >( random_ );
-         if( threads > 1 ) {
-            randomArray_.resize( threads - 1, Random( 0 ));
-            for( dip::uint ii = 1; ii < threads; ++ii ) {
-               randomArray_[ ii - 1 ] = random_.Split();
-               generatorArray_[ ii ] = std::make_unique< PoissonRandomGenerator >( randomArray_[ ii - 1 ] );
+         ForEachBlock( params, [ & ]( Block const& block, dip::uint n, dip::uint index, dip::uint step ) {
+            for( dip::uint ii = 0; ii < n; ++ii, index += step ) {
+               dfloat mean = *in * conversion_;
+               dip::uint value = 0;
+               if( mean > 0 ) {
+                  PixelRandomStream stream( philox_, index, {{ block.w0[ ii ], block.w1[ ii ], block.w2[ ii ], block.w3[ ii ] }} );
+                  std::poisson_distribution< dip::uint > distribution( mean );
+                  value = distribution( stream );
+               }
+               *out = static_cast< dfloat >( value ) / conversion_;
+               in += inStride;
+               out += outStride;
             }
-         }
+         } );
       }
-      PoissonScanLineFilter( Random& random, dfloat conversion ) : random_( random ), conversion_( conversion ) {}
-      // Make the class non copyable (generatorArray_ cannot be copied)
-      PoissonScanLineFilter(const PoissonScanLineFilter&) = delete;
-      PoissonScanLineFilter& operator =(const PoissonScanLineFilter&) = delete;
    private:
-      Random& random_;
-      std::vector< Random > randomArray_;
-      std::vector< std::unique_ptr< PoissonRandomGenerator >> generatorArray_;
       dfloat conversion_;
 };
-}
+
+} // namespace
 
 void PoissonNoise( Image const& in, Image& out, Random& random, dfloat conversion ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !in.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
-   PoissonScanLineFilter filter( random, conversion );
+   PoissonScanLineFilter filter( random, in, conversion );
    DataType dt = in.DataType();
-   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim );
+   Framework::ScanMonadic( in, out, DT_DFLOAT, dt, 1, filter, Framework::Scan_TensorAsSpatialDim + Framework::Scan_NeedCoordinates );
 }
 
 namespace {
-class BinaryScanLineFilter : public Framework::ScanLineFilter {
+
+class BinaryScanLineFilter : public NoiseScanLineFilter {
    public:
+      BinaryScanLineFilter( Random& random, Image const& in, dfloat p10, dfloat p01 ) :
+            NoiseScanLineFilter( random, in ), pForeground( 1.0 - p10 ), pBackground( p01 ) {}
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 40; }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          bin const* in = static_cast< bin const* >( params.inBuffer[ 0 ].buffer );
          dip::sint inStride = params.inBuffer[ 0 ].stride;
-         dip::uint const bufferLength = params.bufferLength;
          bin* out = static_cast< bin* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
-         BinaryRandomGenerator& generator = *generatorArray_[ params.thread ];
-         for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
-            *out = generator( *in ? pForeground : pBackground );
-            in += inStride;
-            out += outStride;
-         }
-      }
-      virtual void SetNumberOfThreads( dip::uint threads ) override {
-         generatorArray_.resize( threads );
-         generatorArray_[ 0 ] = std::make_unique< BinaryRandomGenerator >( random_ );
-         if( threads > 1 ) {
-            randomArray_.resize( threads - 1, Random( 0 ));
-            for( dip::uint ii = 1; ii < threads; ++ii ) {
-               randomArray_[ ii - 1 ] = random_.Split();
-               generatorArray_[ ii ] = std::make_unique< BinaryRandomGenerator >( randomArray_[ ii - 1 ] );
+         ForEachBlock( params, [ & ]( Block const& block, dip::uint n, dip::uint, dip::uint ) {
+            for( dip::uint ii = 0; ii < n; ++ii ) {
+               *out = UniformFromBits( block.w0[ ii ], block.w1[ ii ] ) < ( *in ? pForeground : pBackground );
+               in += inStride;
+               out += outStride;
             }
-         }
+         } );
       }
-      BinaryScanLineFilter( Random& random, dfloat p10, dfloat p01 ) :
-            random_( random ), pForeground( 1.0 - p10 ), pBackground( p01 ) {}
-      // Make the class non copyable (generatorArray_ cannot be copied)
-      BinaryScanLineFilter(const BinaryScanLineFilter&) = delete;
-      BinaryScanLineFilter& operator =(const BinaryScanLineFilter&) = delete;
    private:
-      Random& random_;
-      std::vector< Random > randomArray_;
-      std::vector< std::unique_ptr< BinaryRandomGenerator >> generatorArray_;
       dfloat pForeground;
       dfloat pBackground;
 };
-}
+
+} // namespace
 
 void BinaryNoise( Image const& in, Image& out, Random& random, dfloat p10, dfloat p01 ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !in.DataType().IsBinary(), E::IMAGE_NOT_BINARY );
-   BinaryScanLineFilter filter( random, p10, p01 );
-   Framework::ScanMonadic( in, out, DT_BIN, DT_BIN, 1, filter, Framework::Scan_TensorAsSpatialDim );
+   BinaryScanLineFilter filter( random, in, p10, p01 );
+   Framework::ScanMonadic( in, out, DT_BIN, DT_BIN, 1, filter, Framework::Scan_TensorAsSpatialDim + Framework::Scan_NeedCoordinates );
 }
 
 void FillColoredNoise( Image& out, Random& random, dfloat variance, dfloat color ) {
@@ -253,8 +341,65 @@ void FillColoredNoise( Image& out, Random& random, dfloat variance, dfloat color
    // Modulate and inverse transform
    fd *= modulation;
    bool prot = out.Protect();
-   FourierTransform( fd, out, { "inverse", "real" } ); // We set "real" so only the real component is written to `out`.
+   // `fd` is not conjugate symmetric, so we cannot use the "real" option; only the real component is written to `out`.
+   out.Copy( FourierTransform( fd, { "inverse" } ).Real() );
    out.Protect( prot );
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "diplib/accumulators.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the counter-based noise generators") {
+   // Known-answer tests from the Random123 distribution
+   dip::Philox::Block r = dip::Philox( 0 )( 0 );
+   DOCTEST_CHECK( r[ 0 ] == 0x6627e8d5u );
+   DOCTEST_CHECK( r[ 1 ] == 0xe169c58du );
+   DOCTEST_CHECK( r[ 2 ] == 0xbc57ac4cu );
+   DOCTEST_CHECK( r[ 3 ] == 0x9b00dbd8u );
+
+   // The noise must not depend on the number of threads
+   dip::Image img{ dip::UnsignedArray{ 300, 200 }, 3, dip::DT_SFLOAT };
+   img.Fill( 10.0 );
+   dip::Image bimg{ dip::UnsignedArray{ 300, 200 }, 1, dip::DT_BIN };
+   bimg.Fill( 0 );
+   std::vector< dip::Image > results[ 2 ];
+   bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+      dip::Random random( 42 );
+      results[ ii ].push_back( dip::UniformNoise( img, random, -1.0, 1.0 ));
+      results[ ii ].push_back( dip::GaussianNoise( img, random, 4.0 ));
+      results[ ii ].push_back( dip::PoissonNoise( img, random, 1.0 ));
+      results[ ii ].push_back( dip::BinaryNoise( bimg, random, 0.0, 0.3 ));
+   } );
+   if( multiThreaded ) {
+      for( dip::uint ii = 0; ii < results[ 0 ].size(); ++ii ) {
+         dip::Image different = results[ 0 ][ ii ] != results[ 1 ][ ii ];
+         different.TensorToSpatial();
+         DOCTEST_CHECK( dip::Count( different ) == 0 );
+      }
+   }
+
+   // And it must have the right statistics
+   auto statistics = []( dip::Image const& noise ) {
+      dip::Image tmp = noise.QuickCopy();
+      tmp.TensorToSpatial();
+      return dip::SampleStatistics( tmp );
+   };
+   dip::StatisticsAccumulator stats = statistics( results[ 0 ][ 0 ] );
+   DOCTEST_CHECK( std::abs( stats.Mean() - 10.0 ) < 0.01 );
+   DOCTEST_CHECK( std::abs( stats.Variance() - 1.0 / 3.0 ) < 0.01 );
+   stats = statistics( results[ 0 ][ 1 ] );
+   DOCTEST_CHECK( std::abs( stats.Mean() - 10.0 ) < 0.03 );
+   DOCTEST_CHECK( std::abs( stats.Variance() - 4.0 ) < 0.1 );
+   DOCTEST_CHECK( std::abs( stats.Skewness() ) < 0.03 );
+   stats = statistics( results[ 0 ][ 2 ] );
+   DOCTEST_CHECK( std::abs( stats.Mean() - 10.0 ) < 0.03 );
+   DOCTEST_CHECK( std::abs( stats.Variance() - 10.0 ) < 0.3 );
+   dip::dfloat fraction = static_cast< dip::dfloat >( dip::Count( results[ 0 ][ 3 ] )) / static_cast< dip::dfloat >( bimg.NumberOfPixels() );
+   DOCTEST_CHECK( std::abs( fraction - 0.3 ) < 0.01 );
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -122,8 +122,15 @@ class dip__HistogramBase : public Framework::ScanLineFilter {
          // data segment. This ensures there's no false sharing.
       }
       void Reduce() {
+         // A thread that was not handed any image lines never forged its image
+         if( !image_.IsForged() ) {
+            image_.Forge();
+            image_.Fill( 0 );
+         }
          for( auto const& img : imageArray_ ) {
-            image_ += img;
+            if( img.IsForged() ) {
+               image_ += img;
+            }
          }
       }
    protected:
@@ -311,7 +318,7 @@ void Histogram::ScalarImageHistogram( Image const& input, Image const& mask, His
    if( GetNumberOfThreads() > 1 ) {
       dip::uint parallelOperations = input.NumberOfPixels() * 6;
       dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
+      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + GetThreadingCostModel().Overhead( GetNumberOfThreads() ) > parallelOperations ) {
          opts = Framework::Scan_NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
       }
    }
@@ -338,7 +345,7 @@ void Histogram::TensorImageHistogram( Image const& input, Image const& mask, His
    if( GetNumberOfThreads() > 1 ) {
       dip::uint parallelOperations = input.NumberOfPixels() * ndims * 6;
       dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
+      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + GetThreadingCostModel().Overhead( GetNumberOfThreads() ) > parallelOperations ) {
          opts = Framework::Scan_NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
       }
    }
@@ -377,7 +384,7 @@ void Histogram::JointImageHistogram( Image const& input1, Image const& input2, I
    if( GetNumberOfThreads() > 1 ) {
       dip::uint parallelOperations = input1.NumberOfPixels() * 2 * 6;
       dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
+      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + GetThreadingCostModel().Overhead( GetNumberOfThreads() ) > parallelOperations ) {
          opts = Framework::Scan_NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
       }
    }
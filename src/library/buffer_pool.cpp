@@ -0,0 +1,406 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definition of the buffer pool that recycles image data segments.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#endif
+#ifdef __linux__
+#include <sys/mman.h> // madvise
+#endif
+
+#include "diplib.h"
+
+namespace dip {
+
+namespace {
+
+// Size classes: class 0 holds blocks of 256 bytes, and each power of two above that is divided into four classes.
+constexpr dip::uint minimumBlockSizeLog2 = 8;
+constexpr dip::uint minimumBlockSize = dip::uint( 1 ) << minimumBlockSizeLog2;
+constexpr dip::uint maximumBlockSizeLog2 = 62;
+constexpr dip::uint nClasses = ( maximumBlockSizeLog2 - minimumBlockSizeLog2 ) * 4 + 1;
+
+// Blocks up to 1 MiB are kept in the thread caches, larger blocks always go to the shared pool.
+constexpr dip::uint maximumLocalBlockSizeLog2 = 20;
+constexpr dip::uint nLocalClasses = ( maximumLocalBlockSizeLog2 - minimumBlockSizeLog2 ) * 4 + 1;
+constexpr dip::uint blocksPerLocalClass = 4;
+
+constexpr dip::uint defaultAlignment = 64;
+constexpr dip::uint hugePageSize = 2 * 1024 * 1024;
+constexpr dip::uint defaultMemoryLimit = 256 * 1024 * 1024;
+
+dip::uint FloorLog2( dip::uint value ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+   return 63 - static_cast< dip::uint >( __builtin_clzll( value ));
+#else
+   dip::uint result = 0;
+   while( value >>= 1 ) {
+      ++result;
+   }
+   return result;
+#endif
+}
+
+dip::uint ClassIndex( dip::uint bytes ) {
+   if( bytes <= minimumBlockSize ) {
+      return 0;
+   }
+   dip::uint value = bytes - 1;
+   dip::uint exponent = FloorLog2( value );
+   dip::uint sub = ( value >> ( exponent - 2 )) & 3u;
+   return ( exponent - minimumBlockSizeLog2 ) * 4 + sub + 1;
+}
+
+dip::uint ClassSize( dip::uint index ) {
+   if( index == 0 ) {
+      return minimumBlockSize;
+   }
+   dip::uint exponent = ( index - 1 ) / 4 + minimumBlockSizeLog2;
+   dip::uint sub = ( index - 1 ) % 4;
+   return ( dip::uint( 1 ) << exponent ) + (( sub + 1 ) << ( exponent - 2 ));
+}
+
+void SystemFree( void* ptr ) {
+#ifdef _WIN32
+   _aligned_free( ptr );
+#else
+   std::free( ptr );
+#endif
+}
+
+void* SystemAllocate( dip::uint size, bool hugePages ) {
+   dip::uint alignment = ( hugePages && ( size >= hugePageSize )) ? hugePageSize : defaultAlignment;
+#ifdef _WIN32
+   return _aligned_malloc( size, alignment );
+#else
+   void* ptr = nullptr;
+   if( posix_memalign( &ptr, alignment, size ) != 0 ) {
+      return nullptr;
+   }
+#ifdef MADV_HUGEPAGE
+   if( alignment == hugePageSize ) {
+      madvise( ptr, size, MADV_HUGEPAGE ); // A hint only, failure is not a problem
+   }
+#endif
+   return ptr;
+#endif
+}
+
+// The pool shared by all threads. It is never destroyed, so that images that outlive the static objects
+// (and the thread caches of threads that exit late) can still return their blocks to it.
+class SharedPool {
+   public:
+      SharedPool() : freeLists_( nClasses ) {}
+
+      void* Take( dip::uint index ) {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         auto& list = freeLists_[ index ];
+         if( list.empty() ) {
+            return nullptr;
+         }
+         void* ptr = list.back();
+         list.pop_back();
+         return ptr;
+      }
+
+      void Put( void* ptr, dip::uint index ) {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         freeLists_[ index ].push_back( ptr );
+      }
+
+      // Frees blocks, largest first, until the cached size is within `limit`.
+      void Trim( dip::uint limit ) {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         for( dip::uint index = nClasses; index > 0; ) {
+            --index;
+            auto& list = freeLists_[ index ];
+            while( !list.empty() && ( bytesCached > limit )) {
+               SystemFree( list.back() );
+               list.pop_back();
+               bytesCached -= ClassSize( index );
+            }
+         }
+      }
+
+      // Adds `size` to `bytesCached` if that doesn't exceed the limit.
+      bool ReserveCached( dip::uint size ) {
+         dip::uint cached = bytesCached.load();
+         do {
+            if( cached + size > memoryLimit.load() ) {
+               return false;
+            }
+         } while( !bytesCached.compare_exchange_weak( cached, cached + size ));
+         return true;
+      }
+
+      void AddInUse( dip::uint size ) {
+         dip::uint inUse = bytesInUse.fetch_add( size ) + size;
+         dip::uint peak = peakBytesInUse.load();
+         while(( inUse > peak ) && !peakBytesInUse.compare_exchange_weak( peak, inUse )) {}
+      }
+
+      std::atomic< dip::uint > memoryLimit{ defaultMemoryLimit };
+      std::atomic< bool > hugePages{ false };
+      std::atomic< bool > isDefaultAllocator{ false };
+
+      std::atomic< dip::uint > hits{ 0 };
+      std::atomic< dip::uint > misses{ 0 };
+      std::atomic< dip::uint > bytesInUse{ 0 };
+      std::atomic< dip::uint > peakBytesInUse{ 0 };
+      std::atomic< dip::uint > bytesCached{ 0 }; // includes the blocks in the thread caches
+
+   private:
+      std::mutex mutex_;
+      std::vector< std::vector< void* >> freeLists_;
+};
+
+SharedPool& GetSharedPool() {
+   static SharedPool* pool = new SharedPool;
+   return *pool;
+}
+
+// Each thread keeps a few blocks of each small size class, used without locking.
+class ThreadCache {
+   public:
+      ThreadCache();
+      ~ThreadCache();
+
+      void* Take( dip::uint index ) {
+         if( count_[ index ] == 0 ) {
+            return nullptr;
+         }
+         return blocks_[ index ][ --count_[ index ]];
+      }
+
+      bool Put( void* ptr, dip::uint index ) {
+         if( count_[ index ] == blocksPerLocalClass ) {
+            return false;
+         }
+         blocks_[ index ][ count_[ index ]++ ] = ptr;
+         return true;
+      }
+
+      // Moves all blocks to the shared pool
+      void Flush() {
+         SharedPool& pool = GetSharedPool();
+         for( dip::uint index = 0; index < nLocalClasses; ++index ) {
+            while( count_[ index ] > 0 ) {
+               pool.Put( blocks_[ index ][ --count_[ index ]], index );
+            }
+         }
+      }
+
+   private:
+      void* blocks_[ nLocalClasses ][ blocksPerLocalClass ];
+      dip::uint count_[ nLocalClasses ] = {};
+};
+
+// The state of the calling thread's cache. It is trivially destructible, so it can be tested after the
+// cache has been destroyed, when an image is freed late during thread exit.
+enum class CacheState : dip::uint8 { NOT_CREATED, ALIVE, DESTROYED };
+thread_local CacheState cacheState = CacheState::NOT_CREATED;
+
+ThreadCache::ThreadCache() {
+   cacheState = CacheState::ALIVE;
+}
+
+ThreadCache::~ThreadCache() {
+   cacheState = CacheState::DESTROYED;
+   Flush();
+}
+
+ThreadCache* GetThreadCache() {
+   if( cacheState == CacheState::DESTROYED ) {
+      return nullptr;
+   }
+   thread_local ThreadCache cache;
+   return &cache;
+}
+
+void Recycle( void* ptr, dip::uint index ) {
+   SharedPool& pool = GetSharedPool();
+   dip::uint size = ClassSize( index );
+   pool.bytesInUse -= size;
+   if( !pool.ReserveCached( size )) {
+      SystemFree( ptr );
+      return;
+   }
+   if( index < nLocalClasses ) {
+      ThreadCache* cache = GetThreadCache();
+      if( cache && cache->Put( ptr, index )) {
+         return;
+      }
+   }
+   pool.Put( ptr, index );
+}
+
+} // namespace
+
+DataSegment BufferPoolInterface::Allocate( dip::uint bytes ) {
+   DIP_THROW_IF( bytes > ( dip::uint( 1 ) << maximumBlockSizeLog2 ), E::SIZE_EXCEEDS_LIMIT );
+   SharedPool& pool = GetSharedPool();
+   dip::uint index = ClassIndex( bytes );
+   dip::uint size = ClassSize( index );
+   void* ptr = nullptr;
+   if( index < nLocalClasses ) {
+      ThreadCache* cache = GetThreadCache();
+      if( cache ) {
+         ptr = cache->Take( index );
+      }
+   }
+   if( !ptr ) {
+      ptr = pool.Take( index );
+   }
+   if( ptr ) {
+      pool.bytesCached -= size;
+      ++pool.hits;
+   } else {
+      ptr = SystemAllocate( size, pool.hugePages );
+      if( !ptr ) {
+         // Return the cached blocks to the system and try again
+         Release();
+         ptr = SystemAllocate( size, pool.hugePages );
+         DIP_THROW_IF( !ptr, "Failed to allocate memory" );
+      }
+      ++pool.misses;
+   }
+   pool.AddInUse( size );
+   return DataSegment{ ptr, [ index ]( void* p ) { Recycle( p, index ); }};
+}
+
+void BufferPoolInterface::SetMemoryLimit( dip::uint bytes ) {
+   SharedPool& pool = GetSharedPool();
+   pool.memoryLimit = bytes;
+   ThreadCache* cache = GetThreadCache();
+   if( cache ) {
+      cache->Flush();
+   }
+   pool.Trim( bytes );
+}
+
+dip::uint BufferPoolInterface::MemoryLimit() const {
+   return GetSharedPool().memoryLimit;
+}
+
+void BufferPoolInterface::SetHugePages( bool enable ) {
+   GetSharedPool().hugePages = enable;
+}
+
+void BufferPoolInterface::Release() {
+   ThreadCache* cache = GetThreadCache();
+   if( cache ) {
+      cache->Flush();
+   }
+   GetSharedPool().Trim( 0 );
+}
+
+BufferPoolInterface::Statistics BufferPoolInterface::GetStatistics() const {
+   SharedPool const& pool = GetSharedPool();
+   Statistics stats;
+   stats.hits = pool.hits;
+   stats.misses = pool.misses;
+   stats.bytesInUse = pool.bytesInUse;
+   stats.peakBytesInUse = pool.peakBytesInUse;
+   stats.bytesCached = pool.bytesCached;
+   return stats;
+}
+
+void BufferPoolInterface::ResetStatistics() {
+   SharedPool& pool = GetSharedPool();
+   pool.hits = 0;
+   pool.misses = 0;
+   pool.peakBytesInUse = pool.bytesInUse.load();
+}
+
+BufferPoolInterface* BufferPoolInterface::GetInstance() {
+   static BufferPoolInterface ei;
+   return &ei;
+}
+
+void BufferPoolInterface::UseAsDefaultAllocator( bool enable ) {
+   GetSharedPool().isDefaultAllocator = enable;
+}
+
+bool BufferPoolInterface::IsDefaultAllocator() {
+   return GetSharedPool().isDefaultAllocator;
+}
+
+} // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the buffer pool") {
+   for( dip::uint bytes : { 1u, 256u, 257u, 320u, 321u, 511u, 512u, 513u, 1000000u, 123456789u } ) {
+      dip::uint index = dip::ClassIndex( bytes );
+      DOCTEST_CHECK( dip::ClassSize( index ) >= bytes );
+      DOCTEST_CHECK(( index == 0 || dip::ClassSize( index - 1 ) < bytes ));
+      DOCTEST_CHECK(( bytes <= dip::minimumBlockSize || dip::ClassSize( index ) - bytes <= dip::ClassSize( index ) / 4 ));
+   }
+   DOCTEST_CHECK( dip::ClassIndex( dip::uint( 1 ) << dip::maximumLocalBlockSizeLog2 ) == dip::nLocalClasses - 1 );
+   DOCTEST_CHECK( dip::ClassIndex( dip::uint( 1 ) << dip::maximumBlockSizeLog2 ) == dip::nClasses - 1 );
+
+   dip::BufferPoolInterface* pool = dip::BufferPoolInterface::GetInstance();
+   pool->ResetStatistics();
+   void* ptr;
+   {
+      dip::Image img;
+      img.SetExternalInterface( pool );
+      img.ReForge( { 100, 50 }, 3, dip::DT_SFLOAT );
+      ptr = img.Origin();
+      DOCTEST_CHECK( reinterpret_cast< dip::uint >( ptr ) % 64 == 0 );
+      DOCTEST_CHECK( img.HasNormalStrides() );
+      DOCTEST_CHECK( pool->GetStatistics().bytesInUse >= 100 * 50 * 3 * 4 );
+   }
+   dip::BufferPoolInterface::Statistics stats = pool->GetStatistics();
+   DOCTEST_CHECK( stats.bytesInUse == 0 );
+   DOCTEST_CHECK( stats.peakBytesInUse >= 100 * 50 * 3 * 4 );
+   DOCTEST_CHECK( stats.bytesCached >= 100 * 50 * 3 * 4 );
+
+   // An image of similar size, using the pool as the default allocator, reuses the block
+   dip::BufferPoolInterface::UseAsDefaultAllocator( true );
+   {
+      dip::Image img( { 50, 98 }, 3, dip::DT_SFLOAT );
+      DOCTEST_CHECK( img.Origin() == ptr );
+      DOCTEST_CHECK( !img.IsExternalData() );
+      img.Fill( 1.0 );
+      dip::Image out = img + img;
+      DOCTEST_CHECK( out.At( 10, 10 ) == 2.0 );
+   }
+   dip::BufferPoolInterface::UseAsDefaultAllocator( false );
+   stats = pool->GetStatistics();
+   DOCTEST_CHECK( stats.hits >= 1 );
+   DOCTEST_CHECK( stats.bytesInUse == 0 );
+
+   // With a memory limit of 0, nothing is kept
+   dip::uint limit = pool->MemoryLimit();
+   pool->SetMemoryLimit( 0 );
+   DOCTEST_CHECK( pool->GetStatistics().bytesCached == 0 );
+   pool->Allocate( 1000 ).reset();
+   DOCTEST_CHECK( pool->GetStatistics().bytesCached == 0 );
+   pool->SetMemoryLimit( limit );
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -19,16 +19,493 @@
  */
 
 #include <limits>
+#include <cstring>
 
 #include "diplib.h"
 #include "diplib/library/copy_buffer.h"
 #include "diplib/boundary.h"
 #include "diplib/saturated_arithmetic.h"
 
+// On x86 processors, contiguous conversions between the most common sample types are done with SSE4.1, AVX2
+// or AVX-512 instructions, selected at run time depending on what the processor supports.
+#if ( defined( __x86_64__ ) || defined( __i386__ )) && ( defined( __GNUC__ ) || defined( __clang__ ))
+#define DIP__COPY_BUFFER_SIMD
+#if defined( __GNUC__ ) && !defined( __clang__ )
+// GCC warns about the uses of `_mm512_undefined_*` in its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+#endif
+
 namespace dip {
 namespace detail {
 
 
+//
+// SIMD conversion kernels
+//
+
+// These are the conversions that the frameworks do most: from the image's sample type to the `sfloat` or `dfloat`
+// buffer type, and back. The results are identical to those of `clamp_cast`.
+
+#ifdef DIP__COPY_BUFFER_SIMD
+
+namespace {
+
+enum class SimdLevel { NONE, SSE41, AVX2, AVX512 };
+
+SimdLevel DetectSimdLevel() {
+   __builtin_cpu_init();
+   if( __builtin_cpu_supports( "avx512f" )) {
+      return SimdLevel::AVX512;
+   }
+   if( __builtin_cpu_supports( "avx2" )) {
+      return SimdLevel::AVX2;
+   }
+   if( __builtin_cpu_supports( "sse4.1" )) {
+      return SimdLevel::SSE41;
+   }
+   return SimdLevel::NONE;
+}
+
+// The level used by `CopyBuffer`, can be lowered for testing.
+SimdLevel& ActiveSimdLevel() {
+   static SimdLevel level = DetectSimdLevel();
+   return level;
+}
+
+template< typename T >
+inline T LoadUnaligned( void const* ptr ) {
+   T value;
+   std::memcpy( &value, ptr, sizeof( T ));
+   return value;
+}
+
+template< typename T >
+inline void StoreUnaligned( void* ptr, T value ) {
+   std::memcpy( ptr, &value, sizeof( T ));
+}
+
+// Clamping limits for float to integer conversion, as used by `clamp_cast`.
+template< typename T, typename F >
+constexpr F LowerLimit() { return static_cast< F >( std::numeric_limits< T >::lowest() ); }
+template< typename T, typename F >
+constexpr F UpperLimit() { return static_cast< F >( std::numeric_limits< T >::max() ); }
+
+// Each of the structs below implements the conversion loops for one instruction set. The `Load` functions read
+// a vector's worth of samples and convert them to floating point, the `Store` functions clamp a vector to the
+// range of the output type (`max` before `min`, such that NaN clamps to the lower limit), truncate and
+// write out the samples. As with `clamp_cast`, NaN converts to the lower limit. The upper limit of `sint32`
+// rounds up to 2^31 in `sfloat`, and truncating that gives 0x80000000; we replace those results with the upper
+// limit.
+
+#define DIP__TARGET( t ) __attribute__(( target( t )))
+
+struct SSE41 {
+   static constexpr dip::uint nFloat = 4;
+   static constexpr dip::uint nDouble = 2;
+
+   DIP__TARGET( "sse4.1" ) static __m128i LoadBytes4( uint8 const* in ) { return _mm_cvtsi32_si128( LoadUnaligned< int >( in )); }
+   DIP__TARGET( "sse4.1" ) static __m128i LoadBytes2( uint8 const* in ) { return _mm_cvtsi32_si128( LoadUnaligned< uint16 >( in )); }
+
+   DIP__TARGET( "sse4.1" ) static __m128 Load( bin const* in ) {
+      return _mm_cvtepi32_ps( _mm_cvtepu8_epi32( _mm_min_epu8( LoadBytes4( reinterpret_cast< uint8 const* >( in )), _mm_set1_epi8( 1 ))));
+   }
+   DIP__TARGET( "sse4.1" ) static __m128 Load( uint8 const* in ) { return _mm_cvtepi32_ps( _mm_cvtepu8_epi32( LoadBytes4( in ))); }
+   DIP__TARGET( "sse4.1" ) static __m128 Load( uint16 const* in ) { return _mm_cvtepi32_ps( _mm_cvtepu16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "sse4.1" ) static __m128 Load( sint16 const* in ) { return _mm_cvtepi32_ps( _mm_cvtepi16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "sse4.1" ) static __m128 Load( sint32 const* in ) { return _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in ))); }
+
+   template< typename T >
+   DIP__TARGET( "sse4.1" ) static __m128i Truncate( __m128 v ) {
+      return _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( v, _mm_set1_ps( LowerLimit< T, sfloat >() )), _mm_set1_ps( UpperLimit< T, sfloat >() )));
+   }
+   DIP__TARGET( "sse4.1" ) static void Store( uint8* out, __m128 v ) {
+      __m128i i = _mm_packs_epi32( Truncate< uint8 >( v ), _mm_setzero_si128() );
+      StoreUnaligned( out, _mm_cvtsi128_si32( _mm_packus_epi16( i, i )));
+   }
+   DIP__TARGET( "sse4.1" ) static void Store( uint16* out, __m128 v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packus_epi32( Truncate< uint16 >( v ), _mm_setzero_si128() )); }
+   DIP__TARGET( "sse4.1" ) static void Store( sint16* out, __m128 v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packs_epi32( Truncate< sint16 >( v ), _mm_setzero_si128() )); }
+   DIP__TARGET( "sse4.1" ) static void Store( sint32* out, __m128 v ) {
+      __m128i overflow = _mm_castps_si128( _mm_cmpge_ps( v, _mm_set1_ps( UpperLimit< sint32, sfloat >() )));
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm_xor_si128( Truncate< sint32 >( v ), overflow ));
+   }
+
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( bin const* in ) {
+      return _mm_cvtepi32_pd( _mm_cvtepu8_epi32( _mm_min_epu8( LoadBytes2( reinterpret_cast< uint8 const* >( in )), _mm_set1_epi8( 1 ))));
+   }
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( uint8 const* in ) { return _mm_cvtepi32_pd( _mm_cvtepu8_epi32( LoadBytes2( in ))); }
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( uint16 const* in ) { return _mm_cvtepi32_pd( _mm_cvtepu16_epi32( LoadBytes4( reinterpret_cast< uint8 const* >( in )))); }
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( sint16 const* in ) { return _mm_cvtepi32_pd( _mm_cvtepi16_epi32( LoadBytes4( reinterpret_cast< uint8 const* >( in )))); }
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( sint32 const* in ) { return _mm_cvtepi32_pd( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in ))); }
+   DIP__TARGET( "sse4.1" ) static __m128d LoadD( sfloat const* in ) { return _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+
+   template< typename T >
+   DIP__TARGET( "sse4.1" ) static __m128i Truncate( __m128d v ) {
+      return _mm_cvttpd_epi32( _mm_min_pd( _mm_max_pd( v, _mm_set1_pd( LowerLimit< T, dfloat >() )), _mm_set1_pd( UpperLimit< T, dfloat >() )));
+   }
+   DIP__TARGET( "sse4.1" ) static void StoreD( uint8* out, __m128d v ) {
+      __m128i i = _mm_packs_epi32( Truncate< uint8 >( v ), _mm_setzero_si128() );
+      StoreUnaligned( out, static_cast< uint16 >( _mm_cvtsi128_si32( _mm_packus_epi16( i, i ))));
+   }
+   DIP__TARGET( "sse4.1" ) static void StoreD( uint16* out, __m128d v ) { StoreUnaligned( out, _mm_cvtsi128_si32( _mm_packus_epi32( Truncate< uint16 >( v ), _mm_setzero_si128() ))); }
+   DIP__TARGET( "sse4.1" ) static void StoreD( sint16* out, __m128d v ) { StoreUnaligned( out, _mm_cvtsi128_si32( _mm_packs_epi32( Truncate< sint16 >( v ), _mm_setzero_si128() ))); }
+   DIP__TARGET( "sse4.1" ) static void StoreD( sint32* out, __m128d v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), Truncate< sint32 >( v )); }
+   DIP__TARGET( "sse4.1" ) static void StoreD( sfloat* out, __m128d v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_castps_si128( _mm_cvtpd_ps( v ))); }
+
+   DIP__TARGET( "sse4.1" ) static void ToBinary( uint8 const* in, uint8* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + 16 <= n; ii += 16 ) {
+         __m128i v = _mm_loadu_si128( reinterpret_cast< __m128i const* >( in + ii ));
+         _mm_storeu_si128( reinterpret_cast< __m128i* >( out + ii ), _mm_min_epu8( v, _mm_set1_epi8( 1 )));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = static_cast< uint8 >( in[ ii ] != 0 );
+      }
+   }
+
+   template< typename inT >
+   DIP__TARGET( "sse4.1" ) static void ToSFloat( inT const* in, sfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         _mm_storeu_ps( out + ii, Load( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< sfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "sse4.1" ) static void FromSFloat( sfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         Store( out + ii, _mm_loadu_ps( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+   template< typename inT >
+   DIP__TARGET( "sse4.1" ) static void ToDFloat( inT const* in, dfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         _mm_storeu_pd( out + ii, LoadD( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< dfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "sse4.1" ) static void FromDFloat( dfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         StoreD( out + ii, _mm_loadu_pd( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+};
+
+struct AVX2 {
+   static constexpr dip::uint nFloat = 8;
+   static constexpr dip::uint nDouble = 4;
+
+   DIP__TARGET( "avx2" ) static __m128i LoadBytes8( uint8 const* in ) { return _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )); }
+   DIP__TARGET( "avx2" ) static __m128i LoadBytes4( uint8 const* in ) { return _mm_cvtsi32_si128( LoadUnaligned< int >( in )); }
+
+   DIP__TARGET( "avx2" ) static __m256 Load( bin const* in ) {
+      return _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_min_epu8( LoadBytes8( reinterpret_cast< uint8 const* >( in )), _mm_set1_epi8( 1 ))));
+   }
+   DIP__TARGET( "avx2" ) static __m256 Load( uint8 const* in ) { return _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( LoadBytes8( in ))); }
+   DIP__TARGET( "avx2" ) static __m256 Load( uint16 const* in ) { return _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx2" ) static __m256 Load( sint16 const* in ) { return _mm256_cvtepi32_ps( _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx2" ) static __m256 Load( sint32 const* in ) { return _mm256_cvtepi32_ps( _mm256_loadu_si256( reinterpret_cast< __m256i const* >( in ))); }
+
+   template< typename T >
+   DIP__TARGET( "avx2" ) static __m256i Truncate( __m256 v ) {
+      return _mm256_cvttps_epi32( _mm256_min_ps( _mm256_max_ps( v, _mm256_set1_ps( LowerLimit< T, sfloat >() )), _mm256_set1_ps( UpperLimit< T, sfloat >() )));
+   }
+   DIP__TARGET( "avx2" ) static void Store( uint8* out, __m256 v ) {
+      __m256i i = Truncate< uint8 >( v );
+      __m128i s = _mm_packs_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 ));
+      _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packus_epi16( s, s ));
+   }
+   DIP__TARGET( "avx2" ) static void Store( uint16* out, __m256 v ) {
+      __m256i i = Truncate< uint16 >( v );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm_packus_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 )));
+   }
+   DIP__TARGET( "avx2" ) static void Store( sint16* out, __m256 v ) {
+      __m256i i = Truncate< sint16 >( v );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm_packs_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 )));
+   }
+   DIP__TARGET( "avx2" ) static void Store( sint32* out, __m256 v ) {
+      __m256i overflow = _mm256_castps_si256( _mm256_cmp_ps( v, _mm256_set1_ps( UpperLimit< sint32, sfloat >() ), _CMP_GE_OQ ));
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( out ), _mm256_xor_si256( Truncate< sint32 >( v ), overflow ));
+   }
+
+   DIP__TARGET( "avx2" ) static __m256d LoadD( bin const* in ) {
+      return _mm256_cvtepi32_pd( _mm_cvtepu8_epi32( _mm_min_epu8( LoadBytes4( reinterpret_cast< uint8 const* >( in )), _mm_set1_epi8( 1 ))));
+   }
+   DIP__TARGET( "avx2" ) static __m256d LoadD( uint8 const* in ) { return _mm256_cvtepi32_pd( _mm_cvtepu8_epi32( LoadBytes4( in ))); }
+   DIP__TARGET( "avx2" ) static __m256d LoadD( uint16 const* in ) { return _mm256_cvtepi32_pd( _mm_cvtepu16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx2" ) static __m256d LoadD( sint16 const* in ) { return _mm256_cvtepi32_pd( _mm_cvtepi16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx2" ) static __m256d LoadD( sint32 const* in ) { return _mm256_cvtepi32_pd( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in ))); }
+   DIP__TARGET( "avx2" ) static __m256d LoadD( sfloat const* in ) { return _mm256_cvtps_pd( _mm_loadu_ps( in )); }
+
+   template< typename T >
+   DIP__TARGET( "avx2" ) static __m128i Truncate( __m256d v ) {
+      return _mm256_cvttpd_epi32( _mm256_min_pd( _mm256_max_pd( v, _mm256_set1_pd( LowerLimit< T, dfloat >() )), _mm256_set1_pd( UpperLimit< T, dfloat >() )));
+   }
+   DIP__TARGET( "avx2" ) static void StoreD( uint8* out, __m256d v ) {
+      __m128i i = _mm_packs_epi32( Truncate< uint8 >( v ), _mm_setzero_si128() );
+      StoreUnaligned( out, _mm_cvtsi128_si32( _mm_packus_epi16( i, i )));
+   }
+   DIP__TARGET( "avx2" ) static void StoreD( uint16* out, __m256d v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packus_epi32( Truncate< uint16 >( v ), _mm_setzero_si128() )); }
+   DIP__TARGET( "avx2" ) static void StoreD( sint16* out, __m256d v ) { _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packs_epi32( Truncate< sint16 >( v ), _mm_setzero_si128() )); }
+   DIP__TARGET( "avx2" ) static void StoreD( sint32* out, __m256d v ) { _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), Truncate< sint32 >( v )); }
+   DIP__TARGET( "avx2" ) static void StoreD( sfloat* out, __m256d v ) { _mm_storeu_ps( out, _mm256_cvtpd_ps( v )); }
+
+   DIP__TARGET( "avx2" ) static void ToBinary( uint8 const* in, uint8* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + 32 <= n; ii += 32 ) {
+         __m256i v = _mm256_loadu_si256( reinterpret_cast< __m256i const* >( in + ii ));
+         _mm256_storeu_si256( reinterpret_cast< __m256i* >( out + ii ), _mm256_min_epu8( v, _mm256_set1_epi8( 1 )));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = static_cast< uint8 >( in[ ii ] != 0 );
+      }
+   }
+
+   template< typename inT >
+   DIP__TARGET( "avx2" ) static void ToSFloat( inT const* in, sfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         _mm256_storeu_ps( out + ii, Load( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< sfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "avx2" ) static void FromSFloat( sfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         Store( out + ii, _mm256_loadu_ps( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+   template< typename inT >
+   DIP__TARGET( "avx2" ) static void ToDFloat( inT const* in, dfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         _mm256_storeu_pd( out + ii, LoadD( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< dfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "avx2" ) static void FromDFloat( dfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         StoreD( out + ii, _mm256_loadu_pd( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+};
+
+struct AVX512 {
+   static constexpr dip::uint nFloat = 16;
+   static constexpr dip::uint nDouble = 8;
+
+   DIP__TARGET( "avx512f" ) static __m512 Load( bin const* in ) {
+      __m128i v = _mm_min_epu8( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )), _mm_set1_epi8( 1 ));
+      return _mm512_cvtepi32_ps( _mm512_cvtepu8_epi32( v ));
+   }
+   DIP__TARGET( "avx512f" ) static __m512 Load( uint8 const* in ) { return _mm512_cvtepi32_ps( _mm512_cvtepu8_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512 Load( uint16 const* in ) { return _mm512_cvtepi32_ps( _mm512_cvtepu16_epi32( _mm256_loadu_si256( reinterpret_cast< __m256i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512 Load( sint16 const* in ) { return _mm512_cvtepi32_ps( _mm512_cvtepi16_epi32( _mm256_loadu_si256( reinterpret_cast< __m256i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512 Load( sint32 const* in ) { return _mm512_cvtepi32_ps( _mm512_loadu_si512( in )); }
+
+   template< typename T >
+   DIP__TARGET( "avx512f" ) static __m512i Truncate( __m512 v ) {
+      return _mm512_cvttps_epi32( _mm512_min_ps( _mm512_max_ps( v, _mm512_set1_ps( LowerLimit< T, sfloat >() )), _mm512_set1_ps( UpperLimit< T, sfloat >() )));
+   }
+   // The values are within range after clamping, so the truncating down-conversions are exact
+   DIP__TARGET( "avx512f" ) static void Store( uint8* out, __m512 v ) { _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm512_cvtepi32_epi8( Truncate< uint8 >( v ))); }
+   DIP__TARGET( "avx512f" ) static void Store( uint16* out, __m512 v ) { _mm256_storeu_si256( reinterpret_cast< __m256i* >( out ), _mm512_cvtepi32_epi16( Truncate< uint16 >( v ))); }
+   DIP__TARGET( "avx512f" ) static void Store( sint16* out, __m512 v ) { _mm256_storeu_si256( reinterpret_cast< __m256i* >( out ), _mm512_cvtepi32_epi16( Truncate< sint16 >( v ))); }
+   DIP__TARGET( "avx512f" ) static void Store( sint32* out, __m512 v ) {
+      __mmask16 overflow = _mm512_cmp_ps_mask( v, _mm512_set1_ps( UpperLimit< sint32, sfloat >() ), _CMP_GE_OQ );
+      _mm512_storeu_si512( out, _mm512_mask_set1_epi32( Truncate< sint32 >( v ), overflow, std::numeric_limits< sint32 >::max() ));
+   }
+
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( bin const* in ) {
+      __m128i v = _mm_min_epu8( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )), _mm_set1_epi8( 1 ));
+      return _mm512_cvtepi32_pd( _mm256_cvtepu8_epi32( v ));
+   }
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( uint8 const* in ) { return _mm512_cvtepi32_pd( _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( uint16 const* in ) { return _mm512_cvtepi32_pd( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( sint16 const* in ) { return _mm512_cvtepi32_pd( _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( in )))); }
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( sint32 const* in ) { return _mm512_cvtepi32_pd( _mm256_loadu_si256( reinterpret_cast< __m256i const* >( in ))); }
+   DIP__TARGET( "avx512f" ) static __m512d LoadD( sfloat const* in ) { return _mm512_cvtps_pd( _mm256_loadu_ps( in )); }
+
+   template< typename T >
+   DIP__TARGET( "avx512f" ) static __m256i Truncate( __m512d v ) {
+      return _mm512_cvttpd_epi32( _mm512_min_pd( _mm512_max_pd( v, _mm512_set1_pd( LowerLimit< T, dfloat >() )), _mm512_set1_pd( UpperLimit< T, dfloat >() )));
+   }
+   DIP__TARGET( "avx512f" ) static void StoreD( uint8* out, __m512d v ) {
+      __m256i i = Truncate< uint8 >( v );
+      __m128i s = _mm_packs_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 ));
+      _mm_storel_epi64( reinterpret_cast< __m128i* >( out ), _mm_packus_epi16( s, s ));
+   }
+   DIP__TARGET( "avx512f" ) static void StoreD( uint16* out, __m512d v ) {
+      __m256i i = Truncate< uint16 >( v );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm_packus_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 )));
+   }
+   DIP__TARGET( "avx512f" ) static void StoreD( sint16* out, __m512d v ) {
+      __m256i i = Truncate< sint16 >( v );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( out ), _mm_packs_epi32( _mm256_castsi256_si128( i ), _mm256_extracti128_si256( i, 1 )));
+   }
+   DIP__TARGET( "avx512f" ) static void StoreD( sint32* out, __m512d v ) { _mm256_storeu_si256( reinterpret_cast< __m256i* >( out ), Truncate< sint32 >( v )); }
+   DIP__TARGET( "avx512f" ) static void StoreD( sfloat* out, __m512d v ) { _mm256_storeu_ps( out, _mm512_cvtpd_ps( v )); }
+
+   // Byte-wise operations need AVX-512BW, we use the AVX2 version instead
+   static void ToBinary( uint8 const* in, uint8* out, dip::uint n ) {
+      AVX2::ToBinary( in, out, n );
+   }
+
+   template< typename inT >
+   DIP__TARGET( "avx512f" ) static void ToSFloat( inT const* in, sfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         _mm512_storeu_ps( out + ii, Load( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< sfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "avx512f" ) static void FromSFloat( sfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nFloat <= n; ii += nFloat ) {
+         Store( out + ii, _mm512_loadu_ps( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+   template< typename inT >
+   DIP__TARGET( "avx512f" ) static void ToDFloat( inT const* in, dfloat* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         _mm512_storeu_pd( out + ii, LoadD( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< dfloat >( in[ ii ] );
+      }
+   }
+   template< typename outT >
+   DIP__TARGET( "avx512f" ) static void FromDFloat( dfloat const* in, outT* out, dip::uint n ) {
+      dip::uint ii = 0;
+      for( ; ii + nDouble <= n; ii += nDouble ) {
+         StoreD( out + ii, _mm512_loadu_pd( in + ii ));
+      }
+      for( ; ii < n; ++ii ) {
+         out[ ii ] = clamp_cast< outT >( in[ ii ] );
+      }
+   }
+};
+
+#undef DIP__TARGET
+
+// Converts `n` contiguous samples using the instruction set `Simd`. Returns false if the combination of
+// data types is not handled, in which case nothing was done.
+template< typename Simd >
+bool ConvertContiguous( void const* in, DataType inType, void* out, DataType outType, dip::uint n ) {
+   switch( outType ) {
+      case DT_BIN:
+         if( inType == DT_UINT8 ) {
+            Simd::ToBinary( static_cast< uint8 const* >( in ), static_cast< uint8* >( out ), n );
+            return true;
+         }
+         return false;
+      case DT_UINT8:
+         switch( inType ) {
+            case DT_BIN: Simd::ToBinary( static_cast< uint8 const* >( in ), static_cast< uint8* >( out ), n ); return true;
+            case DT_SFLOAT: Simd::FromSFloat( static_cast< sfloat const* >( in ), static_cast< uint8* >( out ), n ); return true;
+            case DT_DFLOAT: Simd::FromDFloat( static_cast< dfloat const* >( in ), static_cast< uint8* >( out ), n ); return true;
+            default: return false;
+         }
+      case DT_UINT16:
+         switch( inType ) {
+            case DT_SFLOAT: Simd::FromSFloat( static_cast< sfloat const* >( in ), static_cast< uint16* >( out ), n ); return true;
+            case DT_DFLOAT: Simd::FromDFloat( static_cast< dfloat const* >( in ), static_cast< uint16* >( out ), n ); return true;
+            default: return false;
+         }
+      case DT_SINT16:
+         switch( inType ) {
+            case DT_SFLOAT: Simd::FromSFloat( static_cast< sfloat const* >( in ), static_cast< sint16* >( out ), n ); return true;
+            case DT_DFLOAT: Simd::FromDFloat( static_cast< dfloat const* >( in ), static_cast< sint16* >( out ), n ); return true;
+            default: return false;
+         }
+      case DT_SINT32:
+         switch( inType ) {
+            case DT_SFLOAT: Simd::FromSFloat( static_cast< sfloat const* >( in ), static_cast< sint32* >( out ), n ); return true;
+            case DT_DFLOAT: Simd::FromDFloat( static_cast< dfloat const* >( in ), static_cast< sint32* >( out ), n ); return true;
+            default: return false;
+         }
+      case DT_SFLOAT:
+         switch( inType ) {
+            case DT_BIN: Simd::ToSFloat( static_cast< bin const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            case DT_UINT8: Simd::ToSFloat( static_cast< uint8 const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            case DT_UINT16: Simd::ToSFloat( static_cast< uint16 const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            case DT_SINT16: Simd::ToSFloat( static_cast< sint16 const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            case DT_SINT32: Simd::ToSFloat( static_cast< sint32 const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            case DT_DFLOAT: Simd::FromDFloat( static_cast< dfloat const* >( in ), static_cast< sfloat* >( out ), n ); return true;
+            default: return false;
+         }
+      case DT_DFLOAT:
+         switch( inType ) {
+            case DT_BIN: Simd::ToDFloat( static_cast< bin const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            case DT_UINT8: Simd::ToDFloat( static_cast< uint8 const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            case DT_UINT16: Simd::ToDFloat( static_cast< uint16 const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            case DT_SINT16: Simd::ToDFloat( static_cast< sint16 const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            case DT_SINT32: Simd::ToDFloat( static_cast< sint32 const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            case DT_SFLOAT: Simd::ToDFloat( static_cast< sfloat const* >( in ), static_cast< dfloat* >( out ), n ); return true;
+            default: return false;
+         }
+      default:
+         return false;
+   }
+}
+
+bool ConvertContiguousSimd( void const* in, DataType inType, void* out, DataType outType, dip::uint n ) {
+   switch( ActiveSimdLevel() ) {
+      case SimdLevel::AVX512:
+         return ConvertContiguous< AVX512 >( in, inType, out, outType, n );
+      case SimdLevel::AVX2:
+         return ConvertContiguous< AVX2 >( in, inType, out, outType, n );
+      case SimdLevel::SSE41:
+         return ConvertContiguous< SSE41 >( in, inType, out, outType, n );
+      default:
+         return false;
+   }
+}
+
+} // namespace
+
+#endif // DIP__COPY_BUFFER_SIMD
+
+
 //
 // CopyBuffer()
 //
@@ -297,6 +774,21 @@ void CopyBuffer(
       tensorElements = 1;
       outTensorStride = 1;
    }
+#ifdef DIP__COPY_BUFFER_SIMD
+   // If both buffers are contiguous, convert them as a single 1D array
+   if(( inType != outType ) && lookUpTable.empty() ) {
+      dip::sint nTensor = static_cast< dip::sint >( tensorElements );
+      bool contiguous = false;
+      if(( inStride == 1 ) && ( outStride == 1 )) {
+         contiguous = ( tensorElements == 1 ) || (( inTensorStride == static_cast< dip::sint >( pixels )) && ( outTensorStride == static_cast< dip::sint >( pixels )));
+      } else if(( inTensorStride == 1 ) && ( outTensorStride == 1 )) {
+         contiguous = ( inStride == nTensor ) && ( outStride == nTensor );
+      }
+      if( contiguous && ConvertContiguousSimd( inBuffer, inType, outBuffer, outType, pixels * tensorElements )) {
+         return;
+      }
+   }
+#endif
    switch( inType ) {
       case dip::DT_BIN:
          CopyBufferFrom( static_cast< bin const* >( inBuffer ), inStride, inTensorStride, outBuffer, outType, outStride, outTensorStride, pixels, tensorElements, lookUpTable );
@@ -1032,4 +1524,45 @@ DOCTEST_TEST_CASE("[DIPlib] testing the CopyBuffer function") {
    DOCTEST_CHECK_FALSE( error );
 }
 
+#ifdef DIP__COPY_BUFFER_SIMD
+
+DOCTEST_TEST_CASE("[DIPlib] testing the SIMD conversions in CopyBuffer") {
+   std::vector< dip::dfloat > values{ -3e9, -40000.0, -32768.7, -300.2, -1.5, -0.7, 0.0, 0.3, 1.0, 1.99, 2.0, 127.5, 254.9,
+                                      255.0, 256.0, 32767.9, 40000.0, 65535.5, 70000.0, 2e9, 12345.678, 3e9,
+                                      std::numeric_limits< dip::dfloat >::infinity(), -std::numeric_limits< dip::dfloat >::infinity(),
+                                      std::numeric_limits< dip::dfloat >::quiet_NaN() };
+   std::vector< dip::DataType > types{ dip::DT_BIN, dip::DT_UINT8, dip::DT_UINT16, dip::DT_SINT16, dip::DT_SINT32, dip::DT_SFLOAT, dip::DT_DFLOAT };
+   dip::uint n = 75; // not a multiple of the vector lengths, so we also test the tail loops
+   dip::detail::SimdLevel detected = dip::detail::ActiveSimdLevel();
+   std::vector< dip::uint8 > input( n * 8 );
+   std::vector< dip::uint8 > reference( n * 8 );
+   std::vector< dip::uint8 > output( n * 8 );
+   for( auto inType : types ) {
+      dip::uint inSize = inType.SizeOf();
+      for( dip::uint ii = 0; ii < n; ++ii ) {
+         dip::detail::CastSample( dip::DT_DFLOAT, &values[ ii % values.size() ], inType, input.data() + ii * inSize );
+      }
+      for( auto outType : types ) {
+         dip::uint outSize = outType.SizeOf();
+         for( dip::uint ii = 0; ii < n; ++ii ) {
+            dip::detail::CastSample( inType, input.data() + ii * inSize, outType, reference.data() + ii * outSize );
+         }
+         for( auto level : { dip::detail::SimdLevel::SSE41, dip::detail::SimdLevel::AVX2, dip::detail::SimdLevel::AVX512 } ) {
+            if( level > detected ) {
+               break;
+            }
+            dip::detail::ActiveSimdLevel() = level;
+            std::fill( output.begin(), output.end(), 101 );
+            dip::detail::CopyBuffer( input.data(), inType, 1, 1, output.data(), outType, 1, 1, n, 1 );
+            int levelNumber = static_cast< int >( level );
+            DOCTEST_INFO( "conversion " << inType << " -> " << outType << " at level " << levelNumber );
+            DOCTEST_CHECK( std::memcmp( output.data(), reference.data(), n * outSize ) == 0 );
+         }
+         dip::detail::ActiveSimdLevel() = detected;
+      }
+   }
+}
+
+#endif // DIP__COPY_BUFFER_SIMD
+
 #endif // DIP__ENABLE_DOCTEST
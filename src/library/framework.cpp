@@ -130,5 +130,21 @@ dip::uint OptimalProcessingDim(
    return OptimalProcessingDim_internal( sizes, in.Strides() );
 }
 
+// Find the coordinates of the first pixel of line number `line`.
+UnsignedArray LineStartCoordinates(
+      UnsignedArray const& sizes,
+      dip::uint processingDim,
+      dip::uint line
+) {
+   UnsignedArray coords( sizes.size(), 0 );
+   for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+      if( ii != processingDim ) {
+         coords[ ii ] = line % sizes[ ii ];
+         line /= sizes[ ii ];
+      }
+   }
+   return coords;
+}
+
 } // namespace Framework
 } // namespace dip
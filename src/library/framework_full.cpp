@@ -28,6 +28,187 @@
 namespace dip {
 namespace Framework {
 
+namespace {
+
+// The halo of a tile will not use much more memory than this, unless the tile is a single image line.
+constexpr dip::uint haloBufferSize = 1024 * 1024; // bytes
+
+// A block of output pixels whose neighborhood crosses the image edge. These pixels are computed from a boundary-
+// extended copy of the input image under the block, which we call its halo. The halo has the same strides as the
+// input image, so that the pixel table offsets are valid within it.
+struct HaloTile {
+   UnsignedArray start;     // Coordinates of the first pixel in the tile
+   UnsignedArray sizes;     // Sizes of the tile
+   IntegerArray haloStart;  // Coordinates of the first pixel in the halo, can be outside the image
+   UnsignedArray haloSizes; // Sizes of the halo
+};
+
+// Boundary conditions that fill the boundary using only image pixels close to the edge
+bool IsLocalBoundaryCondition( BoundaryCondition bc ) {
+   return ( bc != BoundaryCondition::PERIODIC ) && ( bc != BoundaryCondition::ASYMMETRIC_PERIODIC );
+}
+
+// Computes the halo along one dimension for a tile covering `[start, start + size)`. The halo always extends by the
+// full boundary size past the image edge (the extrapolating boundary conditions depend on it), and contains enough
+// image pixels for the boundary condition to produce the same values as when extending the whole image.
+void ComputeHalo(
+      dip::uint start,
+      dip::uint size,
+      dip::uint imageSize,
+      dip::uint left,
+      dip::uint right,
+      dip::uint minValid,
+      dip::sint& haloStart,
+      dip::uint& haloSize
+) {
+   dip::sint first = static_cast< dip::sint >( start ) - static_cast< dip::sint >( left );
+   dip::sint last = static_cast< dip::sint >( start + size + right ); // one past the end
+   dip::sint n = static_cast< dip::sint >( imageSize );
+   if( first < 0 ) {
+      first = -static_cast< dip::sint >( left );
+      last = std::max( last, static_cast< dip::sint >( minValid ));
+   }
+   if( last > n ) {
+      last = n + static_cast< dip::sint >( right );
+      first = std::min( first, n - static_cast< dip::sint >( minValid ));
+   }
+   haloStart = first;
+   haloSize = static_cast< dip::uint >( last - first );
+}
+
+// Finds the pixels of `in` whose neighborhood, which extends `left` and `right` pixels from the pixel, crosses the
+// image edge, and splits them into tiles. The remaining pixels form a box that can be processed directly from `in`.
+// Returns false if the halos cannot be laid out with the strides of `in` (we then need to copy the whole image).
+bool MakeHaloTiles(
+      Image const& in,
+      dip::uint processingDim,
+      UnsignedArray const& left,
+      UnsignedArray const& right,
+      std::vector< HaloTile >& tiles,
+      UnsignedArray& maxHaloSizes
+) {
+   dip::uint nDims = in.Dimensionality();
+   UnsignedArray const& sizes = in.Sizes();
+   IntegerArray const& strides = in.Strides();
+
+   // Minimal number of image pixels in a halo, and a bound on how much larger than its tile a halo can be
+   UnsignedArray minValid( nDims );
+   UnsignedArray extra( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      minValid[ ii ] = std::min( sizes[ ii ], std::max( std::max( left[ ii ], right[ ii ] ), dip::uint( 1 )) + 2 );
+      extra[ ii ] = 2 * ( left[ ii ] + right[ ii ] ) + minValid[ ii ];
+   }
+
+   // Choose the maximum tile size along each dimension: the halo must fit in between the strides of the input
+   // image, and along the dimension with the largest stride we limit the size of the halo
+   std::vector< dip::uint > order;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if(( sizes[ ii ] > 1 ) || ( left[ ii ] > 0 ) || ( right[ ii ] > 0 )) {
+         order.push_back( ii );
+      }
+   }
+   std::sort( order.begin(), order.end(), [ & ]( dip::uint a, dip::uint b ) {
+      return std::abs( strides[ a ] ) < std::abs( strides[ b ] );
+   } );
+   UnsignedArray maxTileSizes = sizes;
+   for( dip::uint ii = 0; ii < order.size(); ++ii ) {
+      dip::uint dim = order[ ii ];
+      dip::uint stride = static_cast< dip::uint >( std::abs( strides[ dim ] ));
+      dip::uint maxHaloSize;
+      if( ii + 1 < order.size() ) {
+         maxHaloSize = static_cast< dip::uint >( std::abs( strides[ order[ ii + 1 ]] )) / std::max( stride, dip::uint( 1 ));
+      } else {
+         maxHaloSize = haloBufferSize / std::max( stride * in.DataType().SizeOf(), dip::uint( 1 ));
+      }
+      maxTileSizes[ dim ] = clamp( maxHaloSize > extra[ dim ] ? maxHaloSize - extra[ dim ] : 1, dip::uint( 1 ), sizes[ dim ] );
+   }
+
+   // Split the edge region into boxes, one dimension at a time: the slabs at the two ends of the dimension, with
+   // the box shrunk along the dimensions already handled. The processing dimension goes last, so that the box
+   // that remains contains full image lines along it, except for the first and last few pixels.
+   order.clear();
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( ii != processingDim ) {
+         order.push_back( ii );
+      }
+   }
+   order.push_back( processingDim );
+   UnsignedArray boxStart( nDims, 0 );
+   UnsignedArray boxEnd = sizes;
+   auto addTiles = [ & ]( dip::uint dim, dip::uint first, dip::uint last ) {
+      UnsignedArray start = boxStart;
+      UnsignedArray end = boxEnd;
+      start[ dim ] = first;
+      end[ dim ] = last;
+      HaloTile tile;
+      tile.start = start;
+      tile.sizes.resize( nDims );
+      tile.haloStart.resize( nDims );
+      tile.haloSizes.resize( nDims );
+      while( true ) {
+         for( dip::uint ii = 0; ii < nDims; ++ii ) {
+            tile.sizes[ ii ] = std::min( maxTileSizes[ ii ], end[ ii ] - tile.start[ ii ] );
+            ComputeHalo( tile.start[ ii ], tile.sizes[ ii ], sizes[ ii ], left[ ii ], right[ ii ], minValid[ ii ],
+                         tile.haloStart[ ii ], tile.haloSizes[ ii ] );
+            maxHaloSizes[ ii ] = std::max( maxHaloSizes[ ii ], tile.haloSizes[ ii ] );
+         }
+         tiles.push_back( tile );
+         dip::uint ii = 0;
+         for( ; ii < nDims; ++ii ) {
+            tile.start[ ii ] += tile.sizes[ ii ];
+            if( tile.start[ ii ] < end[ ii ] ) {
+               break;
+            }
+            tile.start[ ii ] = start[ ii ];
+         }
+         if( ii == nDims ) {
+            break;
+         }
+      }
+   };
+   maxHaloSizes = UnsignedArray( nDims, 1 );
+   for( dip::uint dim : order ) {
+      dip::uint n = sizes[ dim ];
+      if( n <= left[ dim ] + right[ dim ] ) {
+         // All remaining pixels are close to the edge
+         addTiles( dim, 0, n );
+         boxEnd[ dim ] = boxStart[ dim ];
+         break;
+      }
+      if( left[ dim ] > 0 ) {
+         addTiles( dim, 0, left[ dim ] );
+      }
+      if( right[ dim ] > 0 ) {
+         addTiles( dim, n - right[ dim ], n );
+      }
+      boxStart[ dim ] = left[ dim ];
+      boxEnd[ dim ] = n - right[ dim ];
+   }
+
+   // The halo must not overlap itself when laid out with the strides of `in`
+   std::vector< std::pair< dip::uint, dip::uint >> extents; // (stride, size) pairs
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( maxHaloSizes[ ii ] > 1 ) {
+         extents.emplace_back( static_cast< dip::uint >( std::abs( strides[ ii ] )), maxHaloSizes[ ii ] );
+      }
+   }
+   if( in.TensorElements() > 1 ) {
+      extents.emplace_back( static_cast< dip::uint >( std::abs( in.TensorStride() )), in.TensorElements() );
+   }
+   std::sort( extents.begin(), extents.end() );
+   for( dip::uint ii = 0; ii < extents.size(); ++ii ) {
+      if( extents[ ii ].first == 0 ) {
+         return false;
+      }
+      if(( ii + 1 < extents.size() ) && ( extents[ ii ].first * extents[ ii ].second > extents[ ii + 1 ].first )) {
+         return false;
+      }
+   }
+   return true;
+}
+
+} // namespace
+
 void Full(
       Image const& c_in,
       Image& c_out,
@@ -42,10 +223,12 @@ void Full(
 ) {
    DIP_THROW_IF( !c_in.IsForged(), E::IMAGE_NOT_FORGED );
    UnsignedArray sizes = c_in.Sizes();
+   dip::uint nDims = sizes.size();
 
    // Check inputs
    UnsignedArray kernelSizes;
-   DIP_STACK_TRACE_THIS( kernelSizes = kernel.Sizes( sizes.size() ));
+   DIP_STACK_TRACE_THIS( kernelSizes = kernel.Sizes( nDims ));
+   DIP_STACK_TRACE_THIS( BoundaryArrayUseParameter( boundaryConditions, nDims ));
 
    // Store these because they can get lost when ReForging `c_out` (it could be the same image as `c_in`)
    PixelSize pixelSize = c_in.PixelSize();
@@ -62,20 +245,12 @@ void Full(
       expandTensor = ( opts == Full_ExpandTensorInBuffer ) && !c_in.Tensor().HasNormalOrder();
    }
 
-   // Determine boundary sizes
-   UnsignedArray boundary = kernel.Boundary( c_in.Dimensionality() );
-
-   // Do we need to adjust the input image?
-   bool dataTypeChange = c_in.DataType() != inBufferType;
-   bool expandBoundary = boundary.any() && ( opts != Full_BorderAlreadyExpanded );
-   bool adjustInput = dataTypeChange || expandTensor || expandBoundary;
-
    // Adjust c_out if necessary (and possible)
    // NOTE: Don't use c_in any more from here on. It has possibly been reforged!
    Image cc_in = c_in.QuickCopy(); // Preserve for later
    DIP_START_STACK_TRACE
       if( c_out.Aliases( c_in )) {
-         // We cannot work in-place! Note this only happens if we didn't call `ExtendImage` earlier.
+         // We cannot work in-place!
          c_out.Strip();
       }
       c_out.ReForge( sizes, outTensor.Elements(), outImageType, Option::AcceptDataTypeChange::DO_ALLOW );
@@ -87,45 +262,89 @@ void Full(
    DIP_END_STACK_TRACE
    Image output = c_out.QuickCopy();
 
+   // Create a pixel table, and determine the boundary sizes from its bounding box. These can be different at the
+   // two ends of a dimension, for example for shifted or even-sized kernels.
+   dip::uint processingDim = OptimalProcessingDim( cc_in, kernelSizes );
+   PixelTable pixelTable;
+   DIP_STACK_TRACE_THIS( pixelTable = kernel.PixelTable( nDims, processingDim ));
+   UnsignedArray left( nDims, 0 );
+   UnsignedArray right( nDims, 0 );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::sint origin = pixelTable.Origin()[ ii ];
+      left[ ii ] = static_cast< dip::uint >( std::max( -origin, dip::sint( 0 )));
+      right[ ii ] = static_cast< dip::uint >( std::max( origin + static_cast< dip::sint >( pixelTable.Sizes()[ ii ] ) - 1, dip::sint( 0 )));
+   }
+
+   // Do we need to adjust the input image?
+   bool dataTypeChange = cc_in.DataType() != inBufferType;
+   bool expandBoundary = ( left.any() || right.any() ) && ( opts != Full_BorderAlreadyExpanded );
+   bool adjustInput = dataTypeChange || expandTensor || expandBoundary;
+
+   // If we only need to expand the boundary, and the boundary conditions can be computed locally, then we read the
+   // interior of the image directly, and only copy and extend the neighborhoods of the pixels close to the edge.
+   bool useHalo = expandBoundary && !dataTypeChange && !expandTensor &&
+                  std::all_of( boundaryConditions.begin(), boundaryConditions.end(), IsLocalBoundaryCondition );
+   std::vector< HaloTile > tiles;
+   UnsignedArray maxHaloSizes;
+   if( useHalo ) {
+      Image tmp = cc_in.QuickCopy();
+      UnsignedArray haloLeft = left;
+      UnsignedArray haloRight = right;
+      if( asScalarImage ) {
+         tmp.TensorToSpatial();
+         haloLeft.push_back( 0 );
+         haloRight.push_back( 0 );
+      }
+      useHalo = MakeHaloTiles( tmp, processingDim, haloLeft, haloRight, tiles, maxHaloSizes );
+      if( !useHalo ) {
+         tiles.clear();
+      }
+   }
+
    // Copy input if necessary (this is the input buffer!)
    // If we do copy the input, we'll adjust its strides to match those of output.
    Image input;
-   if( adjustInput ) {
+   if( adjustInput && !useHalo ) {
       input.SetDataType( inBufferType );
       if( expandTensor ) {
          input.SetTensorSizes( cc_in.TensorColumns() * cc_in.TensorRows() );
       } else {
          input.SetTensorSizes( cc_in.TensorElements() );
       }
-      UnsignedArray bufferSizes = cc_in.Sizes();
+      UnsignedArray bufferSizes = sizes;
+      RangeArray ranges( nDims );
       if( expandBoundary ) {
-         for( dip::uint ii = 0; ii < bufferSizes.size(); ++ii ) {
-            bufferSizes[ ii ] += 2 * boundary[ ii ];
+         for( dip::uint ii = 0; ii < nDims; ++ii ) {
+            bufferSizes[ ii ] += left[ ii ] + right[ ii ];
+            ranges[ ii ] = Range{ static_cast< dip::sint >( left[ ii ] ), static_cast< dip::sint >( left[ ii ] + sizes[ ii ] - 1 ) };
          }
       }
       input.SetSizes( bufferSizes );
       input.MatchStrideOrder( output );
       input.Forge(); // This forge will honor the strides we've set, the image does not have an external interface.
-      input.Protect(); // make sure it's not reforged by `ExtendImage` or `Copy`.
-      if( expandTensor || expandBoundary ) {
-         Option::ExtendImage options = Option::ExtendImage_Masked;
-         if( expandTensor ) {
-            options += Option::ExtendImage_ExpandTensor;
-         }
-         // TODO: Now that we've got `ExtendRegion`, we could expand boundaries unevenly, e.g. for shifted kernels.
-         DIP_STACK_TRACE_THIS( ExtendImage( cc_in, input, boundary, boundaryConditions, options ));
-      } else { // if( dataTypeChange )
-         input.Copy( cc_in );
+      Image window = input.At( ranges );
+      window.Protect(); // make sure it's not reforged by `ExpandTensor` or `Copy`.
+      if( expandTensor ) {
+         ExpandTensor( cc_in, window );
+      } else {
+         window.Copy( cc_in );
+      }
+      window.Protect( false );
+      if( expandBoundary ) {
+         DIP_STACK_TRACE_THIS( ExtendRegion( input, ranges, boundaryConditions ));
+      }
+      input = window;
+      // The strides of `input` could make a different processing dimension optimal
+      dip::uint newProcessingDim = OptimalProcessingDim( input, kernelSizes );
+      if( newProcessingDim != processingDim ) {
+         processingDim = newProcessingDim;
+         DIP_STACK_TRACE_THIS( pixelTable = kernel.PixelTable( nDims, processingDim ));
       }
-      input.Protect( false );
    } else {
       input = cc_in.QuickCopy();
    }
 
    // Create a pixel table suitable to be applied to `input`
-   dip::uint processingDim = OptimalProcessingDim( input, kernelSizes );
-   PixelTable pixelTable;
-   DIP_STACK_TRACE_THIS( pixelTable = kernel.PixelTable( sizes.size(), processingDim ));
    PixelTableOffsets pixelTableOffsets = pixelTable.Prepare( input );
 
    // Convert input and output to scalar images if needed -- add tensor dimension at end so `processingDim` is not affected.
@@ -133,6 +352,9 @@ void Full(
       input.TensorToSpatial();
       output.TensorToSpatial();
       sizes = input.Sizes();
+      nDims = sizes.size();
+      left.push_back( 0 );
+      right.push_back( 0 );
    }
 
    // Do we need an output buffer?
@@ -142,6 +364,45 @@ void Full(
    dip::uint lineLength = input.Size( processingDim );
    dip::uint nLines = input.NumberOfPixels() / lineLength; // this must be a round division
 
+   // The box of pixels that we process reading directly from `input`
+   RangeArray interiorRanges( nDims );
+   UnsignedArray interiorStart( nDims, 0 );
+   UnsignedArray interiorSizes = sizes;
+   if( useHalo ) {
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         if( sizes[ ii ] <= left[ ii ] + right[ ii ] ) {
+            interiorSizes[ ii ] = 0;
+         } else {
+            interiorStart[ ii ] = left[ ii ];
+            interiorSizes[ ii ] = sizes[ ii ] - left[ ii ] - right[ ii ];
+            interiorRanges[ ii ] = Range{ static_cast< dip::sint >( interiorStart[ ii ] ), static_cast< dip::sint >( interiorStart[ ii ] + interiorSizes[ ii ] - 1 ) };
+         }
+      }
+   }
+   dip::uint nInteriorLines = interiorSizes.product() / std::max( interiorSizes[ processingDim ], dip::uint( 1 ));
+   Image interiorInput;
+   Image interiorOutput;
+   if( nInteriorLines > 0 ) {
+      interiorInput = input.At( interiorRanges );
+      interiorOutput = output.At( interiorRanges );
+   }
+
+   // Size and origin of the halo buffer, which has the strides of `input`
+   dip::uint haloBufferLength = 0;
+   dip::uint haloOriginOffset = 0;
+   if( !tiles.empty() ) {
+      dip::sint lowest = 0;
+      dip::sint highest = 0;
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         dip::sint extent = static_cast< dip::sint >( maxHaloSizes[ ii ] - 1 ) * input.Stride( ii );
+         ( extent < 0 ? lowest : highest ) += extent;
+      }
+      dip::sint extent = static_cast< dip::sint >( input.TensorElements() - 1 ) * input.TensorStride();
+      ( extent < 0 ? lowest : highest ) += extent;
+      haloBufferLength = static_cast< dip::uint >( highest - lowest + 1 ) * input.DataType().SizeOf();
+      haloOriginOffset = static_cast< dip::uint >( -lowest ) * input.DataType().SizeOf();
+   }
+
    // Determine the number of threads we'll be using
    dip::uint nThreads = 1;
    if( opts != Full_NoMultiThreading ) {
@@ -150,63 +411,24 @@ void Full(
          dip::uint operations;
          DIP_STACK_TRACE_THIS( operations = nLines *
                lineFilter.GetNumberOfOperations( lineLength, input.TensorElements(), pixelTable.NumberOfPixels(), pixelTable.Runs().size() ));
-         // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-         if( operations < threadingThreshold ) {
-            nThreads = 1;
-         }
+         // Starting threads is only worth while if the work saved outweighs the cost of starting them
+         nThreads = OptimalNumberOfThreads( operations, nThreads );
       }
    }
 
    //std::cout << "Starting " << nThreads << " threads\n";
    DIP_STACK_TRACE_THIS( lineFilter.SetNumberOfThreads( nThreads, pixelTableOffsets ));
 
-   // Divide the image domain into nThreads chunks for split processing. The last chunk will have same or fewer
-   // image lines to process.
-   dip::uint nLinesPerThread = div_ceil( nLines, nThreads );
-   std::vector< UnsignedArray > startCoords( nThreads );
-   dip::uint nDims = sizes.size();
-   startCoords[ 0 ] = UnsignedArray( nDims, 0 );
-   for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-      startCoords[ ii ] = startCoords[ ii - 1 ];
-      // To advance the iterator nLinesPerThread times, we increment it in whole-line steps.
-      dip::uint firstDim = processingDim == 0 ? 1 : 0;
-      dip::uint remaining = nLinesPerThread;
-      do {
-         for( dip::uint dd = 0; dd < nDims; ++dd ) {
-            if( dd == firstDim ) {
-               dip::uint n = sizes[ dd ] - startCoords[ ii ][ dd ];
-               if( remaining >= n ) {
-                  // Rewinding, next loop iteration will increment the next coordinate
-                  remaining -= n;
-                  startCoords[ ii ][ dd ] = 0;
-               } else {
-                  // Forward by `remaining`, then we're done.
-                  startCoords[ ii ][ dd ] += remaining;
-                  remaining = 0;
-                  break;
-               }
-            } else if( dd != processingDim ) {
-               // Increment coordinate
-               ++startCoords[ ii ][ dd ];
-               // Check whether we reached the last pixel of the line
-               if( startCoords[ ii ][ dd ] < sizes[ dd ] ) {
-                  break;
-               }
-               // Rewind, the next loop iteration will increment the next coordinate
-               startCoords[ ii ][ dd ] = 0;
-            }
-         }
-      } while( remaining > 0 );
-   }
+   // Image lines and tiles are distributed dynamically among the threads
+   WorkDistributor interiorWork( nInteriorLines, nThreads );
+   WorkDistributor tileWork( tiles.size(), nThreads );
 
    // Start threads, each thread makes its own buffers
    AssertionError assertionError;
    ParameterError parameterError;
    RunTimeError runTimeError;
    Error error;
-   #pragma omp parallel num_threads( nThreads )
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num() );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) { try {
 
       // Create input buffer data struct
       FullBuffer inBuffer;
@@ -230,18 +452,19 @@ void Full(
          outBuffer.buffer = nullptr;
       }
 
-      // Loop over nLinesPerThread image lines
-      GenericJointImageIterator< 2 > it( { input, output }, processingDim );
-      it.SetCoordinates( startCoords[ thread ] );
+      UnsignedArray position( nDims, 0 );
       FullLineFilterParameters fullLineFilterParameters{
-            inBuffer, outBuffer, lineLength, processingDim, it.Coordinates(), pixelTableOffsets, thread
-      }; // Takes inBuffer, outBuffer, it.Coordinates(), pixelTableOffsets as references
-      for( dip::uint ii = 0; ( ii < nLinesPerThread ) && it; ++ii, ++it ) {
-         inBuffer.buffer = it.InPointer();
+            inBuffer, outBuffer, lineLength, processingDim, position, pixelTableOffsets, thread
+      }; // Takes inBuffer, outBuffer, position, pixelTableOffsets as references
+
+      // Filters `length` pixels, starting at `position`
+      auto filterLine = [ & ]( void* inPointer, void* outPointer, dip::uint length ) {
+         inBuffer.buffer = inPointer;
          if( !useOutBuffer ) {
             // Point output buffer to right line in output image
-            outBuffer.buffer = it.OutPointer();
+            outBuffer.buffer = outPointer;
          }
+         fullLineFilterParameters.bufferLength = length;
          // Filter the line
          lineFilter.Filter( fullLineFilterParameters );
          if( useOutBuffer ) {
@@ -251,13 +474,82 @@ void Full(
                   outBufferType,
                   outBuffer.stride,
                   outBuffer.tensorStride,
-                  it.OutPointer(),
+                  outPointer,
                   output.DataType(),
                   output.Stride( processingDim ),
                   output.TensorStride(),
-                  lineLength,
+                  length,
                   outBuffer.tensorLength );
          }
+      };
+
+      // Loop over chunks of image lines handed to us
+      dip::uint firstLine, lastLine;
+      if( nInteriorLines > 0 ) {
+         GenericJointImageIterator< 2 > it( { interiorInput, interiorOutput }, processingDim );
+         while( interiorWork.Next( thread, firstLine, lastLine )) {
+            it.SetCoordinates( LineStartCoordinates( interiorSizes, processingDim, firstLine ));
+            for( dip::uint ii = firstLine; ii < lastLine; ++ii, ++it ) {
+               position = it.Coordinates();
+               position += interiorStart;
+               filterLine( it.InPointer(), it.OutPointer(), interiorSizes[ processingDim ] );
+            }
+         }
+      }
+
+      // Loop over the tiles handed to us
+      if( !tiles.empty() ) {
+         std::vector< uint8 > haloBuffer( haloBufferLength );
+         Image haloImage( NonOwnedRefToDataSegment( haloBuffer.data() ), haloBuffer.data() + haloOriginOffset,
+                          input.DataType(), maxHaloSizes, input.Strides(), input.Tensor(), input.TensorStride() );
+         BoundaryConditionArray haloBoundaryConditions = boundaryConditions;
+         haloBoundaryConditions.resize( nDims, BoundaryCondition::DEFAULT ); // for the tensor dimension, if `asScalarImage`
+         RangeArray haloRanges( nDims );
+         RangeArray validRanges( nDims );
+         RangeArray inputRanges( nDims );
+         UnsignedArray haloPosition( nDims );
+         UnsignedArray offset( nDims );
+         dip::uint firstTile, lastTile;
+         while( tileWork.Next( thread, firstTile, lastTile )) {
+            for( dip::uint jj = firstTile; jj < lastTile; ++jj ) {
+               HaloTile const& tile = tiles[ jj ];
+               // Fill the halo: copy the image pixels under it, and extend them
+               for( dip::uint ii = 0; ii < nDims; ++ii ) {
+                  dip::sint haloStart = tile.haloStart[ ii ];
+                  dip::sint first = std::max( haloStart, dip::sint( 0 ));
+                  dip::sint last = std::min( haloStart + static_cast< dip::sint >( tile.haloSizes[ ii ] ), static_cast< dip::sint >( sizes[ ii ] )) - 1;
+                  haloRanges[ ii ] = Range{ 0, static_cast< dip::sint >( tile.haloSizes[ ii ] ) - 1 };
+                  validRanges[ ii ] = Range{ first - haloStart, last - haloStart };
+                  inputRanges[ ii ] = Range{ first, last };
+               }
+               Image halo = haloImage.At( haloRanges );
+               Image window = halo.At( validRanges );
+               window.Copy( input.At( inputRanges ));
+               ExtendRegion( halo, validRanges, haloBoundaryConditions );
+               // Filter the lines in the tile
+               offset.fill( 0 );
+               while( true ) {
+                  for( dip::uint ii = 0; ii < nDims; ++ii ) {
+                     position[ ii ] = tile.start[ ii ] + offset[ ii ];
+                     haloPosition[ ii ] = static_cast< dip::uint >( static_cast< dip::sint >( position[ ii ] ) - tile.haloStart[ ii ] );
+                  }
+                  filterLine( halo.Pointer( haloPosition ), output.Pointer( position ), tile.sizes[ processingDim ] );
+                  dip::uint ii = 0;
+                  for( ; ii < nDims; ++ii ) {
+                     if( ii == processingDim ) {
+                        continue;
+                     }
+                     if( ++offset[ ii ] < tile.sizes[ ii ] ) {
+                        break;
+                     }
+                     offset[ ii ] = 0;
+                  }
+                  if( ii == nDims ) {
+                     break;
+                  }
+               }
+            }
+         }
       }
    } catch( dip::AssertionError const& e ) {
       if( !assertionError.IsSet() ) {
@@ -284,7 +576,7 @@ void Full(
          runTimeError = dip::RunTimeError( stde.what() );
          DIP_ADD_STACK_TRACE( runTimeError );
       }
-   }
+   }} );
    if( assertionError.IsSet() ) {
       throw assertionError;
    }
@@ -301,3 +593,108 @@ void Full(
 
 } // namespace Framework
 } // namespace dip
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+namespace {
+
+// Writes, for each output pixel, a weighted sum over the neighborhood, where each neighbor has a different weight
+// if `weighted`, plus a value computed from the pixel's position, so that we can verify the buffers and positions
+// handed to the filter.
+class TestFullLineFilter : public dip::Framework::FullLineFilter {
+   public:
+      explicit TestFullLineFilter( bool weighted ) : weightStep_( weighted ? 0.5f : 0.0f ) {}
+      void SetNumberOfThreads( dip::uint, dip::PixelTableOffsets const& pixelTable ) override {
+         offsets_ = pixelTable.Offsets();
+      }
+      void Filter( dip::Framework::FullLineFilterParameters const& params ) override {
+         dip::sfloat const* in = static_cast< dip::sfloat const* >( params.inBuffer.buffer );
+         dip::sfloat* out = static_cast< dip::sfloat* >( params.outBuffer.buffer );
+         dip::sfloat offset = 0;
+         for( dip::uint ii = 0; ii < params.position.size(); ++ii ) {
+            offset += static_cast< dip::sfloat >(( ii + 1 ) * params.position[ ii ] );
+         }
+         for( dip::uint ii = 0; ii < params.bufferLength; ++ii ) {
+            for( dip::uint jj = 0; jj < params.inBuffer.tensorLength; ++jj ) {
+               dip::sfloat const* pin = in + static_cast< dip::sint >( jj ) * params.inBuffer.tensorStride;
+               dip::sfloat sum = 0;
+               dip::sfloat weight = 1;
+               for( auto o : offsets_ ) {
+                  sum += weight * pin[ o ];
+                  weight += weightStep_;
+               }
+               out[ static_cast< dip::sint >( jj ) * params.outBuffer.tensorStride ] = sum + offset;
+            }
+            in += params.inBuffer.stride;
+            out += params.outBuffer.stride;
+            offset += static_cast< dip::sfloat >( params.dimension + 1 );
+         }
+      }
+   private:
+      std::vector< dip::sint > offsets_;
+      dip::sfloat weightStep_;
+};
+
+// Applies `TestFullLineFilter` to `in`. If `in` is not of type SFLOAT, the framework copies the whole image.
+// The weighted sum depends on the processing dimension, which could be different if the image is copied.
+dip::Image TestFull(
+      dip::Image const& in,
+      dip::Kernel const& kernel,
+      dip::BoundaryCondition bc,
+      dip::Framework::FullOptions opts = {},
+      bool weighted = true
+) {
+   TestFullLineFilter lineFilter( weighted );
+   dip::Image out;
+   dip::Framework::Full( in, out, dip::DT_SFLOAT, dip::DT_SFLOAT, dip::DT_SFLOAT, in.TensorElements(), { bc }, kernel, lineFilter, opts );
+   return out;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the halo boundary handling in the full framework") {
+   dip::Image in( { 50, 40 }, 2, dip::DT_UINT16 );
+   in.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( in, in, random, 0.0, 1000.0 );
+   dip::Image inFloat = dip::Convert( in, dip::DT_SFLOAT );
+   dip::Image mask( { 4, 3 }, 1, dip::DT_BIN );
+   mask.Fill( 1 );
+   mask.At( 0, 0 ) = 0;
+   dip::Kernel evenKernel( mask );     // even-sized, different boundary sizes at the two ends
+   dip::Kernel shiftedKernel( dip::FloatArray{ 5, 3 }, "rectangular" );
+   shiftedKernel.Shift( { 3, -1 } );   // shifted, different boundary sizes at the two ends
+   dip::Kernel largeKernel( dip::FloatArray{ 61, 7 }, "rectangular" ); // larger than the image along x
+   for( auto bc : { dip::BoundaryCondition::SYMMETRIC_MIRROR, dip::BoundaryCondition::ASYMMETRIC_MIRROR,
+                    dip::BoundaryCondition::ADD_ZEROS, dip::BoundaryCondition::ZERO_ORDER_EXTRAPOLATE,
+                    dip::BoundaryCondition::FIRST_ORDER_EXTRAPOLATE, dip::BoundaryCondition::SECOND_ORDER_EXTRAPOLATE,
+                    dip::BoundaryCondition::THIRD_ORDER_EXTRAPOLATE }) {
+      for( auto const& kernel : { evenKernel, shiftedKernel, largeKernel } ) {
+         dip::Image expected = TestFull( in, kernel, bc ); // copies the whole image
+         DOCTEST_CHECK( dip::testing::CompareImages( TestFull( inFloat, kernel, bc ), expected ));
+         expected = TestFull( in, kernel, bc, dip::Framework::Full_AsScalarImage );
+         DOCTEST_CHECK( dip::testing::CompareImages( TestFull( inFloat, kernel, bc, dip::Framework::Full_AsScalarImage ), expected ));
+      }
+   }
+   // Non-standard strides, the processing dimension is different when copying the image
+   dip::Image tmp = in.Copy();
+   tmp.Mirror( { true, false } );
+   tmp.SwapDimensions( 0, 1 );
+   dip::Image tmpFloat = dip::Convert( tmp, dip::DT_SFLOAT );
+   dip::Kernel kernel( dip::FloatArray{ 5, 5 }, "elliptic" );
+   dip::Image expected = TestFull( tmp, kernel, dip::BoundaryCondition::SYMMETRIC_MIRROR, {}, false );
+   DOCTEST_CHECK( dip::testing::CompareImages( TestFull( tmpFloat, kernel, dip::BoundaryCondition::SYMMETRIC_MIRROR, {}, false ), expected ));
+   // 3D image
+   dip::Image in3( { 30, 20, 10 }, 1, dip::DT_UINT16 );
+   in3.Fill( 0 );
+   dip::UniformNoise( in3, in3, random, 0.0, 1000.0 );
+   dip::Kernel kernel3( dip::FloatArray{ 3, 5, 3 }, "rectangular" );
+   expected = TestFull( in3, kernel3, dip::BoundaryCondition::FIRST_ORDER_EXTRAPOLATE );
+   DOCTEST_CHECK( dip::testing::CompareImages( TestFull( dip::Convert( in3, dip::DT_SFLOAT ), kernel3, dip::BoundaryCondition::FIRST_ORDER_EXTRAPOLATE ), expected ));
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -324,30 +324,27 @@ void Scan(
          if( nThreads > 1 ) {
             dip::uint operations;
             DIP_STACK_TRACE_THIS( operations = lineLength * lineFilter.GetNumberOfOperations( nIn, nOut, ( nIn > 0 ? in[ 0 ] : out[ 0 ] ).TensorElements() ));
-            // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-            if( operations < threadingThreshold ) {
-               nThreads = 1;
-            }
+            // Starting threads is only worth while if the work saved outweighs the cost of starting them
+            nThreads = OptimalNumberOfThreads( operations, nThreads );
          }
       }
 
-      // Chunk size if we use threads
+      // Chunk size if we use threads: a few chunks per thread, so that the work can be balanced dynamically
       if( nThreads > 1 ) {
-         lineLength = bufferSize = div_ceil( lineLength, nThreads );
+         bufferSize = div_ceil( lineLength, nThreads * 4 );
       }
       // Chunk size if we'll be copying data to buffers
       if( needBuffers ) {
          if( bufferSize > MAX_BUFFER_SIZE ) {
-            // Divide each thread's work into equal chunks, smaller than MAX_BUFFER_SIZE
-            nLines = div_ceil( bufferSize, MAX_BUFFER_SIZE );
-            bufferSize = div_ceil( bufferSize, nLines );
+            // Divide the work into equal chunks, smaller than MAX_BUFFER_SIZE
+            bufferSize = div_ceil( bufferSize, div_ceil( bufferSize, MAX_BUFFER_SIZE ));
          }
       }
-      nLines *= nThreads;
+      nLines = div_ceil( lineLength, bufferSize );
 
       // Many of these variables have a slightly different (but equivalent) meaning if `scan1D`
-      // For example: `nLines` is the total number of chunks to process.
-      // `lineLength` is the number of pixels that each thread will process.
+      // For example: `nLines` is the total number of chunks to process, each of `bufferSize` pixels
+      // (except the last one).
 
    } else {
 
@@ -364,61 +361,15 @@ void Scan(
          if( nThreads > 1 ) {
             dip::uint operations;
             DIP_STACK_TRACE_THIS( operations = nLines * lineLength * lineFilter.GetNumberOfOperations( nIn, nOut, ( nIn > 0 ? in[ 0 ] : out[ 0 ] ).TensorElements()));
-            // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-            if( operations < threadingThreshold ) {
-               nThreads = 1;
-            }
+            // Starting threads is only worth while if the work saved outweighs the cost of starting them
+            nThreads = OptimalNumberOfThreads( operations, nThreads );
          }
       }
 
    }
 
-   // Divide the image domain into nThreads chunks for split processing. The last chunk will have same or fewer
-   // image lines to process.
-   dip::uint nLinesPerThread = div_ceil( nLines, nThreads );
-   std::vector< UnsignedArray > startCoords( nThreads );
-   if( scan1D ) {
-      startCoords[ 0 ] = UnsignedArray( 1, 0 );
-      for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-         startCoords[ ii ] = startCoords[ ii - 1 ];
-         startCoords[ ii ][ 0 ] += lineLength;        // `lineLength` in this case is the number of pixels per thread
-      }
-   } else {
-      dip::uint nDims = sizes.size();
-      startCoords[ 0 ] = UnsignedArray( nDims, 0 );
-      for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-         startCoords[ ii ] = startCoords[ ii - 1 ];
-         // To advance the iterator nLinesPerThread times, we increment it in whole-line steps.
-         dip::uint firstDim = processingDim == 0 ? 1 : 0;
-         dip::uint remaining = nLinesPerThread;
-         do {
-            for( dip::uint dd = 0; dd < nDims; ++dd ) {
-               if( dd == firstDim ) {
-                  dip::uint n = sizes[ dd ] - startCoords[ ii ][ dd ];
-                  if (remaining >= n) {
-                     // Rewinding, next loop iteration will increment the next coordinate
-                     remaining -= n;
-                     startCoords[ ii ][ dd ] = 0;
-                  } else {
-                     // Forward by `remaining`, then we're done.
-                     startCoords[ ii ][ dd ] += remaining;
-                     remaining = 0;
-                     break;
-                  }
-               } else if( dd != processingDim ) {
-                  // Increment coordinate
-                  ++startCoords[ ii ][ dd ];
-                  // Check whether we reached the last pixel of the line
-                  if( startCoords[ ii ][ dd ] < sizes[ dd ] ) {
-                     break;
-                  }
-                  // Rewind, the next loop iteration will increment the next coordinate
-                  startCoords[ ii ][ dd ] = 0;
-               }
-            }
-         } while( remaining > 0 );
-      }
-   }
+   // Image lines (or chunks if `scan1D`) are distributed dynamically among the threads
+   WorkDistributor work( nLines, nThreads );
 
    //std::cout << "Starting " << nThreads << " threads\n";
    DIP_STACK_TRACE_THIS( lineFilter.SetNumberOfThreads( nThreads ));
@@ -428,9 +379,7 @@ void Scan(
    ParameterError parameterError;
    RunTimeError runTimeError;
    Error error;
-   #pragma omp parallel num_threads( nThreads )
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num());
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) { try {
       std::vector< std::vector< uint8 >> buffers; // The outer one here is not a DimensionArray, because it won't delete() its contents
 
       // Create input buffer data structs and allocate buffers
@@ -498,120 +447,118 @@ void Scan(
       }
       */
 
-      UnsignedArray position = startCoords[ thread ];
+      UnsignedArray position( sizes.size(), 0 );
       ScanLineFilterParameters scanLineFilterParams{
             inBuffers, outBuffers, bufferSize, processingDim, position, tensorToSpatial, thread
       }; // Takes inBuffers, outBuffers, position as references
       IntegerArray inOffsets( nIn );
-      for( dip::uint ii = 0; ii < nIn; ++ii ) {
-         inOffsets[ ii ] = in[ ii ].Offset( position );
-      }
       IntegerArray outOffsets( nOut );
-      for( dip::uint ii = 0; ii < nOut; ++ii ) {
-         outOffsets[ ii ] = out[ ii ].Offset( position );
-      }
-      dip::uint lastCoord = 0;
-      if( scan1D ) {
-         lastCoord = position[ 0 ] + lineLength;
-         lastCoord = std::min( lastCoord, sizes[ 0 ] );
-      }
-
-      // Loop over nLinesPerThread image lines
-      for( dip::uint jj = 0; jj < nLinesPerThread ; ++jj ) {
 
-         // Make `bufferSize` smaller if it's the last chunk in a 1D image
+      // Loop over chunks of image lines handed to us
+      dip::uint firstLine, lastLine;
+      while( work.Next( thread, firstLine, lastLine )) {
+         // Find the first line of the chunk
          if( scan1D ) {
-            if( position[ 0 ] >= lastCoord ) { // This *should* not happen...
-               break;
-            }
-            scanLineFilterParams.bufferLength = std::min( bufferSize, lastCoord - position[ 0 ] );
+            position[ 0 ] = firstLine * bufferSize;
+         } else {
+            position = LineStartCoordinates( sizes, processingDim, firstLine );
          }
-
-         // Get pointers to input and output lines
          for( dip::uint ii = 0; ii < nIn; ++ii ) {
-            if( inUseBuffer[ ii ] ) {
-               // If inOffsets[ii] and is the same as in the previous iteration, we don't need
-               // to copy the buffer over again. This happens with singleton-expanded input images.
-               // But it's easier to copy, and also safer as the lineFilter function could be bad and write in its input!
-               detail::CopyBuffer(
-                     in[ ii ].Pointer( inOffsets[ ii ] ),
-                     in[ ii ].DataType(),
-                     in[ ii ].Stride( processingDim ),
-                     in[ ii ].TensorStride(),
-                     inBuffers[ ii ].buffer,
-                     inBufferTypes[ ii ],
-                     inBuffers[ ii ].stride,
-                     inBuffers[ ii ].tensorStride,
-                     scanLineFilterParams.bufferLength, // if stride == 0, only a single pixel will be copied, because they're all the same
-                     inBuffers[ ii ].tensorLength,
-                     lookUpTables[ ii ] );
-            } else {
-               inBuffers[ ii ].buffer = in[ ii ].Pointer( inOffsets[ ii ] );
-            }
+            inOffsets[ ii ] = in[ ii ].Offset( position );
          }
          for( dip::uint ii = 0; ii < nOut; ++ii ) {
-            if( !outUseBuffer[ ii ] ) {
-               outBuffers[ ii ].buffer = out[ ii ].Pointer( outOffsets[ ii ] );
-            }
+            outOffsets[ ii ] = out[ ii ].Offset( position );
          }
 
-         // Filter the line
-         lineFilter.Filter( scanLineFilterParams );
+         for( dip::uint jj = firstLine; jj < lastLine; ++jj ) {
 
-         // Copy back the line from output buffer to the image
-         for( dip::uint ii = 0; ii < nOut; ++ii ) {
-            if( outUseBuffer[ ii ] ) {
-               detail::CopyBuffer(
-                     outBuffers[ ii ].buffer,
-                     outBufferTypes[ ii ],
-                     outBuffers[ ii ].stride,
-                     outBuffers[ ii ].tensorStride,
-                     out[ ii ].Pointer( outOffsets[ ii ] ),
-                     out[ ii ].DataType(),
-                     out[ ii ].Stride( processingDim ),
-                     out[ ii ].TensorStride(),
-                     scanLineFilterParams.bufferLength,
-                     outBuffers[ ii ].tensorLength );
+            // Make `bufferSize` smaller if it's the last chunk in a 1D image
+            if( scan1D ) {
+               scanLineFilterParams.bufferLength = std::min( bufferSize, sizes[ 0 ] - position[ 0 ] );
             }
-         }
-
-         // Determine which line to process next until we're done
-         if( scan1D ) {
-            position[ 0 ] += bufferSize;
+            // Get pointers to input and output lines
             for( dip::uint ii = 0; ii < nIn; ++ii ) {
-               inOffsets[ ii ] += static_cast< dip::sint >( bufferSize ) * in[ ii ].Stride( 0 );
+               if( inUseBuffer[ ii ] ) {
+                  // If inOffsets[ii] and is the same as in the previous iteration, we don't need
+                  // to copy the buffer over again. This happens with singleton-expanded input images.
+                  // But it's easier to copy, and also safer as the lineFilter function could be bad and write in its input!
+                  detail::CopyBuffer(
+                        in[ ii ].Pointer( inOffsets[ ii ] ),
+                        in[ ii ].DataType(),
+                        in[ ii ].Stride( processingDim ),
+                        in[ ii ].TensorStride(),
+                        inBuffers[ ii ].buffer,
+                        inBufferTypes[ ii ],
+                        inBuffers[ ii ].stride,
+                        inBuffers[ ii ].tensorStride,
+                        scanLineFilterParams.bufferLength, // if stride == 0, only a single pixel will be copied, because they're all the same
+                        inBuffers[ ii ].tensorLength,
+                        lookUpTables[ ii ] );
+               } else {
+                  inBuffers[ ii ].buffer = in[ ii ].Pointer( inOffsets[ ii ] );
+               }
             }
             for( dip::uint ii = 0; ii < nOut; ++ii ) {
-               outOffsets[ ii ] += static_cast< dip::sint >( bufferSize ) * out[ ii ].Stride( 0 );
+               if( !outUseBuffer[ ii ] ) {
+                  outBuffers[ ii ].buffer = out[ ii ].Pointer( outOffsets[ ii ] );
+               }
             }
-         } else {
-            dip::uint dd;
-            for( dd = 0; dd < sizes.size(); dd++ ) {
-               if( dd != processingDim ) {
-                  ++position[ dd ];
-                  for( dip::uint ii = 0; ii < nIn; ++ii ) {
-                     inOffsets[ ii ] += in[ ii ].Stride( dd );
-                  }
-                  for( dip::uint ii = 0; ii < nOut; ++ii ) {
-                     outOffsets[ ii ] += out[ ii ].Stride( dd );
-                  }
-                  // Check whether we reached the last pixel of the line
-                  if( position[ dd ] != sizes[ dd ] ) {
-                     break;
-                  }
-                  // Rewind along this dimension
-                  for( dip::uint ii = 0; ii < nIn; ++ii ) {
-                     inOffsets[ ii ] -= static_cast< dip::sint >( position[ dd ] ) * in[ ii ].Stride( dd );
-                  }
-                  for( dip::uint ii = 0; ii < nOut; ++ii ) {
-                     outOffsets[ ii ] -= static_cast< dip::sint >( position[ dd ] ) * out[ ii ].Stride( dd );
-                  }
-                  position[ dd ] = 0;
-                  // Continue loop to increment along next dimension
+
+            // Filter the line
+            lineFilter.Filter( scanLineFilterParams );
+
+            // Copy back the line from output buffer to the image
+            for( dip::uint ii = 0; ii < nOut; ++ii ) {
+               if( outUseBuffer[ ii ] ) {
+                  detail::CopyBuffer(
+                        outBuffers[ ii ].buffer,
+                        outBufferTypes[ ii ],
+                        outBuffers[ ii ].stride,
+                        outBuffers[ ii ].tensorStride,
+                        out[ ii ].Pointer( outOffsets[ ii ] ),
+                        out[ ii ].DataType(),
+                        out[ ii ].Stride( processingDim ),
+                        out[ ii ].TensorStride(),
+                        scanLineFilterParams.bufferLength,
+                        outBuffers[ ii ].tensorLength );
                }
             }
-            if( dd == sizes.size()) {
-               break;            // We're done!
+
+            // Determine which line to process next until we're done
+            if( scan1D ) {
+               position[ 0 ] += bufferSize;
+               for( dip::uint ii = 0; ii < nIn; ++ii ) {
+                  inOffsets[ ii ] += static_cast< dip::sint >( bufferSize ) * in[ ii ].Stride( 0 );
+               }
+               for( dip::uint ii = 0; ii < nOut; ++ii ) {
+                  outOffsets[ ii ] += static_cast< dip::sint >( bufferSize ) * out[ ii ].Stride( 0 );
+               }
+            } else {
+               dip::uint dd;
+               for( dd = 0; dd < sizes.size(); dd++ ) {
+                  if( dd != processingDim ) {
+                     ++position[ dd ];
+                     for( dip::uint ii = 0; ii < nIn; ++ii ) {
+                        inOffsets[ ii ] += in[ ii ].Stride( dd );
+                     }
+                     for( dip::uint ii = 0; ii < nOut; ++ii ) {
+                        outOffsets[ ii ] += out[ ii ].Stride( dd );
+                     }
+                     // Check whether we reached the last pixel of the line
+                     if( position[ dd ] != sizes[ dd ] ) {
+                        break;
+                     }
+                     // Rewind along this dimension
+                     for( dip::uint ii = 0; ii < nIn; ++ii ) {
+                        inOffsets[ ii ] -= static_cast< dip::sint >( position[ dd ] ) * in[ ii ].Stride( dd );
+                     }
+                     for( dip::uint ii = 0; ii < nOut; ++ii ) {
+                        outOffsets[ ii ] -= static_cast< dip::sint >( position[ dd ] ) * out[ ii ].Stride( dd );
+                     }
+                     position[ dd ] = 0;
+                     // Continue loop to increment along next dimension
+                  }
+               }
             }
          }
       }
@@ -640,7 +587,7 @@ void Scan(
          runTimeError = dip::RunTimeError( stde.what() );
          DIP_ADD_STACK_TRACE( runTimeError );
       }
-   }
+   }} );
    if( assertionError.IsSet() ) {
       throw assertionError;
    }
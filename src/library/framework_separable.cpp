@@ -27,6 +27,32 @@
 namespace dip {
 namespace Framework {
 
+void SeparableLineFilter::FilterLines( SeparableLineFilterParameters const& params, SeparableLineBatch const& batch ) {
+   SeparableBuffer inBuffer = params.inBuffer;
+   SeparableBuffer outBuffer = params.outBuffer;
+   UnsignedArray position = params.position;
+   SeparableLineFilterParameters lineParams{
+         inBuffer, outBuffer, params.dimension, params.pass, params.nPasses, position, params.tensorToSpatial, params.thread
+   };
+   dip::sint sampleSize = static_cast< dip::sint >( batch.bufferType.SizeOf() );
+   for( dip::uint ii = 0; ii < batch.nLines; ++ii ) {
+      Filter( lineParams );
+      inBuffer.buffer = static_cast< uint8* >( inBuffer.buffer ) + batch.inLineStride * sampleSize;
+      outBuffer.buffer = static_cast< uint8* >( outBuffer.buffer ) + batch.outLineStride * sampleSize;
+      ++position[ batch.lineDimension ];
+   }
+}
+
+namespace {
+
+// Blocks of adjacent image lines are gathered into a buffer of about this many bytes (input and output together),
+// such that the buffers fit in the L2 cache. The block contains between `minBlockSize` and `maxBlockSize` lines.
+constexpr dip::uint blockBufferSize = 256 * 1024;
+constexpr dip::uint minBlockSize = 8;
+constexpr dip::uint maxBlockSize = 64;
+
+} // namespace
+
 void Separable(
       Image const& c_in,
       Image& c_out,
@@ -216,12 +242,10 @@ void Separable(
          }
          //std::cout << "lineLength = " << lineLength << ", nLines = " << nLines << ", operations = " << operations << std::endl;
       }
-      // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
+      // Starting threads is only worth while if the work saved outweighs the cost of starting them
       //std::cout << "GetNumberOfThreads() = " << GetNumberOfThreads() << ", maxNLines = " << maxNLines << ", operations = " << operations << std::endl;
-      if( operations >= threadingThreshold ) {
-         // We can't do more threads than the max, and we can't do more threads than lines we have to process
-         nThreads = std::min( GetNumberOfThreads(), maxNLines );
-      }
+      // We can't do more threads than the max, and we can't do more threads than lines we have to process
+      nThreads = OptimalNumberOfThreads( operations, std::min( GetNumberOfThreads(), maxNLines ));
       // Note that we pick the number of threads according to the dimension where most threads can be used.
       // It is possible that one dimension has fewer image lines than threads we're starting. We need to deal
       // with this below.
@@ -230,267 +254,319 @@ void Separable(
    //std::cout << "Starting " << nThreads << " threads\n";
    DIP_STACK_TRACE_THIS( lineFilter.SetNumberOfThreads( nThreads ));
 
-   // Some variables that need to be shared among threads
-   Image inImage;
-   Image outImage;
-   std::vector< UnsignedArray > startCoords( nThreads );
-   dip::uint nLinesPerThread;
+   // The temporary buffers, if needed, will be stored here (each thread their own!)
+   std::vector< std::vector< uint8 >> inBufferStorage( nThreads );
+   std::vector< std::vector< uint8 >> outBufferStorage( nThreads );
 
-   // Start threads, each thread makes its own buffers
    AssertionError assertionError;
    ParameterError parameterError;
    RunTimeError runTimeError;
    Error error;
-   #pragma omp parallel num_threads( nThreads )
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num());
-
-      // The temporary buffers, if needed, will be stored here (each thread their own!)
-      std::vector< uint8 > inBufferStorage;
-      std::vector< uint8 > outBufferStorage;
-
-      // Iterate over the dimensions to be processed. This loop should not parallelized!
-      for( dip::uint rep = 0; rep < order.size(); ++rep ) {
-         dip::uint processingDim = order[ rep ];
-
-         #pragma omp master
-         {
-            // First step always reads from input, other steps read from outImage, which is either intermediate or output
-            inImage = (( rep == 0 ) ? ( input ) : ( outImage )).QuickCopy();
-            // Last step always writes to output, other steps write to intermediate or output
-            UnsignedArray sizes = inImage.Sizes();
-            outImage = (( rep == order.size() - 1 ) ? ( output ) : ( useIntermediate ? intermediate : output )).QuickCopy();
-            sizes[ processingDim ] = outSizes[ processingDim ];
-            outImage.dip__SetSizes( sizes );
-
-            //std::cout << "dip::Framework::Separable(), processingDim = " << processingDim << std::endl;
-            //std::cout << "   inImage.Origin() = " << inImage.Origin() << std::endl;
-            //std::cout << "   inImage.Sizes() = " << inImage.Sizes() << std::endl;
-            //std::cout << "   inImage.Strides() = " << inImage.Strides() << std::endl;
-            //std::cout << "   outImage.Origin() = " << outImage.Origin() << std::endl;
-            //std::cout << "   outImage.Sizes() = " << outImage.Sizes() << std::endl;
-            //std::cout << "   outImage.Strides() = " << outImage.Strides() << std::endl;
-
-            // Divide the image domain into nThreads chunks for split processing. The last chunk will have same or fewer
-            // image lines to process.
-            nLinesPerThread = div_ceil( inImage.NumberOfPixels() / inSizes[ processingDim ], nThreads );
-            DIP_ASSERT( nLinesPerThread == div_ceil( outImage.NumberOfPixels() / outSizes[ processingDim ], nThreads ));
-            startCoords[ 0 ] = UnsignedArray( nDims, 0 );
-            for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-               startCoords[ ii ] = startCoords[ ii - 1 ];
-               // To advance the iterator nLinesPerThread times, we increment it in whole-line steps.
-               dip::uint firstDim = processingDim == 0 ? 1 : 0;
-               dip::uint remaining = nLinesPerThread;
-               do {
-                  for( dip::uint dd = 0; dd < nDims; ++dd ) {
-                     if( dd == firstDim ) {
-                        dip::uint n = sizes[ dd ] - startCoords[ ii ][ dd ];
-                        if (remaining >= n) {
-                           // Rewinding, next loop iteration will increment the next coordinate
-                           remaining -= n;
-                           startCoords[ ii ][ dd ] = 0;
-                        } else {
-                           // Forward by `remaining`, then we're done.
-                           startCoords[ ii ][ dd ] += remaining;
-                           remaining = 0;
-                           break;
-                        }
-                     } else if( dd != processingDim ) {
-                        // Increment coordinate
-                        ++startCoords[ ii ][ dd ];
-                        // Check whether we reached the last pixel of the line
-                        if( startCoords[ ii ][ dd ] < sizes[ dd ] ) {
-                           break;
-                        }
-                        // Rewind, the next loop iteration will increment the next coordinate
-                        startCoords[ ii ][ dd ] = 0;
-                     }
-                  }
-               } while( remaining > 0 );
-               // If we went past the last line to process, set startCoords to an empty array, the corresponding
-               // thread will not do any work. This situation arises when there are fewer image lines than threads
-               // along this dimension.
-               for( dip::uint jj = 0; jj < sizes.size(); ++jj ) {
-                  if( startCoords[ ii ][ jj ] >= sizes[ jj ] ) {
-                     startCoords[ ii ] = {}; //
-                     break;
-                  }
-               }
-               // If we have set startCoords to an empty array, the next ones will all also be empty.
-               if( startCoords[ ii ].empty() ) {
-                  for( ; ii < nThreads; ++ii ) {
-                     startCoords[ ii ] = {};
-                  }
-                  break;
-               }
-            }
-            //for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-            //   std::cout << "   startCoords[ " << ii << " ] = " << startCoords[ ii ] << std::endl;
-            //}
+
+   // Iterate over the dimensions to be processed. This loop should not parallelized!
+   Image outImage;
+   for( dip::uint rep = 0; rep < order.size(); ++rep ) {
+      dip::uint processingDim = order[ rep ];
+
+      // First step always reads from input, other steps read from outImage, which is either intermediate or output
+      Image inImage = (( rep == 0 ) ? ( input ) : ( outImage )).QuickCopy();
+      // Last step always writes to output, other steps write to intermediate or output
+      UnsignedArray sizes = inImage.Sizes();
+      outImage = (( rep == order.size() - 1 ) ? ( output ) : ( useIntermediate ? intermediate : output )).QuickCopy();
+      sizes[ processingDim ] = outSizes[ processingDim ];
+      outImage.dip__SetSizes( sizes );
+
+      //std::cout << "dip::Framework::Separable(), processingDim = " << processingDim << std::endl;
+      //std::cout << "   inImage.Origin() = " << inImage.Origin() << std::endl;
+      //std::cout << "   inImage.Sizes() = " << inImage.Sizes() << std::endl;
+      //std::cout << "   inImage.Strides() = " << inImage.Strides() << std::endl;
+      //std::cout << "   outImage.Origin() = " << outImage.Origin() << std::endl;
+      //std::cout << "   outImage.Sizes() = " << outImage.Sizes() << std::endl;
+      //std::cout << "   outImage.Strides() = " << outImage.Strides() << std::endl;
+
+      // Image lines are distributed dynamically among the threads. If there are fewer image lines than
+      // threads along this dimension, some threads will not do any work.
+      dip::uint nLines = inImage.NumberOfPixels() / inSizes[ processingDim ];
+      DIP_ASSERT( nLines == outImage.NumberOfPixels() / outSizes[ processingDim ] );
+      WorkDistributor work( nLines, nThreads );
+
+      // Start threads, each thread uses its own buffers
+      ParallelExecute( nThreads, [ & ]( dip::uint thread ) { try {
+         // Some values to use during this iteration
+         dip::uint inLength = inSizes[ processingDim ];
+         DIP_ASSERT( inLength == inImage.Size( processingDim ));
+         dip::uint inBorder = border[ processingDim ];
+         dip::uint outLength = outSizes[ processingDim ];
+         dip::uint outBorder = opts == Separable_UseOutputBorder ? inBorder : 0;
+
+         // Determine if we need to make a temporary buffer for this dimension
+         bool inUseBuffer = ( inImage.DataType() != bufferType ) || !lookUpTable.empty() || ( inBorder > 0 ) || ( opts == Separable_UseInputBuffer );
+         bool outUseBuffer = ( outImage.DataType() != bufferType ) || ( outBorder > 0 );
+         if( !outUseBuffer && ( opts == Separable_UseOutputBuffer )) {
+            // We can cheat a little here if UseOutputBuffer is given: if the samples are contiguous, there's no need to actually use the buffer.
+            outUseBuffer = !((( outImage.TensorElements() == 1 ) || ( outImage.TensorStride() == 1 ))
+                  && ( outImage.Stride( processingDim ) == static_cast< dip::sint >( outImage.TensorElements())));
+         }
+         if( !inUseBuffer && !outUseBuffer && ( inImage.Origin() == outImage.Origin() )) {
+            // If input and output images are the same, we need to use at least one buffer!
+            inUseBuffer = true;
          }
-         #pragma omp barrier
-
-         if( !startCoords[ thread ].empty() ) {
-
-            // Some values to use during this iteration
-            dip::uint inLength = inSizes[ processingDim ];
-            DIP_ASSERT( inLength == inImage.Size( processingDim ));
-            dip::uint inBorder = border[ processingDim ];
-            dip::uint outLength = outSizes[ processingDim ];
-            dip::uint outBorder = opts == Separable_UseOutputBorder ? inBorder : 0;
-
-            // Determine if we need to make a temporary buffer for this dimension
-            bool inUseBuffer = ( inImage.DataType() != bufferType ) || !lookUpTable.empty() || ( inBorder > 0 ) || ( opts == Separable_UseInputBuffer );
-            bool outUseBuffer = ( outImage.DataType() != bufferType ) || ( outBorder > 0 );
-            if( !outUseBuffer && ( opts == Separable_UseOutputBuffer )) {
-               // We can cheat a little here if UseOutputBuffer is given: if the samples are contiguous, there's no need to actually use the buffer.
-               outUseBuffer = !((( outImage.TensorElements() == 1 ) || ( outImage.TensorStride() == 1 ))
-                     && ( outImage.Stride( processingDim ) == static_cast< dip::sint >( outImage.TensorElements())));
-            }
-            if( !inUseBuffer && !outUseBuffer && ( inImage.Origin() == outImage.Origin() )) {
-               // If input and output images are the same, we need to use at least one buffer!
-               inUseBuffer = true;
-            }
 
-            // Create buffer data structs and (re-)allocate buffers
-            SeparableBuffer inBuffer;
-            inBuffer.length = inLength;
-            inBuffer.border = inBorder;
-            if( inUseBuffer ) {
-               if( lookUpTable.empty()) {
-                  inBuffer.tensorLength = inImage.TensorElements();
-               } else {
-                  inBuffer.tensorLength = lookUpTable.size();
-               }
-               inBuffer.tensorStride = 1;
-               if( inImage.Stride( processingDim ) == 0 ) {
-                  // A stride of 0 means all pixels are the same, allocate space for a single pixel
-                  inBuffer.stride = 0;
-                  inBufferStorage.resize( bufferType.SizeOf() * inBuffer.tensorLength );
-                  //std::cout << "   Using input buffer, stride = 0\n";
-               } else {
-                  inBuffer.stride = static_cast< dip::sint >( inBuffer.tensorLength );
-                  inBufferStorage.resize(( inLength + 2 * inBorder ) * bufferType.SizeOf() * inBuffer.tensorLength );
-                  //std::cout << "   Using input buffer, size = " << inBufferStorage.size() << std::endl;
-               }
-               inBuffer.buffer = inBufferStorage.data() + inBorder * bufferType.SizeOf() * inBuffer.tensorLength;
-            } else {
+         // Create buffer data structs and (re-)allocate buffers
+         SeparableBuffer inBuffer;
+         inBuffer.length = inLength;
+         inBuffer.border = inBorder;
+         if( inUseBuffer ) {
+            if( lookUpTable.empty()) {
                inBuffer.tensorLength = inImage.TensorElements();
-               inBuffer.tensorStride = inImage.TensorStride();
-               inBuffer.stride = inImage.Stride( processingDim );
-               inBuffer.buffer = nullptr;
-               //std::cout << "   Not using input buffer\n";
+            } else {
+               inBuffer.tensorLength = lookUpTable.size();
+            }
+            inBuffer.tensorStride = 1;
+            if( inImage.Stride( processingDim ) == 0 ) {
+               // A stride of 0 means all pixels are the same, allocate space for a single pixel
+               inBuffer.stride = 0;
+               inBufferStorage[ thread ].resize( bufferType.SizeOf() * inBuffer.tensorLength );
+               //std::cout << "   Using input buffer, stride = 0\n";
+            } else {
+               inBuffer.stride = static_cast< dip::sint >( inBuffer.tensorLength );
+               inBufferStorage[ thread ].resize(( inLength + 2 * inBorder ) * bufferType.SizeOf() * inBuffer.tensorLength );
+               //std::cout << "   Using input buffer, size = " << inBufferStorage[ thread ].size() << std::endl;
             }
-            SeparableBuffer outBuffer;
-            outBuffer.length = outLength;
-            outBuffer.border = outBorder;
-            outBuffer.tensorLength = outImage.TensorElements();
+            inBuffer.buffer = inBufferStorage[ thread ].data() + inBorder * bufferType.SizeOf() * inBuffer.tensorLength;
+         } else {
+            inBuffer.tensorLength = inImage.TensorElements();
+            inBuffer.tensorStride = inImage.TensorStride();
+            inBuffer.stride = inImage.Stride( processingDim );
+            inBuffer.buffer = nullptr;
+            //std::cout << "   Not using input buffer\n";
+         }
+         SeparableBuffer outBuffer;
+         outBuffer.length = outLength;
+         outBuffer.border = outBorder;
+         outBuffer.tensorLength = outImage.TensorElements();
+         if( outUseBuffer ) {
+            outBuffer.tensorStride = 1;
+            outBuffer.stride = static_cast< dip::sint >( outBuffer.tensorLength );
+            outBufferStorage[ thread ].resize(( outLength + 2 * outBorder ) * bufferType.SizeOf() * outBuffer.tensorLength );
+            outBuffer.buffer = outBufferStorage[ thread ].data() + outBorder * bufferType.SizeOf() * outBuffer.tensorLength;
+            //std::cout << "   Using output buffer, size = " << outBufferStorage[ thread ].size() << std::endl;
+         } else {
+            outBuffer.tensorStride = outImage.TensorStride();
+            outBuffer.stride = outImage.Stride( processingDim );
+            outBuffer.buffer = nullptr;
+            //std::cout << "   Not using output buffer\n";
+         }
+
+         // Lines are adjacent in memory along the first dimension not being processed, as that is the dimension
+         // the iterator walks along first. If the processing dimension has a larger stride, we process blocks of
+         // adjacent lines, which we can read and write in a cache-friendly manner.
+         dip::uint lineDim = processingDim == 0 ? 1 : 0;
+         dip::uint blockSize = 1;
+         if(( lineDim < inImage.Dimensionality() ) && ( inImage.Size( lineDim ) > 1 ) && ( inImage.Stride( lineDim ) != 0 ) &&
+            ( std::abs( inImage.Stride( processingDim )) > std::abs( inImage.Stride( lineDim )))) {
+            dip::uint lineBytes = (( inLength + 2 * inBorder ) * ( lookUpTable.empty() ? inImage.TensorElements() : lookUpTable.size() ) +
+                                   ( outLength + 2 * outBorder ) * outImage.TensorElements() ) * bufferType.SizeOf();
+            blockSize = clamp( blockBufferSize / lineBytes, minBlockSize, maxBlockSize );
+            blockSize = std::min( blockSize, inImage.Size( lineDim ));
+         }
+
+         if( blockSize > 1 ) {
+            // Blocked processing: each block of lines is copied into a buffer with one line after the other
+            dip::uint sampleSize = bufferType.SizeOf();
+            inBuffer.tensorLength = lookUpTable.empty() ? inImage.TensorElements() : lookUpTable.size();
+            inBuffer.tensorStride = 1;
+            inBuffer.stride = static_cast< dip::sint >( inBuffer.tensorLength );
+            dip::uint inLineLength = ( inLength + 2 * inBorder ) * inBuffer.tensorLength;
+            inBufferStorage[ thread ].resize( blockSize * inLineLength * sampleSize );
+            uint8* inBlock = inBufferStorage[ thread ].data() + inBorder * inBuffer.tensorLength * sampleSize;
+            inBuffer.buffer = inBlock;
+            SeparableLineBatch batch{ 0, static_cast< dip::sint >( inLineLength ), 0, lineDim, bufferType };
+            uint8* outBlock = nullptr;
             if( outUseBuffer ) {
-               outBuffer.tensorStride = 1;
-               outBuffer.stride = static_cast< dip::sint >( outBuffer.tensorLength );
-               outBufferStorage.resize(( outLength + 2 * outBorder ) * bufferType.SizeOf() * outBuffer.tensorLength );
-               outBuffer.buffer = outBufferStorage.data() + outBorder * bufferType.SizeOf() * outBuffer.tensorLength;
-               //std::cout << "   Using output buffer, size = " << outBufferStorage.size() << std::endl;
+               dip::uint outLineLength = ( outLength + 2 * outBorder ) * outBuffer.tensorLength;
+               outBufferStorage[ thread ].resize( blockSize * outLineLength * sampleSize );
+               outBlock = outBufferStorage[ thread ].data() + outBorder * outBuffer.tensorLength * sampleSize;
+               outBuffer.buffer = outBlock;
+               batch.outLineStride = static_cast< dip::sint >( outLineLength );
             } else {
-               outBuffer.tensorStride = outImage.TensorStride();
-               outBuffer.stride = outImage.Stride( processingDim );
-               outBuffer.buffer = nullptr;
-               //std::cout << "   Not using output buffer\n";
+               batch.outLineStride = outImage.Stride( lineDim );
             }
+            dip::sint inPixelStep = inImage.Stride( processingDim ) * static_cast< dip::sint >( inImage.DataType().SizeOf() );
+            dip::sint outPixelStep = outImage.Stride( processingDim ) * static_cast< dip::sint >( outImage.DataType().SizeOf() );
+            dip::uint inBufferPixelStep = inBuffer.tensorLength * sampleSize;
+            dip::uint outBufferPixelStep = outBuffer.tensorLength * sampleSize;
+
+            // Loop over chunks of image lines handed to us
+            GenericJointImageIterator< 2 > it( { inImage, outImage }, processingDim );
+            SeparableLineFilterParameters separableLineFilterParams{
+                  inBuffer, outBuffer, processingDim, rep, order.size(), it.Coordinates(), tensorToSpatial, thread
+            }; // Takes inBuffer, outBuffer, it.Coordinates() as references
+            dip::uint firstLine, lastLine;
+            while( work.Next( thread, firstLine, lastLine )) {
+               it.SetCoordinates( LineStartCoordinates( inImage.Sizes(), processingDim, firstLine ));
+               dip::uint ii = firstLine;
+               while( ii < lastLine ) {
+                  // The block cannot extend past the end of the image along `lineDim`
+                  batch.nLines = std::min( std::min( blockSize, lastLine - ii ), inImage.Size( lineDim ) - it.Coordinates()[ lineDim ] );
+                  // Copy the input lines into the buffer, one pixel position at the time
+                  uint8 const* inPtr = static_cast< uint8 const* >( it.InPointer() );
+                  for( dip::uint jj = 0; jj < inLength; ++jj ) {
+                     detail::CopyBuffer(
+                           inPtr,
+                           inImage.DataType(),
+                           inImage.Stride( lineDim ),
+                           inImage.TensorStride(),
+                           inBlock + jj * inBufferPixelStep,
+                           bufferType,
+                           batch.inLineStride,
+                           inBuffer.tensorStride,
+                           batch.nLines,
+                           inBuffer.tensorLength,
+                           lookUpTable );
+                     inPtr += inPixelStep;
+                  }
+                  if( inBorder > 0 ) {
+                     for( dip::uint kk = 0; kk < batch.nLines; ++kk ) {
+                        detail::ExpandBuffer(
+                              inBlock + kk * inLineLength * sampleSize,
+                              bufferType,
+                              inBuffer.stride,
+                              inBuffer.tensorStride,
+                              inLength,
+                              inBuffer.tensorLength,
+                              inBorder,
+                              inBorder,
+                              boundaryConditions[ processingDim ] );
+                     }
+                  }
+                  if( !outUseBuffer ) {
+                     outBuffer.buffer = it.OutPointer();
+                  }
 
-            // Loop over nLinesPerThread image lines
+                  // Filter the lines
+                  lineFilter.FilterLines( separableLineFilterParams, batch );
+
+                  // Copy the output lines from the buffer to the image, one pixel position at the time
+                  if( outUseBuffer ) {
+                     uint8* outPtr = static_cast< uint8* >( it.OutPointer() );
+                     for( dip::uint jj = 0; jj < outLength; ++jj ) {
+                        detail::CopyBuffer(
+                              outBlock + jj * outBufferPixelStep,
+                              bufferType,
+                              batch.outLineStride,
+                              outBuffer.tensorStride,
+                              outPtr,
+                              outImage.DataType(),
+                              outImage.Stride( lineDim ),
+                              outImage.TensorStride(),
+                              batch.nLines,
+                              outBuffer.tensorLength );
+                        outPtr += outPixelStep;
+                     }
+                  }
+                  for( dip::uint kk = 0; kk < batch.nLines; ++kk ) {
+                     ++it;
+                  }
+                  ii += batch.nLines;
+               }
+            }
+         } else {
+            // Loop over chunks of image lines handed to us
             GenericJointImageIterator< 2 > it( { inImage, outImage }, processingDim );
-            it.SetCoordinates( startCoords[ thread ] );
             SeparableLineFilterParameters separableLineFilterParams{
                   inBuffer, outBuffer, processingDim, rep, order.size(), it.Coordinates(), tensorToSpatial, thread
             }; // Takes inBuffer, outBuffer, it.Coordinates() as references
-            for( dip::uint ii = 0; ( ii < nLinesPerThread ) && it; ++ii, ++it ) {
-               // Get pointers to input and output lines
-               if( inUseBuffer ) {
-                  detail::CopyBuffer(
-                        it.InPointer(),
-                        inImage.DataType(),
-                        inImage.Stride( processingDim ),
-                        inImage.TensorStride(),
-                        inBuffer.buffer,
-                        bufferType,
-                        inBuffer.stride,
-                        inBuffer.tensorStride,
-                        inLength, // if stride == 0, only a single pixel will be copied, because they're all the same
-                        inBuffer.tensorLength,
-                        lookUpTable );
-                  if(( inBorder > 0 ) && ( inBuffer.stride != 0 )) {
-                     detail::ExpandBuffer(
+            dip::uint firstLine, lastLine;
+            while( work.Next( thread, firstLine, lastLine )) {
+               it.SetCoordinates( LineStartCoordinates( inImage.Sizes(), processingDim, firstLine ));
+               for( dip::uint ii = firstLine; ii < lastLine; ++ii, ++it ) {
+                  // Get pointers to input and output lines
+                  if( inUseBuffer ) {
+                     detail::CopyBuffer(
+                           it.InPointer(),
+                           inImage.DataType(),
+                           inImage.Stride( processingDim ),
+                           inImage.TensorStride(),
                            inBuffer.buffer,
                            bufferType,
                            inBuffer.stride,
                            inBuffer.tensorStride,
-                           inLength,
+                           inLength, // if stride == 0, only a single pixel will be copied, because they're all the same
                            inBuffer.tensorLength,
-                           inBorder,
-                           inBorder,
-                           boundaryConditions[ processingDim ] );
+                           lookUpTable );
+                     if(( inBorder > 0 ) && ( inBuffer.stride != 0 )) {
+                        detail::ExpandBuffer(
+                              inBuffer.buffer,
+                              bufferType,
+                              inBuffer.stride,
+                              inBuffer.tensorStride,
+                              inLength,
+                              inBuffer.tensorLength,
+                              inBorder,
+                              inBorder,
+                              boundaryConditions[ processingDim ] );
+                     }
+                  } else {
+                     inBuffer.buffer = it.InPointer();
                   }
-               } else {
-                  inBuffer.buffer = it.InPointer();
-               }
-               if( !outUseBuffer ) {
-                  outBuffer.buffer = it.OutPointer();
-               }
+                  if( !outUseBuffer ) {
+                     outBuffer.buffer = it.OutPointer();
+                  }
+
+                  // Filter the line
+                  lineFilter.Filter( separableLineFilterParams );
 
-               // Filter the line
-               lineFilter.Filter( separableLineFilterParams );
-
-               // Copy back the line from output buffer to the image
-               if( outUseBuffer ) {
-                  detail::CopyBuffer(
-                        outBuffer.buffer,
-                        bufferType,
-                        outBuffer.stride,
-                        outBuffer.tensorStride,
-                        it.OutPointer(),
-                        outImage.DataType(),
-                        outImage.Stride( processingDim ),
-                        outImage.TensorStride(),
-                        outLength,
-                        outBuffer.tensorLength );
+                  // Copy back the line from output buffer to the image
+                  if( outUseBuffer ) {
+                     detail::CopyBuffer(
+                           outBuffer.buffer,
+                           bufferType,
+                           outBuffer.stride,
+                           outBuffer.tensorStride,
+                           it.OutPointer(),
+                           outImage.DataType(),
+                           outImage.Stride( processingDim ),
+                           outImage.TensorStride(),
+                           outLength,
+                           outBuffer.tensorLength );
+                  }
                }
             }
          }
-
-         // Wait to start the next iteration until all threads have finished their work
-         #pragma omp barrier
-
-         // Clear the tensor look-up table: if it was defined, then the intermediate data now has a full matrix
-         // as tensor shape and we don't need it any more.
-         #pragma omp master
-         lookUpTable.clear();
-      }
-   } catch( dip::AssertionError const& e ) {
-      if( !assertionError.IsSet() ) {
-         assertionError = e;
-         DIP_ADD_STACK_TRACE( assertionError );
-      }
-   } catch( dip::ParameterError const& e ) {
-      if( !parameterError.IsSet() ) {
-         parameterError = e;
-         DIP_ADD_STACK_TRACE( parameterError );
-      }
-   } catch( dip::RunTimeError const& e ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = e;
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   } catch( dip::Error const& e ) {
-      if( !error.IsSet() ) {
-         error = e;
-         DIP_ADD_STACK_TRACE( error );
-      }
-   } catch( std::exception const& stde ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = dip::RunTimeError( stde.what() );
-         DIP_ADD_STACK_TRACE( runTimeError );
+      } catch( dip::AssertionError const& e ) {
+         if( !assertionError.IsSet() ) {
+            assertionError = e;
+            DIP_ADD_STACK_TRACE( assertionError );
+         }
+      } catch( dip::ParameterError const& e ) {
+         if( !parameterError.IsSet() ) {
+            parameterError = e;
+            DIP_ADD_STACK_TRACE( parameterError );
+         }
+      } catch( dip::RunTimeError const& e ) {
+         if( !runTimeError.IsSet() ) {
+            runTimeError = e;
+            DIP_ADD_STACK_TRACE( runTimeError );
+         }
+      } catch( dip::Error const& e ) {
+         if( !error.IsSet() ) {
+            error = e;
+            DIP_ADD_STACK_TRACE( error );
+         }
+      } catch( std::exception const& stde ) {
+         if( !runTimeError.IsSet() ) {
+            runTimeError = dip::RunTimeError( stde.what() );
+            DIP_ADD_STACK_TRACE( runTimeError );
+         }
+      }} );
+      if( assertionError.IsSet() || parameterError.IsSet() || runTimeError.IsSet() || error.IsSet() ) {
+         break;
       }
+
+      // Clear the tensor look-up table: if it was defined, then the intermediate data now has a full matrix
+      // as tensor shape and we don't need it any more.
+      lookUpTable.clear();
    }
    if( assertionError.IsSet() ) {
       throw assertionError;
@@ -508,3 +584,99 @@ void Separable(
 
 } // namespace Framework
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/iterators.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+namespace {
+
+// Writes, for each output pixel, the sum of the input pixel and its two neighbors (using the border), plus
+// a value computed from the line's position, so that we can verify the buffers and positions handed to the filter.
+class TestLineFilter : public dip::Framework::SeparableLineFilter {
+   public:
+      explicit TestLineFilter( bool addPosition ) : addPosition_( addPosition ) {}
+      void Filter( dip::Framework::SeparableLineFilterParameters const& params ) override {
+         dip::sfloat const* in = static_cast< dip::sfloat const* >( params.inBuffer.buffer );
+         dip::sfloat* out = static_cast< dip::sfloat* >( params.outBuffer.buffer );
+         dip::sint inStride = params.inBuffer.stride;
+         dip::sint outStride = params.outBuffer.stride;
+         dip::sfloat offset = addPosition_ ? PositionValue( params.position ) : 0.0f;
+         for( dip::uint ii = 0; ii < params.inBuffer.length; ++ii ) {
+            *out = in[ -inStride ] + in[ 0 ] + in[ inStride ] + offset;
+            in += inStride;
+            out += outStride;
+         }
+      }
+      void FilterLines( dip::Framework::SeparableLineFilterParameters const& params, dip::Framework::SeparableLineBatch const& batch ) override {
+         maxBatchSize = std::max( maxBatchSize, batch.nLines );
+         SeparableLineFilter::FilterLines( params, batch );
+      }
+      static dip::sfloat PositionValue( dip::UnsignedArray const& position ) {
+         return static_cast< dip::sfloat >( position[ 0 ] + 100 * position[ 1 ] + 10000 * position[ 2 ] );
+      }
+      dip::uint maxBatchSize = 0;
+   private:
+      bool addPosition_;
+};
+
+// Applies what `TestLineFilter` does along dimension `dim`, using the "zero order" boundary condition.
+dip::Image TestLineFilterReference( dip::Image const& in, dip::uint dim, bool addPosition ) {
+   dip::Image out = in.Copy();
+   dip::ImageIterator< dip::sfloat > it( out, dim );
+   do {
+      dip::UnsignedArray position = it.Coordinates();
+      dip::sfloat offset = addPosition ? TestLineFilter::PositionValue( position ) : 0.0f;
+      dip::uint size = in.Size( dim );
+      for( dip::uint ii = 0; ii < size; ++ii ) {
+         position[ dim ] = ii == 0 ? 0 : ii - 1;
+         dip::sfloat left = in.At< dip::sfloat >( position );
+         position[ dim ] = ii;
+         dip::sfloat middle = in.At< dip::sfloat >( position );
+         position[ dim ] = ii == size - 1 ? ii : ii + 1;
+         dip::sfloat right = in.At< dip::sfloat >( position );
+         position[ dim ] = ii;
+         out.At( position ) = left + middle + right + offset;
+      }
+   } while( ++it );
+   return out;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the blocked processing in the separable framework") {
+   dip::Image in( { 40, 30, 20 }, 1, dip::DT_UINT16 );
+   in.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( in, in, random, 0.0, 1000.0 );
+   dip::Image inFloat = dip::Convert( in, dip::DT_SFLOAT );
+   dip::BoundaryConditionArray bc{ dip::BoundaryCondition::ZERO_ORDER_EXTRAPOLATE };
+   // Individual dimensions, checking the line positions
+   for( dip::uint dim = 0; dim < 3; ++dim ) {
+      dip::BooleanArray process( 3, false );
+      process[ dim ] = true;
+      TestLineFilter lineFilter( true );
+      dip::Image out;
+      dip::Framework::Separable( in, out, dip::DT_SFLOAT, dip::DT_SFLOAT, process, { 1 }, bc, lineFilter );
+      DOCTEST_CHECK( ( lineFilter.maxBatchSize > 1 ) == ( dim > 0 ));
+      DOCTEST_CHECK( dip::testing::CompareImages( out, TestLineFilterReference( inFloat, dim, true )));
+   }
+   // All dimensions
+   dip::Image expected = TestLineFilterReference( inFloat, 0, false );
+   expected = TestLineFilterReference( expected, 1, false );
+   expected = TestLineFilterReference( expected, 2, false );
+   TestLineFilter lineFilter( false );
+   dip::Image out;
+   dip::Framework::Separable( in, out, dip::DT_SFLOAT, dip::DT_SFLOAT, {}, { 1 }, bc, lineFilter );
+   DOCTEST_CHECK( dip::testing::CompareImages( out, expected ));
+   // Output of a different type than the buffer, and in-place operation
+   out = dip::Convert( in, dip::DT_SINT32 );
+   dip::Framework::Separable( out, out, dip::DT_SFLOAT, dip::DT_SINT32, {}, { 1 }, bc, lineFilter );
+   DOCTEST_CHECK( dip::testing::CompareImages( out, dip::Convert( expected, dip::DT_SINT32 )));
+}
+
+#endif // DIP__ENABLE_DOCTEST
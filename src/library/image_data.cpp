@@ -203,6 +203,22 @@ DataSegment AlignedAllocInterface::AllocateData(
    return DataSegment{ pAligned, Deleter( pUnaligned ) };  // Pass deleter that deletes the pointer to the block allocated by malloc()
 }
 
+DataSegment BufferPoolInterface::AllocateData(
+      void*& origin,
+      dip::DataType dataType,
+      UnsignedArray const& sizes,
+      IntegerArray& strides,
+      dip::Tensor const& tensor,
+      dip::sint& tensorStride
+) {
+   dip::uint numSamples = FindNumberOfPixels( sizes ) * tensor.Elements();
+   DataSegment data = Allocate( numSamples * dataType.SizeOf() );
+   tensorStride = 1;
+   ComputeStrides( sizes, tensor.Elements(), strides );
+   origin = data.get();
+   return data;
+}
+
 
 // Constructor.
 CoordinatesComputer::CoordinatesComputer( UnsignedArray const& sizes, IntegerArray const& strides ) {
@@ -677,9 +693,15 @@ void Image::Forge() {
             SetNormalStrides();
          }
          dip::uint sz = dataType_.SizeOf();
-         void* p = std::malloc( size * sz );
-         DIP_THROW_IF( !p, "Failed to allocate memory" );
-         dataBlock_ = DataSegment{ p, std::free };
+         void* p;
+         if( BufferPoolInterface::IsDefaultAllocator() ) {
+            dataBlock_ = BufferPoolInterface::GetInstance()->Allocate( size * sz );
+            p = dataBlock_.get();
+         } else {
+            p = std::malloc( size * sz );
+            DIP_THROW_IF( !p, "Failed to allocate memory" );
+            dataBlock_ = DataSegment{ p, std::free };
+         }
          //[]( void* ptr ) { std::cout << "   Successfully freed image with DataSegment " << ptr << std::endl; std::free( ptr ); }
          origin_ = static_cast< uint8* >( p ) + start * static_cast< dip::sint >( sz );
          //std::cout << "   Successfully forged image with DataSegment " << p << std::endl;
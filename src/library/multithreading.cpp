@@ -18,6 +18,14 @@
  * limitations under the License.
  */
 
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+#include "diplib.h"
 #include "diplib/multithreading.h"
 
 namespace dip {
@@ -26,18 +34,451 @@ namespace {
 
 dip::uint maxNumberOfThreads = static_cast< dip::uint >( omp_get_max_threads() ); // This responds to the OMP_NUM_THREADS environment variable.
 
+// Set in the worker threads, and in the calling thread while it executes a parallel job, so that nested calls
+// to `ParallelExecute` don't try to use the pool.
+thread_local bool insideParallelJob = false;
+
+// The persistent thread pool. Worker threads sleep on a condition variable until a new job is posted. A job
+// is posted by incrementing `generation_`; worker `ii` participates in the job if `ii < nWorkersActive_`.
+class ThreadPool {
+   public:
+      ThreadPool() = default;
+      ThreadPool( ThreadPool const& ) = delete;
+      ThreadPool& operator=( ThreadPool const& ) = delete;
+      ~ThreadPool() {
+         std::lock_guard< std::mutex > runLock( runMutex_ );
+         StopWorkers();
+      }
+
+      // Returns false if the pool is in use by another thread
+      bool Run( dip::uint nThreads, std::function< void( dip::uint ) > const& function ) {
+         std::unique_lock< std::mutex > runLock( runMutex_, std::try_to_lock );
+         if( !runLock.owns_lock() ) {
+            return false;
+         }
+         dip::uint nWorkers = nThreads - 1;
+         while( workers_.size() < nWorkers ) {
+            dip::uint index = workers_.size();
+            dip::uint generation = generation_; // no need to lock `mutex_`, only the thread holding `runMutex_` modifies it
+            workers_.emplace_back( [ this, index, generation ]() { WorkerLoop( index, generation ); } );
+         }
+         std::exception_ptr exception;
+         {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            function_ = &function;
+            nWorkersActive_ = nWorkers;
+            nWorkersBusy_ = nWorkers;
+            exception_ = nullptr;
+            ++generation_;
+         }
+         wakeUp_.notify_all();
+         insideParallelJob = true;
+         try {
+            function( 0 );
+         } catch( ... ) {
+            exception = std::current_exception();
+         }
+         insideParallelJob = false;
+         {
+            std::unique_lock< std::mutex > lock( mutex_ );
+            done_.wait( lock, [ this ]() { return nWorkersBusy_ == 0; } );
+            function_ = nullptr;
+            if( !exception ) {
+               exception = exception_;
+            }
+         }
+         if( exception ) {
+            std::rethrow_exception( exception );
+         }
+         return true;
+      }
+
+      // Stops worker threads with an index of `nWorkers` or larger
+      void Shrink( dip::uint nWorkers ) {
+         std::lock_guard< std::mutex > runLock( runMutex_ );
+         if( workers_.size() > nWorkers ) {
+            StopWorkers(); // they will be restarted when needed
+         }
+      }
+
+   private:
+      std::vector< std::thread > workers_;
+      std::mutex runMutex_;            // held by the thread that is using the pool
+      std::mutex mutex_;               // protects the variables below
+      std::condition_variable wakeUp_;
+      std::condition_variable done_;
+      std::function< void( dip::uint ) > const* function_ = nullptr;
+      dip::uint nWorkersActive_ = 0;
+      dip::uint nWorkersBusy_ = 0;
+      dip::uint generation_ = 0;
+      bool stop_ = false;
+      std::exception_ptr exception_;
+
+      // `generation` is the last job posted before the worker was created, the worker waits for the next one
+      void WorkerLoop( dip::uint index, dip::uint generation ) {
+         insideParallelJob = true;
+         while( true ) {
+            std::function< void( dip::uint ) > const* function;
+            {
+               std::unique_lock< std::mutex > lock( mutex_ );
+               wakeUp_.wait( lock, [ & ]() { return stop_ || ( generation_ != generation ); } );
+               if( stop_ ) {
+                  return;
+               }
+               generation = generation_;
+               if( index >= nWorkersActive_ ) {
+                  continue;
+               }
+               function = function_;
+            }
+            std::exception_ptr exception;
+            try {
+               ( *function )( index + 1 );
+            } catch( ... ) {
+               exception = std::current_exception();
+            }
+            {
+               std::lock_guard< std::mutex > lock( mutex_ );
+               if( exception && !exception_ ) {
+                  exception_ = exception;
+               }
+               --nWorkersBusy_;
+            }
+            done_.notify_one();
+         }
+      }
+
+      // Assumes `runMutex_` is locked
+      void StopWorkers() {
+         {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            stop_ = true;
+         }
+         wakeUp_.notify_all();
+         for( auto& worker : workers_ ) {
+            worker.join();
+         }
+         workers_.clear();
+         std::lock_guard< std::mutex > lock( mutex_ );
+         stop_ = false;
+      }
+};
+
+ThreadPool& GetThreadPool() {
+   static ThreadPool pool;
+   return pool;
+}
+
+// The threading cost model. It is initialized on first use, see `GetThreadingCostModel`.
+std::mutex costModelMutex;
+ThreadingCostModel costModel;
+bool costModelInitialized = false;
+
+ThreadingCostModel MeasureThreadingCostModel() {
+   using Clock = std::chrono::steady_clock;
+   ThreadingCostModel model;
+   // Time per operation: a chain of multiply-adds
+   {
+      constexpr dip::uint N = 1u << 22;
+      volatile dfloat seed = 1.0;
+      dfloat value = seed;
+      auto start = Clock::now();
+      for( dip::uint ii = 0; ii < N; ++ii ) {
+         value = value * 0.999999 + 1e-7;
+      }
+      std::chrono::duration< dfloat > elapsed = Clock::now() - start;
+      seed = value; // prevents the loop from being optimized out
+      model.operationTime = std::max( elapsed.count() / static_cast< dfloat >( N ), 1e-12 );
+   }
+   // Time per additional thread: an empty parallel job, compared to an empty job on one thread.
+   // We take the minimum over a few repetitions, to reduce the influence of other processes.
+   {
+      dip::uint nThreads = std::max< dip::uint >( GetNumberOfThreads(), 2 );
+      auto noop = []( dip::uint ) {};
+      ParallelExecute( nThreads, noop ); // makes sure the worker threads exist
+      dfloat parallelTime = std::numeric_limits< dfloat >::max();
+      dfloat serialTime = std::numeric_limits< dfloat >::max();
+      for( dip::uint ii = 0; ii < 20; ++ii ) {
+         auto start = Clock::now();
+         ParallelExecute( nThreads, noop );
+         std::chrono::duration< dfloat > elapsed = Clock::now() - start;
+         parallelTime = std::min( parallelTime, elapsed.count() );
+         start = Clock::now();
+         ParallelExecute( 1, noop );
+         elapsed = Clock::now() - start;
+         serialTime = std::min( serialTime, elapsed.count() );
+      }
+      model.threadStartTime = std::max( ( parallelTime - serialTime ) / static_cast< dfloat >( nThreads - 1 ), 1e-7 );
+   }
+   return model;
+}
+
+void WriteThreadingCostModel( String const& filename, ThreadingCostModel const& model ) {
+   std::ofstream file( filename );
+   DIP_THROW_IF( !file, "Could not open file for writing" );
+   file.precision( 17 );
+   file << "operationTime " << model.operationTime << '\n';
+   file << "threadStartTime " << model.threadStartTime << '\n';
+   DIP_THROW_IF( !file, "Error writing to file" );
+}
+
+bool ReadThreadingCostModel( String const& filename, ThreadingCostModel& model ) {
+   std::ifstream file( filename );
+   if( !file ) {
+      return false;
+   }
+   ThreadingCostModel newModel;
+   bool hasOperationTime = false;
+   bool hasThreadStartTime = false;
+   String key;
+   dfloat value;
+   while( file >> key >> value ) {
+      if( key == "operationTime" ) {
+         newModel.operationTime = value;
+         hasOperationTime = true;
+      } else if( key == "threadStartTime" ) {
+         newModel.threadStartTime = value;
+         hasThreadStartTime = true;
+      }
+   }
+   if( !hasOperationTime || !hasThreadStartTime || !( newModel.operationTime > 0 ) || !( newModel.threadStartTime >= 0 )) {
+      return false;
+   }
+   model = newModel;
+   return true;
+}
+
+// Call with `costModelMutex` locked
+void InitializeThreadingCostModel() {
+   if( costModelInitialized ) {
+      return;
+   }
+   costModelInitialized = true;
+   char const* filename = std::getenv( "DIP_THREADING_COST_MODEL" );
+   if(( filename == nullptr ) || ( *filename == '\0' )) {
+      return;
+   }
+   if( ReadThreadingCostModel( filename, costModel )) {
+      return;
+   }
+   costModel = MeasureThreadingCostModel();
+   try {
+      WriteThreadingCostModel( filename, costModel );
+   } catch( Error const& ) {
+      // Failing to write the cache file is not a reason to fail the computation
+   }
 }
 
+} // namespace
+
 void SetNumberOfThreads( dip::uint nThreads ) {
    if( nThreads == 0 ) {
       maxNumberOfThreads = static_cast< dip::uint >( omp_get_max_threads());
    } else {
       maxNumberOfThreads = std::min( nThreads, static_cast< dip::uint >( omp_get_max_threads()));
    }
+   if( !insideParallelJob ) {
+      GetThreadPool().Shrink( maxNumberOfThreads - 1 );
+   }
 }
 
 dip::uint GetNumberOfThreads() {
    return maxNumberOfThreads;
 }
 
+void ParallelExecute( dip::uint nThreads, std::function< void( dip::uint ) > const& function ) {
+   if(( nThreads <= 1 ) || insideParallelJob || !GetThreadPool().Run( nThreads, function )) {
+      // Either we were asked to run on a single thread, or the pool is busy: do all the work in this thread.
+      // The `dip::WorkDistributor` object will hand all the work to thread 0.
+      function( 0 );
+   }
+}
+
+ThreadingCostModel GetThreadingCostModel() {
+   std::lock_guard< std::mutex > lock( costModelMutex );
+   InitializeThreadingCostModel();
+   return costModel;
+}
+
+void SetThreadingCostModel( ThreadingCostModel const& model ) {
+   DIP_THROW_IF( !( model.operationTime > 0 ), E::PARAMETER_OUT_OF_RANGE );
+   DIP_THROW_IF( !( model.threadStartTime >= 0 ), E::PARAMETER_OUT_OF_RANGE );
+   std::lock_guard< std::mutex > lock( costModelMutex );
+   costModel = model;
+   costModelInitialized = true;
+}
+
+ThreadingCostModel CalibrateThreadingCostModel( String const& filename ) {
+   ThreadingCostModel model = MeasureThreadingCostModel();
+   SetThreadingCostModel( model );
+   if( !filename.empty() ) {
+      DIP_STACK_TRACE_THIS( WriteThreadingCostModel( filename, model ));
+   }
+   return model;
+}
+
+void SaveThreadingCostModel( String const& filename ) {
+   DIP_STACK_TRACE_THIS( WriteThreadingCostModel( filename, GetThreadingCostModel() ));
+}
+
+bool LoadThreadingCostModel( String const& filename ) {
+   ThreadingCostModel model;
+   if( !ReadThreadingCostModel( filename, model )) {
+      return false;
+   }
+   SetThreadingCostModel( model );
+   return true;
+}
+
+dip::uint OptimalNumberOfThreads( dip::uint operations, dip::uint maxThreads ) {
+   if( maxThreads <= 1 ) {
+      return 1;
+   }
+   ThreadingCostModel model = GetThreadingCostModel();
+   // Estimated time is `operations * operationTime / N + ( N - 1 ) * threadStartTime`, we find the smallest
+   // `N` that minimizes it. The function is convex in `N`, so we can stop as soon as it increases.
+   dfloat work = static_cast< dfloat >( operations ) * model.operationTime;
+   dip::uint best = 1;
+   dfloat bestTime = work;
+   for( dip::uint nThreads = 2; nThreads <= maxThreads; ++nThreads ) {
+      dfloat time = work / static_cast< dfloat >( nThreads ) + static_cast< dfloat >( nThreads - 1 ) * model.threadStartTime;
+      if( time >= bestTime ) {
+         break;
+      }
+      best = nThreads;
+      bestTime = time;
+   }
+   return best;
+}
+
+WorkDistributor::WorkDistributor( dip::uint nItems, dip::uint nThreads, dip::uint minChunkSize )
+      : parts_( std::max< dip::uint >( nThreads, 1 )), minChunkSize_( std::max< dip::uint >( minChunkSize, 1 )) {
+   dip::uint nParts = parts_.size();
+   for( dip::uint ii = 0; ii < nParts; ++ii ) {
+      parts_[ ii ].begin = nItems * ii / nParts;
+      parts_[ ii ].end = nItems * ( ii + 1 ) / nParts;
+   }
+}
+
+bool WorkDistributor::TakeChunk( Part& part, dip::uint& begin, dip::uint& end ) {
+   dip::uint remaining = part.end - part.begin;
+   if( remaining == 0 ) {
+      return false;
+   }
+   // Take a quarter of what's left, so that chunks get smaller as we near the end and others can steal work.
+   dip::uint size = std::min( std::max( remaining / 4, minChunkSize_ ), remaining );
+   begin = part.begin;
+   end = begin + size;
+   part.begin = end;
+   return true;
+}
+
+bool WorkDistributor::Next( dip::uint thread, dip::uint& begin, dip::uint& end ) {
+   DIP_ASSERT( thread < parts_.size() );
+   Part& own = parts_[ thread ];
+   {
+      std::lock_guard< std::mutex > lock( own.mutex );
+      if( TakeChunk( own, begin, end )) {
+         return true;
+      }
+   }
+   // Our part is empty, steal half of someone else's remaining work
+   dip::uint nParts = parts_.size();
+   for( dip::uint ii = 1; ii < nParts; ++ii ) {
+      Part& victim = parts_[ ( thread + ii ) % nParts ];
+      dip::uint stolenBegin;
+      dip::uint stolenEnd;
+      {
+         std::lock_guard< std::mutex > lock( victim.mutex );
+         dip::uint remaining = victim.end - victim.begin;
+         if( remaining == 0 ) {
+            continue;
+         }
+         stolenEnd = victim.end;
+         stolenBegin = victim.end - div_ceil( remaining, dip::uint( 2 ));
+         victim.end = stolenBegin;
+      }
+      std::lock_guard< std::mutex > lock( own.mutex );
+      own.begin = stolenBegin;
+      own.end = stolenEnd;
+      return TakeChunk( own, begin, end );
+   }
+   return false;
+}
+
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include <atomic>
+
+DOCTEST_TEST_CASE("[DIPlib] testing the thread pool and work distribution") {
+   dip::uint nItems = 1000;
+   dip::uint nThreads = 4;
+   std::vector< dip::uint8 > done( nItems, 0 );
+   std::atomic< dip::uint > nCalls( 0 );
+   dip::WorkDistributor work( nItems, nThreads );
+   dip::ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      ++nCalls;
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         for( dip::uint ii = begin; ii < end; ++ii ) {
+            ++done[ ii ];
+         }
+      }
+   } );
+   DOCTEST_CHECK( nCalls == nThreads );
+   DOCTEST_CHECK( std::count( done.begin(), done.end(), 1 ) == static_cast< dip::sint >( nItems ));
+
+   // Thread 0 does all the work if the other threads don't show up
+   std::fill( done.begin(), done.end(), 0 );
+   dip::WorkDistributor work2( nItems, nThreads, 7 );
+   dip::uint begin, end;
+   while( work2.Next( 0, begin, end )) {
+      for( dip::uint ii = begin; ii < end; ++ii ) {
+         ++done[ ii ];
+      }
+   }
+   DOCTEST_CHECK( std::count( done.begin(), done.end(), 1 ) == static_cast< dip::sint >( nItems ));
+
+   // Nested calls run in the calling thread
+   nCalls = 0;
+   dip::ParallelExecute( nThreads, [ & ]( dip::uint ) {
+      dip::ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+         DOCTEST_CHECK( thread == 0 );
+         ++nCalls;
+      } );
+   } );
+   DOCTEST_CHECK( nCalls == nThreads );
+
+   // Exceptions are propagated to the caller
+   DOCTEST_CHECK_THROWS( dip::ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      if( thread == nThreads - 1 ) {
+         DIP_THROW( "Test exception" );
+      }
+   } ));
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the threading cost model") {
+   dip::ThreadingCostModel original = dip::GetThreadingCostModel();
+   dip::ThreadingCostModel model;
+   model.operationTime = 1e-9;
+   model.threadStartTime = 1e-5; // 10,000 operations per thread
+   dip::SetThreadingCostModel( model );
+   DOCTEST_CHECK( dip::GetThreadingCostModel().Overhead( 3 ) == 20000 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 100, 8 ) == 1 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 19000, 8 ) == 1 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 21000, 8 ) == 2 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 1000000, 8 ) == 8 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 1000000, 4 ) == 4 );
+   DOCTEST_CHECK( dip::OptimalNumberOfThreads( 1000000, 1 ) == 1 );
+   DOCTEST_CHECK_THROWS( dip::SetThreadingCostModel( dip::ThreadingCostModel{ 0.0, 1.0 } ));
+   dip::ThreadingCostModel calibrated = dip::CalibrateThreadingCostModel();
+   DOCTEST_CHECK( calibrated.operationTime > 0 );
+   DOCTEST_CHECK( calibrated.threadStartTime > 0 );
+   DOCTEST_CHECK( !dip::LoadThreadingCostModel( "this_file_does_not_exist.txt" ));
+   dip::SetThreadingCostModel( original );
+}
+
+#endif // DIP__ENABLE_DOCTEST
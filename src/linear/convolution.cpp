@@ -23,8 +23,12 @@
 #include "diplib.h"
 #include "diplib/linear.h"
 #include "diplib/transform.h"
+#include "diplib/boundary.h"
 #include "diplib/framework.h"
+#include "diplib/multithreading.h"
 #include "diplib/pixel_table.h"
+#include "diplib/iterators.h"
+#include "diplib/statistics.h"
 #include "diplib/overload.h"
 
 namespace dip {
@@ -232,6 +236,268 @@ inline bool IsMeaninglessFilter( InternOneDimensionalFilter const& filter ) {
    ));
 }
 
+// The automatically chosen blocks for the overlap-save convolution have about this many pixels
+constexpr dip::uint overlapSaveBlockPixels = 1u << 16;
+
+// Chooses the sizes of the blocks for the overlap-save convolution. `blockSizes` are the requested sizes, 0 or
+// an empty array mean automatic. Along dimensions where the filter has size 1 no transform is computed, and the
+// block size is chosen to fill the block up to `overlapSaveBlockPixels`.
+UnsignedArray OverlapSaveBlockSizes( UnsignedArray const& imageSizes, UnsignedArray const& filterSizes, UnsignedArray blockSizes ) {
+   dip::uint nDims = imageSizes.size();
+   if( blockSizes.empty() ) {
+      blockSizes.resize( nDims, 0 );
+   } else {
+      ArrayUseParameter( blockSizes, nDims, dip::uint( 0 ));
+   }
+   dip::uint nProcessed = 0;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( filterSizes[ ii ] > 1 ) {
+         ++nProcessed;
+      }
+   }
+   dip::uint target = nProcessed > 0
+                      ? static_cast< dip::uint >( std::round( std::pow( static_cast< dfloat >( overlapSaveBlockPixels ), 1.0 / static_cast< dfloat >( nProcessed ))))
+                      : overlapSaveBlockPixels;
+   dip::uint blockPixels = 1;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::uint overlap = filterSizes[ ii ] - 1;
+      if( overlap > 0 ) {
+         dip::uint size = blockSizes[ ii ] > 0 ? std::max( blockSizes[ ii ], overlap + 1 ) : std::max( target, 4 * overlap );
+         size = std::min( size, imageSizes[ ii ] + overlap );
+         blockSizes[ ii ] = OptimalFourierTransformSize( size );
+         blockPixels *= blockSizes[ ii ];
+      }
+   }
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( filterSizes[ ii ] == 1 ) {
+         if( blockSizes[ ii ] == 0 ) {
+            blockSizes[ ii ] = std::max( overlapSaveBlockPixels / blockPixels, dip::uint( 1 ));
+         }
+         blockSizes[ ii ] = std::min( blockSizes[ ii ], imageSizes[ ii ] );
+         blockPixels *= blockSizes[ ii ];
+      }
+   }
+   return blockSizes;
+}
+
+// Estimates the number of operations per output pixel for the overlap-save convolution
+dfloat OverlapSaveCost( UnsignedArray const& blockSizes, UnsignedArray const& filterSizes, bool isComplex ) {
+   dfloat blockPixels = 1;
+   dfloat validPixels = 1;
+   dfloat logSize = 0;
+   for( dip::uint ii = 0; ii < blockSizes.size(); ++ii ) {
+      blockPixels *= static_cast< dfloat >( blockSizes[ ii ] );
+      validPixels *= static_cast< dfloat >( blockSizes[ ii ] - filterSizes[ ii ] + 1 );
+      if( filterSizes[ ii ] > 1 ) {
+         logSize += std::log2( static_cast< dfloat >( blockSizes[ ii ] ));
+      }
+   }
+   // Forward and inverse transform (a real-valued transform costs half), multiplication and copies
+   dfloat perBlockPixel = ( isComplex ? 10.0 : 5.0 ) * logSize + 8.0;
+   return perBlockPixel * blockPixels / validPixels;
+}
+
+// Returns true if the overlap-save convolution is expected to be faster than a direct convolution that
+// uses `directOperations` multiply-adds per output pixel. The "add max" and "add min" boundary conditions
+// fill the boundary with a value that depends on the data type of the intermediate image, so extending
+// the input image once does not give the same result as extending it in each pass of a separable filter.
+bool PreferOverlapSave(
+      UnsignedArray const& imageSizes,
+      UnsignedArray const& filterSizes,
+      BoundaryConditionArray const& bc,
+      bool isComplex,
+      dfloat directOperations
+) {
+   if( !( filterSizes <= imageSizes )) {
+      return false;
+   }
+   for( auto b : bc ) {
+      if(( b == BoundaryCondition::ADD_MAX_VALUE ) || ( b == BoundaryCondition::ADD_MIN_VALUE )) {
+         return false;
+      }
+   }
+   UnsignedArray blockSizes = OverlapSaveBlockSizes( imageSizes, filterSizes, {} );
+   // The factor 2 accounts for the overhead of processing the blocks independently
+   return directOperations > 2.0 * OverlapSaveCost( blockSizes, filterSizes, isComplex );
+}
+
+// Computes the convolution of `in` with `filter`, whose origin is at `origin`, using the overlap-save method.
+// `filter` must be scalar and have the same dimensionality as `in`. `out` is forged here.
+void OverlapSave(
+      Image const& in,
+      Image const& filter,
+      UnsignedArray const& origin,
+      Image& out,
+      BoundaryConditionArray const& bc,
+      UnsignedArray const& requestedBlockSizes
+) {
+   dip::uint nDims = in.Dimensionality();
+   UnsignedArray const& imageSizes = in.Sizes();
+   UnsignedArray const& filterSizes = filter.Sizes();
+   bool isComplex = in.DataType().IsComplex() || filter.DataType().IsComplex();
+   DataType dtype = DataType::SuggestFlex( in.DataType() );
+   if( isComplex ) {
+      dtype = DataType::SuggestComplex( dtype );
+   }
+   BooleanArray process( nDims, false );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      process[ ii ] = filterSizes[ ii ] > 1;
+   }
+   UnsignedArray blockSizes = OverlapSaveBlockSizes( imageSizes, filterSizes, requestedBlockSizes );
+   // Pixel `ii` of the output needs input pixels `ii - left` through `ii + right`
+   UnsignedArray left( nDims );
+   UnsignedArray validSizes( nDims );
+   UnsignedArray nBlocks( nDims );
+   UnsignedArray extendedSizes = imageSizes;
+   RangeArray window( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      left[ ii ] = filterSizes[ ii ] - 1 - origin[ ii ];
+      extendedSizes[ ii ] += filterSizes[ ii ] - 1;
+      window[ ii ] = Range{ static_cast< dip::sint >( left[ ii ] ), static_cast< dip::sint >( left[ ii ] + imageSizes[ ii ] ) - 1 };
+      validSizes[ ii ] = blockSizes[ ii ] - filterSizes[ ii ] + 1;
+      nBlocks[ ii ] = div_ceil( imageSizes[ ii ], validSizes[ ii ] );
+   }
+   // The input with the boundary extension, and the transformed filter, must be computed before `out` is forged,
+   // in case it aliases one of the inputs. The extrapolated values must not be clipped to the range of the input
+   // data type.
+   bool extrapolate = false;
+   for( auto b : bc ) {
+      extrapolate |= ( b == BoundaryCondition::FIRST_ORDER_EXTRAPOLATE ) ||
+                     ( b == BoundaryCondition::SECOND_ORDER_EXTRAPOLATE ) ||
+                     ( b == BoundaryCondition::THIRD_ORDER_EXTRAPOLATE );
+   }
+   Image extended( extendedSizes, in.TensorElements(), extrapolate ? DataType::SuggestFlex( in.DataType() ) : in.DataType() );
+   extended.At( window ).Copy( in );
+   ExtendRegion( extended, window, bc );
+   Tensor tensor = in.Tensor();
+   PixelSize pixelSize = in.PixelSize();
+   String colorSpace = in.ColorSpace();
+   StringSet forwardOptions{ "corner" };
+   StringSet inverseOptions{ "corner", "inverse" };
+   if( !isComplex ) {
+      forwardOptions.insert( "half" );
+      inverseOptions.insert( "half" );
+   }
+   UnsignedArray filterBlockSizes = blockSizes;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( !process[ ii ] ) {
+         filterBlockSizes[ ii ] = 1;
+      }
+   }
+   DataType blockType = isComplex ? dtype : DataType::SuggestFloat( dtype );
+   Image filterBlock( filterBlockSizes, 1, blockType );
+   filterBlock.Fill( 0 );
+   RangeArray filterRanges( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      filterRanges[ ii ] = Range{ 0, static_cast< dip::sint >( filterSizes[ ii ] ) - 1 };
+   }
+   filterBlock.At( filterRanges ).Copy( filter );
+   Image filterFT = FourierTransform( filterBlock, forwardOptions, process );
+   // Forge output
+   out.ReForge( imageSizes, tensor.Elements(), dtype, Option::AcceptDataTypeChange::DO_ALLOW );
+   out.ReshapeTensor( tensor );
+   out.SetPixelSize( pixelSize );
+   out.SetColorSpace( colorSpace );
+   dip::uint nTensor = tensor.Elements();
+   dip::uint blocksPerTensorElement = nBlocks.product();
+   dip::uint nItems = blocksPerTensorElement * nTensor;
+   dip::uint operations = static_cast< dip::uint >( OverlapSaveCost( blockSizes, filterSizes, isComplex ) * static_cast< dfloat >( imageSizes.product() * nTensor ));
+   dip::uint nThreads = OptimalNumberOfThreads( operations, std::min( GetNumberOfThreads(), nItems ));
+   std::vector< Image > inBlocks( nThreads );
+   std::vector< Image > outBlocks( nThreads );
+   WorkDistributor work( nItems, nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      Image& inBlock = inBlocks[ thread ];
+      Image& outBlock = outBlocks[ thread ];
+      inBlock.ReForge( blockSizes, 1, blockType );
+      outBlock.ReForge( blockSizes, 1, blockType );
+      Image blockFT;
+      RangeArray inRanges( nDims );
+      RangeArray blockRanges( nDims );
+      RangeArray outRanges( nDims );
+      RangeArray validRanges( nDims );
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         for( dip::uint item = begin; item < end; ++item ) {
+            dip::uint tensorElement = item / blocksPerTensorElement;
+            dip::uint index = item % blocksPerTensorElement;
+            bool partial = false;
+            for( dip::uint ii = 0; ii < nDims; ++ii ) {
+               dip::uint start = ( index % nBlocks[ ii ] ) * validSizes[ ii ];
+               index /= nBlocks[ ii ];
+               dip::uint length = std::min( validSizes[ ii ], imageSizes[ ii ] - start );
+               dip::uint overlap = filterSizes[ ii ] - 1;
+               inRanges[ ii ] = Range{ static_cast< dip::sint >( start ), static_cast< dip::sint >( start + length + overlap ) - 1 };
+               blockRanges[ ii ] = Range{ 0, static_cast< dip::sint >( length + overlap ) - 1 };
+               outRanges[ ii ] = Range{ static_cast< dip::sint >( start ), static_cast< dip::sint >( start + length ) - 1 };
+               validRanges[ ii ] = Range{ static_cast< dip::sint >( overlap ), static_cast< dip::sint >( overlap + length ) - 1 };
+               partial |= length + overlap < blockSizes[ ii ];
+            }
+            if( partial ) {
+               inBlock.Fill( 0 ); // The samples past the end of the image only affect output samples we don't use
+            }
+            Image src = extended[ tensorElement ];
+            inBlock.At( blockRanges ).Copy( src.At( inRanges ));
+            FourierTransform( inBlock, blockFT, forwardOptions, process );
+            MultiplySampleWise( blockFT, filterFT, blockFT, blockFT.DataType() );
+            FourierTransform( blockFT, outBlock, inverseOptions, process );
+            Image dest = out[ tensorElement ];
+            dest.At( outRanges ).Copy( outBlock.At( validRanges ));
+         }
+      }
+   } );
+}
+
+// Creates the full, non-separated filter kernel from a separable filter, for use with `OverlapSave`.
+// `filterArray` has one element for each dimension; those with `process` false are not used.
+void SeparableFilterAsKernel(
+      OneDimensionalFilterArray const& filterArray,
+      BooleanArray const& process,
+      Image& kernel,
+      UnsignedArray& origin
+) {
+   dip::uint nDims = process.size();
+   std::vector< std::vector< dfloat >> weights( nDims );
+   UnsignedArray sizes( nDims, 1 );
+   origin.resize( nDims, 0 );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( !process[ ii ] ) {
+         weights[ ii ] = { 1.0 };
+         origin[ ii ] = 0;
+         continue;
+      }
+      OneDimensionalFilter const& filter = filterArray[ filterArray.size() == 1 ? 0 : ii ];
+      std::vector< dfloat >& w = weights[ ii ];
+      w.assign( filter.filter.begin(), filter.filter.end() );
+      dip::uint n = w.size();
+      if(( filter.symmetry == "even" ) || ( filter.symmetry == "odd" )) {
+         dfloat sign = filter.symmetry == "even" ? 1.0 : -1.0;
+         for( dip::uint jj = n - 1; jj > 0; ) {
+            --jj;
+            w.push_back( sign * w[ jj ] );
+         }
+      } else if(( filter.symmetry == "d-even" ) || ( filter.symmetry == "d-odd" )) {
+         dfloat sign = filter.symmetry == "d-even" ? 1.0 : -1.0;
+         for( dip::uint jj = n; jj > 0; ) {
+            --jj;
+            w.push_back( sign * w[ jj ] );
+         }
+      }
+      sizes[ ii ] = w.size();
+      origin[ ii ] = filter.origin < 0 ? w.size() / 2 : static_cast< dip::uint >( filter.origin );
+   }
+   kernel.ReForge( sizes, 1, DT_DFLOAT );
+   ImageIterator< dfloat > it( kernel );
+   do {
+      UnsignedArray const& coords = it.Coordinates();
+      dfloat value = 1.0;
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         value *= weights[ ii ][ coords[ ii ]];
+      }
+      *it = value;
+   } while( ++it );
+}
+
 } // namespace
 
 
@@ -290,6 +556,23 @@ void SeparableConvolution(
    DIP_START_STACK_TRACE
       // handle boundary condition array (checks are made in Framework::Separable, no need to repeat them here)
       BoundaryConditionArray bc = StringArrayToBoundaryConditionArray( boundaryCondition );
+      // Large filters are cheaper to apply through the Fourier domain
+      UnsignedArray filterSizes( nDims, 1 );
+      dfloat directOperations = 0;
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         if( process[ ii ] ) {
+            filterSizes[ ii ] = filterData[ filterData.size() == 1 ? 0 : ii ].size;
+            directOperations += static_cast< dfloat >( filterSizes[ ii ] );
+         }
+      }
+      if( process.any() && PreferOverlapSave( in.Sizes(), filterSizes, bc, in.DataType().IsComplex(), directOperations )) {
+         Image kernel;
+         UnsignedArray origin;
+         SeparableFilterAsKernel( filterArray, process, kernel, origin );
+         BoundaryArrayUseParameter( bc, nDims );
+         OverlapSave( in, kernel, origin, out, bc, {} );
+         return;
+      }
       // Get callback function
       DataType dtype = DataType::SuggestFlex( in.DataType() );
       //std::cout << "dtype = " << dtype << std::endl;
@@ -310,11 +593,20 @@ void ConvolveFT(
 ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !filter.IsForged(), E::IMAGE_NOT_FORGED );
+   bool inSpatial = BooleanFromString( inRepresentation, "spatial", "frequency" );
+   bool filterSpatial = BooleanFromString( filterRepresentation, "spatial", "frequency" );
+   bool outSpatial = BooleanFromString( outRepresentation, "spatial", "frequency" );
+   // If both inputs are real-valued, and we return to the spatial domain, we only need to compute half the spectrum
+   bool half = inSpatial && filterSpatial && outSpatial && in.DataType().IsReal() && filter.DataType().IsReal();
+   StringSet forwardOptions;
+   if( half ) {
+      forwardOptions.insert( "half" );
+   }
    bool real = true;
    Image inFT;
-   if( BooleanFromString( inRepresentation, "spatial", "frequency" )) {
+   if( inSpatial ) {
       real &= in.DataType().IsReal();
-      FourierTransform( in, inFT );
+      FourierTransform( in, inFT, forwardOptions );
    } else {
       real = false;
       inFT = in.QuickCopy();
@@ -325,15 +617,24 @@ void ConvolveFT(
    }
    DIP_THROW_IF( !( filterFT.Sizes() <= in.Sizes() ), E::SIZES_DONT_MATCH ); // Also throws if dimensionalities don't match
    filterFT = filterFT.Pad( in.Sizes() );
-   if( BooleanFromString( filterRepresentation, "spatial", "frequency" )) {
+   if( filterSpatial ) {
       real &= filterFT.DataType().IsReal();
-      FourierTransform( filterFT, filterFT );
+      FourierTransform( filterFT, filterFT, forwardOptions );
    } else {
       real = false;
    }
    DataType dt = inFT.DataType();
+   if( half ) {
+      Image outFT;
+      MultiplySampleWise( inFT, filterFT, outFT, dt );
+      // Forging `out` with the sizes of `in` tells `FourierTransform` the size of the half dimension
+      UnsignedArray sizes = in.Sizes();
+      out.ReForge( sizes, outFT.TensorElements(), DataType::SuggestFloat( dt ), Option::AcceptDataTypeChange::DO_ALLOW );
+      FourierTransform( outFT, out, { "inverse", "half" } );
+      return;
+   }
    MultiplySampleWise( inFT, filterFT, out, dt );
-   if( BooleanFromString( outRepresentation, "spatial", "frequency" )) {
+   if( outSpatial ) {
       StringSet options{ "inverse" };
       if( real ) {
          options.insert( "real" );
@@ -343,6 +644,35 @@ void ConvolveFT(
 }
 
 
+void OverlapSaveConvolution(
+      Image const& in,
+      Image const& c_filter,
+      Image& out,
+      StringArray const& boundaryCondition,
+      UnsignedArray const& blockSizes
+) {
+   DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !c_filter.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !c_filter.IsScalar(), E::IMAGE_NOT_SCALAR );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( nDims < 1, E::DIMENSIONALITY_NOT_SUPPORTED );
+   Image filter = c_filter.QuickCopy();
+   if( filter.Dimensionality() < nDims ) {
+      filter.ExpandDimensionality( nDims );
+   }
+   DIP_THROW_IF( !( filter.Sizes() <= in.Sizes() ), E::SIZES_DONT_MATCH ); // Also throws if dimensionalities don't match
+   UnsignedArray origin = filter.Sizes();
+   for( auto& o : origin ) {
+      o /= 2;
+   }
+   DIP_START_STACK_TRACE
+      BoundaryConditionArray bc = StringArrayToBoundaryConditionArray( boundaryCondition );
+      BoundaryArrayUseParameter( bc, nDims );
+      OverlapSave( in, filter, origin, out, bc, blockSizes );
+   DIP_END_STACK_TRACE
+}
+
+
 namespace {
 
 template< typename TPI >
@@ -396,6 +726,17 @@ void GeneralConvolution(
          return;
       }
       BoundaryConditionArray bc = StringArrayToBoundaryConditionArray( boundaryCondition );
+      // Large filters are cheaper to apply through the Fourier domain
+      if( c_filter.IsScalar() && ( c_filter.Dimensionality() <= in.Dimensionality() )) {
+         UnsignedArray filterSizes = c_filter.Sizes();
+         filterSizes.resize( in.Dimensionality(), 1 );
+         // Each weight is applied through a pixel table offset, costing about twice a separable filter tap
+         dfloat directOperations = 2.0 * static_cast< dfloat >( Count( c_filter ));
+         if( PreferOverlapSave( in.Sizes(), filterSizes, bc, in.DataType().IsComplex(), directOperations )) {
+            OverlapSaveConvolution( in, c_filter, out, boundaryCondition );
+            return;
+         }
+      }
       DataType dtype = DataType::SuggestFlex( in.DataType() );
       std::unique_ptr< Framework::FullLineFilter > lineFilter;
       DIP_OVL_NEW_FLEX( lineFilter, GeneralConvolutionLineFilter, (), dtype );
@@ -499,4 +840,78 @@ DOCTEST_TEST_CASE("[DIPlib] testing the separable convolution") {
    DOCTEST_CHECK( dip::Mean( out1 - out2 ).As< dip::dfloat >() / meanval == doctest::Approx( 0.0 ));
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the overlap-save convolution") {
+   dip::Image img{ dip::UnsignedArray{ 47, 38 }, 1, dip::DT_SFLOAT };
+   img.Fill( 50.0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   // An asymmetric, even-sized filter
+   dip::Image filter{ dip::UnsignedArray{ 6, 5 }, 1, dip::DT_SFLOAT };
+   dip::ImageIterator< dip::sfloat > it( filter );
+   dip::sfloat value = 1.0f;
+   do {
+      *it = value / 100.0f;
+      value += 1.0f;
+   } while( ++it );
+   dip::Image out1, out2;
+   for( auto const& bc : { "mirror", "periodic", "add zeros", "first order" } ) {
+      dip::GeneralConvolution( img, filter, out1, { bc } );
+      dip::OverlapSaveConvolution( img, filter, out2, { bc }, { 16, 12 } );
+      DOCTEST_CHECK( dip::MaximumAbsoluteError( out1, out2 ) < 1e-3 );
+   }
+   // Automatic block sizes
+   dip::OverlapSaveConvolution( img, filter, out2, { "first order" } );
+   DOCTEST_CHECK( dip::MaximumAbsoluteError( out1, out2 ) < 1e-3 );
+   // A true convolution: the result is consistent with ConvolveFT
+   dip::GeneralConvolution( img, filter, out1, { "periodic" } );
+   dip::ConvolveFT( img, filter, out2 );
+   DOCTEST_CHECK( dip::MaximumAbsoluteError( out1, out2 ) < 1e-3 );
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the separable convolution through the overlap-save method") {
+   // The filter along x is large enough for `SeparableConvolution` to use `OverlapSave`
+   dip::Image img{ dip::UnsignedArray{ 1200, 16 }, 1, dip::DT_SFLOAT };
+   img.Fill( 50.0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   dip::OneDimensionalFilterArray filterArray( 2 );
+   filterArray[ 0 ].filter.resize( 201 );
+   for( dip::uint ii = 0; ii < 201; ++ii ) {
+      filterArray[ 0 ].filter[ ii ] = static_cast< dip::dfloat >( ii + 1 ) / ( 201.0 * 201.0 );
+   }
+   filterArray[ 1 ].filter = { 0.1, 0.2, 0.3 };
+   // Full filters: x is the half filter followed by its mirror image without the middle element,
+   // y is the half filter followed by its mirror image
+   auto fullX = [ & ]( dip::uint ii, dip::dfloat sign ) {
+      return ii <= 200 ? filterArray[ 0 ].filter[ ii ] : sign * filterArray[ 0 ].filter[ 400 - ii ];
+   };
+   auto fullY = [ & ]( dip::uint ii, dip::dfloat sign ) {
+      return ii <= 2 ? filterArray[ 1 ].filter[ ii ] : sign * filterArray[ 1 ].filter[ 5 - ii ];
+   };
+   struct Case { char const* symmetryX; dip::sint originX; char const* symmetryY; dip::sint originY; };
+   for( auto const& c : { Case{ "even", -1, "d-odd", 1 }, Case{ "odd", 150, "d-even", -1 }} ) {
+      filterArray[ 0 ].symmetry = c.symmetryX;
+      filterArray[ 0 ].origin = c.originX;
+      filterArray[ 1 ].symmetry = c.symmetryY;
+      filterArray[ 1 ].origin = c.originY;
+      dip::dfloat signX = std::string( c.symmetryX ) == "even" ? 1.0 : -1.0;
+      dip::dfloat signY = std::string( c.symmetryY ) == "d-even" ? 1.0 : -1.0;
+      dip::uint originX = c.originX < 0 ? 200 : static_cast< dip::uint >( c.originX );
+      dip::uint originY = c.originY < 0 ? 3 : static_cast< dip::uint >( c.originY );
+      // The same filter as an image with the origin in the middle, for `ConvolveFT`
+      dip::uint halfX = std::max( originX, 400 - originX );
+      dip::uint halfY = std::max( originY, 5 - originY );
+      dip::Image filter{ dip::UnsignedArray{ 2 * halfX + 1, 2 * halfY + 1 }, 1, dip::DT_SFLOAT };
+      filter.Fill( 0 );
+      for( dip::uint ii = 0; ii < 401; ++ii ) {
+         for( dip::uint jj = 0; jj < 6; ++jj ) {
+            filter.At( halfX + ii - originX, halfY + jj - originY ) = fullX( ii, signX ) * fullY( jj, signY );
+         }
+      }
+      dip::Image out1 = dip::SeparableConvolution( img, filterArray, { "periodic" } );
+      dip::Image out2 = dip::ConvolveFT( img, filter );
+      DOCTEST_CHECK( dip::MaximumAbsoluteError( out1, out2 ) < 1e-3 );
+   }
+}
+
 #endif // DIP__ENABLE_DOCTEST
@@ -184,6 +184,25 @@ void GaussFIR(
    SeparableConvolution( in, out, filter, boundaryCondition, process );
 }
 
+UnsignedArray GaussFIRBoundary(
+      FloatArray sigmas,
+      UnsignedArray derivativeOrder,
+      dip::uint nDims,
+      dfloat truncation
+) {
+   DIP_START_STACK_TRACE
+      ArrayUseParameter( sigmas, nDims, 1.0 );
+      ArrayUseParameter( derivativeOrder, nDims, dip::uint( 0 ));
+   DIP_END_STACK_TRACE
+   UnsignedArray boundary( nDims, 0 );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( sigmas[ ii ] > 0.0 ) {
+         boundary[ ii ] = HalfGaussianSize( sigmas[ ii ], derivativeOrder[ ii ], truncation );
+      }
+   }
+   return boundary;
+}
+
 
 namespace {
 
@@ -191,7 +210,9 @@ template< typename TPI > // TPI is always complex (either scomplex or dcomplex)
 class GaussFTLineFilter : public Framework::ScanLineFilter {
    public:
       using TPIf = FloatType< TPI >;
-      GaussFTLineFilter( UnsignedArray const& sizes, FloatArray const& sigmas, UnsignedArray const& order, dfloat truncation ) {
+      // If `half`, the image holds only frequencies 0 to N/2 along the first dimension, see the "half" option to
+      // `dip::FourierTransform`. `sizes` are always the sizes of the full spectrum.
+      GaussFTLineFilter( UnsignedArray const& sizes, FloatArray const& sigmas, UnsignedArray const& order, dfloat truncation, bool half ) {
          dip::uint nDims = sizes.size();
          gaussLUTs_.resize( nDims );
          for( dip::uint ii = 0; ii < nDims; ++ii ) {
@@ -246,6 +267,16 @@ class GaussFTLineFilter : public Framework::ScanLineFilter {
                }
             }
          }
+         if( half ) {
+            // Frequency x is at index x for x >= 0; for even sizes, the last index is the frequency -N/2, as in the full LUT
+            dip::uint size = sizes[ 0 ];
+            dip::uint origin = size / 2;
+            std::vector< TPI > halfLUT( size / 2 + 1 );
+            for( dip::uint jj = 0; jj < halfLUT.size(); ++jj ) {
+               halfLUT[ jj ] = gaussLUTs_[ 0 ][ ( origin + jj ) % size ];
+            }
+            gaussLUTs_[ 0 ] = std::move( halfLUT );
+         }
       }
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 3; } // not counting initialization
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
@@ -300,17 +331,21 @@ void GaussFT(
       }
    }
    if( sigmas.any() || order.any() ) {
+      // For real-valued input, we compute only half the spectrum
       bool isreal = !in.DataType().IsComplex();
-      Image ft = FourierTransform( in );
+      UnsignedArray sizes = in.Sizes();
+      Image ft = FourierTransform( in, isreal ? StringSet{ "half" } : StringSet{} );
       DataType dtype = DataType::SuggestComplex( ft.DataType() );
       std::unique_ptr< Framework::ScanLineFilter > scanLineFilter;
-      DIP_OVL_NEW_COMPLEX( scanLineFilter, GaussFTLineFilter, ( in.Sizes(), sigmas, order, truncation ), dtype );
+      DIP_OVL_NEW_COMPLEX( scanLineFilter, GaussFTLineFilter, ( sizes, sigmas, order, truncation, isreal ), dtype );
       Framework::ScanMonadic(
             ft, ft, dtype, dtype, 1, *scanLineFilter,
             Framework::Scan_TensorAsSpatialDim + Framework::Scan_NeedCoordinates );
       StringSet opts = { "inverse" };
       if( isreal ) {
-         opts.emplace( "real" );
+         opts.emplace( "half" );
+         // Forging `out` with the sizes of `in` tells `FourierTransform` the size of the half dimension
+         out.ReForge( sizes, ft.TensorElements(), DataType::SuggestFloat( dtype ), Option::AcceptDataTypeChange::DO_ALLOW );
       }
       FourierTransform( ft, out, opts );
    } else {
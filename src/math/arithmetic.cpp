@@ -351,6 +351,7 @@ void Invert(
 #ifdef DIP__ENABLE_DOCTEST
 #include "doctest.h"
 #include "diplib/math.h"
+#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the matrix multiplication operation") {
    dip::Image lhs( { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 } );
@@ -372,4 +373,32 @@ DOCTEST_TEST_CASE("[DIPlib] testing the matrix multiplication operation") {
    DOCTEST_CHECK( out.At( 0 ) == dip::Image::Pixel( { 5.0, 25.0, 61.0, 11.0, 17.0, 39.0 } ));
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing pixel-wise arithmetic on contiguous and strided images") {
+   // Contiguous buffers are processed by a different loop than strided ones, results must be identical
+   dip::Image lhs( { 30, 20 }, 3, dip::DT_UINT8 );
+   dip::Image rhs( { 30, 20 }, 3, dip::DT_UINT8 );
+   dip::uint8* lptr = static_cast< dip::uint8* >( lhs.Origin() );
+   dip::uint8* rptr = static_cast< dip::uint8* >( rhs.Origin() );
+   for( dip::uint ii = 0; ii < lhs.NumberOfSamples(); ++ii ) {
+      lptr[ ii ] = static_cast< dip::uint8 >( ii * 7 );
+      rptr[ ii ] = static_cast< dip::uint8 >( ii * 13 + 100 );
+   }
+   dip::Image sum = dip::Add( lhs, rhs, dip::DT_UINT8 );
+   dip::Image mirrored = dip::Add( dip::Image( lhs ).Mirror(), dip::Image( rhs ).Mirror(), dip::DT_UINT8 );
+   DOCTEST_CHECK( dip::testing::CompareImages( sum, mirrored.Mirror() ) );
+   dip::uint8* sptr = static_cast< dip::uint8* >( sum.Origin() );
+   bool correct = true;
+   for( dip::uint ii = 0; ii < sum.NumberOfSamples(); ++ii ) {
+      correct &= sptr[ ii ] == std::min( lptr[ ii ] + rptr[ ii ], 255 );
+   }
+   DOCTEST_CHECK( correct );
+   // Comparison operators have their own line filter
+   dip::Image lesser = lhs < rhs;
+   dip::Image expected = dip::Image( lhs ).Mirror() < dip::Image( rhs ).Mirror();
+   DOCTEST_CHECK( dip::testing::CompareImages( lesser, expected.Mirror() ) );
+   // In-place operation
+   dip::Add( lhs, rhs, lhs, lhs.DataType() );
+   DOCTEST_CHECK( dip::testing::CompareImages( lhs, sum ) );
+}
+
 #endif // DIP__ENABLE_DOCTEST
@@ -42,18 +42,35 @@ class VariadicScanLineFilterBinOut : public Framework::ScanLineFilter {
          std::array< dip::sint, N > inTensorStride;
          dip::uint const bufferLength = params.bufferLength;
          dip::uint const tensorLength = params.outBuffer[ 0 ].tensorLength; // all buffers have same number of tensor elements
+         // `contiguous` is true if all buffers have their samples one after the other, with the tensor elements
+         // (if any) interleaved. We then treat the buffers as simple arrays of `bufferLength * tensorLength`
+         // samples, and index all of them with the same counter, which allows the compiler to vectorize the loop.
+         dip::sint const contiguousStride = static_cast< dip::sint >( tensorLength );
+         bool contiguous = ( params.outBuffer[ 0 ].stride == contiguousStride ) &&
+                           (( tensorLength == 1 ) || ( params.outBuffer[ 0 ].tensorStride == 1 ));
          for( dip::uint ii = 0; ii < N; ++ii ) {
             in[ ii ] = static_cast< TPI const* >( params.inBuffer[ ii ].buffer );
             inStride[ ii ] = params.inBuffer[ ii ].stride;
             if( tensorLength > 1 ) {
                inTensorStride[ ii ] = params.inBuffer[ ii ].tensorStride;
+               contiguous &= inTensorStride[ ii ] == 1;
             }
+            contiguous &= inStride[ ii ] == contiguousStride;
             DIP_ASSERT( params.inBuffer[ ii ].tensorLength == tensorLength );
          }
          bin* out = static_cast< bin* >( params.outBuffer[ 0 ].buffer );
          dip::sint const outStride = params.outBuffer[ 0 ].stride;
          dip::sint const outTensorStride = params.outBuffer[ 0 ].tensorStride;
-         if( tensorLength > 1 ) {
+         if( contiguous ) {
+            dip::uint const length = bufferLength * tensorLength;
+            for( dip::uint kk = 0; kk < length; ++kk ) {
+               std::array< TPI const*, N > inK;
+               for( dip::uint ii = 0; ii < N; ++ii ) {
+                  inK[ ii ] = in[ ii ] + kk;
+               }
+               out[ kk ] = func_( inK );
+            }
+         } else if( tensorLength > 1 ) {
             for( dip::uint kk = 0; kk < bufferLength; ++kk ) {
                std::array< TPI const*, N > inT = in;
                bin* outT = out;
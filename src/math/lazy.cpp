@@ -0,0 +1,344 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definition of the lazily evaluated image arithmetic.
+ *
+ * (c)2026, DIPlib contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <functional>
+
+#include "diplib.h"
+#include "diplib/lazy.h"
+#include "diplib/framework.h"
+#include "diplib/overload.h"
+#include "diplib/saturated_arithmetic.h"
+#include "diplib/library/copy_buffer.h"
+
+namespace dip {
+
+ImageExpression::ImageExpression( Image const& image ) {
+   DIP_THROW_IF( !image.IsForged(), E::IMAGE_NOT_FORGED );
+   node_ = std::make_shared< Node const >( Node{ Operation::Leaf, image.DataType(), image.Tensor(), image, nullptr, nullptr } );
+}
+
+ImageExpression::ImageExpression( Operation operation, ImageExpression const& lhs, ImageExpression const& rhs ) {
+   DIP_THROW_IF( operation == Operation::Leaf, E::INVALID_FLAG );
+   if( operation == Operation::Invert ) {
+      node_ = std::make_shared< Node const >( Node{ operation, lhs.DataType(), lhs.Tensor(), {}, lhs.node_, nullptr } );
+      return;
+   }
+   dip::Tensor tensor;
+   if( lhs.Tensor().IsScalar() ) {
+      tensor = rhs.Tensor();
+   } else if( rhs.Tensor().IsScalar() ) {
+      tensor = lhs.Tensor();
+   } else {
+      DIP_THROW_IF( operation == Operation::Multiply, "Lazy multiplication requires one of the operands to be scalar" );
+      DIP_THROW_IF( !( lhs.Tensor() == rhs.Tensor() ), E::NTENSORELEM_DONT_MATCH );
+      tensor = lhs.Tensor();
+   }
+   dip::DataType dataType = dip::DataType::SuggestArithmetic( lhs.DataType(), rhs.DataType() );
+   node_ = std::make_shared< Node const >( Node{ operation, dataType, tensor, {}, lhs.node_, rhs.node_ } );
+}
+
+namespace {
+
+using ExpressionKernel = void ( * )( void const* lhs, void const* rhs, void* out, dip::uint n );
+
+template< typename TPI >
+void AddKernel( void const* lhs, void const* rhs, void* out, dip::uint n ) {
+   TPI const* a = static_cast< TPI const* >( lhs );
+   TPI const* b = static_cast< TPI const* >( rhs );
+   TPI* o = static_cast< TPI* >( out );
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      o[ ii ] = saturated_add( a[ ii ], b[ ii ] );
+   }
+}
+
+template< typename TPI >
+void SubtractKernel( void const* lhs, void const* rhs, void* out, dip::uint n ) {
+   TPI const* a = static_cast< TPI const* >( lhs );
+   TPI const* b = static_cast< TPI const* >( rhs );
+   TPI* o = static_cast< TPI* >( out );
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      o[ ii ] = saturated_sub( a[ ii ], b[ ii ] );
+   }
+}
+
+template< typename TPI >
+void MultiplyKernel( void const* lhs, void const* rhs, void* out, dip::uint n ) {
+   TPI const* a = static_cast< TPI const* >( lhs );
+   TPI const* b = static_cast< TPI const* >( rhs );
+   TPI* o = static_cast< TPI* >( out );
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      o[ ii ] = saturated_mul( a[ ii ], b[ ii ] );
+   }
+}
+
+template< typename TPI >
+void DivideKernel( void const* lhs, void const* rhs, void* out, dip::uint n ) {
+   TPI const* a = static_cast< TPI const* >( lhs );
+   TPI const* b = static_cast< TPI const* >( rhs );
+   TPI* o = static_cast< TPI* >( out );
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      o[ ii ] = saturated_div( a[ ii ], b[ ii ] );
+   }
+}
+
+template< typename TPI >
+void InvertKernel( void const* in, void const*, void* out, dip::uint n ) {
+   TPI const* a = static_cast< TPI const* >( in );
+   TPI* o = static_cast< TPI* >( out );
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      o[ ii ] = saturated_inv( a[ ii ] );
+   }
+}
+
+// One step of the flattened expression. Operands always come earlier in the program than the step that uses
+// them, and the last step yields the result.
+struct ExpressionStep {
+   DataType dataType;
+   ExpressionKernel kernel = nullptr; // If null, this is a leaf
+   dip::uint input = 0;               // For leaves, the index of the input buffer
+   dip::uint lhs = 0;                 // For operations, the index of the operand steps
+   dip::uint rhs = 0;
+   bool dyadic = false;
+};
+
+using ExpressionProgram = std::vector< ExpressionStep >;
+
+class ExpressionLineFilter : public Framework::ScanLineFilter {
+   public:
+      ExpressionLineFilter( ExpressionProgram const& program ) : program_( program ) {}
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         buffers_.resize( threads );
+      }
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         dip::uint cost = 0;
+         for( auto const& step : program_ ) {
+            cost += step.kernel ? 2 : 1;
+         }
+         return cost;
+      }
+      virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+         // We evaluate the expression on blocks of `blockSize` samples. Each step writes its result into its own
+         // buffer; these are small enough to remain in the cache.
+         ThreadBuffers& buffers = buffers_[ params.thread ];
+         if( buffers.results.empty() ) {
+            buffers.results.resize( program_.size() );
+            for( dip::uint ii = 0; ii < program_.size(); ++ii ) {
+               buffers.results[ ii ].resize( blockSize * program_[ ii ].dataType.SizeOf() );
+            }
+            buffers.lhs.resize( blockSize * maxSampleSize );
+            buffers.rhs.resize( blockSize * maxSampleSize );
+            buffers.values.resize( program_.size() );
+         }
+         dip::uint const bufferLength = params.bufferLength;
+         for( dip::uint start = 0; start < bufferLength; start += blockSize ) {
+            dip::uint n = std::min( blockSize, bufferLength - start );
+            for( dip::uint ii = 0; ii < program_.size(); ++ii ) {
+               ExpressionStep const& step = program_[ ii ];
+               void* result = buffers.results[ ii ].data();
+               if( step.kernel ) {
+                  void const* lhs = Operand( buffers, step.lhs, step.dataType, buffers.lhs.data(), n );
+                  void const* rhs = step.dyadic ? Operand( buffers, step.rhs, step.dataType, buffers.rhs.data(), n ) : nullptr;
+                  step.kernel( lhs, rhs, result, n );
+                  buffers.values[ ii ] = result;
+               } else {
+                  auto const& in = params.inBuffer[ step.input ];
+                  uint8 const* ptr = static_cast< uint8 const* >( in.buffer ) +
+                                     static_cast< dip::sint >( start ) * in.stride * static_cast< dip::sint >( step.dataType.SizeOf() );
+                  if( in.stride == 1 ) {
+                     buffers.values[ ii ] = ptr;
+                  } else {
+                     detail::CopyBuffer( ptr, step.dataType, in.stride, in.tensorStride,
+                                         result, step.dataType, 1, 1, n, 1 );
+                     buffers.values[ ii ] = result;
+                  }
+               }
+            }
+            auto const& out = params.outBuffer[ 0 ];
+            DataType dataType = program_.back().dataType;
+            uint8* outPtr = static_cast< uint8* >( out.buffer ) +
+                            static_cast< dip::sint >( start ) * out.stride * static_cast< dip::sint >( dataType.SizeOf() );
+            detail::CopyBuffer( buffers.values.back(), dataType, 1, 1, outPtr, dataType, out.stride, out.tensorStride, n, 1 );
+         }
+      }
+
+   private:
+      static constexpr dip::uint blockSize = 256;
+      static constexpr dip::uint maxSampleSize = sizeof( dcomplex );
+
+      struct ThreadBuffers {
+         std::vector< std::vector< uint8 >> results; // One for each step
+         std::vector< uint8 > lhs;                   // For converting operands to the step's data type
+         std::vector< uint8 > rhs;
+         std::vector< void const* > values;          // Points at each step's result for the current block
+      };
+
+      ExpressionProgram const& program_;
+      std::vector< ThreadBuffers > buffers_; // One for each thread
+
+      // Returns a pointer to the result of step `index`, converted to `dataType` if necessary.
+      void const* Operand( ThreadBuffers& buffers, dip::uint index, DataType dataType, uint8* scratch, dip::uint n ) const {
+         DataType operandType = program_[ index ].dataType;
+         if( operandType == dataType ) {
+            return buffers.values[ index ];
+         }
+         detail::CopyBuffer( buffers.values[ index ], operandType, 1, 1, scratch, dataType, 1, 1, n, 1 );
+         return scratch;
+      }
+};
+
+constexpr dip::uint ExpressionLineFilter::blockSize;
+
+ExpressionKernel GetKernel( ImageExpression::Operation operation, DataType dataType ) {
+   ExpressionKernel kernel = nullptr;
+   switch( operation ) {
+      case ImageExpression::Operation::Add:
+         DIP_OVL_ASSIGN_ALL( kernel, AddKernel, dataType );
+         break;
+      case ImageExpression::Operation::Subtract:
+         DIP_OVL_ASSIGN_ALL( kernel, SubtractKernel, dataType );
+         break;
+      case ImageExpression::Operation::Multiply:
+         DIP_OVL_ASSIGN_ALL( kernel, MultiplyKernel, dataType );
+         break;
+      case ImageExpression::Operation::Divide:
+         DIP_OVL_ASSIGN_ALL( kernel, DivideKernel, dataType );
+         break;
+      case ImageExpression::Operation::Invert:
+         DIP_OVL_ASSIGN_ALL( kernel, InvertKernel, dataType );
+         break;
+      default:
+         DIP_THROW( E::NOT_IMPLEMENTED );
+   }
+   return kernel;
+}
+
+} // namespace
+
+void ImageExpression::Evaluate( Image& out ) const {
+   // Flatten the tree into a program. Sub-expressions that appear multiple times are evaluated only once,
+   // and images that appear multiple times are read only once.
+   dip::Tensor const& outTensor = node_->tensor;
+   ExpressionProgram program;
+   ImageArray images;
+   std::vector< std::pair< Node const*, dip::uint >> visited;
+   std::function< dip::uint( Node const& ) > flatten = [ & ]( Node const& node ) -> dip::uint {
+      for( auto const& v : visited ) {
+         if( v.first == &node ) {
+            return v.second;
+         }
+      }
+      ExpressionStep step;
+      step.dataType = node.dataType;
+      if( node.operation == Operation::Leaf ) {
+         Image image = node.image;
+         if( image.IsScalar() && !outTensor.IsScalar() ) {
+            image.ExpandSingletonTensor( outTensor.Elements() );
+         }
+         step.input = images.size();
+         for( dip::uint ii = 0; ii < images.size(); ++ii ) {
+            if( images[ ii ].IsIdenticalView( image )) {
+               step.input = ii;
+               break;
+            }
+         }
+         if( step.input == images.size() ) {
+            images.push_back( std::move( image ));
+         }
+      } else {
+         step.kernel = GetKernel( node.operation, node.dataType );
+         step.lhs = flatten( *node.lhs );
+         if( node.operation != Operation::Invert ) {
+            step.rhs = flatten( *node.rhs );
+            step.dyadic = true;
+         }
+      }
+      program.push_back( step );
+      visited.emplace_back( &node, program.size() - 1 );
+      return program.size() - 1;
+   };
+   DIP_START_STACK_TRACE
+      flatten( *node_ );
+   DIP_END_STACK_TRACE
+   // Call the scan framework
+   ImageConstRefArray inar;
+   DataTypeArray inBufT;
+   for( auto const& image : images ) {
+      inar.emplace_back( image );
+      inBufT.push_back( image.DataType() );
+   }
+   ImageRefArray outar{ out };
+   dip::DataType dataType = node_->dataType;
+   ExpressionLineFilter lineFilter( program );
+   DIP_START_STACK_TRACE
+      Framework::Scan( inar, outar, inBufT, { dataType }, { dataType }, { outTensor.Elements() }, lineFilter,
+                       Framework::Scan_TensorAsSpatialDim );
+   DIP_END_STACK_TRACE
+   out.ReshapeTensor( outTensor );
+}
+
+} // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the lazy image expressions") {
+   dip::Image a( { 40, 30 }, 1, dip::DT_UINT8 );
+   dip::Image b( { 40, 1 }, 1, dip::DT_UINT8 );
+   dip::Image c( { 40, 30 }, 3, dip::DT_SFLOAT );
+   dip::uint8* aptr = static_cast< dip::uint8* >( a.Origin() );
+   for( dip::uint ii = 0; ii < a.NumberOfPixels(); ++ii ) {
+      aptr[ ii ] = static_cast< dip::uint8 >( ii * 37 );
+   }
+   dip::uint8* bptr = static_cast< dip::uint8* >( b.Origin() );
+   for( dip::uint ii = 0; ii < b.NumberOfPixels(); ++ii ) {
+      bptr[ ii ] = static_cast< dip::uint8 >( ii * 11 );
+   }
+   dip::sfloat* cptr = static_cast< dip::sfloat* >( c.Origin() );
+   for( dip::uint ii = 0; ii < c.NumberOfSamples(); ++ii ) {
+      cptr[ ii ] = static_cast< dip::sfloat >( ii ) * 0.37f - 100.0f;
+   }
+   // Saturated uint8 product, singleton expansion, promotion to float, tensor expansion
+   dip::Image eager = a * b + c / 2;
+   dip::Image lazy = dip::Lazy( a ) * b + c / 2;
+   DOCTEST_CHECK( lazy.DataType() == eager.DataType() );
+   DOCTEST_CHECK( lazy.Sizes() == eager.Sizes() );
+   DOCTEST_CHECK( lazy.Tensor() == eager.Tensor() );
+   DOCTEST_CHECK( dip::testing::CompareImages( lazy, eager ));
+   // Repeated sub-expressions, strided input and unary negation
+   dip::Image am = a;
+   am.Mirror();
+   dip::ImageExpression ab = dip::Lazy( a ) - am;
+   lazy = ab * ab - -dip::Lazy( a ) / 3;
+   eager = ( a - am ) * ( a - am ) - ( -a ) / 3;
+   DOCTEST_CHECK( lazy.DataType() == eager.DataType() );
+   DOCTEST_CHECK( dip::testing::CompareImages( lazy, eager ));
+   // In-place evaluation into a protected image
+   dip::Image out = a.Copy();
+   out.Protect();
+   ( dip::Lazy( out ) + 1.5 ).Evaluate( out );
+   DOCTEST_CHECK( out.DataType() == dip::DT_UINT8 );
+   DOCTEST_CHECK( dip::testing::CompareImages( out, dip::Convert( a + 1.5, dip::DT_UINT8 )));
+   // Errors
+   DOCTEST_CHECK_THROWS( dip::Lazy( c ) * c );
+   DOCTEST_CHECK_THROWS( dip::Lazy( dip::Image{} ));
+}
+
+#endif // DIP__ENABLE_DOCTEST
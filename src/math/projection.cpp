@@ -26,6 +26,7 @@
 #include "diplib/overload.h"
 #include "diplib/iterators.h"
 #include "diplib/accumulators.h"
+#include "diplib/multithreading.h"
 #include "diplib/library/copy_buffer.h"
 
 
@@ -41,10 +42,102 @@ class ProjectionScanFunction {
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint thread ) = 0;
       // The derived class can define this function if it needs this information ahead of time.
       virtual void SetNumberOfThreads( dip::uint /*threads*/ ) {}
+      // The derived class can define the following four functions if a projection over the whole image can
+      // be computed by splitting the image into parts, projecting each part independently (possibly in parallel),
+      // and merging the results. `ProjectPart` is called exactly once for each part, `MergeParts` then writes
+      // the result to `out`, as `Project` does.
+      virtual bool CanProjectInParts() const { return false; }
+      virtual void SetNumberOfParts( dip::uint /*parts*/ ) {}
+      virtual void ProjectPart( Image const& /*in*/, Image const& /*mask*/, dip::uint /*part*/ ) {}
+      virtual void MergeParts( void* /*out*/ ) {}
       // A virtual destructor guarantees that we can destroy a derived class by a pointer to base
       virtual ~ProjectionScanFunction() {}
 };
 
+// A projection over the whole image is split into parts of at least this many pixels, and at most `maxParts`
+// parts. The number of parts depends only on the image size, not on the number of threads, such that the
+// result does not depend on the number of threads used.
+constexpr dip::uint minPixelsPerPart = 65536;
+constexpr dip::uint maxParts = 64;
+
+// Reduces the number of dimensions of `in` and `mask` (if forged) without changing the set of pixels they
+// reference. Both images are modified identically, so that corresponding pixels remain paired.
+void FlattenJointly( Image& in, Image& mask ) {
+   if( !mask.IsForged() ) {
+      in.FlattenAsMuchAsPossible();
+   } else if( in.Strides() == mask.Strides() ) {
+      in.FlattenAsMuchAsPossible();
+      mask.FlattenAsMuchAsPossible();
+   }
+}
+
+// Calls `lineFunction( ptr, stride, length )` for each image line in `in`. `in` must be scalar.
+template< typename TPI, typename F >
+void ForEachImageLine( Image const& in, F const& lineFunction ) {
+   dip::uint procDim = Framework::OptimalProcessingDim( in );
+   dip::sint stride = in.Stride( procDim );
+   dip::uint length = in.Size( procDim );
+   ImageIterator< TPI > it( in, procDim );
+   do {
+      lineFunction( it.Pointer(), stride, length );
+   } while( ++it );
+}
+
+// Reductions over a single image line, written such that the compiler can vectorize the loop over contiguous data.
+// Integer samples are summed in a 64-bit integer, which is exact.
+template< typename TPI > struct LineSumType { using type = FlexType< TPI >; };
+template<> struct LineSumType< bin > { using type = dip::uint; };
+template<> struct LineSumType< uint8 > { using type = dip::uint; };
+template<> struct LineSumType< uint16 > { using type = dip::uint; };
+template<> struct LineSumType< uint32 > { using type = dip::uint; };
+template<> struct LineSumType< sint8 > { using type = dip::sint; };
+template<> struct LineSumType< sint16 > { using type = dip::sint; };
+template<> struct LineSumType< sint32 > { using type = dip::sint; };
+
+template< typename TPI >
+typename LineSumType< TPI >::type SumLine( TPI const* ptr, dip::sint stride, dip::uint length ) {
+   using TPS = typename LineSumType< TPI >::type;
+   TPS sum = 0;
+   if( stride == 1 ) {
+      for( dip::uint ii = 0; ii < length; ++ii ) {
+         sum += static_cast< TPS >( ptr[ ii ] );
+      }
+   } else {
+      for( dip::uint ii = 0; ii < length; ++ii, ptr += stride ) {
+         sum += static_cast< TPS >( *ptr );
+      }
+   }
+   return sum;
+}
+
+template< typename TPI >
+TPI MaxLine( TPI const* ptr, dip::sint stride, dip::uint length, TPI max ) {
+   if( stride == 1 ) {
+      for( dip::uint ii = 0; ii < length; ++ii ) {
+         max = std::max( max, ptr[ ii ] );
+      }
+   } else {
+      for( dip::uint ii = 0; ii < length; ++ii, ptr += stride ) {
+         max = std::max( max, *ptr );
+      }
+   }
+   return max;
+}
+
+template< typename TPI >
+TPI MinLine( TPI const* ptr, dip::sint stride, dip::uint length, TPI min ) {
+   if( stride == 1 ) {
+      for( dip::uint ii = 0; ii < length; ++ii ) {
+         min = std::min( min, ptr[ ii ] );
+      }
+   } else {
+      for( dip::uint ii = 0; ii < length; ++ii, ptr += stride ) {
+         min = std::min( min, *ptr );
+      }
+   }
+   return min;
+}
+
 void ProjectionScan(
       Image const& c_in,
       Image const& c_mask,
@@ -133,37 +226,71 @@ void ProjectionScan(
       nDims = outSizes.size();
    }
 
+
    // Do we need to loop at all?
-   if( process.all() ) {
+   if( output.NumberOfPixels() == 1 ) {
       //std::cout << "Projection framework: no need to loop!" << std::endl;
-      function.SetNumberOfThreads( 1 );
+      FlattenJointly( input, mask );
+      // Can we split the image into parts to be processed in parallel?
+      dip::uint nPixels = input.NumberOfPixels();
+      dip::uint nParts = 1;
+      dip::uint splitDim = 0;
+      if( function.CanProjectInParts() ) {
+         // Split along the dimension with the largest stride, so that each part is as compact as possible.
+         for( dip::uint ii = 1; ii < input.Dimensionality(); ++ii ) {
+            if( std::abs( input.Stride( ii )) > std::abs( input.Stride( splitDim ))) {
+               splitDim = ii;
+            }
+         }
+         nParts = std::min( std::min( nPixels / minPixelsPerPart, maxParts ), input.Size( splitDim ));
+      }
+      Image outBuffer;
+      void* outPtr = output.Origin();
       if( output.DataType() != outImageType ) {
-         Image outBuffer( {}, 1, outImageType );
-         function.Project( input, mask, outBuffer.Origin(), 0 );
+         outBuffer.SetDataType( outImageType );
+         outBuffer.Forge(); // By default it's a single sample.
+         outPtr = outBuffer.Origin();
+      }
+      if( nParts > 1 ) {
+         function.SetNumberOfParts( nParts );
+         dip::uint nThreads = OptimalNumberOfThreads( nPixels, std::min( GetNumberOfThreads(), nParts ));
+         dip::sint splitSize = static_cast< dip::sint >( input.Size( splitDim ));
+         dip::sint sParts = static_cast< dip::sint >( nParts );
+         WorkDistributor work( nParts, nThreads );
+         ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+            RangeArray ranges( input.Dimensionality() );
+            dip::uint begin, end;
+            while( work.Next( thread, begin, end )) {
+               for( dip::uint part = begin; part < end; ++part ) {
+                  dip::sint sPart = static_cast< dip::sint >( part );
+                  ranges[ splitDim ] = Range{ sPart * splitSize / sParts, ( sPart + 1 ) * splitSize / sParts - 1 };
+                  Image partIn = input.At( ranges );
+                  Image partMask;
+                  if( hasMask ) {
+                     partMask = mask.At( ranges );
+                  }
+                  function.ProjectPart( partIn, partMask, part );
+               }
+            }
+         } );
+         function.MergeParts( outPtr );
+      } else {
+         function.SetNumberOfThreads( 1 );
+         function.Project( input, mask, outPtr, 0 );
+      }
+      if( outBuffer.IsForged() ) {
          detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
                              output.Origin(), output.DataType(), 1, 1, 1, 1 );
-      } else {
-         function.Project( input, mask, output.Origin(), 0 );
       }
       return;
    }
 
-   // Can we treat the images as if they were 1D?
-   // TODO: This is an opportunity for improving performance if the non-processing dimensions in in, mask and out have the same layout and simple stride
-
-   // TODO: Determine the number of threads we'll be using. The size of the data has an influence. As is the number of sub-images that we can generate
-   function.SetNumberOfThreads( 1 );
-
-   // TODO: Start threads, each thread makes its own temp image.
-   dip::uint thread = 0;
-
    // Create view over input image, that spans the processing dimensions
    Image tempIn;
    tempIn.CopyProperties( input );
    tempIn.SetSizes( procSizes );
    tempIn.dip__SetOrigin( input.Origin() );
    tempIn.Squeeze(); // we want to make sure that function.Project() won't be looping over singleton dimensions
-   // TODO: instead of Squeeze, do a FlattenAsMuchAsPossible. But Mask must be flattened in the same way.
    // Create view over mask image, identically to input
    Image tempMask;
    if( hasMask ) {
@@ -172,12 +299,13 @@ void ProjectionScan(
       tempMask.dip__SetOrigin( mask.Origin() );
       tempMask.Squeeze(); // keep in sync with tempIn.
    }
-   // Create view over output image that doesn't contain the processing dimensions or other singleton dimensions
-   Image tempOut;
-   tempOut.CopyProperties( output );
-   // Squeeze tempOut, but keep inStride, maskStride, outStride and outSizes in synch
+   // Flattening might move the origin, we record how much so we can apply this shift to each sub-image
+   FlattenJointly( tempIn, tempMask );
+   dip::sint inOriginShift = static_cast< uint8* >( tempIn.Origin() ) - static_cast< uint8* >( input.Origin() );
+   dip::sint maskOriginShift = hasMask ? static_cast< uint8* >( tempMask.Origin() ) - static_cast< uint8* >( mask.Origin() ) : 0;
+   // Squeeze output, but keep inStride, maskStride, outStride and outSizes in synch
    IntegerArray inStride = input.Strides();
-   IntegerArray maskStride( nDims );
+   IntegerArray maskStride( nDims, 0 );
    if( hasMask ) {
       maskStride = mask.Strides();
    }
@@ -192,65 +320,115 @@ void ProjectionScan(
          ++jj;
       }
    }
-   inStride.resize( jj );
-   maskStride.resize( jj );
-   outStride.resize( jj );
-   outSizes.resize( jj );
    nDims = jj;
-   tempOut.SetSizes( outSizes );
-   tempOut.dip__SetOrigin( output.Origin() );
-   // Create a temporary output buffer, to collect a single sample in the data type requested by the calling function
-   bool useOutputBuffer = false;
-   Image outBuffer;
-   if( output.DataType() != outImageType ) {
-      // We need a temporary space for the output sample also, because `function.Project` expects `outImageType`.
-      outBuffer.SetDataType( outImageType );
-      outBuffer.Forge(); // By default it's a single sample.
-      useOutputBuffer = true;
-   }
-
-   // Iterate over the pixels in the output image. For each, we create a view in the input image.
-   UnsignedArray position( nDims, 0 );
-   for( ;; ) {
-
-      // Do the thing
-      if( useOutputBuffer ) {
-         function.Project( tempIn, tempMask, outBuffer.Origin(), thread );
-         // Copy data from output buffer to output image
-         detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
-                             tempOut.Origin(), tempOut.DataType(), 1, 1, 1, 1 );
-      } else {
-         function.Project( tempIn, tempMask, tempOut.Origin(), thread );
-      }
-
-      // Next output pixel
-      dip::uint dd;
-      for( dd = 0; dd < nDims; dd++ ) {
-         ++position[ dd ];
-         tempIn.dip__ShiftOrigin( inStride[ dd ]);
-         if( hasMask ) {
-            tempMask.dip__ShiftOrigin( maskStride[ dd ]);
+   // Merge output dimensions that can be walked through as a single one in input, mask and output
+   if( nDims > 1 ) {
+      jj = 0;
+      for( dip::uint ii = 1; ii < nDims; ++ii ) {
+         dip::sint size = static_cast< dip::sint >( outSizes[ jj ] );
+         if(( inStride[ ii ] == inStride[ jj ] * size ) &&
+            ( maskStride[ ii ] == maskStride[ jj ] * size ) &&
+            ( outStride[ ii ] == outStride[ jj ] * size )) {
+            outSizes[ jj ] *= outSizes[ ii ];
+         } else {
+            ++jj;
+            inStride[ jj ] = inStride[ ii ];
+            maskStride[ jj ] = maskStride[ ii ];
+            outStride[ jj ] = outStride[ ii ];
+            outSizes[ jj ] = outSizes[ ii ];
          }
-         tempOut.dip__ShiftOrigin( outStride[ dd ]);
-         // Check whether we reached the last pixel of the line
-         if( position[ dd ] != outSizes[ dd ] ) {
-            break;
+      }
+      nDims = jj + 1;
+   }
+   inStride.resize( nDims );
+   maskStride.resize( nDims );
+   outStride.resize( nDims );
+   outSizes.resize( nDims );
+   dip::uint nOutPixels = outSizes.product();
+
+   // Determine the number of threads we'll be using. Each thread processes a range of output pixels.
+   dip::uint nThreads = std::min( GetNumberOfThreads(), nOutPixels );
+   if( nThreads > 1 ) {
+      nThreads = OptimalNumberOfThreads( input.NumberOfPixels(), nThreads );
+   }
+   function.SetNumberOfThreads( nThreads );
+
+   dip::sint outSampleSize = static_cast< dip::sint >( output.DataType().SizeOf() );
+   WorkDistributor work( nOutPixels, nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      // Each thread makes its own copies of the views, which it moves around the image
+      Image threadIn = tempIn;
+      Image threadMask = tempMask;
+      // Create a temporary output buffer, to collect a single sample in the data type requested by the calling function
+      bool useOutputBuffer = false;
+      Image outBuffer;
+      if( output.DataType() != outImageType ) {
+         // We need a temporary space for the output sample also, because `function.Project` expects `outImageType`.
+         outBuffer.SetDataType( outImageType );
+         outBuffer.Forge(); // By default it's a single sample.
+         useOutputBuffer = true;
+      }
+      UnsignedArray position( nDims, 0 );
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         // Set the views to the first output pixel in our range
+         dip::uint index = begin;
+         dip::sint inOffset = 0;
+         dip::sint maskOffset = 0;
+         dip::sint outOffset = 0;
+         for( dip::uint dd = 0; dd < nDims; ++dd ) {
+            position[ dd ] = index % outSizes[ dd ];
+            index /= outSizes[ dd ];
+            dip::sint pos = static_cast< dip::sint >( position[ dd ] );
+            inOffset += pos * inStride[ dd ];
+            maskOffset += pos * maskStride[ dd ];
+            outOffset += pos * outStride[ dd ];
          }
-         // Rewind along this dimension
-         tempIn.dip__ShiftOrigin( -inStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+         threadIn.dip__SetOrigin( static_cast< uint8* >( input.Origin() ) + inOriginShift );
+         threadIn.dip__ShiftOrigin( inOffset );
          if( hasMask ) {
-            tempMask.dip__ShiftOrigin( -maskStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+            threadMask.dip__SetOrigin( static_cast< uint8* >( mask.Origin() ) + maskOriginShift );
+            threadMask.dip__ShiftOrigin( maskOffset );
+         }
+         uint8* outPtr = static_cast< uint8* >( output.Origin() ) + outOffset * outSampleSize;
+
+         // Iterate over the pixels in the output image. For each, we create a view in the input image.
+         for( dip::uint ii = begin; ii < end; ++ii ) {
+
+            // Do the thing
+            if( useOutputBuffer ) {
+               function.Project( threadIn, threadMask, outBuffer.Origin(), thread );
+               // Copy data from output buffer to output image
+               detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
+                                   outPtr, output.DataType(), 1, 1, 1, 1 );
+            } else {
+               function.Project( threadIn, threadMask, outPtr, thread );
+            }
+
+            // Next output pixel
+            for( dip::uint dd = 0; dd < nDims; dd++ ) {
+               ++position[ dd ];
+               threadIn.dip__ShiftOrigin( inStride[ dd ] );
+               if( hasMask ) {
+                  threadMask.dip__ShiftOrigin( maskStride[ dd ] );
+               }
+               outPtr += outStride[ dd ] * outSampleSize;
+               // Check whether we reached the last pixel of the line
+               if( position[ dd ] != outSizes[ dd ] ) {
+                  break;
+               }
+               // Rewind along this dimension
+               threadIn.dip__ShiftOrigin( -inStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+               if( hasMask ) {
+                  threadMask.dip__ShiftOrigin( -maskStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+               }
+               outPtr -= outStride[ dd ] * static_cast< dip::sint >( position[ dd ] ) * outSampleSize;
+               position[ dd ] = 0;
+               // Continue loop to increment along next dimension
+            }
          }
-         tempOut.dip__ShiftOrigin( -outStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
-         position[ dd ] = 0;
-         // Continue loop to increment along next dimension
-      }
-      if( dd == nDims ) {
-         break;            // We're done!
       }
-   }
-
-   // TODO: End threads.
+   } );
 }
 
 } // namespace
@@ -263,29 +441,53 @@ class ProjectionMean : public ProjectionScanFunction {
    public:
       ProjectionMean( bool computeMean ) : computeMean_( computeMean ) {}
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
-         dip::uint n = 0;
+         Write( Accumulate( in, mask ), out );
+      }
+      virtual bool CanProjectInParts() const override { return true; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         parts_[ part ] = Accumulate( in, mask );
+      }
+      virtual void MergeParts( void* out ) override {
+         Partial total;
+         for( auto const& part : parts_ ) {
+            total.sum += part.sum;
+            total.n += part.n;
+         }
+         Write( total, out );
+      }
+   private:
+      struct Partial {
          FlexType< TPI > sum = 0;
+         dip::uint n = 0;
+      };
+      Partial Accumulate( Image const& in, Image const& mask ) {
+         Partial result;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
             do {
                if( it.template Sample< 1 >() ) {
-                  sum += static_cast< FlexType< TPI >>( it.template Sample< 0 >() );
-                  ++n;
+                  result.sum += static_cast< FlexType< TPI >>( it.template Sample< 0 >() );
+                  ++result.n;
                }
             } while( ++it );
          } else {
-            ImageIterator< TPI > it( in );
-            do {
-               sum += static_cast< FlexType< TPI >>( *it );
-            } while( ++it );
-            n = in.NumberOfPixels();
+            ForEachImageLine< TPI >( in, [ & ]( TPI const* ptr, dip::sint stride, dip::uint length ) {
+               result.sum += static_cast< FlexType< TPI >>( SumLine( ptr, stride, length ));
+            } );
+            result.n = in.NumberOfPixels();
          }
-         *static_cast< FlexType< TPI >* >( out ) = ( computeMean_ && ( n > 0 ))
-                                                   ? ( sum / static_cast< FloatType< TPI >>( n ))
-                                                   : ( sum );
+         return result;
+      }
+      void Write( Partial const& result, void* out ) {
+         *static_cast< FlexType< TPI >* >( out ) = ( computeMean_ && ( result.n > 0 ))
+                                                   ? ( result.sum / static_cast< FloatType< TPI >>( result.n ))
+                                                   : ( result.sum );
       }
-   private:
       bool computeMean_ = true;
+      std::vector< Partial > parts_;
 };
 
 template< typename TPI >
@@ -513,6 +715,24 @@ class ProjectionVariance : public ProjectionScanFunction {
    public:
       ProjectionVariance( bool computeStD ) : computeStD_( computeStD ) {}
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+         Write( Accumulate( in, mask ), out );
+      }
+      virtual bool CanProjectInParts() const override { return true; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         parts_[ part ] = Accumulate( in, mask );
+      }
+      virtual void MergeParts( void* out ) override {
+         ACC acc;
+         for( auto const& part : parts_ ) {
+            acc += part;
+         }
+         Write( acc, out );
+      }
+   private:
+      ACC Accumulate( Image const& in, Image const& mask ) {
          ACC acc;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
@@ -522,16 +742,20 @@ class ProjectionVariance : public ProjectionScanFunction {
                }
             } while( ++it );
          } else {
-            ImageIterator< TPI > it( in );
-            do {
-               acc.Push( static_cast< dfloat >( *it ));
-            } while( ++it );
+            ForEachImageLine< TPI >( in, [ & ]( TPI const* ptr, dip::sint stride, dip::uint length ) {
+               for( dip::uint ii = 0; ii < length; ++ii, ptr += stride ) {
+                  acc.Push( static_cast< dfloat >( *ptr ));
+               }
+            } );
          }
+         return acc;
+      }
+      void Write( ACC const& acc, void* out ) {
          *static_cast< FloatType< TPI >* >( out ) = clamp_cast< FloatType< TPI >>(
                computeStD_ ? acc.StandardDeviation() : acc.Variance() );
       }
-   private:
       bool computeStD_ = true;
+      std::vector< ACC > parts_;
 };
 
 template< typename TPI >
@@ -603,6 +827,24 @@ template< typename TPI >
 class ProjectionMaximum : public ProjectionScanFunction {
    public:
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+         *static_cast< TPI* >( out ) = Accumulate( in, mask );
+      }
+      virtual bool CanProjectInParts() const override { return true; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         parts_[ part ] = Accumulate( in, mask );
+      }
+      virtual void MergeParts( void* out ) override {
+         TPI max = std::numeric_limits< TPI >::lowest();
+         for( auto const& part : parts_ ) {
+            max = std::max( max, part );
+         }
+         *static_cast< TPI* >( out ) = max;
+      }
+   private:
+      TPI Accumulate( Image const& in, Image const& mask ) {
          TPI max = std::numeric_limits< TPI >::lowest();
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
@@ -612,13 +854,13 @@ class ProjectionMaximum : public ProjectionScanFunction {
                }
             } while( ++it );
          } else {
-            ImageIterator< TPI > it( in );
-            do {
-               max = std::max( max, *it );
-            } while( ++it );
+            ForEachImageLine< TPI >( in, [ & ]( TPI const* ptr, dip::sint stride, dip::uint length ) {
+               max = MaxLine( ptr, stride, length, max );
+            } );
          }
-         *static_cast< TPI* >( out ) = max;
+         return max;
       }
+      std::vector< TPI > parts_;
 };
 
 }
@@ -640,6 +882,24 @@ template< typename TPI >
 class ProjectionMinimum : public ProjectionScanFunction {
    public:
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+         *static_cast< TPI* >( out ) = Accumulate( in, mask );
+      }
+      virtual bool CanProjectInParts() const override { return true; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         parts_[ part ] = Accumulate( in, mask );
+      }
+      virtual void MergeParts( void* out ) override {
+         TPI min = std::numeric_limits< TPI >::max();
+         for( auto const& part : parts_ ) {
+            min = std::min( min, part );
+         }
+         *static_cast< TPI* >( out ) = min;
+      }
+   private:
+      TPI Accumulate( Image const& in, Image const& mask ) {
          TPI min = std::numeric_limits< TPI >::max();
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
@@ -649,13 +909,13 @@ class ProjectionMinimum : public ProjectionScanFunction {
                }
             } while( ++it );
          } else {
-            ImageIterator< TPI > it( in );
-            do {
-               min = std::min( min, *it );
-            } while( ++it );
+            ForEachImageLine< TPI >( in, [ & ]( TPI const* ptr, dip::sint stride, dip::uint length ) {
+               min = MinLine( ptr, stride, length, min );
+            } );
          }
-         *static_cast< TPI* >( out ) = min;
+         return min;
       }
+      std::vector< TPI > parts_;
 };
 
 }
@@ -760,86 +1020,46 @@ void MinimumAbs(
 
 namespace {
 
+// Computes the rank of the `percentile` percentile in a set of `N` values, `N > 0`.
+inline dip::uint PercentileRank( dip::uint N, dfloat percentile ) {
+   return std::min( static_cast< dip::uint >( floor_cast( static_cast< dfloat >( N ) * percentile / 100.0 )), N - 1 );
+}
+
+// Calls `function( value )` for each sample in `in` selected by `mask` (if forged). `in` must be scalar.
+template< typename TPI, typename F >
+void ForEachSample( Image const& in, Image const& mask, F const& function ) {
+   if( mask.IsForged() ) {
+      JointImageIterator< TPI, bin > it( { in, mask } );
+      do {
+         if( it.template Sample< 1 >() ) {
+            function( it.template Sample< 0 >() );
+         }
+      } while( ++it );
+   } else {
+      ForEachImageLine< TPI >( in, [ & ]( TPI const* ptr, dip::sint stride, dip::uint length ) {
+         for( dip::uint ii = 0; ii < length; ++ii, ptr += stride ) {
+            function( *ptr );
+         }
+      } );
+   }
+}
+
+// Exact percentile by partial sorting of a copy of the data.
 template< typename TPI >
 class ProjectionPercentile : public ProjectionScanFunction {
    public:
       ProjectionPercentile( dfloat percentile ) : percentile_( percentile ) {}
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint thread ) override {
-         dip::uint N;
-         if( mask.IsForged() ) {
-            N = Count( mask );
-         } else {
-            N = in.NumberOfPixels();
-         }
-         if( N == 0 ) {
+         std::vector< TPI >& buffer = buffer_[ thread ];
+         buffer.clear();
+         buffer.reserve( in.NumberOfPixels() );
+         ForEachSample< TPI >( in, mask, [ & ]( TPI value ) { buffer.push_back( value ); } );
+         if( buffer.empty() ) {
             *static_cast< TPI* >( out ) = TPI{};
             return;
          }
-         dip::sint rank = floor_cast( static_cast< dfloat >( N ) * percentile_ / 100.0 ); // rank < N, because percentile_ < 100
-         buffer_[ thread ].resize( N );
-#if 0 // Strategy 1: Copy data to buffer, and partition at the same time. The issue is finding a good pivot
-         auto leftIt = buffer_[ thread ].begin();
-         auto rightIt = buffer_[ thread ].rbegin();
-         TPI pivot{};
-         if( mask.IsForged() ) {
-            JointImageIterator< TPI, bin > it( { in, mask } );
-            do {
-               if( it.template Sample< 1 >() ) {
-                  pivot = it.template Sample< 0 >();
-                  ++it;
-                  break;
-               }
-            } while( ++it );
-            do {
-               if( it.template Sample< 1 >() ) {
-                  TPI v = it.template Sample< 0 >();
-                  if( v < pivot ) {
-                     *( leftIt++ ) = v;
-                  } else {
-                     *( rightIt++ ) = v;
-                  }
-               }
-            } while( ++it );
-         } else {
-            ImageIterator< TPI > it( in );
-            pivot = *( it++ );
-            do {
-               TPI v = *it;
-               if( v < pivot ) {
-                  *( leftIt++ ) = v;
-               } else {
-                  *( rightIt++ ) = v;
-               }
-            } while( ++it );
-         }
-         DIP_ASSERT( &*leftIt == &*rightIt ); // They should both be pointing to the same array element.
-         *leftIt = pivot;
-         auto ourGuy = buffer_[ thread ].begin() + rank;
-         if( ourGuy < leftIt ) {
-            // our guy is to the left
-            std::nth_element( buffer_[ thread ].begin(), ourGuy, leftIt );
-         } else if( ourGuy > leftIt ){
-            // our guy is to the right
-            std::nth_element( ++leftIt, ourGuy, buffer_[ thread ].end() );
-         } // else: ourGuy == leftIt, which is already sorted correctly.
-#else // Strategy 1: Copy data to buffer, let std lib do the partitioning using its OK pivot strategy
-         auto outIt = buffer_[ thread ].begin();
-         if( mask.IsForged() ) {
-            JointImageIterator< TPI, bin > it( { in, mask } );
-            do {
-               if( it.template Sample< 1 >() ) {
-                  *( outIt++ ) = it.template Sample< 0 >();
-               }
-            } while( ++it );
-         } else {
-            ImageIterator< TPI > it( in );
-            do {
-               *( outIt++ ) = *it;
-            } while( ++it );
-         }
-         auto ourGuy = buffer_[ thread ].begin() + rank;
-         std::nth_element( buffer_[ thread ].begin(), ourGuy, buffer_[ thread ].end() );
-#endif
+         auto ourGuy = buffer.begin() + static_cast< dip::sint >( PercentileRank( buffer.size(), percentile_ ));
+         std::nth_element( buffer.begin(), ourGuy, buffer.end() );
          *static_cast< TPI* >( out ) = *ourGuy;
       }
       void SetNumberOfThreads( dip::uint threads ) override {
@@ -850,6 +1070,275 @@ class ProjectionPercentile : public ProjectionScanFunction {
       dfloat percentile_;
 };
 
+// 8-bit and 16-bit integer samples are mapped to an unsigned key with the same ordering, such that
+// the percentile can be found by counting keys in a histogram.
+template< typename TPI >
+struct HistogramKey {
+   static constexpr bool valid = std::is_integral< TPI >::value && ( sizeof( TPI ) <= 2 );
+   static constexpr dip::uint bits = 8 * sizeof( TPI );
+   static dip::uint Key( TPI value ) {
+      return static_cast< dip::uint >( static_cast< dip::sint >( value ) - static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+   }
+   static TPI Value( dip::uint key ) {
+      return static_cast< TPI >( static_cast< dip::sint >( key ) + static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+   }
+};
+template<>
+struct HistogramKey< bin > {
+   static constexpr bool valid = true;
+   static constexpr dip::uint bits = 8;
+   static dip::uint Key( bin value ) { return value ? 1 : 0; }
+   static bin Value( dip::uint key ) { return key != 0; }
+};
+
+// Finds the bin in `histogram` that contains the value of rank `rank`, and updates `rank` to be the rank within that bin.
+inline dip::uint FindRankInHistogram( std::vector< dip::uint > const& histogram, dip::uint& rank ) {
+   dip::uint bin = 0;
+   while( rank >= histogram[ bin ] ) {
+      rank -= histogram[ bin ];
+      ++bin;
+   }
+   return bin;
+}
+
+// Exact percentile for 8-bit and 16-bit integer data by radix selection: a 256-bin histogram of the most
+// significant byte of each sample selects the byte that the percentile has, and for 16-bit data a second pass
+// over the data builds a histogram of the least significant byte of those samples that share this first byte.
+// For 8-bit data the projection can be computed in parts.
+template< typename TPI >
+class ProjectionPercentileHistogram : public ProjectionScanFunction {
+      using Key = HistogramKey< TPI >;
+      static constexpr dip::uint nBins = 256;
+      static constexpr dip::uint shift = Key::bits - 8;
+   public:
+      ProjectionPercentileHistogram( dfloat percentile ) : percentile_( percentile ) {}
+      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint thread ) override {
+         std::vector< dip::uint >& histogram = histogram_[ thread ];
+         histogram.assign( nBins, 0 );
+         ForEachSample< TPI >( in, mask, [ & ]( TPI value ) { ++histogram[ Key::Key( value ) >> shift ]; } );
+         *static_cast< TPI* >( out ) = Select( histogram, in, mask );
+      }
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         histogram_.resize( threads );
+      }
+      virtual bool CanProjectInParts() const override { return shift == 0; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         std::vector< dip::uint >& histogram = parts_[ part ];
+         histogram.assign( nBins, 0 );
+         ForEachSample< TPI >( in, mask, [ & ]( TPI value ) { ++histogram[ Key::Key( value ) ]; } );
+      }
+      virtual void MergeParts( void* out ) override {
+         std::vector< dip::uint > histogram( nBins, 0 );
+         for( auto const& part : parts_ ) {
+            for( dip::uint ii = 0; ii < nBins; ++ii ) {
+               histogram[ ii ] += part[ ii ];
+            }
+         }
+         *static_cast< TPI* >( out ) = Select( histogram, {}, {} );
+      }
+   private:
+      // Finds the percentile given the histogram of the most significant byte. For 16-bit data, `histogram` is
+      // reused for the second pass over `in`.
+      TPI Select( std::vector< dip::uint >& histogram, Image const& in, Image const& mask ) {
+         dip::uint N = 0;
+         for( auto n : histogram ) {
+            N += n;
+         }
+         if( N == 0 ) {
+            return TPI{};
+         }
+         dip::uint rank = PercentileRank( N, percentile_ );
+         dip::uint key = FindRankInHistogram( histogram, rank );
+         if( shift > 0 ) {
+            histogram.assign( nBins, 0 );
+            ForEachSample< TPI >( in, mask, [ & ]( TPI value ) {
+               dip::uint k = Key::Key( value );
+               if(( k >> shift ) == key ) {
+                  ++histogram[ k & ( nBins - 1 ) ];
+               }
+            } );
+            key = ( key << shift ) + FindRankInHistogram( histogram, rank );
+         }
+         return Key::Value( key );
+      }
+      std::vector< std::vector< dip::uint >> histogram_;
+      std::vector< std::vector< dip::uint >> parts_;
+      dfloat percentile_;
+};
+
+// A t-digest: a compact summary of a set of values, from which quantiles can be estimated, and which can be
+// built in a single pass over the data. Values are collected into a buffer, which is regularly merged into
+// a sorted set of centroids. Centroids are kept small near the extremes of the distribution, and larger near
+// the median, according to the k1 scale function. See T. Dunning and O. Ertl, "Computing extremely accurate
+// quantiles using t-digests", arXiv:1902.04023, 2019.
+class TDigest {
+   public:
+      // A centroid spans at most about pi/compression of the data, this bounds the error in the rank of
+      // an estimated quantile.
+      static constexpr dfloat compression = 300;
+      static constexpr dip::uint bufferSize = 5 * static_cast< dip::uint >( compression );
+
+      void Reset() {
+         centroids_.clear();
+         buffer_.clear();
+         weight_ = 0;
+         min_ = std::numeric_limits< dfloat >::max();
+         max_ = std::numeric_limits< dfloat >::lowest();
+      }
+
+      void Push( dfloat value ) {
+         buffer_.push_back( { value, 1 } );
+         weight_ += 1;
+         min_ = std::min( min_, value );
+         max_ = std::max( max_, value );
+         if( buffer_.size() >= bufferSize ) {
+            Compress();
+         }
+      }
+
+      TDigest& operator+=( TDigest const& other ) {
+         buffer_.insert( buffer_.end(), other.buffer_.begin(), other.buffer_.end() );
+         buffer_.insert( buffer_.end(), other.centroids_.begin(), other.centroids_.end() );
+         weight_ += other.weight_;
+         min_ = std::min( min_, other.min_ );
+         max_ = std::max( max_, other.max_ );
+         if( buffer_.size() >= bufferSize ) {
+            Compress();
+         }
+         return *this;
+      }
+
+      bool IsEmpty() const { return weight_ == 0; }
+
+      // Returns the estimated `percentile` percentile. If the digest contains few enough values to not
+      // have been compressed, the result is exact.
+      dfloat Percentile( dfloat percentile ) {
+         DIP_ASSERT( !IsEmpty() );
+         if( centroids_.empty() && ( static_cast< dfloat >( buffer_.size() ) == weight_ )) {
+            auto ourGuy = buffer_.begin() + static_cast< dip::sint >( PercentileRank( buffer_.size(), percentile ));
+            std::nth_element( buffer_.begin(), ourGuy, buffer_.end(), []( Centroid const& a, Centroid const& b ) { return a.mean < b.mean; } );
+            return ourGuy->mean;
+         }
+         Compress();
+         // Interpolate between the centers of the centroids, and between the extreme values and the outer centroids
+         dfloat target = weight_ * percentile / 100.0;
+         dfloat left = 0;       // cumulative weight at the left edge of centroid `ii`
+         dfloat prevCenter = 0; // cumulative weight at the center of the previous centroid
+         dfloat prevMean = min_;
+         for( auto const& c : centroids_ ) {
+            dfloat center = left + c.weight / 2;
+            if( target < center ) {
+               return prevMean + ( c.mean - prevMean ) * ( target - prevCenter ) / ( center - prevCenter );
+            }
+            prevCenter = center;
+            prevMean = c.mean;
+            left += c.weight;
+         }
+         if( weight_ <= prevCenter ) {
+            return max_;
+         }
+         return prevMean + ( max_ - prevMean ) * ( target - prevCenter ) / ( weight_ - prevCenter );
+      }
+
+   private:
+      struct Centroid {
+         dfloat mean;
+         dfloat weight;
+      };
+
+      static dfloat ScaleFunction( dfloat q ) {
+         return compression / ( 2 * pi ) * std::asin( 2 * clamp( q, 0.0, 1.0 ) - 1 );
+      }
+
+      // Merges the buffer into the centroids
+      void Compress() {
+         if( buffer_.empty() ) {
+            return;
+         }
+         buffer_.insert( buffer_.end(), centroids_.begin(), centroids_.end() );
+         std::sort( buffer_.begin(), buffer_.end(), []( Centroid const& a, Centroid const& b ) { return a.mean < b.mean; } );
+         centroids_.clear();
+         Centroid current = buffer_[ 0 ];
+         dfloat weightSoFar = 0;
+         dfloat kLeft = ScaleFunction( 0 );
+         for( dip::uint ii = 1; ii < buffer_.size(); ++ii ) {
+            dfloat qRight = ( weightSoFar + current.weight + buffer_[ ii ].weight ) / weight_;
+            if( ScaleFunction( qRight ) - kLeft <= 1.0 ) {
+               current.mean += ( buffer_[ ii ].mean - current.mean ) * buffer_[ ii ].weight / ( current.weight + buffer_[ ii ].weight );
+               current.weight += buffer_[ ii ].weight;
+            } else {
+               centroids_.push_back( current );
+               weightSoFar += current.weight;
+               kLeft = ScaleFunction( weightSoFar / weight_ );
+               current = buffer_[ ii ];
+            }
+         }
+         centroids_.push_back( current );
+         buffer_.clear();
+      }
+
+      std::vector< Centroid > centroids_;
+      std::vector< Centroid > buffer_;
+      dfloat weight_ = 0;
+      dfloat min_ = std::numeric_limits< dfloat >::max();
+      dfloat max_ = std::numeric_limits< dfloat >::lowest();
+};
+
+// Approximate percentile in a single pass over the data, using a t-digest.
+template< typename TPI >
+class ProjectionPercentileApproximate : public ProjectionScanFunction {
+   public:
+      ProjectionPercentileApproximate( dfloat percentile ) : percentile_( percentile ) {}
+      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint thread ) override {
+         TDigest& digest = digest_[ thread ];
+         Accumulate( digest, in, mask );
+         Write( digest, out );
+      }
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         digest_.resize( threads );
+      }
+      virtual bool CanProjectInParts() const override { return true; }
+      virtual void SetNumberOfParts( dip::uint parts ) override {
+         parts_.resize( parts );
+      }
+      virtual void ProjectPart( Image const& in, Image const& mask, dip::uint part ) override {
+         Accumulate( parts_[ part ], in, mask );
+      }
+      virtual void MergeParts( void* out ) override {
+         TDigest digest;
+         for( auto const& part : parts_ ) {
+            digest += part;
+         }
+         Write( digest, out );
+      }
+   private:
+      static void Accumulate( TDigest& digest, Image const& in, Image const& mask ) {
+         digest.Reset();
+         ForEachSample< TPI >( in, mask, [ & ]( TPI value ) { digest.Push( static_cast< dfloat >( value )); } );
+      }
+      void Write( TDigest& digest, void* out ) {
+         *static_cast< TPI* >( out ) = digest.IsEmpty() ? TPI{} : clamp_cast< TPI >( digest.Percentile( percentile_ ));
+      }
+      std::vector< TDigest > digest_;
+      std::vector< TDigest > parts_;
+      dfloat percentile_;
+};
+
+template< typename TPI, typename std::enable_if< HistogramKey< TPI >::valid, int >::type = 0 >
+std::unique_ptr< ProjectionScanFunction > NewProjectionPercentile( dfloat percentile, bool /*approximate*/ ) {
+   return static_cast< std::unique_ptr< ProjectionScanFunction >>( new ProjectionPercentileHistogram< TPI >( percentile ));
+}
+template< typename TPI, typename std::enable_if< !HistogramKey< TPI >::valid, int >::type = 0 >
+std::unique_ptr< ProjectionScanFunction > NewProjectionPercentile( dfloat percentile, bool approximate ) {
+   if( approximate ) {
+      return static_cast< std::unique_ptr< ProjectionScanFunction >>( new ProjectionPercentileApproximate< TPI >( percentile ));
+   }
+   return static_cast< std::unique_ptr< ProjectionScanFunction >>( new ProjectionPercentile< TPI >( percentile ));
+}
+
 }
 
 void Percentile(
@@ -857,16 +1346,19 @@ void Percentile(
       Image const& mask,
       Image& out,
       dfloat percentile,
+      String const& mode,
       BooleanArray const& process
 ) {
    DIP_THROW_IF(( percentile < 0.0 ) || ( percentile > 100.0 ), E::PARAMETER_OUT_OF_RANGE );
+   bool approximate;
+   DIP_STACK_TRACE_THIS( approximate = BooleanFromString( mode, "approximate", "exact" ));
    if( percentile == 0.0 ) {
       Minimum( in, mask, out, process );
    } else if( percentile == 100.0 ) {
       Maximum( in, mask, out, process );
    } else {
       std::unique_ptr< ProjectionScanFunction > lineFilter;
-      DIP_OVL_NEW_NONCOMPLEX( lineFilter, ProjectionPercentile, ( percentile ), in.DataType() );
+      DIP_OVL_CALL_ASSIGN_NONCOMPLEX( lineFilter, NewProjectionPercentile, ( percentile, approximate ), in.DataType() );
       ProjectionScan( in, mask, out, in.DataType(), process, *lineFilter );
    }
 }
@@ -958,6 +1450,7 @@ void Any(
 
 
 #ifdef DIP__ENABLE_DOCTEST
+#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the projection functions") {
    // We mostly test that the ProjectionScan framework works appropriately.
@@ -1018,4 +1511,92 @@ DOCTEST_TEST_CASE("[DIPlib] testing the projection functions") {
          std::atan2( std::sin( 1 ), std::cos( 1 ) + ( 3 * 4 * 2 - 1 ))));
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the multi-threaded projection functions") {
+   // Results must be independent of the number of threads used, and must match a simple serial computation.
+   dip::Image img{ dip::UnsignedArray{ 300, 250, 3 }, 1, dip::DT_UINT16 };
+   dip::uint16 value = 0;
+   dip::uint sum = 0;
+   dip::uint16 max = 0;
+   dip::ImageIterator< dip::uint16 > it( img );
+   do {
+      value = static_cast< dip::uint16 >(( value * 31 + 7 ) % 1009 );
+      *it = value;
+      sum += value;
+      max = std::max( max, value );
+   } while( ++it );
+   dip::Image mask = img > 500;
+   dip::BooleanArray ps{ true, false, true };
+   dip::Image reference = dip::Image{ dip::UnsignedArray{ 1, 250, 1 }, 1, dip::DT_SFLOAT };
+   for( dip::uint y = 0; y < 250; ++y ) {
+      dip::uint lineSum = 0;
+      for( dip::uint z = 0; z < 3; ++z ) {
+         for( dip::uint x = 0; x < 300; ++x ) {
+            lineSum += img.At( x, y, z ).As< dip::uint >();
+         }
+      }
+      reference.At( 0, y, 0 ) = static_cast< dip::dfloat >( lineSum );
+   }
+
+   std::vector< dip::Image > results[ 2 ];
+   bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+      dip::Image out = dip::Sum( img );
+      DOCTEST_CHECK( out.As< dip::dfloat >() == doctest::Approx( static_cast< dip::dfloat >( sum )));
+      results[ ii ].push_back( out );
+      out = dip::Maximum( img );
+      DOCTEST_CHECK( out.As< dip::uint >() == max );
+      results[ ii ].push_back( out );
+      out = dip::Sum( img, {}, ps );
+      DOCTEST_CHECK( dip::Count( out != reference ) == 0 );
+      results[ ii ].push_back( out );
+      dip::Image mirrored = img.QuickCopy();
+      mirrored.Mirror( { true, true, false } );
+      out = dip::Sum( mirrored, {}, ps );
+      out.Mirror( { false, true, false } );
+      DOCTEST_CHECK( dip::Count( out != reference ) == 0 );
+      results[ ii ].push_back( dip::Variance( img, mask ));
+      results[ ii ].push_back( dip::Minimum( img, mask, { false, true, false } ));
+      results[ ii ].push_back( dip::Percentile( img, mask, 30, "exact", ps ));
+      results[ ii ].push_back( dip::Percentile( dip::Convert( img, dip::DT_SFLOAT ), {}, 30, "approximate" ));
+   } );
+   if( multiThreaded ) {
+      for( dip::uint ii = 0; ii < results[ 0 ].size(); ++ii ) {
+         DOCTEST_CHECK( dip::Count( results[ 0 ][ ii ] != results[ 1 ][ ii ] ) == 0 );
+      }
+   }
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the percentile projection") {
+   // The histogram-based selection for small integer types must yield the same result as sorting
+   dip::Image img{ dip::UnsignedArray{ 20, 30, 200 }, 1, dip::DT_SINT16 };
+   dip::sint value = 0;
+   dip::ImageIterator< dip::sint16 > it( img );
+   do {
+      value = ( value * 4099 + 12345 ) % 65521;
+      *it = static_cast< dip::sint16 >( value - 32768 );
+   } while( ++it );
+   dip::Image mask = img > -10000;
+   dip::BooleanArray ps{ false, false, true };
+   for( dip::DataType dt : { dip::DT_SINT16, dip::DT_UINT16, dip::DT_UINT8, dip::DT_SINT8 } ) {
+      dip::Image in = dip::Convert( img, dt );
+      dip::Image reference = dip::Percentile( dip::Convert( in, dip::DT_SINT32 ), mask, 30, "exact", ps );
+      dip::Image out = dip::Percentile( in, mask, 30, "exact", ps );
+      DOCTEST_CHECK( out.DataType() == dt );
+      DOCTEST_CHECK( dip::Count( out != reference ) == 0 );
+      reference = dip::Percentile( dip::Convert( in, dip::DT_SINT32 ), {}, 70 );
+      out = dip::Percentile( in, {}, 70 );
+      DOCTEST_CHECK( out.As< dip::sint >() == reference.As< dip::sint >() );
+   }
+
+   // The approximate percentile is exact for small sets, and has a small rank error for large ones
+   dip::Image flt = dip::Convert( img, dip::DT_SFLOAT );
+   dip::Image out = dip::Percentile( flt, mask, 30, "approximate", ps );
+   DOCTEST_CHECK( dip::Count( out != dip::Percentile( flt, mask, 30, "exact", ps )) == 0 );
+   dip::uint N = flt.NumberOfPixels();
+   for( dip::dfloat percentile : { 1.0, 30.0, 50.0, 99.5 } ) {
+      out = dip::Percentile( flt, {}, percentile, "approximate" );
+      dip::uint rank = dip::Count( flt < out.As< dip::dfloat >() );
+      DOCTEST_CHECK( std::abs( static_cast< dip::dfloat >( rank ) - static_cast< dip::dfloat >( N ) * percentile / 100.0 ) < 0.01 * static_cast< dip::dfloat >( N ));
+   }
+}
+
 #endif // DIP__ENABLE_DOCTEST
@@ -734,3 +734,68 @@ MomentAccumulator Moments(
 }
 
 } // namespace dip
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/accumulators.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the merging of statistics accumulators") {
+   // Merging must yield the same result as pushing all samples into one accumulator, also when one of the
+   // two is empty, as happens when a thread in a parallel reduction is not handed any work.
+   dip::StatisticsAccumulator all;
+   dip::StatisticsAccumulator part1;
+   dip::StatisticsAccumulator part2;
+   dip::VarianceAccumulator allVar;
+   dip::VarianceAccumulator part1Var;
+   dip::VarianceAccumulator part2Var;
+   for( dip::uint ii = 0; ii < 20; ++ii ) {
+      dip::dfloat x = static_cast< dip::dfloat >(( ii * 7 ) % 11 ) + 0.5;
+      all.Push( x );
+      allVar.Push( x );
+      if( ii < 8 ) {
+         part1.Push( x );
+         part1Var.Push( x );
+      } else {
+         part2.Push( x );
+         part2Var.Push( x );
+      }
+   }
+   dip::StatisticsAccumulator empty;
+   dip::VarianceAccumulator emptyVar;
+   for( dip::uint order = 0; order < 3; ++order ) {
+      dip::StatisticsAccumulator acc;
+      dip::VarianceAccumulator accVar;
+      switch( order ) {
+         case 0: // An empty accumulator merged into a filled one
+            acc = all;
+            acc += empty;
+            accVar = allVar;
+            accVar += emptyVar;
+            break;
+         case 1: // A filled accumulator merged into an empty one
+            acc += all;
+            accVar += allVar;
+            break;
+         default: // Two filled accumulators
+            acc = part1;
+            acc += part2;
+            accVar = part1Var;
+            accVar += part2Var;
+            break;
+      }
+      DOCTEST_CHECK( acc.Number() == all.Number() );
+      DOCTEST_CHECK( acc.Mean() == doctest::Approx( all.Mean() ));
+      DOCTEST_CHECK( acc.Variance() == doctest::Approx( all.Variance() ));
+      DOCTEST_CHECK( acc.Skewness() == doctest::Approx( all.Skewness() ));
+      DOCTEST_CHECK( acc.ExcessKurtosis() == doctest::Approx( all.ExcessKurtosis() ));
+      DOCTEST_CHECK( accVar.Number() == allVar.Number() );
+      DOCTEST_CHECK( accVar.Mean() == doctest::Approx( allVar.Mean() ));
+      DOCTEST_CHECK( accVar.Variance() == doctest::Approx( allVar.Variance() ));
+   }
+   dip::StatisticsAccumulator acc;
+   acc += empty;
+   DOCTEST_CHECK( acc.Number() == 0 );
+   DOCTEST_CHECK( acc.Mean() == 0.0 );
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -52,7 +52,7 @@ class FeatureCartesianBox : public LineBased {
             LineIterator <dfloat>, // unused
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexLookup const& objectIndices
       ) override {
          // If new objectID is equal to previous one, we don't need to fetch the data pointer again
          uint32 objectID = 0;
@@ -61,11 +61,11 @@ class FeatureCartesianBox : public LineBased {
             if( *label > 0 ) {
                if( *label != objectID ) {
                   objectID = *label;
-                  auto it = objectIndices.find( objectID );
-                  if( it == objectIndices.end() ) {
+                  dip::uint index;
+                  if( !objectIndices.Find( objectID, index )) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * nD_ ] );
+                     data = &( data_[ index * nD_ ] );
                      for( dip::uint ii = 0; ii < nD_; ii++ ) {
                         data[ ii ].min = std::min( data[ ii ].min, coordinates[ ii ] );
                         data[ ii ].max = std::max( data[ ii ].max, coordinates[ ii ] );
@@ -94,6 +94,18 @@ class FeatureCartesianBox : public LineBased {
          }
       }
 
+      virtual std::unique_ptr< LineBased > Clone() const override {
+         return std::unique_ptr< LineBased >( new FeatureCartesianBox( *this ));
+      }
+
+      virtual void Reduce( LineBased& other ) override {
+         auto const& otherData = static_cast< FeatureCartesianBox& >( other ).data_;
+         for( dip::uint ii = 0; ii < data_.size(); ++ii ) {
+            data_[ ii ].min = std::min( data_[ ii ].min, otherData[ ii ].min );
+            data_[ ii ].max = std::max( data_[ ii ].max, otherData[ ii ].max );
+         }
+      }
+
       virtual void Cleanup() override {
          data_.clear();
          data_.shrink_to_fit();
@@ -52,7 +52,7 @@ class FeatureCenter : public LineBased {
             LineIterator <dfloat>,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexLookup const& objectIndices
       ) override {
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          uint32 objectID = 0;
@@ -61,11 +61,11 @@ class FeatureCenter : public LineBased {
             if( *label > 0 ) {
                if( *label != objectID ) {
                   objectID = *label;
-                  auto it = objectIndices.find( objectID );
-                  if( it == objectIndices.end() ) {
+                  dip::uint index;
+                  if( !objectIndices.Find( objectID, index )) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * ( nD_ + 1 ) ] );
+                     data = &( data_[ index * ( nD_ + 1 ) ] );
                   }
                }
                if( data ) {
@@ -92,6 +92,17 @@ class FeatureCenter : public LineBased {
          }
       }
 
+      virtual std::unique_ptr< LineBased > Clone() const override {
+         return std::unique_ptr< LineBased >( new FeatureCenter( *this ));
+      }
+
+      virtual void Reduce( LineBased& other ) override {
+         auto const& otherData = static_cast< FeatureCenter& >( other ).data_;
+         for( dip::uint ii = 0; ii < data_.size(); ++ii ) {
+            data_[ ii ] += otherData[ ii ];
+         }
+      }
+
       virtual void Cleanup() override {
          data_.clear();
          data_.shrink_to_fit();
@@ -44,7 +44,7 @@ class FeatureDirectionalStatistics : public LineBased {
             LineIterator <dfloat> grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexLookup const& objectIndices
       ) override {
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          uint32 objectID = 0;
@@ -53,11 +53,11 @@ class FeatureDirectionalStatistics : public LineBased {
             if( *label > 0 ) {
                if( *label != objectID ) {
                   objectID = *label;
-                  auto it = objectIndices.find( objectID );
-                  if( it == objectIndices.end() ) {
+                  dip::uint index;
+                  if( !objectIndices.Find( objectID, index )) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( data_[ index ] );
                   }
                }
                if( data ) {
@@ -74,6 +74,17 @@ class FeatureDirectionalStatistics : public LineBased {
          output[ 1 ] = data.StandardDeviation();
       }
 
+      virtual std::unique_ptr< LineBased > Clone() const override {
+         return std::unique_ptr< LineBased >( new FeatureDirectionalStatistics( *this ));
+      }
+
+      virtual void Reduce( LineBased& other ) override {
+         auto const& otherData = static_cast< FeatureDirectionalStatistics& >( other ).data_;
+         for( dip::uint ii = 0; ii < data_.size(); ++ii ) {
+            data_[ ii ] += otherData[ ii ];
+         }
+      }
+
       virtual void Cleanup() override {
          data_.clear();
          data_.shrink_to_fit();
@@ -70,7 +70,7 @@ class FeatureGreyMu : public LineBased {
             LineIterator <dfloat> grey,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexLookup const& objectIndices
       ) override {
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          uint32 objectID = 0;
@@ -80,11 +80,11 @@ class FeatureGreyMu : public LineBased {
             if( *label > 0 ) {
                if( *label != objectID ) {
                   objectID = *label;
-                  auto it = objectIndices.find( objectID );
-                  if( it == objectIndices.end() ) {
+                  dip::uint index;
+                  if( !objectIndices.Find( objectID, index )) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( data_[ index ] );
                   }
                }
                if( data ) {
@@ -104,6 +104,17 @@ class FeatureGreyMu : public LineBased {
          }
       }
 
+      virtual std::unique_ptr< LineBased > Clone() const override {
+         return std::unique_ptr< LineBased >( new FeatureGreyMu( *this ));
+      }
+
+      virtual void Reduce( LineBased& other ) override {
+         auto const& otherData = static_cast< FeatureGreyMu& >( other ).data_;
+         for( dip::uint ii = 0; ii < data_.size(); ++ii ) {
+            data_[ ii ] += otherData[ ii ];
+         }
+      }
+
       virtual void Cleanup() override {
          data_.clear();
          data_.shrink_to_fit();
@@ -42,7 +42,7 @@ class FeatureMean : public LineBased {
             LineIterator <dfloat> grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexLookup const& objectIndices
       ) override {
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          uint32 objectID = 0;
@@ -51,11 +51,11 @@ class FeatureMean : public LineBased {
             if( *label > 0 ) {
                if( *label != objectID ) {
                   objectID = *label;
-                  auto it = objectIndices.find( objectID );
-                  if( it == objectIndices.end() ) {
+                  dip::uint index;
+                  if( !objectIndices.Find( objectID, index )) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( data_[ index ] );
                   }
                }
                if( data ) {
@@ -72,6 +72,18 @@ class FeatureMean : public LineBased {
          *output = ( data.number != 0 ) ? ( data.sum / static_cast< dfloat >( data.number )) : ( 0.0 );
       }
 
+      virtual std::unique_ptr< LineBased > Clone() const override {
+         return std::unique_ptr< LineBased >( new FeatureMean( *this ));
+      }
+
+      virtual void Reduce( LineBased& other ) override {
+         auto const& otherData = static_cast< FeatureMean& >( other ).data_;
+         for( dip::uint ii = 0; ii < data_.size(); ++ii ) {
+            data_[ ii ].sum += otherData[ ii ].sum;
+            data_[ ii ].number += otherData[ ii ].number;
+         }
+      }
+
       virtual void Cleanup() override {
          data_.clear();
          data_.shrink_to_fit();
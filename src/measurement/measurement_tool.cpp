@@ -23,6 +23,7 @@
 #include "diplib/iterators.h"
 #include "diplib/chain_code.h"
 #include "diplib/framework.h"
+#include "diplib/multithreading.h"
 #include "diplib/regions.h"
 
 // FEATURES:
@@ -121,9 +122,23 @@ namespace {
 
 // dip::Framework::ScanFilter function, not overloaded because the Feature::LineBased::ScanLine functions
 // that we call here are not overloaded.
+// If all features can be cloned, each thread uses its own copy of the features, which are merged by `Reduce`.
 class MeasureLineFilter : public Framework::ScanLineFilter {
    public:
-      // not defining GetNumberOfOperations(), always called in a single thread
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         return 5 * features_.size(); // a rough estimate: looking up the object index and updating the accumulators
+      }
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         // `CanRunInParallel` has already created the copies for the first additional thread
+         threadFeatures_.resize( threads - 1 );
+         for( auto& copies : threadFeatures_ ) {
+            if( copies.empty() ) {
+               for( auto const& feature : features_ ) {
+                  copies.emplace_back( feature->Clone() );
+               }
+            }
+         }
+      }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          LineIterator< uint32 > label(
                static_cast< uint32* >( params.inBuffer[ 0 ].buffer ),
@@ -139,17 +154,43 @@ class MeasureLineFilter : public Framework::ScanLineFilter {
             );
          }
 
-         for( auto const& feature : features ) {
+         for( dip::uint ii = 0; ii < features_.size(); ++ii ) {
+            Feature::LineBased* feature = params.thread == 0 ? features_[ ii ] : threadFeatures_[ params.thread - 1 ][ ii ].get();
             // NOTE! params.dimension here works as long as params.tensorToSpatial is false.
             // As is now, MeasurementTool::Measure only works with scalar images, so we don't need to test here.
-            feature->ScanLine( label, grey, params.position, params.dimension, objectIndices );
+            feature->ScanLine( label, grey, params.position, params.dimension, objectIndices_ );
          }
       }
       MeasureLineFilter( LineBasedFeatureArray const& features, ObjectIdToIndexMap const& objectIndices ) :
-            features( features ), objectIndices( objectIndices ) {}
+            features_( features ), objectIndices_( objectIndices ) {}
+      // Returns true if all features can be cloned, creating the copies for one additional thread.
+      bool CanRunInParallel() {
+         if( GetNumberOfThreads() < 2 ) {
+            return false;
+         }
+         std::vector< std::unique_ptr< Feature::LineBased >> copies;
+         for( auto const& feature : features_ ) {
+            copies.emplace_back( feature->Clone() );
+            if( !copies.back() ) {
+               return false;
+            }
+         }
+         threadFeatures_.push_back( std::move( copies ));
+         return true;
+      }
+      // Merges the measurements accumulated by the other threads into the original features
+      void Reduce() {
+         for( auto& copies : threadFeatures_ ) {
+            for( dip::uint ii = 0; ii < features_.size(); ++ii ) {
+               features_[ ii ]->Reduce( *copies[ ii ] );
+            }
+         }
+         threadFeatures_.clear();
+      }
    private:
-      LineBasedFeatureArray const& features;
-      ObjectIdToIndexMap const& objectIndices;
+      LineBasedFeatureArray const& features_;
+      ObjectIdToIndexLookup objectIndices_;
+      std::vector< std::vector< std::unique_ptr< Feature::LineBased >>> threadFeatures_;
 };
 
 } // namespace
@@ -260,8 +301,12 @@ Measurement MeasurementTool::Measure(
 
       // Do the scan, which calls dip::Feature::LineBased::ScanLine()
       MeasureLineFilter functor{ lineBasedFeatures, measurement.ObjectIndices() };
-      Framework::Scan( inar, outar, inBufT, {}, {}, {}, functor,
-            Framework::Scan_NoMultiThreading + Framework::Scan_NeedCoordinates );
+      Framework::ScanOptions opts = Framework::Scan_NeedCoordinates;
+      if( !functor.CanRunInParallel() ) {
+         opts += Framework::Scan_NoMultiThreading;
+      }
+      Framework::Scan( inar, outar, inBufT, {}, {}, {}, functor, opts );
+      functor.Reduce();
 
       // Call dip::Feature::LineBased::Finish()
       for( auto const& feature : lineBasedFeatures ) {
@@ -334,3 +379,54 @@ Measurement MeasurementTool::Measure(
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the parallel measurement of line-based features") {
+   dip::Random random( 0 );
+   dip::Image grey( { 300, 200 }, 1, dip::DT_SFLOAT );
+   grey.Fill( 0 );
+   dip::UniformNoise( grey, grey, random );
+   dip::Image label = dip::Label( grey > 0.6, 1 );
+   dip::Image sparseLabel = label * 1000; // object IDs that are not compact
+   sparseLabel.Convert( dip::DT_UINT32 );
+   dip::MeasurementTool tool;
+   dip::StringArray features{ "Size", "Minimum", "CartesianBox", "Center", "Mean", "MinVal", "StandardDeviation", "Mu" };
+   dip::Measurement msr[ 2 ];
+   dip::Measurement msrSparse[ 2 ];
+   bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+      msr[ ii ] = tool.Measure( label, grey, features );
+      msrSparse[ ii ] = tool.Measure( sparseLabel, grey, features );
+   } );
+   // Without multithreading we still compare the compact and sparse object IDs
+   dip::Measurement& msr1 = msr[ 0 ];
+   dip::Measurement& msrN = msr[ multiThreaded ? 1 : 0 ];
+   dip::Measurement& msrSparseN = msrSparse[ multiThreaded ? 1 : 0 ];
+   DOCTEST_REQUIRE( msr1.NumberOfObjects() > 1000 );
+   DOCTEST_REQUIRE( msrN.NumberOfObjects() == msr1.NumberOfObjects() );
+   DOCTEST_REQUIRE( msrSparseN.NumberOfObjects() == msr1.NumberOfObjects() );
+   bool match = true;
+   for( auto id : msr1.Objects() ) {
+      auto obj1 = msr1[ id ];
+      auto obj4 = msrN[ id ];
+      auto objSparse = msrSparseN[ id * 1000 ];
+      for( auto const& feature : features ) {
+         auto v1 = obj1[ feature ];
+         auto v4 = obj4[ feature ];
+         auto vs = objSparse[ feature ];
+         for( dip::uint ii = 0; ii < v1.size(); ++ii ) {
+            dip::dfloat tolerance = 1e-10 * std::abs( v1[ ii ] ) + 1e-12;
+            match &= std::abs( v1[ ii ] - v4[ ii ] ) <= tolerance;
+            match &= std::abs( v1[ ii ] - vs[ ii ] ) <= tolerance;
+         }
+      }
+   }
+   DOCTEST_CHECK( match );
+}
+
+#endif // DIP__ENABLE_DOCTEST
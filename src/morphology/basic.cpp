@@ -976,6 +976,30 @@ DOCTEST_TEST_CASE("[DIPlib] testing the basic morphological filters") {
    DOCTEST_CHECK( dip::Count( out ) == 1 );
    DOCTEST_CHECK( out.At( 32, 20 ) == pval );
 
+   // Grey-value SE morphology -- mirroring a run of different weights
+   seImg = dip::Image( { 3, 1 }, 1, dip::DT_SFLOAT );
+   seImg.At( 0, 0 ) = 0;
+   seImg.At( 1, 0 ) = -1;
+   seImg.At( 2, 0 ) = -2;
+   se = seImg;
+   auto checkRow = [ & ]( dip::UnsignedArray const& values ) { // values at x = 30..34, zero elsewhere near the pixel
+      DOCTEST_CHECK( dip::Sum( out.At( dip::Range{ 26, 38 }, dip::Range{ 16, 24 } )).As< dip::uint >() == values.sum() );
+      for( dip::uint ii = 0; ii < 5; ++ii ) {
+         DOCTEST_CHECK( out.At( 30 + ii, 20 ) == values[ ii ] );
+      }
+   };
+   dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::DILATION );
+   checkRow( { 0, pval - 2, pval - 1, pval, 0 } );
+   dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::CLOSING );
+   checkRow( { 1, 2, pval, 0, 0 } );
+   dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::OPENING );
+   checkRow( { 0, 0, 1, 0, 0 } );
+   se.Mirror(); // the weights must be mirrored together with the pixel locations
+   dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::DILATION );
+   checkRow( { 0, pval, pval - 1, pval - 2, 0 } );
+   dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::EROSION );
+   checkRow( { 0, 1, 0, 0, 0 } );
+
    // Line morphology
    se = {{ 10, 4 }, "discrete line" };
    dip::detail::BasicMorphology( in, out, se, {}, dip::detail::BasicMorphologyOperation::DILATION );
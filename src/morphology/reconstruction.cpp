@@ -18,8 +18,6 @@
  * limitations under the License.
  */
 
-#include <queue>
-
 #include "diplib.h"
 #include "diplib/morphology.h"
 #include "diplib/statistics.h"
@@ -32,20 +30,6 @@ namespace dip {
 
 namespace {
 
-template< typename TPI >
-struct Qitem {
-   TPI value;              // pixel value - used for sorting
-   dip::sint offset;       // offset into `done` image
-};
-template< typename TPI >
-bool QitemComparator_LowFirst( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return a.value > b.value;
-}
-template< typename TPI >
-bool QitemComparator_HighFirst ( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return a.value < b.value;
-}
-
 template< typename TPI >
 void dip__MorphologicalReconstruction(
       Image const& c_in,
@@ -58,36 +42,29 @@ void dip__MorphologicalReconstruction(
       Image const& c_minval,
       bool dilation
 ) {
-   auto QitemComparator = dilation ? QitemComparator_HighFirst< TPI > : QitemComparator_LowFirst< TPI >;
-   std::priority_queue< Qitem< TPI >, std::vector< Qitem< TPI >>, decltype( QitemComparator ) > Q( QitemComparator );
-
    dip::uint nNeigh = neighborList.Size();
    UnsignedArray const& imsz = c_in.Sizes();
 
    TPI minval = *static_cast< TPI const* >( c_minval.Origin() );
 
-   // Walk over the entire image & put all the pixels larger than minval on the heap.
-   // Also set done=DIP_FALSE for all pixels and reduce the value of c_out where c_out > c_in.
+   // Walk over the entire image, set done=DIP_FALSE for all pixels and reduce the value of c_out where c_out > c_in.
    JointImageIterator< TPI, TPI, bin > it( { c_in, c_out, c_done } );
-   if( dilation ) {
-      do {
-         it.Out() = std::min( it.Out(), it.In() );
-         if( it.Out() > minval ) {
-            Q.push( Qitem< TPI >{ it.Out(), it.template Offset< 2 >() } ); // offset pushed is that of `done`, so we can test it fast.
-            //std::cout << " - Pushed " << it.Out();
-         }
-         it.template Sample< 2 >() = false;
-      } while( ++it );
-   } else {
-      do {
-         it.Out() = std::max( it.Out(), it.In() );
-         if( it.Out() < minval ) {
-            Q.push( Qitem< TPI >{ it.Out(), it.template Offset< 2 >() } ); // offset pushed is that of `done`, so we can test it fast.
-            //std::cout << " - Pushed " << it.Out();
-         }
-         it.template Sample< 2 >() = false;
-      } while( ++it );
-   }
+   do {
+      it.Out() = dilation ? std::min( it.Out(), it.In() ) : std::max( it.Out(), it.In() );
+      it.template Sample< 2 >() = false;
+   } while( ++it );
+
+   // All values pushed are within the range of `c_out` at this point: they are either values of `c_out`, or
+   // values of `c_in` clipped by values of `c_out`.
+   PixelQueue< TPI > Q( !dilation, c_out ); // Offsets pushed are those of `done`, so we can test it fast.
+
+   // Put all the pixels larger than minval on the heap.
+   it.Reset();
+   do {
+      if( dilation ? it.Out() > minval : it.Out() < minval ) {
+         Q.Push( it.Out(), it.template Offset< 2 >() );
+      }
+   } while( ++it );
 
    // Start processing pixels
    TPI* in = static_cast< TPI* >( c_in.Origin() );
@@ -95,9 +72,9 @@ void dip__MorphologicalReconstruction(
    bin* done = static_cast< bin* >( c_done.Origin() );
    auto coordinatesComputer = c_done.OffsetToCoordinatesComputer();
    BooleanArray skipar( nNeigh );
-   while( !Q.empty() ) {
-      dip::sint offsetDone = Q.top().offset;
-      Q.pop();
+   while( !Q.Empty() ) {
+      dip::sint offsetDone = Q.Top();
+      Q.Pop();
       if( !done[ offsetDone ] ) {
          UnsignedArray coords = coordinatesComputer( offsetDone );
          dip::sint offsetIn = c_in.Offset( coords );
@@ -115,7 +92,7 @@ void dip__MorphologicalReconstruction(
                      if( out[ offsetOut + neighborOffsetsOut[ jj ]] < newval ) {
                         out[ offsetOut + neighborOffsetsOut[ jj ]] = newval;
                         // Add the updated neighbours to the heap
-                        Q.push( Qitem< TPI >{ newval, offsetDone + neighborOffsetsDone[ jj ] } );
+                        Q.Push( newval, offsetDone + neighborOffsetsDone[ jj ] );
                         //std::cout << " - Pushed " << newval;
                      }
                   } else {
@@ -123,7 +100,7 @@ void dip__MorphologicalReconstruction(
                      if( out[ offsetOut + neighborOffsetsOut[ jj ]] > newval ) {
                         out[ offsetOut + neighborOffsetsOut[ jj ]] = newval;
                         // Add the updated neighbours to the heap
-                        Q.push( Qitem< TPI >{ newval, offsetDone + neighborOffsetsDone[ jj ] } );
+                        Q.Push( newval, offsetDone + neighborOffsetsDone[ jj ] );
                         //std::cout << " - Pushed " << newval;
                      }
                   }
@@ -183,3 +160,34 @@ void MorphologicalReconstruction (
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/linear.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the morphological reconstruction with integer and floating-point images") {
+   dip::Image image( { 120, 90 }, 1, dip::DT_SFLOAT );
+   image.Fill( 0 );
+   dip::Random random( 0 );
+   dip::GaussianNoise( image, image, random, 1.0 );
+   dip::Gauss( image, image, { 2.0 } );
+   image *= 300;
+   image += 128;
+   dip::Image grey = dip::Convert( image, dip::DT_UINT8 );
+   dip::Image marker = grey - 20;
+   image = dip::Convert( grey, dip::DT_SFLOAT );
+   dip::Image result1 = dip::MorphologicalReconstruction( marker, grey );
+   dip::Image result2 = dip::MorphologicalReconstruction( marker, image );
+   DOCTEST_CHECK( result1.DataType() == dip::DT_UINT8 );
+   DOCTEST_CHECK( dip::testing::CompareImages( dip::Convert( result1, dip::DT_SFLOAT ), result2 ));
+   marker = grey + 20;
+   result1 = dip::MorphologicalReconstruction( marker, grey, 2, dip::S::EROSION );
+   result2 = dip::MorphologicalReconstruction( marker, image, 2, dip::S::EROSION );
+   DOCTEST_CHECK( dip::testing::CompareImages( dip::Convert( result1, dip::DT_SFLOAT ), result2 ));
+}
+
+#endif // DIP__ENABLE_DOCTEST
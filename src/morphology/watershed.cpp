@@ -19,7 +19,6 @@
  */
 
 #include <functional>
-#include <queue>
 
 #include "diplib.h"
 #include "diplib/morphology.h"
@@ -415,27 +414,12 @@ constexpr LabelType WATERSHED_LABEL = std::numeric_limits< LabelType >::max();
 constexpr LabelType PIXEL_ON_STACK = WATERSHED_LABEL - 1;
 constexpr LabelType MAX_LABEL = WATERSHED_LABEL - 2;
 
-template< typename TPI >
-struct Qitem {
-   TPI value;              // pixel value - used for sorting
-   dip::uint insertOrder;  // order of insertion - used for sorting
-   dip::sint offset;       // offset into labels image
-};
-template< typename TPI >
-bool QitemComparator_LowFirst( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return ( a.value > b.value ) || (( a.value == b.value ) && ( a.insertOrder > b.insertOrder )); // NOTE comparison on insertOrder! It's always "low first"
-}
-template< typename TPI >
-bool QitemComparator_HighFirst ( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return ( a.value < b.value ) || (( a.value == b.value ) && ( a.insertOrder > b.insertOrder )); // NOTE comparison on insertOrder! It's always "low first"
-}
-
 template< typename TPI, typename QType >
 inline void EnqueueNeighbors(
       TPI* grey, LabelType* labels, BooleanArray const& useNeighbor,
       dip::sint offsetGrey, dip::sint offsetLabels,
       IntegerArray const& neighborOffsetsGrey, IntegerArray const& neighborOffsetsLabels,
-      QType& Q, dip::uint& order, bool lowFirst, bool uphillOnly
+      QType& Q, bool lowFirst, bool uphillOnly
 ) {
    for( dip::uint jj = 0; jj < useNeighbor.size(); ++jj ) {
       if( useNeighbor[ jj ] ) {
@@ -443,7 +427,7 @@ inline void EnqueueNeighbors(
          if( labels[ neighOffset ] == 0 ) {
             TPI nVal = grey[ offsetGrey + neighborOffsetsGrey[ jj ] ];
             if( !uphillOnly || ( lowFirst ? grey[ offsetGrey ] < nVal : grey[ offsetGrey ] > nVal )) {
-               Q.push( Qitem< TPI >{ nVal, order++, neighOffset } );
+               Q.Push( nVal, neighOffset );
                labels[ neighOffset ] = PIXEL_ON_STACK;
             }
          }
@@ -474,8 +458,7 @@ void dip__SeededWatershed(
                                             : std::numeric_limits< TPI >::lowest() );
    WatershedRegionList< TPI, decltype( AddRegions ) > regions( numlabs, defaultRegion, AddRegions );
 
-   auto QitemComparator = lowFirst ? QitemComparator_LowFirst< TPI > : QitemComparator_HighFirst< TPI >;
-   std::priority_queue< Qitem< TPI >, std::vector< Qitem< TPI >>, decltype( QitemComparator ) > Q( QitemComparator );
+   PixelQueue< TPI > Q( lowFirst, c_grey );
 
    dip::uint nNeigh = neighborOffsetsLabels.size();
    UnsignedArray const& imsz = c_grey.Sizes();
@@ -484,7 +467,6 @@ void dip__SeededWatershed(
    // TODO: StandardizeStrides() across multiple images?
    JointImageIterator< TPI, LabelType, bin > it( { c_grey, c_labels, c_mask } );
    bool hasMask = c_mask.IsForged();
-   dip::uint order = 0;
    do {
       if( !hasMask || it.template Sample< 2 >() ) {
          LabelType lab = it.template Sample< 1 >();
@@ -504,7 +486,7 @@ void dip__SeededWatershed(
                                               hasMask ? it.template Pointer< 2 >() : nullptr,
                                               neighborList, neighborOffsetsLabels, neighborOffsetsMask,
                                               it.Coordinates(), imsz, onEdge )) {
-               Q.push( Qitem< TPI >{ it.template Sample< 0 >(), order++, it.template Offset< 1 >() } );
+               Q.Push( it.template Sample< 0 >(), it.template Offset< 1 >() );
                it.template Sample< 1 >() = PIXEL_ON_STACK;
             }
          } else { // lab > 0
@@ -524,9 +506,9 @@ void dip__SeededWatershed(
    auto coordinatesComputer = c_labels.OffsetToCoordinatesComputer();
    NeighborLabels neighborLabels;
    BooleanArray useNeighbor( nNeigh );
-   while( !Q.empty() ) {
-      dip::sint offsetLabels = Q.top().offset;
-      Q.pop();
+   while( !Q.Empty() ) {
+      dip::sint offsetLabels = Q.Top();
+      Q.Pop();
       UnsignedArray coords = coordinatesComputer( offsetLabels );
       bool onEdge = c_grey.IsOnEdge( coords ); // TODO: label edge pixels (use upper bit?) such that we don't need to do compute this
       dip::sint offsetGrey = c_grey.Offset( coords );
@@ -559,7 +541,7 @@ void dip__SeededWatershed(
             AddPixel( regions, lab, grey[ offsetGrey ], lowFirst );
             // Add all unprocessed neighbors to heap
             EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                              neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                              neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
             break;
          }
          default: {
@@ -581,7 +563,7 @@ void dip__SeededWatershed(
                AddPixel( regions, lab, grey[ offsetGrey ], lowFirst );
                // Add all unprocessed neighbors to heap
                EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                                 neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                                 neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
             } else {
                // Else don't merge
                if( noGaps ) {
@@ -609,7 +591,7 @@ void dip__SeededWatershed(
                      AddPixel( regions, bestLab, grey[ offsetGrey ], lowFirst );
                      // Add all unprocessed neighbors to heap
                      EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                                       neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                                       neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
                   }
                } else {
                   // Set as watershed label (so it won't be considered again)
@@ -790,3 +772,44 @@ void WatershedMaxima(
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/linear.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the seeded watershed with integer and floating-point images") {
+   // The integer image has many pixels with the same value, the order in which these are processed must be
+   // the same for the bucket queue used for integer images as for the heap used for floating-point images.
+   dip::Image image( { 120, 90 }, 1, dip::DT_SFLOAT );
+   image.Fill( 0 );
+   dip::Random random( 0 );
+   dip::GaussianNoise( image, image, random, 1.0 );
+   dip::Gauss( image, image, { 3.0 } );
+   image *= 200;
+   image += 1000;
+   dip::Image grey = dip::Convert( image, dip::DT_UINT16 );
+   dip::Image seeds = dip::Minima( grey, {}, 1, dip::S::LABELS );
+   image = dip::Convert( grey, dip::DT_SFLOAT );
+   for( auto const& flags : std::vector< dip::StringSet >{
+         { dip::S::LABELS }, { dip::S::BINARY }, { dip::S::LABELS, dip::S::NOGAPS }, { dip::S::LABELS, dip::S::UPHILLONLY }} ) {
+      dip::Image result1 = dip::SeededWatershed( grey, seeds, {}, 1, 5.0, 0, flags );
+      dip::Image result2 = dip::SeededWatershed( image, seeds, {}, 1, 5.0, 0, flags );
+      DOCTEST_CHECK( dip::testing::CompareImages( result1, result2 ));
+   }
+   seeds = dip::Maxima( grey, {}, 1, dip::S::LABELS );
+   dip::Image result1 = dip::SeededWatershed( grey, seeds, {}, 2, 5.0, 0, { dip::S::LABELS, dip::S::HIGHFIRST } );
+   dip::Image result2 = dip::SeededWatershed( image, seeds, {}, 2, 5.0, 0, { dip::S::LABELS, dip::S::HIGHFIRST } );
+   DOCTEST_CHECK( dip::testing::CompareImages( result1, result2 ));
+   // The bucket queue only has buckets for the range of values in the image, here all negative
+   image -= 3000;
+   grey = dip::Convert( image, dip::DT_SINT16 );
+   result1 = dip::SeededWatershed( grey, seeds, {}, 2, 5.0, 0, { dip::S::LABELS, dip::S::HIGHFIRST } );
+   result2 = dip::SeededWatershed( image, seeds, {}, 2, 5.0, 0, { dip::S::LABELS, dip::S::HIGHFIRST } );
+   DOCTEST_CHECK( dip::testing::CompareImages( result1, result2 ));
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -21,7 +21,10 @@
 #ifndef DIP_WATERSHED_SUPPORT_H
 #define DIP_WATERSHED_SUPPORT_H
 
+#include <queue>
+
 #include "diplib.h"
+#include "diplib/statistics.h"
 
 namespace dip {
 
@@ -36,6 +39,114 @@ DIP_NO_EXPORT std::vector< dip::sint > CreateOffsetsArray( Image const& mask, In
 // Sorts the list of offsets by the grey value they index.
 DIP_NO_EXPORT void SortOffsets( Image const& img, std::vector< dip::sint >& offsets, bool lowFirst );
 
+// A priority queue of pixel offsets, ordered by grey value: the lowest value first if `lowFirst`, the highest
+// value first otherwise. Pixels with the same grey value are popped in the order in which they were pushed.
+// All values pushed must be within the range of values of `grey`.
+// This generic version uses a heap, with an insertion counter to break ties.
+template< typename TPI >
+class DIP_NO_EXPORT PixelHeapQueue {
+   public:
+      PixelHeapQueue( bool lowFirst, Image const& /*grey*/ ) : queue_( Comparator{ lowFirst } ) {}
+      void Push( TPI value, dip::sint offset ) {
+         queue_.push( Item{ value, order_++, offset } );
+      }
+      dip::sint Top() const {
+         return queue_.top().offset;
+      }
+      void Pop() {
+         queue_.pop();
+      }
+      bool Empty() const {
+         return queue_.empty();
+      }
+   private:
+      struct Item {
+         TPI value;              // pixel value - used for sorting
+         dip::uint insertOrder;  // order of insertion - used for sorting
+         dip::sint offset;       // offset into image
+      };
+      struct Comparator {
+         bool lowFirst;
+         bool operator()( Item const& a, Item const& b ) const {
+            if( a.value == b.value ) {
+               return a.insertOrder > b.insertOrder; // NOTE comparison on insertOrder! It's always "low first"
+            }
+            return lowFirst ? a.value > b.value : a.value < b.value;
+         }
+      };
+      std::priority_queue< Item, std::vector< Item >, Comparator > queue_;
+      dip::uint order_ = 0;
+};
+
+// The same priority queue for 8-bit and 16-bit integer grey values, implemented as a hierarchical queue:
+// there is one FIFO queue for each grey value in the range of `grey`. Pushing and popping take constant time,
+// and the grey value and insertion order are not stored with the pixel offset.
+template< typename TPI >
+class DIP_NO_EXPORT PixelBucketQueue {
+   public:
+      PixelBucketQueue( bool lowFirst, Image const& grey ) : lowFirst_( lowFirst ) {
+         MinMaxAccumulator range = MaximumAndMinimum( grey );
+         lowest_ = static_cast< TPI >( range.Minimum() );
+         nLevels_ = static_cast< dip::uint >( static_cast< dip::sint >( range.Maximum() ) - static_cast< dip::sint >( lowest_ )) + 1;
+         buckets_.resize( nLevels_ );
+      }
+      void Push( TPI value, dip::sint offset ) {
+         dip::uint level = Level( value );
+         buckets_[ level ].items.push_back( offset );
+         if(( size_ == 0 ) || ( level < current_ )) {
+            current_ = level;
+         }
+         ++size_;
+      }
+      dip::sint Top() const {
+         Bucket const& bucket = buckets_[ current_ ];
+         return bucket.items[ bucket.head ];
+      }
+      void Pop() {
+         Bucket& bucket = buckets_[ current_ ];
+         ++bucket.head;
+         --size_;
+         if( bucket.head == bucket.items.size() ) {
+            // Reuse the bucket's memory for later pushes
+            bucket.items.clear();
+            bucket.head = 0;
+            if( size_ > 0 ) {
+               // There are no non-empty buckets before `current_`
+               do {
+                  ++current_;
+               } while( buckets_[ current_ ].items.empty() );
+            }
+         }
+      }
+      bool Empty() const {
+         return size_ == 0;
+      }
+   private:
+      struct Bucket {
+         std::vector< dip::sint > items;
+         dip::uint head = 0;  // index of the first item not yet popped
+      };
+      bool lowFirst_;
+      TPI lowest_;
+      dip::uint nLevels_;
+      std::vector< Bucket > buckets_;
+      dip::uint current_ = 0; // the first non-empty bucket
+      dip::uint size_ = 0;
+      // Buckets are ordered such that the first one to be popped has the lowest index
+      dip::uint Level( TPI value ) const {
+         dip::uint level = static_cast< dip::uint >( static_cast< dip::sint >( value ) - static_cast< dip::sint >( lowest_ ));
+         return lowFirst_ ? level : nLevels_ - 1 - level;
+      }
+};
+
+// `PixelQueue< TPI >` is the best priority queue for the grey-value type `TPI`
+template< typename TPI > struct DIP_NO_EXPORT PixelQueueSelector { using type = PixelHeapQueue< TPI >; };
+template<> struct DIP_NO_EXPORT PixelQueueSelector< uint8 > { using type = PixelBucketQueue< uint8 >; };
+template<> struct DIP_NO_EXPORT PixelQueueSelector< uint16 > { using type = PixelBucketQueue< uint16 >; };
+template<> struct DIP_NO_EXPORT PixelQueueSelector< sint8 > { using type = PixelBucketQueue< sint8 >; };
+template<> struct DIP_NO_EXPORT PixelQueueSelector< sint16 > { using type = PixelBucketQueue< sint16 >; };
+template< typename TPI > using PixelQueue = typename PixelQueueSelector< TPI >::type;
+
 // This class manages a list of neighbor labels.
 // There are never more than N neighbors added at a time, N being defined
 // by the dimensionality and the connectivity. However, typically there are
@@ -29,46 +29,256 @@ namespace dip {
 
 namespace {
 
-// TODO: an 8 or 16-bit specialization could use the moving histogram technique
+// A Fenwick tree (binary indexed tree) over a histogram, allows adding and removing samples and selecting
+// the k-th smallest sample in O(log n) time, where n is the number of bins.
+class RankHistogram {
+   public:
+      // Makes room for `nBins` bins and empties the histogram
+      void Reset( dip::uint nBins ) {
+         nBins_ = 1;
+         while( nBins_ < nBins ) {
+            nBins_ <<= 1;
+         }
+         tree_.assign( nBins_, 0 );
+      }
+      // Number of bins (rounded up to a power of two)
+      dip::uint Size() const { return nBins_; }
+      void Add( dip::uint bin ) {
+         for( ++bin; bin <= nBins_; bin += bin & ( ~bin + 1 )) {
+            ++tree_[ bin - 1 ];
+         }
+      }
+      void Remove( dip::uint bin ) {
+         for( ++bin; bin <= nBins_; bin += bin & ( ~bin + 1 )) {
+            --tree_[ bin - 1 ];
+         }
+      }
+      // Returns the bin that contains the k-th sample (0-based)
+      dip::uint Select( dip::uint k ) const {
+         dip::uint pos = 0;
+         for( dip::uint step = nBins_; step > 0; step >>= 1 ) {
+            if(( pos + step <= nBins_ ) && ( tree_[ pos + step - 1 ] <= k )) {
+               pos += step;
+               k -= tree_[ pos - 1 ];
+            }
+         }
+         return pos;
+      }
+   private:
+      dip::uint nBins_ = 0;
+      std::vector< dip::uint32 > tree_;
+};
+
+// Number of histogram bins needed to represent all values of type TPI, 0 if we don't use a histogram for that type.
+template< typename TPI > constexpr dip::uint HistogramBins() { return 0; }
+template<> constexpr dip::uint HistogramBins< uint8 >() { return 256; }
+template<> constexpr dip::uint HistogramBins< sint8 >() { return 256; }
+template<> constexpr dip::uint HistogramBins< uint16 >() { return 65536; }
+template<> constexpr dip::uint HistogramBins< sint16 >() { return 65536; }
+
+template< typename TPI >
+dip::uint ValueToBin( TPI value ) {
+   return static_cast< dip::uint >( static_cast< dip::sint >( value ) - static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+}
+
+template< typename TPI >
+TPI BinToValue( dip::uint bin ) {
+   return static_cast< TPI >( static_cast< dip::sint >( bin ) + static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+}
+
+// Sorts NaN after all other values, `<` alone is not a strict weak ordering if there are NaNs
+template< typename TPI >
+bool NaNLastLess( TPI a, TPI b ) {
+   return ( a < b ) || (( a == a ) && ( b != b ));
+}
+
+enum class RankMethod { SELECT, HISTOGRAM, SORTED };
+
+// Estimates the cost per output pixel of each method, and picks the cheapest one.
+template< typename TPI >
+RankMethod ChooseRankMethod( dip::uint lineLength, dip::uint nKernelPixels, dip::uint nRuns, dip::uint& cost ) {
+   dfloat N = static_cast< dfloat >( nKernelPixels );
+   dfloat R = static_cast< dfloat >( nRuns );
+   dfloat L = static_cast< dfloat >( std::max< dip::uint >( lineLength, 1 ));
+   // `std::nth_element`: copying, sorting, iterating over pixel table
+   dfloat selectCost = N + 3 * N * std::round( std::log( N )) + 2 * N + R;
+   RankMethod method = RankMethod::SELECT;
+   dfloat bestCost = selectCost;
+   constexpr dip::uint nBins = HistogramBins< TPI >();
+   if( nBins > 0 ) {
+      // Moving histogram: for each run add and remove one value, then one selection; initialization is amortized over the line
+      dfloat logBins = std::log2( static_cast< dfloat >( nBins ));
+      dfloat histCost = ( 2 * R + 1 ) * logBins + 2 * N * logBins / L;
+      if( histCost < bestCost ) {
+         method = RankMethod::HISTOGRAM;
+         bestCost = histCost;
+      }
+   } else {
+      // Sorted window: sort all values touched by the line once, then as above, with ranks instead of values
+      dfloat M = R * L + N;
+      dfloat logM = std::log2( M );
+      dfloat sortCost = ( 2 * R + 1 ) * logM + 3 * M * logM / L;
+      if( sortCost < bestCost ) {
+         method = RankMethod::SORTED;
+         bestCost = sortCost;
+      }
+   }
+   cost = static_cast< dip::uint >( bestCost );
+   return method;
+}
+
+// Computes the rank filter either by:
+//  - Selecting the rank in a copy of the neighborhood for each pixel, using `std::nth_element`. This is O(N) per
+//    pixel, with N the number of pixels in the kernel, and the best option for small kernels.
+//  - A moving histogram (Huang's algorithm, but updating along each of the pixel table runs), for 8 and 16-bit
+//    integer types. The histogram is stored in a Fenwick tree so that the rank can be found in O(log n).
+//    The cost per pixel is proportional to the number of runs in the kernel, not the number of pixels.
+//  - A sorted window for the other types: all values that the line's neighborhoods touch are sorted once, and
+//    the moving histogram is computed over their ranks. This is O(R log(M)) per pixel, with R the number of
+//    runs, and M the number of values touched (approximately R times the line length).
 template< typename TPI >
 class RankLineFilter : public Framework::FullLineFilter {
    public:
-      RankLineFilter( dip::uint rank ) : rank_( static_cast< dip::sint >( rank )) {}
+      RankLineFilter( dip::uint rank ) : rank_( rank ) {}
       void SetNumberOfThreads( dip::uint threads, PixelTableOffsets const& pixelTable ) override {
          buffers_.resize( threads );
+         histograms_.resize( threads );
+         sortBuffers_.resize( threads );
+         rankBuffers_.resize( threads );
          offsets_ = pixelTable.Offsets();
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint nKernelPixels, dip::uint nRuns ) override {
-         return lineLength * (
-               nKernelPixels // copying
-               + 3 * nKernelPixels * static_cast< dip::uint >( std::round( std::log( nKernelPixels )))  // sorting
-               + 2 * nKernelPixels + nRuns );   // iterating over pixel table
+         dip::uint cost;
+         ChooseRankMethod< TPI >( lineLength, nKernelPixels, nRuns, cost );
+         return lineLength * cost;
       }
       virtual void Filter( Framework::FullLineFilterParameters const& params ) override {
+         dip::uint cost;
+         RankMethod method = ChooseRankMethod< TPI >( params.bufferLength, offsets_.size(), params.pixelTable.Runs().size(), cost );
+         switch( method ) {
+            case RankMethod::SELECT:
+               FilterSelect( params );
+               break;
+            case RankMethod::HISTOGRAM:
+               FilterHistogram( params );
+               break;
+            case RankMethod::SORTED:
+               FilterSorted( params );
+               break;
+         }
+      }
+   private:
+      dip::uint rank_;
+      std::vector< std::vector< TPI >> buffers_;
+      std::vector< RankHistogram > histograms_;
+      std::vector< std::vector< std::pair< TPI, dip::uint >>> sortBuffers_;
+      std::vector< std::vector< dip::uint >> rankBuffers_;
+      std::vector< dip::sint > offsets_;
+
+      void FilterSelect( Framework::FullLineFilterParameters const& params ) {
          TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
          dip::sint inStride = params.inBuffer.stride;
          TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
          dip::sint outStride = params.outBuffer.stride;
          dip::uint length = params.bufferLength;
          dip::uint N = offsets_.size();
-         buffers_[ params.thread ].resize( N );
+         std::vector< TPI >& buffer = buffers_[ params.thread ];
+         buffer.resize( N );
          for( dip::uint ii = 0; ii < length; ++ii ) {
-            TPI* buffer = buffers_[ params.thread ].data();
+            TPI* ptr = buffer.data();
             for( auto offset : offsets_ ) {
-               *buffer = in[ offset ];
-               ++buffer;
+               *ptr = in[ offset ];
+               ++ptr;
             }
-            auto ourGuy = buffers_[ params.thread ].begin() + rank_;
-            std::nth_element( buffers_[ params.thread ].begin(), ourGuy, buffers_[ params.thread ].end() );
+            auto ourGuy = buffer.begin() + static_cast< dip::sint >( rank_ );
+            std::nth_element( buffer.begin(), ourGuy, buffer.end(), NaNLastLess< TPI > );
             *out = *ourGuy;
             in += inStride;
             out += outStride;
          }
       }
-   private:
-      dip::sint rank_;
-      std::vector< std::vector< TPI >> buffers_;
-      std::vector< dip::sint > offsets_;
+
+      void FilterHistogram( Framework::FullLineFilterParameters const& params ) {
+         TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
+         dip::sint inStride = params.inBuffer.stride;
+         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
+         dip::sint outStride = params.outBuffer.stride;
+         dip::uint length = params.bufferLength;
+         PixelTableOffsets const& pixelTable = params.pixelTable;
+         RankHistogram& histogram = histograms_[ params.thread ];
+         constexpr dip::uint nBins = HistogramBins< TPI >();
+         if( histogram.Size() != nBins ) {
+            histogram.Reset( nBins ); // The histogram is empty at the end of each line, we only need to reset it once
+         }
+         for( auto offset : offsets_ ) {
+            histogram.Add( ValueToBin( in[ offset ] ));
+         }
+         *out = BinToValue< TPI >( histogram.Select( rank_ ));
+         for( dip::uint ii = 1; ii < length; ++ii ) {
+            for( auto const& run : pixelTable.Runs() ) {
+               histogram.Remove( ValueToBin( in[ run.offset ] ));
+               histogram.Add( ValueToBin( in[ run.offset + static_cast< dip::sint >( run.length ) * inStride ] ));
+            }
+            in += inStride;
+            out += outStride;
+            *out = BinToValue< TPI >( histogram.Select( rank_ ));
+         }
+         // Empty the histogram for the next line, cheaper than zeroing all the bins
+         for( auto offset : offsets_ ) {
+            histogram.Remove( ValueToBin( in[ offset ] ));
+         }
+      }
+
+      void FilterSorted( Framework::FullLineFilterParameters const& params ) {
+         TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
+         dip::sint inStride = params.inBuffer.stride;
+         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
+         dip::sint outStride = params.outBuffer.stride;
+         dip::uint length = params.bufferLength;
+         PixelTableOffsets const& pixelTable = params.pixelTable;
+         auto const& runs = pixelTable.Runs();
+         // Collect all values touched while processing this line: run `r` touches `length + runs[ r ].length - 1`
+         // values, which we store consecutively.
+         std::vector< std::pair< TPI, dip::uint >>& values = sortBuffers_[ params.thread ];
+         values.clear();
+         for( auto const& run : runs ) {
+            dip::uint n = length + run.length - 1;
+            TPI* ptr = in + run.offset;
+            for( dip::uint jj = 0; jj < n; ++jj, ptr += inStride ) {
+               values.emplace_back( *ptr, values.size() );
+            }
+         }
+         // Sorting also on the index makes this deterministic
+         std::sort( values.begin(), values.end(), []( std::pair< TPI, dip::uint > const& a, std::pair< TPI, dip::uint > const& b ) {
+            return NaNLastLess( a.first, b.first ) || ( !NaNLastLess( b.first, a.first ) && ( a.second < b.second ));
+         } );
+         // Each value's rank goes into `ranks`
+         std::vector< dip::uint >& ranks = rankBuffers_[ params.thread ];
+         ranks.resize( values.size() );
+         for( dip::uint ii = 0; ii < values.size(); ++ii ) {
+            ranks[ values[ ii ].second ] = ii;
+         }
+         RankHistogram& histogram = histograms_[ params.thread ];
+         histogram.Reset( values.size() );
+         dip::uint* runRanks = ranks.data();
+         for( auto const& run : runs ) {
+            for( dip::uint jj = 0; jj < run.length; ++jj ) {
+               histogram.Add( runRanks[ jj ] );
+            }
+            runRanks += length + run.length - 1;
+         }
+         *out = values[ histogram.Select( rank_ ) ].first;
+         for( dip::uint ii = 1; ii < length; ++ii ) {
+            runRanks = ranks.data();
+            for( auto const& run : runs ) {
+               histogram.Remove( runRanks[ ii - 1 ] );
+               histogram.Add( runRanks[ ii - 1 + run.length ] );
+               runRanks += length + run.length - 1;
+            }
+            out += outStride;
+            *out = values[ histogram.Select( rank_ ) ].first;
+         }
+      }
 };
 
 void ComputeRankFilter(
@@ -143,9 +353,102 @@ void PercentileFilter(
    DIP_START_STACK_TRACE
       dip::uint nPixels = kernel.NumberOfPixels( in.Dimensionality());
       dip::uint rank = static_cast< dip::uint >( std::round( static_cast< dfloat >( nPixels ) * percentile / 100.0 ));
+      rank = std::min( rank, nPixels - 1 );
       BoundaryConditionArray bc = StringArrayToBoundaryConditionArray( boundaryCondition );
       ComputeRankFilter( in, out, kernel, rank, bc );
    DIP_END_STACK_TRACE
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/random.h"
+#include "diplib/statistics.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the percentile filter") {
+   dip::uint const sizeX = 60;
+   dip::uint const sizeY = 45;
+   dip::Image img( { sizeX, sizeY }, 1, dip::DT_UINT16 );
+   dip::uint16* ptr = static_cast< dip::uint16* >( img.Origin() );
+   dip::Random random( 0 );
+   for( dip::uint ii = 0; ii < sizeX * sizeY; ++ii ) {
+      ptr[ ii ] = static_cast< dip::uint16 >( random() % 5000 );
+   }
+   // Brute-force computation of the 30th percentile in a 7x7 window, for the interior pixels
+   dip::uint const kernelSize = 7;
+   dip::uint const halfSize = kernelSize / 2;
+   dip::uint const rank = static_cast< dip::uint >( std::round( kernelSize * kernelSize * 30.0 / 100.0 ));
+   dip::Image reference( { sizeX - 2 * halfSize, sizeY - 2 * halfSize }, 1, dip::DT_UINT16 );
+   dip::uint16* refPtr = static_cast< dip::uint16* >( reference.Origin() );
+   std::vector< dip::uint16 > window( kernelSize * kernelSize );
+   for( dip::uint y = halfSize; y < sizeY - halfSize; ++y ) {
+      for( dip::uint x = halfSize; x < sizeX - halfSize; ++x ) {
+         auto wIt = window.begin();
+         for( dip::uint ky = 0; ky < kernelSize; ++ky ) {
+            for( dip::uint kx = 0; kx < kernelSize; ++kx ) {
+               *wIt++ = ptr[ ( y + ky - halfSize ) * sizeX + x + kx - halfSize ];
+            }
+         }
+         std::nth_element( window.begin(), window.begin() + static_cast< dip::sint >( rank ), window.end() );
+         *refPtr++ = window[ rank ];
+      }
+   }
+   dip::Kernel kernel( static_cast< dip::dfloat >( kernelSize ), "rectangular" );
+   dip::Range range( static_cast< dip::sint >( halfSize ), -static_cast< dip::sint >( halfSize ) - 1 );
+   dip::RangeArray interior{ range, range };
+   // Moving histogram
+   dip::Image out = dip::PercentileFilter( img, 30.0, kernel );
+   DOCTEST_CHECK( dip::Count( dip::Image( out.At( interior )) != reference ) == 0 );
+   // Sorted window
+   dip::Image fimg = dip::Convert( img, dip::DT_SFLOAT );
+   dip::Image fout = dip::PercentileFilter( fimg, 30.0, kernel );
+   DOCTEST_CHECK( dip::Count( dip::Image( fout.At( interior )) != reference ) == 0 );
+   // The two methods should give identical results also at the image edge, and with an arbitrary kernel shape
+   kernel = dip::Kernel( 11.0, "elliptic" );
+   out = dip::MedianFilter( img, kernel );
+   fout = dip::MedianFilter( fimg, kernel );
+   DOCTEST_CHECK( dip::Count( out != fout ) == 0 );
+   // A small kernel uses `std::nth_element`
+   kernel = dip::Kernel( 3.0, "rectangular" );
+   out = dip::MedianFilter( img, kernel );
+   dip::Image bout = dip::MedianFilter( dip::Convert( img / 20, dip::DT_UINT8 ), kernel );
+   DOCTEST_CHECK( dip::Count( dip::Convert( out / 20, dip::DT_UINT8 ) != bout ) == 0 );
+   // NaN sorts after all other values, as if it were infinity
+   dip::Image nanimg = fimg.Copy();
+   dip::Image infimg = fimg.Copy();
+   dip::sfloat* nanPtr = static_cast< dip::sfloat* >( nanimg.Origin() );
+   dip::sfloat* infPtr = static_cast< dip::sfloat* >( infimg.Origin() );
+   for( dip::uint ii = 0; ii < sizeX * sizeY; ++ii ) {
+      if( random() % 4 == 0 ) {
+         nanPtr[ ii ] = std::numeric_limits< dip::sfloat >::quiet_NaN();
+         infPtr[ ii ] = std::numeric_limits< dip::sfloat >::infinity();
+      }
+   }
+   for( dip::dfloat size : { 3.0, 7.0 } ) { // `std::nth_element` and sorted window
+      kernel = dip::Kernel( size, "rectangular" );
+      dip::Image nanout = dip::PercentileFilter( nanimg, 80.0, kernel, { "mirror" } );
+      dip::Image infout = dip::PercentileFilter( infimg, 80.0, kernel, { "mirror" } );
+      DOCTEST_REQUIRE( nanout.DataType() == dip::DT_SFLOAT );
+      DOCTEST_REQUIRE( infout.DataType() == dip::DT_SFLOAT );
+      dip::sfloat const* nanOutPtr = static_cast< dip::sfloat const* >( nanout.Origin() );
+      dip::sfloat const* infOutPtr = static_cast< dip::sfloat const* >( infout.Origin() );
+      dip::uint nNaN = 0;
+      dip::uint nWrong = 0;
+      for( dip::uint ii = 0; ii < sizeX * sizeY; ++ii ) {
+         if( std::isnan( nanOutPtr[ ii ] )) {
+            ++nNaN;
+            if( !std::isinf( infOutPtr[ ii ] )) {
+               ++nWrong;
+            }
+         } else if( nanOutPtr[ ii ] != infOutPtr[ ii ] ) {
+            ++nWrong;
+         }
+      }
+      DOCTEST_CHECK( nNaN > 0 );
+      DOCTEST_CHECK( nWrong == 0 );
+   }
+}
+
+#endif // DIP__ENABLE_DOCTEST
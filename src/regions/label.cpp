@@ -25,6 +25,7 @@
 #include "diplib/iterators.h"
 #include "diplib/boundary.h"
 #include "diplib/framework.h" // for OptimalProcessingDim
+#include "diplib/multithreading.h"
 
 #include "labelingGrana2016.h"
 
@@ -104,9 +105,9 @@ void LabelFirstPass(
       Image& c_img,
       LabelRegionList& regions,
       NeighborList const& c_neighborList,
-      dip::uint connectivity
+      dip::uint connectivity,
+      dip::uint procDim
 ) {
-   dip::uint procDim = Framework::OptimalProcessingDim( c_img ); // this will typically be 0, because we've "standardized the strides".
    dip::uint length = c_img.Size( procDim );
    if( length < 3 ) {
       // Note that if length < 3, the image is very small all around, because `OptimalProcessingDim` will return a larger dimension if it exists.
@@ -245,6 +246,145 @@ void LabelFirstPass(
 
 }
 
+// Calls `function( slab, slabImage )` for each of the slabs of `img` along dimension `dim`, in parallel.
+// Slab `ii` covers the indices `slabStart[ ii ]` to `slabStart[ ii + 1 ] - 1` along `dim`.
+template< typename F >
+void ForEachSlab( Image const& img, dip::uint dim, UnsignedArray const& slabStart, F const& function ) {
+   dip::uint nSlabs = slabStart.size() - 1;
+   WorkDistributor work( nSlabs, nSlabs );
+   ParallelExecute( nSlabs, [ & ]( dip::uint thread ) {
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         for( dip::uint slab = begin; slab < end; ++slab ) {
+            RangeArray ranges( img.Dimensionality() );
+            ranges[ dim ] = Range{ static_cast< dip::sint >( slabStart[ slab ] ), static_cast< dip::sint >( slabStart[ slab + 1 ] ) - 1 };
+            Image slabImage = img.At( ranges );
+            function( slab, slabImage );
+         }
+      }
+   } );
+}
+
+// Runs the first pass independently on slabs of `labels` along dimension `splitDim`, in parallel, and merges the
+// results into `regions`. Because `splitDim` is the dimension that is scanned last, the slabs are contiguous
+// chunks of the scan order. The labels of each slab are appended to `regions` in slab order, and the labels
+// in `labels` are updated accordingly, such that `regions` ends up identical to what the serial first pass
+// would produce (up to the labels used internally, which are merged with the background). The labels
+// of objects that cross slab boundaries are merged at the end.
+// If `useGrana` is set, `labels` must be 2D, and `in` is the binary input image with the same sizes.
+// Otherwise, `labels` contains a copy of the binary input image, and `in` is not used.
+void LabelFirstPassParallel(
+      Image const& in,
+      Image& labels,
+      LabelRegionList& regions,
+      bool useGrana,
+      dip::uint connectivity,
+      dip::uint procDim,
+      dip::uint splitDim,
+      dip::uint nSlabs
+) {
+   dip::uint nDims = labels.Dimensionality();
+   dip::uint size = labels.Size( splitDim );
+   UnsignedArray slabStart( nSlabs + 1 );
+   for( dip::uint ii = 0; ii <= nSlabs; ++ii ) {
+      slabStart[ ii ] = ii * size / nSlabs;
+   }
+   NeighborList neighborList( { Metric::TypeCode::CONNECTED, connectivity }, nDims );
+
+   // Label each slab with its own region list
+   std::plus< dip::uint > unionFunction;
+   std::vector< LabelRegionList > slabRegions;
+   slabRegions.reserve( nSlabs );
+   for( dip::uint ii = 0; ii < nSlabs; ++ii ) {
+      slabRegions.emplace_back( unionFunction );
+   }
+   if( useGrana ) {
+      ForEachSlab( labels, splitDim, slabStart, [ & ]( dip::uint slab, Image& slabLabels ) {
+         RangeArray ranges( nDims );
+         ranges[ splitDim ] = Range{ static_cast< dip::sint >( slabStart[ slab ] ), static_cast< dip::sint >( slabStart[ slab + 1 ] ) - 1 };
+         Image slabIn = in.At( ranges );
+         LabelFirstPass_Grana2016( slabIn, slabLabels, slabRegions[ slab ] );
+      } );
+   } else {
+      ForEachSlab( labels, splitDim, slabStart, [ & ]( dip::uint slab, Image& slabLabels ) {
+         LabelFirstPass( slabLabels, slabRegions[ slab ], neighborList, connectivity, procDim );
+      } );
+   }
+
+   // Append the slab region lists to `regions`
+   std::vector< LabelType > slabOffset( nSlabs );
+   for( dip::uint slab = 0; slab < nSlabs; ++slab ) {
+      LabelRegionList& local = slabRegions[ slab ];
+      LabelType offset = static_cast< LabelType >( regions.Size() );
+      slabOffset[ slab ] = offset;
+      LabelType n = static_cast< LabelType >( local.Size() );
+      for( LabelType ii = 1; ii <= n; ++ii ) {
+         regions.Create( local.FindRoot( ii ) == ii ? local.Value( ii ) : 0 );
+      }
+      for( LabelType ii = 1; ii <= n; ++ii ) {
+         LabelType root = local.FindRoot( ii );
+         if( root != ii ) {
+            regions.Union( offset + root, offset + ii );
+         }
+      }
+      if( !useGrana ) {
+         regions.Union( 0, offset + 1 ); // Label 1 is used internally by `LabelFirstPass`.
+      }
+   }
+   ForEachSlab( labels, splitDim, slabStart, [ & ]( dip::uint slab, Image& slabLabels ) {
+      LabelType offset = slabOffset[ slab ];
+      if( offset > 0 ) {
+         ImageIterator< LabelType > it( slabLabels );
+         do {
+            if( *it ) {
+               *it += offset;
+            }
+         } while( ++it );
+      }
+   } );
+
+   // Merge labels across slab boundaries: compare the first plane of each slab with the last plane of the previous one
+   IntegerArray neighborOffsets = neighborList.ComputeOffsets( labels.Strides() );
+   std::vector< IntegerArray > previousCoords;
+   IntegerArray previousOffsets;
+   auto nl = neighborList.begin();
+   auto no = neighborOffsets.begin();
+   for( ; nl != neighborList.end(); ++no, ++nl ) {
+      if( nl.Coordinates()[ splitDim ] == -1 ) {
+         previousCoords.push_back( nl.Coordinates() );
+         previousOffsets.push_back( *no );
+      }
+   }
+   for( dip::uint slab = 1; slab < nSlabs; ++slab ) {
+      RangeArray ranges( nDims );
+      ranges[ splitDim ] = Range{ static_cast< dip::sint >( slabStart[ slab ] ) };
+      Image plane = labels.At( ranges );
+      ImageIterator< LabelType > it( plane );
+      do {
+         if( *it ) {
+            UnsignedArray const& coords = it.Coordinates();
+            for( dip::uint kk = 0; kk < previousOffsets.size(); ++kk ) {
+               bool use = true;
+               for( dip::uint dd = 0; dd < nDims; ++dd ) {
+                  // Relying on 2's complement conversion, see the comment in `Label` below.
+                  if(( dd != splitDim ) &&
+                     ( static_cast< dip::uint >( static_cast< dip::sint >( coords[ dd ] ) + previousCoords[ kk ][ dd ] ) >= labels.Size( dd ))) {
+                     use = false;
+                     break;
+                  }
+               }
+               if( use ) {
+                  LabelType lab = it.Pointer()[ previousOffsets[ kk ]];
+                  if( lab ) {
+                     regions.Union( *it, lab );
+                  }
+               }
+            }
+         }
+      } while( ++it );
+   }
+}
+
 } // namespace
 
 dip::uint Label(
@@ -277,22 +417,53 @@ dip::uint Label(
    // First scan
    dip::uint trueNDims = out.Dimensionality(); // If `c_in` had singleton dimensions, `out` will have fewer dimensions
    dip::uint trueConnectivity = std::min( connectivity, trueNDims );
-   if(( trueNDims == 2 ) && ( trueConnectivity == 2 )) {
+   bool useGrana = ( trueNDims == 2 ) && ( trueConnectivity == 2 );
+   Image granaIn;
+   Image labels; // The image written to by the first pass
+   dip::uint procDim = 0;
+   dip::uint splitDim = 0; // The dimension scanned last, along which we can split the image for parallel processing
+   if( useGrana ) {
       out.Fill( 0 );
-      Image granaIn = in.QuickCopy();
-      Image granaOut = c_out.QuickCopy(); // Note use of `c_out` here, not `out`, because dimensions must agree with `in`.
+      granaIn = in.QuickCopy();
+      labels = c_out.QuickCopy(); // Note use of `c_out` here, not `out`, because dimensions must agree with `in`.
       if( nDims > 2 ) {
          // This is the case where we had singleton dimensions
          granaIn.Squeeze();
-         granaOut.Squeeze();
+         labels.Squeeze();
+      }
+      // `LabelFirstPass_Grana2016` scans the image along the dimension with the smallest input stride first
+      splitDim = granaIn.Stride( 1 ) < granaIn.Stride( 0 ) ? 0 : 1;
+   } else {
+      c_out.Copy( in ); // Copy `in` into `c_out`, not into `out`, which could be reshaped.
+      labels = out.QuickCopy();
+      procDim = Framework::OptimalProcessingDim( out ); // this will typically be 0, because we've "standardized the strides".
+      // The image iterator in `LabelFirstPass` scans the dimensions other than `procDim` in order
+      splitDim = trueNDims > 0 ? trueNDims - 1 : 0;
+      if(( splitDim == procDim ) && ( splitDim > 0 )) {
+         --splitDim;
       }
-      LabelFirstPass_Grana2016( granaIn, granaOut, regions );
+   }
+
+   // Determine the number of threads we'll be using
+   dip::uint nThreads = 1;
+   if(( trueNDims > 1 ) && ( useGrana || ( labels.Size( procDim ) >= 3 ))) {
+      nThreads = std::min( GetNumberOfThreads(), labels.Size( splitDim ));
+      if( nThreads > 1 ) {
+         // Roughly 10 operations per pixel for the first scan
+         nThreads = OptimalNumberOfThreads( 10 * labels.NumberOfPixels(), nThreads );
+      }
+   }
+
+   if( nThreads > 1 ) {
+      // Each thread labels one slab of the image, the slabs are merged afterwards
+      DIP_STACK_TRACE_THIS( LabelFirstPassParallel( granaIn, labels, regions, useGrana, trueConnectivity, procDim, splitDim, nThreads ));
+   } else if( useGrana ) {
+      LabelFirstPass_Grana2016( granaIn, labels, regions );
       // This saves ~20% on an image 2k x 2k pixels: 0.0559 vs 0.0658s
       // (including MATLAB overhead, probably slightly larger relative difference without that overhead).
    } else {
-      c_out.Copy( in ); // Copy `in` into `c_out`, not into `out`, which could be reshaped.
       NeighborList neighborList( { Metric::TypeCode::CONNECTED, trueConnectivity }, trueNDims );
-      DIP_STACK_TRACE_THIS( LabelFirstPass( out, regions, neighborList, trueConnectivity ));
+      DIP_STACK_TRACE_THIS( LabelFirstPass( out, regions, neighborList, trueConnectivity, procDim ));
       regions.Union( 0, 1 ); // This gets rid of label 1, which we used internally, but otherwise causes the first region to get label 2.
    }
 
@@ -375,14 +546,62 @@ dip::uint Label(
    }
 
    // Second scan
-   auto it = ImageIterator< LabelType >( out );
-   do {
-      if( *it > 0 ) {
-         *it = regions.Label( *it );
+   if( nThreads > 1 ) {
+      UnsignedArray slabStart( nThreads + 1 );
+      for( dip::uint ii = 0; ii <= nThreads; ++ii ) {
+         slabStart[ ii ] = ii * labels.Size( splitDim ) / nThreads;
       }
-   } while( ++it );
+      ForEachSlab( labels, splitDim, slabStart, [ & ]( dip::uint, Image& slabLabels ) {
+         ImageIterator< LabelType > it( slabLabels );
+         do {
+            if( *it > 0 ) {
+               *it = regions.Label( *it );
+            }
+         } while( ++it );
+      } );
+   } else {
+      auto it = ImageIterator< LabelType >( out );
+      do {
+         if( *it > 0 ) {
+            *it = regions.Label( *it );
+         }
+      } while( ++it );
+   }
 
    return nLabel;
 }
 
 } // namespace dip
+
+
+#ifdef DIP__ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/testing.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing that parallel labeling yields the same result as serial labeling") {
+   dip::Random random( 0 );
+   for( auto const& sizes : std::vector< dip::UnsignedArray >{{ 700, 500 }, { 90, 70, 50 }, { 1, 300, 1, 400 }} ) {
+      dip::Image image( sizes, 1, dip::DT_SFLOAT );
+      image.Fill( 0 );
+      dip::UniformNoise( image, image, random );
+      dip::Image binary = image > 0.6;
+      for( dip::uint connectivity = 1; connectivity <= binary.Dimensionality(); ++connectivity ) {
+         dip::Image labels[ 2 ][ 2 ];
+         dip::uint counts[ 2 ][ 2 ];
+         bool multiThreaded = dip::testing::SingleAndMultiThreaded( [ & ]( dip::uint ii ) {
+            counts[ ii ][ 0 ] = dip::Label( binary, labels[ ii ][ 0 ], connectivity, 2, 0 );
+            counts[ ii ][ 1 ] = dip::Label( binary, labels[ ii ][ 1 ], connectivity, 0, 0, { "periodic" } );
+         } );
+         if( multiThreaded ) {
+            for( dip::uint jj = 0; jj < 2; ++jj ) {
+               DOCTEST_CHECK( counts[ 0 ][ jj ] == counts[ 1 ][ jj ] );
+               DOCTEST_CHECK( dip::testing::CompareImages( labels[ 0 ][ jj ], labels[ 1 ][ jj ] ));
+            }
+         }
+      }
+   }
+}
+
+#endif // DIP__ENABLE_DOCTEST
@@ -29,10 +29,41 @@
 
 namespace dip {
 
-using LabelSet = std::set< dip::uint >;
-
 namespace {
 
+// The set of labels found in an image. Labels smaller than `limit` are recorded in a table, larger ones
+// in a `std::set`. Most labeled images have compact labels, and then the set is never used.
+class LabelSet {
+   public:
+      explicit LabelSet( dip::uint limit ) : limit_( limit ) {}
+      void insert( dip::uint id ) {
+         if( id < limit_ ) {
+            if( id >= table_.size() ) {
+               table_.resize( std::min( std::max( id + 1, table_.size() * 2 ), limit_ ), 0 );
+            }
+            table_[ id ] = 1;
+         } else {
+            set_.insert( id );
+         }
+      }
+      // Returns the labels in increasing order
+      template< typename F >
+      void ForEach( F const& function ) const {
+         for( dip::uint id = 0; id < table_.size(); ++id ) {
+            if( table_[ id ] ) {
+               function( id );
+            }
+         }
+         for( auto id : set_ ) {
+            function( id );
+         }
+      }
+   private:
+      dip::uint limit_;
+      std::vector< uint8 > table_;
+      std::set< dip::uint > set_;
+};
+
 template< typename TPI >
 class dip__GetLabels: public Framework::ScanLineFilter {
    public:
@@ -91,7 +122,7 @@ UnsignedArray GetObjectLabels(
    }
    bool nullIsObject = BooleanFromString( background, "include", "exclude" );
 
-   LabelSet objectIDs; // output
+   LabelSet objectIDs( std::max< dip::uint >( label.NumberOfPixels(), 1024 )); // output; the table uses at most as much memory as a uint8 image
 
    // Get pointer to overloaded scan function
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
@@ -102,21 +133,21 @@ UnsignedArray GetObjectLabels(
 
    // Count the number of unique labels
    dip::uint count = 0;
-   for( auto id : objectIDs ) {
+   objectIDs.ForEach( [ & ]( dip::uint id ) {
       if( nullIsObject || ( id != 0 )) {
          ++count;
       }
-   }
+   } );
 
    // Copy the labels to output array
    UnsignedArray out( count );
    count = 0;
-   for( auto id : objectIDs ) {
+   objectIDs.ForEach( [ & ]( dip::uint id ) {
       if( nullIsObject || ( id != 0 )) {
          out[ count ] = id;
          ++count;
       }
-   }
+   } );
    return out;
 }
 
@@ -18,6 +18,12 @@
  * limitations under the License.
  */
 
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <functional>
+
 #include "diplib.h"
 #include "diplib/transform.h"
 #include "diplib/dft.h"
@@ -26,6 +32,7 @@
 #include "diplib/multithreading.h"
 #include "diplib/iterators.h"
 #include "diplib/geometry.h"
+#include "diplib/library/copy_buffer.h"
 
 #ifdef DIP__HAS_FFTW
    #ifdef _WIN32
@@ -38,6 +45,101 @@ namespace dip {
 
 namespace {
 
+// Thread-safe cache of DFT objects, one instance for each float type.
+template< typename T >
+class DFTCache {
+   public:
+      static DFTCache& GetInstance() {
+         static DFTCache cache;
+         return cache;
+      }
+
+      std::shared_ptr< DFT< T > const > Get( size_t size, bool inverse ) {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         Key key{ size, inverse };
+         auto it = cache_.find( key );
+         if( it != cache_.end() ) {
+            return it->second;
+         }
+         if( cache_.size() >= maximumSize ) {
+            RemoveUnused();
+         }
+         auto dft = std::make_shared< DFT< T > const >( size, inverse );
+         cache_.emplace( key, dft );
+         return dft;
+      }
+
+      // Returns the sizes and directions of all the cached objects
+      std::vector< std::pair< size_t, bool >> Keys() {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         std::vector< std::pair< size_t, bool >> keys;
+         keys.reserve( cache_.size() );
+         for( auto const& entry : cache_ ) {
+            keys.push_back( entry.first );
+         }
+         return keys;
+      }
+
+      void Clear() {
+         std::lock_guard< std::mutex > lock( mutex_ );
+         cache_.clear();
+      }
+
+   private:
+      using Key = std::pair< size_t, bool >;
+      static constexpr dip::uint maximumSize = 256;
+      std::mutex mutex_;
+      std::map< Key, std::shared_ptr< DFT< T > const >> cache_;
+
+      DFTCache() = default;
+
+      // Removes the objects not referenced outside the cache
+      void RemoveUnused() {
+         for( auto it = cache_.begin(); it != cache_.end(); ) {
+            if( it->second.use_count() == 1 ) {
+               it = cache_.erase( it );
+            } else {
+               ++it;
+            }
+         }
+      }
+};
+
+// The two functions below by Alexei: http://stackoverflow.com/a/19752002/7328782
+template< typename T >
+void ShiftCornerToCenter( T* data, dip::uint length ) { // fftshift
+   dip::uint jj = length / 2;
+   if( length & 1 ) { // Odd-sized transform
+      T tmp = data[ 0 ];
+      for( dip::uint ii = 0; ii < jj; ++ii ) {
+         data[ ii ] = data[ jj + ii + 1 ];
+         data[ jj + ii + 1 ] = data[ ii + 1 ];
+      }
+      data[ jj ] = tmp;
+   } else { // Even-sized transform
+      for( dip::uint ii = 0; ii < jj; ++ii ) {
+         std::swap( data[ ii ], data[ ii + jj ] );
+      }
+   }
+}
+template< typename T >
+void ShiftCenterToCorner( T* data, dip::uint length ) { // ifftshift
+   dip::uint jj = length / 2;
+   if( length & 1 ) { // Odd-sized transform
+      T tmp = data[ length - 1 ];
+      for( dip::uint ii = jj; ii > 0; ) {
+         --ii;
+         data[ jj + ii + 1 ] = data[ ii ];
+         data[ ii ] = data[ jj + ii ];
+      }
+      data[ jj ] = tmp;
+   } else { // Even-sized transform
+      for( dip::uint ii = 0; ii < jj; ++ii ) {
+         std::swap( data[ ii ], data[ ii + jj ] );
+      }
+   }
+}
+
 // TPI is either scomplex or dcomplex.
 template< typename TPI >
 class DFTLineFilter : public Framework::SeparableLineFilter {
@@ -51,17 +153,7 @@ class DFTLineFilter : public Framework::SeparableLineFilter {
          scale_ = 1.0;
          for( dip::uint ii = 0; ii < outSize.size(); ++ii ) {
             if( process[ ii ] ) {
-               bool found = false;
-               for( dip::uint jj = 0; jj < ii; ++jj ) {
-                  if( process[ jj ] && ( outSize[ jj ] == outSize[ ii ] )) {
-                     dft_[ ii ] = dft_[ jj ];
-                     found = true;
-                     break;
-                  }
-               }
-               if( !found ) {
-                  dft_[ ii ].Initialize( outSize[ ii ], inverse );
-               }
+               dft_[ ii ] = GetCachedDFT< FloatType< TPI >>( outSize[ ii ], inverse );
                if( inverse || symmetric ) {
                   scale_ /= static_cast< FloatType< TPI >>( outSize[ ii ] );
                }
@@ -78,7 +170,7 @@ class DFTLineFilter : public Framework::SeparableLineFilter {
          return 10 * lineLength * static_cast< dip::uint >( std::round( std::log2( lineLength )));
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
-         DFT< FloatType< TPI >> const& dft = dft_[ params.dimension ];
+         DFT< FloatType< TPI >> const& dft = *dft_[ params.dimension ];
          if( buffers_[ params.thread ].size() != dft.BufferSize() ) {
             buffers_[ params.thread ].resize( dft.BufferSize() );
          }
@@ -100,46 +192,389 @@ class DFTLineFilter : public Framework::SeparableLineFilter {
             ShiftCornerToCenter( out, length );
          }
       }
-      // The two functions below by Alexei: http://stackoverflow.com/a/19752002/7328782
-      static void ShiftCornerToCenter( TPI* data, dip::uint length ) { // fftshift
-         dip::uint jj = length / 2;
-         if( length & 1 ) { // Odd-sized transform
-            TPI tmp = data[ 0 ];
-            for( dip::uint ii = 0; ii < jj; ++ii ) {
-               data[ ii ] = data[ jj + ii + 1 ];
-               data[ jj + ii + 1 ] = data[ ii + 1 ];
+   private:
+      std::vector< std::shared_ptr< DFT< FloatType< TPI >> const >> dft_; // one for each dimension
+      std::vector< std::vector< TPI >> buffers_; // one for each thread
+      FloatType< TPI > scale_;
+      bool shift_;
+};
+
+// Computes the DFT of a real-valued line of length N, producing the frequencies 0 to N/2 (the other half follows
+// from the conjugate symmetry), and the inverse transform. For even N, the real line is seen as a complex line
+// of length N/2, whose transform is split into the transforms of the even and odd samples; this halves the
+// work compared to a complex transform of length N. Odd N use a complex transform of length N.
+template< typename TPF >
+class RealDFT {
+   public:
+      using TPC = std::complex< TPF >;
+
+      RealDFT( dip::uint length, bool inverse ) : length_( length ) {
+         if(( length_ & 1u ) == 0 ) {
+            dip::uint half = length_ / 2;
+            dft_ = GetCachedDFT< TPF >( half, inverse );
+            twiddles_.resize( half + 1 );
+            dfloat sign = inverse ? 1.0 : -1.0;
+            for( dip::uint kk = 0; kk <= half; ++kk ) {
+               dfloat phase = sign * 2.0 * pi * static_cast< dfloat >( kk ) / static_cast< dfloat >( length_ );
+               twiddles_[ kk ] = { static_cast< TPF >( std::cos( phase )), static_cast< TPF >( std::sin( phase )) };
+            }
+         } else {
+            dft_ = GetCachedDFT< TPF >( length_, inverse );
+         }
+      }
+
+      // The size of the buffer to pass to `Forward` and `Inverse`, in complex samples
+      dip::uint BufferSize() const {
+         return 2 * dft_->TransformSize() + dft_->BufferSize();
+      }
+
+      // `in` has N samples, `out` receives N/2+1 samples
+      void Forward( TPF const* in, TPC* out, TPC* buffer, TPF scale ) const {
+         if( !twiddles_.empty() ) {
+            dip::uint half = length_ / 2;
+            // Pairs of real samples are read as complex samples, std::complex has the layout of an array of two values
+            dft_->Apply( reinterpret_cast< TPC const* >( in ), out, buffer, 1 );
+            TPC z0 = out[ 0 ];
+            out[ 0 ] = { ( z0.real() + z0.imag() ) * scale, 0 };
+            out[ half ] = { ( z0.real() - z0.imag() ) * scale, 0 };
+            for( dip::uint kk = 1; kk <= half / 2; ++kk ) {
+               TPC a = out[ kk ];
+               TPC b = out[ half - kk ];
+               out[ kk ] = Split( a, b, twiddles_[ kk ] ) * scale;
+               out[ half - kk ] = Split( b, a, twiddles_[ half - kk ] ) * scale;
             }
-            data[ jj ] = tmp;
-         } else { // Even-sized transform
-            for( dip::uint ii = 0; ii < jj; ++ii ) {
-               std::swap( data[ ii ], data[ ii + jj ] );
+         } else {
+            TPC* line = buffer;
+            TPC* full = buffer + length_;
+            for( dip::uint ii = 0; ii < length_; ++ii ) {
+               line[ ii ] = in[ ii ];
             }
+            dft_->Apply( line, full, full + length_, scale );
+            std::copy( full, full + length_ / 2 + 1, out );
          }
       }
-      static void ShiftCenterToCorner( TPI* data, dip::uint length ) { // ifftshift
-         dip::uint jj = length / 2;
-         if( length & 1 ) { // Odd-sized transform
-            TPI tmp = data[ length - 1 ];
-            for( dip::uint ii = jj; ii > 0; ) {
-               --ii;
-               data[ jj + ii + 1 ] = data[ ii ];
-               data[ ii ] = data[ jj + ii ];
+
+      // `in` has N/2+1 samples, `out` receives N samples. The imaginary components of frequencies 0 and N/2 are ignored.
+      void Inverse( TPC const* in, TPF* out, TPC* buffer, TPF scale ) const {
+         if( !twiddles_.empty() ) {
+            dip::uint half = length_ / 2;
+            TPC* line = buffer;
+            TPF x0 = in[ 0 ].real();
+            TPF xh = in[ half ].real();
+            line[ 0 ] = { x0 + xh, x0 - xh };
+            for( dip::uint kk = 1; kk < half; ++kk ) {
+               TPC a = in[ kk ];
+               TPC b = std::conj( in[ half - kk ] );
+               TPC odd = ( a - b ) * twiddles_[ kk ];
+               line[ kk ] = ( a + b ) + TPC{ -odd.imag(), odd.real() }; // ( a + b ) + i * odd
             }
-            data[ jj ] = tmp;
-         } else { // Even-sized transform
-            for( dip::uint ii = 0; ii < jj; ++ii ) {
-               std::swap( data[ ii ], data[ ii + jj ] );
+            // The complex result holds the even samples in the real component, the odd ones in the imaginary component
+            dft_->Apply( line, reinterpret_cast< TPC* >( out ), buffer + half, scale );
+         } else {
+            TPC* line = buffer;
+            TPC* full = buffer + length_;
+            line[ 0 ] = in[ 0 ].real();
+            for( dip::uint kk = 1; kk <= length_ / 2; ++kk ) {
+               line[ kk ] = in[ kk ];
+               line[ length_ - kk ] = std::conj( in[ kk ] );
+            }
+            dft_->Apply( line, full, full + length_, scale );
+            for( dip::uint ii = 0; ii < length_; ++ii ) {
+               out[ ii ] = full[ ii ].real();
             }
          }
       }
 
    private:
-      std::vector< DFT< FloatType< TPI >>> dft_; // one for each dimension
-      std::vector< std::vector< TPI >> buffers_; // one for each thread
-      FloatType< TPI > scale_;
-      bool shift_;
+      dip::uint length_;
+      std::shared_ptr< DFT< TPF > const > dft_; // of length N/2 for even N, N otherwise
+      std::vector< TPC > twiddles_;             // exp( -/+ 2 pi i k / N ), for k = 0 to N/2; empty for odd N
+
+      // Computes frequency k of the real transform from Z[k] and Z[N/2-k] of the half-length complex transform
+      static TPC Split( TPC a, TPC b, TPC twiddle ) {
+         TPC even = ( a + std::conj( b )) * TPF( 0.5 );
+         TPC odd = ( a - std::conj( b )) * TPF( 0.5 );
+         odd = { odd.imag(), -odd.real() }; // -i * odd
+         return even + twiddle * odd;
+      }
 };
 
+// Enumerates the image lines along dimension `dim`, separately for each tensor element. Two images with the same
+// sizes except along `dim` have the same lines.
+class ImageLines {
+   public:
+      ImageLines( Image const& img, dip::uint dim )
+            : dim_( dim ), sizes_( img.Sizes() ), strides_( img.Strides() ),
+              tensorElements_( img.TensorElements() ), tensorStride_( img.TensorStride() ) {}
+
+      dip::uint NumberOfLines() const {
+         return sizes_.product() / sizes_[ dim_ ] * tensorElements_;
+      }
+
+      // Computes the coordinates of the first pixel of line `line`, and its tensor element
+      void Coordinates( dip::uint line, UnsignedArray& coords, dip::uint& tensorElement ) const {
+         tensorElement = line % tensorElements_;
+         line /= tensorElements_;
+         coords.resize( sizes_.size() );
+         for( dip::uint ii = 0; ii < sizes_.size(); ++ii ) {
+            if( ii == dim_ ) {
+               coords[ ii ] = 0;
+            } else {
+               coords[ ii ] = line % sizes_[ ii ];
+               line /= sizes_[ ii ];
+            }
+         }
+      }
+
+      // The offset, in samples, of the given pixel and tensor element
+      dip::sint Offset( UnsignedArray const& coords, dip::uint tensorElement ) const {
+         dip::sint offset = static_cast< dip::sint >( tensorElement ) * tensorStride_;
+         for( dip::uint ii = 0; ii < sizes_.size(); ++ii ) {
+            offset += static_cast< dip::sint >( coords[ ii ] ) * strides_[ ii ];
+         }
+         return offset;
+      }
+
+   private:
+      dip::uint dim_;
+      UnsignedArray sizes_;
+      IntegerArray strides_;
+      dip::uint tensorElements_;
+      dip::sint tensorStride_;
+};
+
+// Calls `function( line, thread )` for lines 0 to `nLines`, distributed over `nThreads` threads.
+template< typename F >
+void ForEachLine( dip::uint nLines, dip::uint nThreads, F const& function ) {
+   if( nThreads <= 1 ) {
+      for( dip::uint ii = 0; ii < nLines; ++ii ) {
+         function( ii, 0 );
+      }
+      return;
+   }
+   WorkDistributor work( nLines, nThreads );
+   ParallelExecute( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint begin, end;
+      while( work.Next( thread, begin, end )) {
+         for( dip::uint ii = begin; ii < end; ++ii ) {
+            function( ii, thread );
+         }
+      }
+   } );
+}
+
+dip::uint NumberOfThreadsForLines( dip::uint nLines, dip::uint operationsPerLine ) {
+   return OptimalNumberOfThreads( nLines * operationsPerLine, std::min( GetNumberOfThreads(), nLines ));
+}
+
+dip::uint DFTOperations( dip::uint length ) {
+   return 10 * length * static_cast< dip::uint >( std::round( std::log2( length )));
+}
+
+// Computes the DFT along dimension `dim` of the real-valued image `in` (of any data type), writing frequencies
+// 0 to N/2 to `out`, which is forged here. If `shift`, the origin of `in` is in the middle of the line (see
+// `dip::FourierTransform`); in `out` frequency 0 is always at the first pixel.
+template< typename TPF >
+void RealToHalfComplex( Image const& in, Image& out, dip::uint dim, bool shift, TPF scale ) {
+   using TPC = std::complex< TPF >;
+   dip::uint length = in.Size( dim );
+   dip::uint halfLength = length / 2 + 1;
+   UnsignedArray sizes = in.Sizes();
+   sizes[ dim ] = halfLength;
+   out.ReForge( sizes, in.TensorElements(), DataType( TPC() ));
+   out.ReshapeTensor( in.Tensor() );
+   ImageLines inLines( in, dim );
+   ImageLines outLines( out, dim );
+   RealDFT< TPF > dft( length, false );
+   dip::uint nLines = inLines.NumberOfLines();
+   dip::uint nThreads = NumberOfThreadsForLines( nLines, DFTOperations( length ) / 2 );
+   std::vector< std::vector< TPF >> inBuffers( nThreads, std::vector< TPF >( length ));
+   std::vector< std::vector< TPC >> outBuffers( nThreads, std::vector< TPC >( halfLength + dft.BufferSize() ));
+   DataType inType = in.DataType();
+   uint8 const* inOrigin = static_cast< uint8 const* >( in.Origin() );
+   dip::sint inSampleSize = static_cast< dip::sint >( inType.SizeOf() );
+   dip::sint inStride = in.Stride( dim );
+   TPC* outOrigin = static_cast< TPC* >( out.Origin() );
+   dip::sint outStride = out.Stride( dim );
+   ForEachLine( nLines, nThreads, [ & ]( dip::uint line, dip::uint thread ) {
+      UnsignedArray coords;
+      dip::uint tensorElement;
+      inLines.Coordinates( line, coords, tensorElement );
+      TPF* inBuffer = inBuffers[ thread ].data();
+      detail::CopyBuffer( inOrigin + inLines.Offset( coords, tensorElement ) * inSampleSize, inType, inStride, 0,
+                          inBuffer, DataType( TPF() ), 1, 0, length, 1 );
+      if( shift ) {
+         ShiftCenterToCorner( inBuffer, length );
+      }
+      TPC* outBuffer = outBuffers[ thread ].data();
+      dft.Forward( inBuffer, outBuffer, outBuffer + halfLength, scale );
+      TPC* outPtr = outOrigin + outLines.Offset( coords, tensorElement );
+      for( dip::uint ii = 0; ii < halfLength; ++ii, outPtr += outStride ) {
+         *outPtr = outBuffer[ ii ];
+      }
+   } );
+}
+
+// The inverse of `RealToHalfComplex`: computes the inverse DFT along dimension `dim` of `in`, of type `TPC`,
+// which holds frequencies 0 to N/2. `out` must be forged, with size N along `dim`, and can have any data type.
+template< typename TPF >
+void HalfComplexToReal( Image const& in, Image& out, dip::uint dim, bool shift, TPF scale ) {
+   using TPC = std::complex< TPF >;
+   dip::uint length = out.Size( dim );
+   dip::uint halfLength = length / 2 + 1;
+   DIP_ASSERT( in.Size( dim ) == halfLength );
+   DIP_ASSERT( in.DataType() == DataType( TPC() ));
+   ImageLines inLines( in, dim );
+   ImageLines outLines( out, dim );
+   RealDFT< TPF > dft( length, true );
+   dip::uint nLines = inLines.NumberOfLines();
+   dip::uint nThreads = NumberOfThreadsForLines( nLines, DFTOperations( length ) / 2 );
+   std::vector< std::vector< TPC >> inBuffers( nThreads, std::vector< TPC >( halfLength + dft.BufferSize() ));
+   std::vector< std::vector< TPF >> outBuffers( nThreads, std::vector< TPF >( length ));
+   TPC const* inOrigin = static_cast< TPC const* >( in.Origin() );
+   dip::sint inStride = in.Stride( dim );
+   DataType outType = out.DataType();
+   uint8* outOrigin = static_cast< uint8* >( out.Origin() );
+   dip::sint outSampleSize = static_cast< dip::sint >( outType.SizeOf() );
+   dip::sint outStride = out.Stride( dim );
+   ForEachLine( nLines, nThreads, [ & ]( dip::uint line, dip::uint thread ) {
+      UnsignedArray coords;
+      dip::uint tensorElement;
+      inLines.Coordinates( line, coords, tensorElement );
+      TPC* inBuffer = inBuffers[ thread ].data();
+      TPC const* inPtr = inOrigin + inLines.Offset( coords, tensorElement );
+      for( dip::uint ii = 0; ii < halfLength; ++ii, inPtr += inStride ) {
+         inBuffer[ ii ] = *inPtr;
+      }
+      TPF* outBuffer = outBuffers[ thread ].data();
+      dft.Inverse( inBuffer, outBuffer, inBuffer + halfLength, scale );
+      if( shift ) {
+         ShiftCornerToCenter( outBuffer, length );
+      }
+      detail::CopyBuffer( outBuffer, DataType( TPF() ), 1, 0,
+                          outOrigin + outLines.Offset( coords, tensorElement ) * outSampleSize, outType, outStride, 0, length, 1 );
+   } );
+}
+
+// The index of frequency 0 along a dimension of size `size`
+dip::uint FrequencyOrigin( dip::uint size, bool corner ) {
+   return corner ? 0 : size / 2;
+}
+
+// Writes the full spectrum to `out`, given the half spectrum `half` along dimension `dim` (as computed by
+// `RealToHalfComplex` followed by complex transforms along the other dimensions in `process`). `out` is forged here.
+template< typename TPC >
+void CompleteSpectrum( Image const& half, Image& out, dip::uint dim, dip::uint length, BooleanArray const& process, bool corner ) {
+   UnsignedArray sizes = half.Sizes();
+   sizes[ dim ] = length;
+   out.ReForge( sizes, half.TensorElements(), DataType( TPC() ));
+   out.ReshapeTensor( half.Tensor() );
+   dip::uint halfLength = half.Size( dim );
+   ImageLines halfLines( half, dim );
+   ImageLines outLines( out, dim );
+   dip::uint nLines = outLines.NumberOfLines();
+   dip::uint nThreads = NumberOfThreadsForLines( nLines, 2 * length );
+   TPC const* halfOrigin = static_cast< TPC const* >( half.Origin() );
+   dip::sint halfStride = half.Stride( dim );
+   TPC* outOrigin = static_cast< TPC* >( out.Origin() );
+   dip::sint outStride = out.Stride( dim );
+   dip::uint origin = FrequencyOrigin( length, corner );
+   ForEachLine( nLines, nThreads, [ & ]( dip::uint line, dip::uint ) {
+      UnsignedArray coords;
+      dip::uint tensorElement;
+      outLines.Coordinates( line, coords, tensorElement );
+      // The line with the negated frequencies along the other processed dimensions
+      UnsignedArray mirrored = coords;
+      for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+         if(( ii != dim ) && process[ ii ] ) {
+            mirrored[ ii ] = ( 2 * FrequencyOrigin( sizes[ ii ], corner ) + sizes[ ii ] - coords[ ii ] ) % sizes[ ii ];
+         }
+      }
+      TPC const* src = halfOrigin + halfLines.Offset( coords, tensorElement );
+      TPC const* mirroredSrc = halfOrigin + halfLines.Offset( mirrored, tensorElement );
+      TPC* dest = outOrigin + outLines.Offset( coords, tensorElement );
+      for( dip::uint ii = 0; ii < halfLength; ++ii ) {
+         dest[ static_cast< dip::sint >(( origin + ii ) % length ) * outStride ] = src[ static_cast< dip::sint >( ii ) * halfStride ];
+      }
+      for( dip::uint ii = 1; ii < length - halfLength + 1; ++ii ) {
+         dest[ static_cast< dip::sint >(( origin + length - ii ) % length ) * outStride ] = std::conj( mirroredSrc[ static_cast< dip::sint >( ii ) * halfStride ] );
+      }
+   } );
+}
+
+// Copies frequencies 0 to N/2 along dimension `dim` of the full spectrum `in` to `out`, which is forged here.
+template< typename TPC >
+void ExtractHalfSpectrum( Image const& in, Image& out, dip::uint dim, bool corner ) {
+   dip::uint length = in.Size( dim );
+   dip::uint halfLength = length / 2 + 1;
+   UnsignedArray sizes = in.Sizes();
+   sizes[ dim ] = halfLength;
+   out.ReForge( sizes, in.TensorElements(), DataType( TPC() ));
+   out.ReshapeTensor( in.Tensor() );
+   ImageLines inLines( in, dim );
+   ImageLines outLines( out, dim );
+   dip::uint nLines = inLines.NumberOfLines();
+   dip::uint nThreads = NumberOfThreadsForLines( nLines, halfLength );
+   TPC const* inOrigin = static_cast< TPC const* >( in.Origin() );
+   dip::sint inStride = in.Stride( dim );
+   TPC* outOrigin = static_cast< TPC* >( out.Origin() );
+   dip::sint outStride = out.Stride( dim );
+   dip::uint origin = FrequencyOrigin( length, corner );
+   ForEachLine( nLines, nThreads, [ & ]( dip::uint line, dip::uint ) {
+      UnsignedArray coords;
+      dip::uint tensorElement;
+      inLines.Coordinates( line, coords, tensorElement );
+      TPC const* src = inOrigin + inLines.Offset( coords, tensorElement );
+      TPC* dest = outOrigin + outLines.Offset( coords, tensorElement );
+      for( dip::uint ii = 0; ii < halfLength; ++ii, dest += outStride ) {
+         *dest = src[ static_cast< dip::sint >(( origin + ii ) % length ) * inStride ];
+      }
+   } );
+}
+
+// Forward transform of the real-valued `in` along the dimensions in `process`. `out` receives half the spectrum
+// along `dim`, and is forged here.
+template< typename TPF >
+void RealToHalfComplexTransform( Image const& in, Image& out, dip::uint dim, BooleanArray const& process, bool corner, bool symmetric ) {
+   using TPC = std::complex< TPF >;
+   dfloat scale = symmetric ? 1.0 / std::sqrt( static_cast< dfloat >( in.Size( dim ))) : 1.0;
+   RealToHalfComplex< TPF >( in, out, dim, !corner, static_cast< TPF >( scale ));
+   BooleanArray otherProcess = process;
+   otherProcess[ dim ] = false;
+   if( otherProcess.any() ) {
+      DataType dtype = DataType( TPC() );
+      DFTLineFilter< TPC > lineFilter( out.Sizes(), otherProcess, false, corner, symmetric );
+      Framework::Separable( out, out, dtype, dtype, otherProcess, UnsignedArray( out.Dimensionality(), 0 ), {}, lineFilter,
+            Framework::Separable_UseInputBuffer + Framework::Separable_UseOutputBuffer + Framework::Separable_AsScalarImage );
+   }
+}
+
+// Inverse transform along the dimensions in `process` of `in`, which holds half the spectrum along `dim`.
+// `out` must be forged, with `in.Size( dim ) == out.Size( dim ) / 2 + 1`, and receives the real-valued result.
+template< typename TPF >
+void HalfComplexToRealTransform( Image const& in, Image& out, dip::uint dim, BooleanArray const& process, bool corner, bool symmetric ) {
+   using TPC = std::complex< TPF >;
+   DataType dtype = DataType( TPC() );
+   Image tmp;
+   BooleanArray otherProcess = process;
+   otherProcess[ dim ] = false;
+   if( otherProcess.any() ) {
+      DFTLineFilter< TPC > lineFilter( in.Sizes(), otherProcess, true, corner, symmetric );
+      Framework::Separable( in, tmp, dtype, dtype, otherProcess, UnsignedArray( in.Dimensionality(), 0 ), {}, lineFilter,
+            Framework::Separable_UseInputBuffer + Framework::Separable_UseOutputBuffer + Framework::Separable_AsScalarImage );
+   } else if(( in.DataType() != dtype ) || out.Aliases( in )) {
+      tmp = Convert( in, dtype );
+   } else {
+      tmp = in.QuickCopy();
+   }
+   dip::uint length = out.Size( dim );
+   dfloat scale = 1.0 / static_cast< dfloat >( length );
+   if( symmetric ) {
+      scale = std::sqrt( scale );
+   }
+   HalfComplexToReal< TPF >( tmp, out, dim, !corner, static_cast< TPF >( scale ));
+}
+
 } // namespace
 
 #ifdef DIP__HAS_FFTW
@@ -182,18 +617,6 @@ public:
    int GetInitResult() const {
       return initResult_;
    }
-
-   int GetOptimalNumThreads( UnsignedArray const& outSize ) const {
-      // TODO: find heuristic. The FFTW 3 manual says:
-      // "You will have to experiment with your system to see what level of parallelization is best
-      // for your problem size. Typically, the problem will have to involve at least a few thousand
-      // data points before threads become beneficial. If you plan with FFTW_PATIENT, it will
-      // automatically disable threads for sizes that don't benefit from parallelization."
-      if( outSize.product() < 2000 )
-         return 1;
-      else
-         return omp_get_max_threads();
-   }
 };
 
 // Force FFTW threading initialization at shared library creation
@@ -214,7 +637,7 @@ public:
 // - Normalization (done while copying the input in order to save a post processing step)
 //
 // First, the output is forged. Next, FFTW plans with the FFTW_MEASURE flag on uninitialized data in the
-// output image. Finally, the output image is filled with the (processed) input data and the
+// output image, unless a plan for the same sizes and strides is in the cache. Finally, the output image is filled with the (processed) input data and the
 // transform is done in-place. This eliminates all needs for an intermediate image.
 template< class fftwapi >
 class FFTWHelper
@@ -314,6 +737,23 @@ public:
    // No re-measuring is done for subsequent calls with the same sizes.
    virtual typename fftwapi::plan CreatePlan( bool inverse ) = 0;
 
+   // Execute a plan created by `CreatePlan` for an image with the same sizes, strides and alignment
+   virtual void Execute( typename fftwapi::plan plan ) = 0;
+
+   // Identifies the plan created by `CreatePlan`, see `FFTWPlanCache`.
+   // Requires calling PrepareIODims() first.
+   std::vector< dip::sint > PlanKey( int kind, bool inverse ) {
+      std::vector< dip::sint > key{ kind, inverse, fftwapi::alignment_of( static_cast< typename fftwapi::real* >( out_.Origin() )) };
+      for( auto const& dim : sizeDims_ ) {
+         key.insert( key.end(), { dim.n, dim.is, dim.os } );
+      }
+      key.push_back( -1 ); // separates the two lists
+      for( auto const& dim : repeatDims_ ) {
+         key.insert( key.end(), { dim.n, dim.is, dim.os } );
+      }
+      return key;
+   }
+
 protected:
    // Define dip's float type and complex type
    DataType floatType_;
@@ -400,6 +840,10 @@ public:
       return fftwapi::plan_guru_r2r( static_cast<int>( sizeDims_.size() ), &sizeDims_[0], static_cast<int>( repeatDims_.size() ), &repeatDims_[0],
          (typename fftwapi::real*)out_.Origin(), (typename fftwapi::real*)out_.Origin(), &r2rKinds[0], FFTW_MEASURE );
    }
+
+   virtual void Execute( typename fftwapi::plan plan ) override {
+      fftwapi::execute_r2r( plan, (typename fftwapi::real*)out_.Origin(), (typename fftwapi::real*)out_.Origin() );
+   }
 };
 
 // FFTW helper class for real to complex transforms
@@ -507,6 +951,10 @@ public:
       return fftwapi::plan_guru_dft_r2c( static_cast<int>( sizeDims_.size() ), &sizeDims_[0], static_cast<int>( repeatDims_.size() ), &repeatDims_[0],
          (typename fftwapi::real*)out_.Origin(), (typename fftwapi::complex*)out_.Origin(), FFTW_MEASURE );
    }
+
+   virtual void Execute( typename fftwapi::plan plan ) override {
+      fftwapi::execute_dft_r2c( plan, (typename fftwapi::real*)out_.Origin(), (typename fftwapi::complex*)out_.Origin() );
+   }
 };
 
 // FFTW helper class for complex to real transforms
@@ -625,6 +1073,10 @@ public:
          (typename fftwapi::complex*)out_.Origin(), (typename fftwapi::real*)out_.Origin(), FFTW_MEASURE );
    }
 
+   virtual void Execute( typename fftwapi::plan plan ) override {
+      fftwapi::execute_dft_c2r( plan, (typename fftwapi::complex*)out_.Origin(), (typename fftwapi::real*)out_.Origin() );
+   }
+
 protected:
    UnsignedArray complexOutSize_;
    UnsignedArray floatOutSize_;  // filled by ForgeOutput()
@@ -694,6 +1146,126 @@ public:
       return fftwapi::plan_guru_dft( static_cast<int>( sizeDims_.size() ), &sizeDims_[0], static_cast<int>( repeatDims_.size() ), &repeatDims_[0],
          (typename fftwapi::complex*)out_.Origin(), (typename fftwapi::complex*)out_.Origin(), sign, FFTW_MEASURE );
    }
+
+   virtual void Execute( typename fftwapi::plan plan ) override {
+      fftwapi::execute_dft( plan, (typename fftwapi::complex*)out_.Origin(), (typename fftwapi::complex*)out_.Origin() );
+   }
+};
+
+// Thread-safe cache of FFTW plans, one instance for each float type.
+//
+// The plans are keyed on the transform kind, direction, sizes, strides and alignment (see `FFTWHelper::PlanKey`),
+// and can be executed on any image with those properties through the new-array execute functions. Creating and
+// destroying a plan is not thread safe in FFTW, executing it is. Plans are handed out as shared pointers, so that
+// clearing the cache, or removing a plan to make space for a new one, does not destroy a plan that is being
+// executed. `plannerMutex_` serializes all other FFTW calls.
+//
+// When a plan is created, it is created both for a single thread and for the number of threads configured through
+// `dip::SetNumberOfThreads`. The two plans are timed, and the faster one is kept.
+template< typename FloatType >
+class FFTWPlanCache {
+   public:
+      using fftwapi = fftwapidef< FloatType >;
+      using plan = typename fftwapi::plan;
+      using PlanPointer = std::shared_ptr< typename std::remove_pointer< plan >::type >;
+
+      static FFTWPlanCache& GetInstance() {
+         static FFTWPlanCache cache;
+         return cache;
+      }
+
+      // `createPlan( nThreads )` creates the plan on the image's arrays, and leaves them filled with zeros.
+      PlanPointer Get( std::vector< dip::sint > const& key, std::function< plan( int ) > const& createPlan ) {
+         std::vector< PlanPointer > unused; // destroyed after `mutex_` is released
+         std::lock_guard< std::mutex > lock( mutex_ );
+         auto it = plans_.find( key );
+         if( it != plans_.end() ) {
+            return it->second;
+         }
+         if( plans_.size() >= maximumSize ) {
+            RemoveUnused( unused );
+         }
+         std::lock_guard< std::mutex > plannerLock( plannerMutex_ );
+         plan best = createPlan( 1 );
+         DIP_THROW_IF( best == NULL, "FFTW planner failed, requested data formats/strides not supported" );
+         int nThreads = static_cast< int >( GetNumberOfThreads() );
+         if( nThreads > 1 ) {
+            plan threaded = createPlan( nThreads );
+            if( threaded != NULL ) {
+               if( IsFaster( threaded, best )) {
+                  std::swap( best, threaded );
+               }
+               fftwapi::destroy_plan( threaded );
+            }
+         }
+         PlanPointer ptr( best, [ this ]( plan p ) {
+            std::lock_guard< std::mutex > plannerLock( plannerMutex_ );
+            fftwapi::destroy_plan( p );
+         } );
+         plans_.emplace( key, ptr );
+         return ptr;
+      }
+
+      void Clear() {
+         std::map< std::vector< dip::sint >, PlanPointer > plans; // destroyed after `mutex_` is released
+         std::lock_guard< std::mutex > lock( mutex_ );
+         plans.swap( plans_ );
+      }
+
+      String ExportWisdom() {
+         std::lock_guard< std::mutex > plannerLock( plannerMutex_ );
+         char* str = fftwapi::export_wisdom_to_string();
+         DIP_THROW_IF( !str, "Failed exporting FFTW wisdom" );
+         String wisdom( str );
+         std::free( str );
+         return wisdom;
+      }
+
+      void ImportWisdom( String const& wisdom ) {
+         std::lock_guard< std::mutex > plannerLock( plannerMutex_ );
+         DIP_THROW_IF( fftwapi::import_wisdom_from_string( wisdom.c_str() ) == 0, "Failed importing FFTW wisdom" );
+      }
+
+   private:
+      static constexpr dip::uint maximumSize = 256;
+      std::mutex mutex_;        // protects `plans_`
+      std::mutex plannerMutex_; // protects all FFTW calls except for the execution of a plan
+      std::map< std::vector< dip::sint >, PlanPointer > plans_;
+
+      FFTWPlanCache() = default;
+
+      // Moves the plans not referenced outside the cache to `unused`
+      void RemoveUnused( std::vector< PlanPointer >& unused ) {
+         for( auto it = plans_.begin(); it != plans_.end(); ) {
+            if( it->second.use_count() == 1 ) {
+               unused.push_back( std::move( it->second ));
+               it = plans_.erase( it );
+            } else {
+               ++it;
+            }
+         }
+      }
+
+      // Returns true if `p1` executes faster than `p2`. The plans are executed on the arrays they were created for,
+      // before the input data is written to them. A single execution is easily disturbed by other processes or by
+      // the first touch of the memory, so each plan is executed several times, alternating, and the fastest time
+      // of each is compared.
+      static bool IsFaster( plan p1, plan p2 ) {
+         constexpr dip::uint repetitions = 3;
+         double t1 = std::numeric_limits< double >::max();
+         double t2 = std::numeric_limits< double >::max();
+         for( dip::uint ii = 0; ii < repetitions; ++ii ) {
+            t1 = std::min( t1, TimeExecution( p1 ));
+            t2 = std::min( t2, TimeExecution( p2 ));
+         }
+         return t1 < t2;
+      }
+
+      static double TimeExecution( plan p ) {
+         auto start = std::chrono::steady_clock::now();
+         fftwapi::execute( p );
+         return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+      }
 };
 
 // \brief Function that performs the FFTW transform, templated in the floating point type
@@ -714,14 +1286,20 @@ void PerformFFTW( Image const& in, Image& out, UnsignedArray const& outSize, Boo
 
    // Determine transform type and reate data helper for it
    std::shared_ptr< FFTWHelper< fftwapi > > helper;
-   if (in.DataType().IsReal() && realOutput) // Real-to-real
+   int kind;
+   if (in.DataType().IsReal() && realOutput) { // Real-to-real
       helper.reset( new FFTWHelperR2R< fftwapi >( in, out ) );
-   else if (in.DataType().IsReal()) // Real-to-complex
+      kind = 0;
+   } else if (in.DataType().IsReal()) { // Real-to-complex
       helper.reset( new FFTWHelperR2C< fftwapi >( in, out ) );
-   else if (in.DataType().IsComplex() && realOutput ) // Complex-to-real
+      kind = 1;
+   } else if (in.DataType().IsComplex() && realOutput ) { // Complex-to-real
       helper.reset( new FFTWHelperC2R< fftwapi >( in, out ) );
-   else // Complex-to-complex
+      kind = 2;
+   } else { // Complex-to-complex
       helper.reset( new FFTWHelperC2C< fftwapi >( in, out ) );
+      kind = 3;
+   }
 
    // Handle processing dims
    helper->HandleProcessingDims( process );
@@ -732,20 +1310,21 @@ void PerformFFTW( Image const& in, Image& out, UnsignedArray const& outSize, Boo
    // Prepare iodim structs
    helper->PrepareIODims();
 
-   // Create FFTW plan
-   fftwapi::plan_with_nthreads( FFTWThreading< FloatType >::GetInstance()->GetOptimalNumThreads( outSize ) );
-   typename fftwapi::plan plan = helper->CreatePlan( inverse );
-   DIP_THROW_IF( plan == NULL, "FFTW planner failed, requested data formats/strides not supported" );
+   // Get the FFTW plan from the cache, or create it. Planning writes garbage to the arrays, we zero them for timing
+   // the plan's execution: garbage can contain denormals or NaNs, which might make the computation slower.
+   auto plan = FFTWPlanCache< FloatType >::GetInstance().Get( helper->PlanKey( kind, inverse ), [ & ]( int nThreads ) {
+      fftwapi::plan_with_nthreads( nThreads );
+      typename fftwapi::plan p = helper->CreatePlan( inverse );
+      out.Fill( 0 );
+      return p;
+   } );
 
    // Fill output for in-place operation
    // NOTE!! This must be done after creating the plan, because FFTW_MEASURE overwrites the in/out arrays.
    helper->PrepareInput( inverse, symmetric, shiftOriginToCenter );
 
    // The actual work: execute the plan
-   fftwapi::execute( plan );
-
-   // Destroy the plan
-   fftwapi::destroy_plan( plan );
+   helper->Execute( plan.get() );
 
    // Finalize the output image
    helper->FinalizeOutput( shiftOriginToCenter );
@@ -767,6 +1346,7 @@ void FourierTransform(
    // Read `options` set
    bool inverse = false; // forward or inverse transform?
    bool real = false; // real-valued output?
+   bool half = false; // only half of the spectrum in the frequency domain?
    bool fast = false; // pad the image to a "nice" size?
    bool corner = false;
    bool symmetric = false;
@@ -774,9 +1354,9 @@ void FourierTransform(
       if( option == "inverse" ) {
          inverse = true;
       } else if( option == "real" ) {
-         // TODO: We should probably write code to do real -> 1/2 plane complex, and 1/2 plane complex -> real DFTs.
-         // TODO: If so, we'll need to write our own loop code here, we won't be able to depend on Framework::Separable (unless we add some options there...)
          real = true;
+      } else if( option == "half" ) {
+         half = true;
       } else if( option == "fast" ) {
          fast = true;
       } else if( option == "corner" ) {
@@ -794,6 +1374,15 @@ void FourierTransform(
       DIP_THROW_IF( process.size() != nDims, E::ARRAY_PARAMETER_WRONG_LENGTH );
    }
    //std::cout << "process = " << process << std::endl;
+   // The "half" spectrum stores only the non-negative frequencies along the first processed dimension
+   dip::uint halfDim = 0;
+   while(( halfDim < nDims ) && !process[ halfDim ] ) {
+      ++halfDim;
+   }
+   bool realToComplex = !inverse && !real && !fast && !in.DataType().IsComplex() && ( halfDim < nDims );
+   bool complexToReal = inverse && ( real || half ) && !fast && ( halfDim < nDims );
+   DIP_THROW_IF( half && fast, "Options \"half\" and \"fast\" cannot be combined" );
+   DIP_THROW_IF( half && !realToComplex && !complexToReal, "Option \"half\" requires a real-valued input or output" );
    // Determine output size and create `border` array
    UnsignedArray outSize = in.Sizes();
    UnsignedArray border( nDims, 0 );
@@ -819,63 +1408,148 @@ void FourierTransform(
    DataType dtype = DataType::SuggestComplex( in.DataType() );
    // Allocate output image, so that it has the right (padded) size. If we don't do padding, then we're just doing the framework's work here
    Image const in_copy = in; // Make a copy of the header to preserve image in case in == out
-   
+   bool doublePrecision = dtype == DT_DCOMPLEX;
+   UnsignedArray fullSize = outSize; // The sizes of the full spectrum, for the pixel sizes
+
 #ifdef DIP__HAS_FFTW
+   // The "half" layout and real-to-real transforms are implemented only with our own DFT
+   bool useFFTW = !half && !( in.DataType().IsReal() && real );
+#else
+   bool useFFTW = false;
+#endif
 
-   // Determine floating point size and call appropriate work horse
-   // NOTE: There is no support for padded output yet, so outSize is not yet passed
-   DataType floatOutType = DataType::SuggestFloat( in.DataType() );
-   switch( floatOutType ) {
-   case DT_SFLOAT:
-      PerformFFTW< float >( in, out, in.Sizes(), process, inverse, real, !corner, symmetric );
-      break;
-   case DT_DFLOAT:
-      PerformFFTW< double >( in, out, in.Sizes(), process, inverse, real, !corner, symmetric );
-      break;
-   default:
-      DIP_THROW( "Unknown float type for FFTW" );
-      break;
-   }
+   if( useFFTW ) {
 
-#else // DIP__HAS_FFTW
+#ifdef DIP__HAS_FFTW
+      // Determine floating point size and call appropriate work horse
+      // NOTE: There is no support for padded output yet, so outSize is not yet passed
+      // FFTW writes into an image of its own data type, a protected output image gets a copy of the result
+      Image tmp;
+      Image& dest = out.IsProtected() ? tmp : out;
+      DataType floatOutType = DataType::SuggestFloat( in.DataType() );
+      switch( floatOutType ) {
+      case DT_SFLOAT:
+         PerformFFTW< float >( in, dest, in.Sizes(), process, inverse, real, !corner, symmetric );
+         break;
+      case DT_DFLOAT:
+         PerformFFTW< double >( in, dest, in.Sizes(), process, inverse, real, !corner, symmetric );
+         break;
+      default:
+         DIP_THROW( "Unknown float type for FFTW" );
+         break;
+      }
+      if( out.IsProtected() ) {
+         out.Copy( tmp );
+      }
+#endif // DIP__HAS_FFTW
+
+   } else if( realToComplex ) {
+
+      // Real-to-complex transform along `halfDim`, then complex transforms along the other dimensions of
+      // the half-sized image
+      Image halfImage;
+      DIP_START_STACK_TRACE
+         if( doublePrecision ) {
+            RealToHalfComplexTransform< dfloat >( in_copy, halfImage, halfDim, process, corner, symmetric );
+         } else {
+            RealToHalfComplexTransform< sfloat >( in_copy, halfImage, halfDim, process, corner, symmetric );
+         }
+         if( half ) {
+            if( out.IsProtected() ) {
+               out.Copy( halfImage );
+            } else {
+               out = std::move( halfImage );
+            }
+         } else {
+            // Fill in the negative frequencies using the conjugate symmetry
+            Image tmp;
+            Image& full = ( out.IsProtected() && ( out.DataType() != dtype )) ? tmp : out;
+            if( doublePrecision ) {
+               CompleteSpectrum< dcomplex >( halfImage, full, halfDim, outSize[ halfDim ], process, corner );
+            } else {
+               CompleteSpectrum< scomplex >( halfImage, full, halfDim, outSize[ halfDim ], process, corner );
+            }
+            if( tmp.IsForged() ) {
+               out.Copy( tmp );
+            }
+         }
+      DIP_END_STACK_TRACE
+
+   } else if( complexToReal ) {
+
+      // Complex transforms along the other dimensions, then complex-to-real transform along `halfDim`
+      Image halfImage = in_copy.DataType() == dtype ? in_copy.QuickCopy() : Convert( in_copy, dtype );
+      DIP_START_STACK_TRACE
+         if( half ) {
+            // The output size along `halfDim` is either 2H-2 or 2H-1; we use the size of `out` if it's one of these
+            dip::uint halfLength = in_copy.Size( halfDim );
+            dip::uint length = halfLength > 1 ? 2 * halfLength - 2 : 1;
+            if( out.IsForged() && ( out.Dimensionality() == nDims ) && ( out.Size( halfDim ) / 2 + 1 == halfLength )) {
+               UnsignedArray sizes = out.Sizes();
+               sizes[ halfDim ] = halfLength;
+               if( sizes == in_copy.Sizes() ) {
+                  length = out.Size( halfDim );
+               }
+            }
+            fullSize[ halfDim ] = length;
+         } else {
+            Image tmp;
+            if( doublePrecision ) {
+               ExtractHalfSpectrum< dcomplex >( halfImage, tmp, halfDim, corner );
+            } else {
+               ExtractHalfSpectrum< scomplex >( halfImage, tmp, halfDim, corner );
+            }
+            halfImage = std::move( tmp );
+         }
+         out.ReForge( fullSize, in_copy.TensorElements(), DataType::SuggestFloat( dtype ), Option::AcceptDataTypeChange::DO_ALLOW );
+         if( !out.IsProtected() ) {
+            out.ReshapeTensor( in_copy.Tensor() );
+         }
+         if( doublePrecision ) {
+            HalfComplexToRealTransform< dfloat >( halfImage, out, halfDim, process, corner, symmetric );
+         } else {
+            HalfComplexToRealTransform< sfloat >( halfImage, out, halfDim, process, corner, symmetric );
+         }
+      DIP_END_STACK_TRACE
 
-   Image tmp;
-   if( real ) {
-      tmp.ReForge( outSize, 1, dtype );
    } else {
-      out.ReForge( outSize, 1, dtype );
-      tmp = out.QuickCopy();
-   }
-   // Do the processing
-   DIP_START_STACK_TRACE
-      // Get callback function
-      std::unique_ptr< Framework::SeparableLineFilter > lineFilter;
-      DIP_OVL_NEW_COMPLEX( lineFilter, DFTLineFilter, ( outSize, process, inverse, corner, symmetric ), dtype );
-      Framework::Separable( in_copy, tmp, dtype, dtype, process, border, bc, *lineFilter,
-            Framework::Separable_UseInputBuffer +   // input stride is always 1
-            Framework::Separable_UseOutputBuffer +  // output stride is always 1
-            Framework::Separable_DontResizeOutput + // output is potentially larger than input, if padding with zeros
-            Framework::Separable_AsScalarImage      // each tensor element processed separately
-      );
-   DIP_END_STACK_TRACE
-   // Produce real-valued output
-   // TODO: OpenCV has code for a DFT that takes complex data but reads only half the array, assumes symmetry, and produces a real ouput. We should use that here.
-   // TODO: We should also use the code that takes real data in.
-   if( real ) {
-      tmp = tmp.Real();
-      if(( out.DataType() != tmp.DataType() ) && ( !out.IsProtected() )) {
-         out.Strip(); // Avoid accidental data conversion.
-      }
-      out.Copy( tmp );
-   }
 
-#endif // DIP__HAS_FFTW
+      Image tmp;
+      if( real ) {
+         tmp.ReForge( outSize, in_copy.TensorElements(), dtype );
+      } else {
+         out.ReForge( outSize, in_copy.TensorElements(), dtype );
+         tmp = out.QuickCopy();
+      }
+      tmp.ReshapeTensor( in_copy.Tensor() );
+      // Do the processing
+      DIP_START_STACK_TRACE
+         // Get callback function
+         std::unique_ptr< Framework::SeparableLineFilter > lineFilter;
+         DIP_OVL_NEW_COMPLEX( lineFilter, DFTLineFilter, ( outSize, process, inverse, corner, symmetric ), dtype );
+         Framework::Separable( in_copy, tmp, dtype, dtype, process, border, bc, *lineFilter,
+               Framework::Separable_UseInputBuffer +   // input stride is always 1
+               Framework::Separable_UseOutputBuffer +  // output stride is always 1
+               Framework::Separable_DontResizeOutput + // output is potentially larger than input, if padding with zeros
+               Framework::Separable_AsScalarImage      // each tensor element processed separately
+         );
+      DIP_END_STACK_TRACE
+      // Produce real-valued output
+      if( real ) {
+         tmp = tmp.Real();
+         if(( out.DataType() != tmp.DataType() ) && ( !out.IsProtected() )) {
+            out.Strip(); // Avoid accidental data conversion.
+         }
+         out.Copy( tmp );
+      }
+
+   }
 
    // Set output pixel sizes
    PixelSize pixelSize = in_copy.PixelSize();
    for( dip::uint ii = 0; ii < nDims; ++ii ) {
       if( process[ ii ] ) {
-         pixelSize.Scale( ii, static_cast< dfloat >( out.Size( ii )));
+         pixelSize.Scale( ii, static_cast< dfloat >( fullSize[ ii ] ));
          pixelSize.Invert( ii );
       }
    }
@@ -894,12 +1568,109 @@ dip::uint OptimalFourierTransformSize( dip::uint size ) {
 }
 
 
+template< typename T >
+std::shared_ptr< DFT< T > const > GetCachedDFT( size_t size, bool inverse ) {
+   return DFTCache< T >::GetInstance().Get( size, inverse );
+}
+template std::shared_ptr< DFT< float > const > GetCachedDFT( size_t size, bool inverse );
+template std::shared_ptr< DFT< double > const > GetCachedDFT( size_t size, bool inverse );
+
+
+namespace {
+
+// The file starts with this line, followed by a line with the name of the FFT implementation.
+constexpr char const* wisdomFileHeader = "DIPlib Fourier transform wisdom";
+#ifdef DIP__HAS_FFTW
+constexpr char const* wisdomImplementation = "FFTW";
+#else
+constexpr char const* wisdomImplementation = "built-in";
+#endif
+
+} // namespace
+
+void ExportFourierTransformWisdom( String const& filename ) {
+   std::ofstream file( filename );
+   DIP_THROW_IF( !file, "Could not open file for writing: " + filename );
+   file << wisdomFileHeader << '\n' << wisdomImplementation << '\n';
+#ifdef DIP__HAS_FFTW
+   // For each float type, the number of characters in the wisdom string, followed by the string
+   String wisdom = FFTWPlanCache< float >::GetInstance().ExportWisdom();
+   file << "float " << wisdom.size() << '\n' << wisdom << '\n';
+   wisdom = FFTWPlanCache< double >::GetInstance().ExportWisdom();
+   file << "double " << wisdom.size() << '\n' << wisdom << '\n';
+#else
+   // One line per cached DFT object: the float type, the size, and 1 for inverse or 0 for forward
+   for( auto const& key : DFTCache< float >::GetInstance().Keys() ) {
+      file << "float " << key.first << ' ' << key.second << '\n';
+   }
+   for( auto const& key : DFTCache< double >::GetInstance().Keys() ) {
+      file << "double " << key.first << ' ' << key.second << '\n';
+   }
+#endif
+   DIP_THROW_IF( !file, "Error writing to file: " + filename );
+}
+
+void ImportFourierTransformWisdom( String const& filename ) {
+   std::ifstream file( filename );
+   DIP_THROW_IF( !file, "Could not open file for reading: " + filename );
+   String line;
+   std::getline( file, line );
+   DIP_THROW_IF( line != wisdomFileHeader, "Not a Fourier transform wisdom file: " + filename );
+   std::getline( file, line );
+   DIP_THROW_IF( line != wisdomImplementation, "Fourier transform wisdom file was written for a different FFT implementation" );
+   String type;
+#ifdef DIP__HAS_FFTW
+   dip::uint length;
+   while( file >> type >> length ) {
+      file.ignore(); // the newline
+      String wisdom( length, '\0' );
+      DIP_THROW_IF( !file.read( &wisdom[ 0 ], static_cast< std::streamsize >( length )), "Fourier transform wisdom file is truncated" );
+      if( type == "float" ) {
+         FFTWPlanCache< float >::GetInstance().ImportWisdom( wisdom );
+      } else if( type == "double" ) {
+         FFTWPlanCache< double >::GetInstance().ImportWisdom( wisdom );
+      } else {
+         DIP_THROW( "Fourier transform wisdom file is corrupt" );
+      }
+   }
+#else
+   size_t size;
+   bool inverse;
+   while( file >> type >> size >> inverse ) {
+      DIP_THROW_IF(( size < 1 ) || ( size > maximumDFTSize ), "Fourier transform wisdom file is corrupt" );
+      if( type == "float" ) {
+         DFTCache< float >::GetInstance().Get( size, inverse );
+      } else if( type == "double" ) {
+         DFTCache< double >::GetInstance().Get( size, inverse );
+      } else {
+         DIP_THROW( "Fourier transform wisdom file is corrupt" );
+      }
+   }
+#endif
+   DIP_THROW_IF( !file.eof(), "Fourier transform wisdom file is corrupt" );
+}
+
+void ClearFourierTransformPlanCache() {
+   DFTCache< float >::GetInstance().Clear();
+   DFTCache< double >::GetInstance().Clear();
+#ifdef DIP__HAS_FFTW
+   FFTWPlanCache< float >::GetInstance().Clear();
+   FFTWPlanCache< double >::GetInstance().Clear();
+#endif
+}
+
+
 } // namespace dip
 
 
 #ifdef DIP__ENABLE_DOCTEST
+#include <atomic>
+#include <cstdio>
+#include <thread>
 #include "doctest.h"
 #include "diplib/random.h"
+#include "diplib/generation.h"
+#include "diplib/testing.h"
 
 #ifndef M_PIl
 #define M_PIl 3.1415926535897932384626433832795029L
@@ -946,4 +1717,93 @@ DOCTEST_TEST_CASE("[DIPlib] testing the DFT function") {
    DOCTEST_CHECK( doctest::Approx( dotest< double >( 840, true )) == 0 );
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the Fourier transform plan cache") {
+   auto dft1 = dip::GetCachedDFT< float >( 60, false );
+   auto dft2 = dip::GetCachedDFT< float >( 60, false );
+   DOCTEST_CHECK( dft1 == dft2 );
+   DOCTEST_CHECK( dft1 != dip::GetCachedDFT< float >( 60, true ));
+   DOCTEST_CHECK( dft1 != dip::GetCachedDFT< float >( 64, false ));
+   DOCTEST_CHECK( dft1->TransformSize() == 60 );
+   DOCTEST_CHECK( !dft1->IsInverse() );
+
+   dip::Image img{ dip::UnsignedArray{ 30, 42 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random );
+   dip::Image ft1 = dip::FourierTransform( img );
+   char const* filename = "test_fourier_wisdom.txt";
+   dip::ExportFourierTransformWisdom( filename );
+   dip::ClearFourierTransformPlanCache();
+   dip::ImportFourierTransformWisdom( filename );
+   std::remove( filename );
+   dip::Image ft2 = dip::FourierTransform( img );
+   DOCTEST_CHECK( dip::testing::CompareImages( ft1, ft2, dip::Option::CompareImagesMode::EXACT ));
+   dip::Image inv = dip::FourierTransform( ft2, { "inverse", "real" } );
+   DOCTEST_CHECK( dip::testing::CompareImages( img, inv, dip::Option::CompareImagesMode::APPROX, 1e-5 ));
+
+   // Clearing the cache while other threads are using the plans in it
+   std::atomic< dip::uint > nWrong{ 0 };
+   std::vector< std::thread > threads;
+   for( dip::uint ii = 0; ii < 3; ++ii ) {
+      threads.emplace_back( [ & ]() {
+         for( dip::uint jj = 0; jj < 20; ++jj ) {
+            dip::Image ft = dip::FourierTransform( img );
+            if( !dip::testing::CompareImages( ft1, ft, dip::Option::CompareImagesMode::APPROX, 1e-2 )) {
+               ++nWrong;
+            }
+         }
+      } );
+   }
+   for( dip::uint jj = 0; jj < 20; ++jj ) {
+      dip::ClearFourierTransformPlanCache();
+      std::this_thread::yield();
+   }
+   for( auto& thread : threads ) {
+      thread.join();
+   }
+   DOCTEST_CHECK( nWrong == 0 );
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the real-to-complex Fourier transform") {
+   dip::Random random( 0 );
+   for( auto const& sizes : { dip::UnsignedArray{ 16, 9 }, dip::UnsignedArray{ 7, 10 }, dip::UnsignedArray{ 5, 1, 6 }} ) {
+      dip::Image img{ sizes, 2, dip::DT_DFLOAT };
+      img.Fill( 0 );
+      dip::UniformNoise( img, img, random );
+      dip::Image complexImg = dip::Convert( img, dip::DT_DCOMPLEX );
+      for( auto const& options : { dip::StringSet{}, dip::StringSet{ "corner", "symmetric" }} ) {
+         // The forward transform of a real image matches that of the complex image
+         dip::Image ft = dip::FourierTransform( img, options );
+         DOCTEST_CHECK( dip::testing::CompareImages( ft, dip::FourierTransform( complexImg, options ), dip::Option::CompareImagesMode::APPROX, 1e-12 ));
+         dip::StringSet inverse = options;
+         inverse.insert( { "inverse", "real" } );
+         dip::Image back = dip::FourierTransform( ft, inverse );
+         DOCTEST_CHECK( back.DataType() == dip::DT_DFLOAT );
+         DOCTEST_CHECK( back.TensorElements() == 2 );
+         DOCTEST_CHECK( dip::testing::CompareImages( back, img, dip::Option::CompareImagesMode::APPROX, 1e-12 ));
+         // The "half" spectrum is the first half of the full spectrum along the first dimension
+         dip::StringSet halfOptions = options;
+         halfOptions.insert( "half" );
+         dip::Image half = dip::FourierTransform( img, halfOptions );
+         DOCTEST_CHECK( half.Size( 0 ) == sizes[ 0 ] / 2 + 1 );
+         dip::IntegerArray wrap( sizes.size(), 0 );
+         wrap[ 0 ] = options.count( "corner" ) ? 0 : -static_cast< dip::sint >( sizes[ 0 ] / 2 );
+         dip::Image ftShifted = dip::Wrap( ft, wrap );
+         dip::RangeArray ranges( sizes.size() );
+         ranges[ 0 ] = dip::Range{ 0, static_cast< dip::sint >( sizes[ 0 ] / 2 ) };
+         DOCTEST_CHECK( dip::testing::CompareImages( half, ftShifted.At( ranges ), dip::Option::CompareImagesMode::APPROX, 1e-12 ));
+         // The inverse of the "half" spectrum, using `out` to set the size for odd sizes
+         halfOptions.insert( "inverse" );
+         back = dip::Image( sizes, 2, dip::DT_DFLOAT );
+         dip::FourierTransform( half, back, halfOptions );
+         DOCTEST_CHECK( dip::testing::CompareImages( back, img, dip::Option::CompareImagesMode::APPROX, 1e-12 ));
+      }
+   }
+   dip::Image img{ dip::UnsignedArray{ 7 }, 1, dip::DT_SFLOAT };
+   img.Fill( 1 );
+   DOCTEST_CHECK( dip::FourierTransform( dip::FourierTransform( img, { "half" } ), { "inverse", "half" } ).Size( 0 ) == 6 );
+   DOCTEST_CHECK_THROWS( dip::FourierTransform( img, { "half", "fast" } ));
+   DOCTEST_CHECK_THROWS( dip::FourierTransform( dip::Convert( img, dip::DT_SCOMPLEX ), { "half" } ));
+}
+
 #endif // DIP__ENABLE_DOCTEST